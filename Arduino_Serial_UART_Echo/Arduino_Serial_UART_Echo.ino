@@ -1,33 +1,205 @@
 /*
  * serial_echo.pde
- * ----------------- 
+ * -----------------
  * Echoes what is sent back through the serial port.
  *
+ * Data moves through a ring buffer in blocks: each pass of loop() reads
+ * whatever the UART has received into the free part of the ring and writes
+ * as much of the ring as the UART transmit buffer can take. Neither call
+ * waits, so reading and writing overlap and the echo keeps up with the
+ * line rate. When the ring is full, reading stops until it drains; bursts
+ * of any length are safe.
+ *
+ * With ECHO_CHECK set the sketch also checks the frames sent by
+ * tools/serialecho.py as they pass through:
+ *
+ *   '#' seq len payload[len] crcLo crcHi
+ *
+ * where the CRC is CRC-16/CCITT-FALSE over seq, len and the payload, and
+ * seq counts up by one per frame. Every byte is still echoed unchanged. A
+ * frame with len 0 asks for the counters, which are sent as one text line
+ * after its echo.
+ *
  * http://spacetinkerer.blogspot.com
  */
 
-char incomingByte[30];    // for incoming serial data
+#define ECHO_BAUD         115200
+#ifndef ECHO_CHECK
+#define ECHO_CHECK        0
+#endif
 
-void setup() {
-    for (int i = 0; i < 30; i++) {
-      incomingByte[i] = 0;
-    }
-  
-    Serial.begin(115200);    // opens serial port, sets data rate to 9600 bps
-}
-
-void loop() {  
-  if (Serial.available()) {
-      int i = 0;
-    // send data only when you receive data:
-    while (Serial.available() > 0) {
-      // read the incoming byte:
-      incomingByte[i] = Serial.read();
-      i++;
+// Ring buffer size, must be a power of two
+#define ECHO_BUFFER_SIZE  256
+#define ECHO_BUFFER_MASK  (ECHO_BUFFER_SIZE - 1)
+
+#define FRAME_SYNC        '#'
+
+uint8_t ringBuffer[ECHO_BUFFER_SIZE];
+uint16_t ringHead = 0;    // Next byte to read into, free running
+uint16_t ringTail = 0;    // Next byte to echo, free running
+
+// Counters, reported by a stats request in ECHO_CHECK mode
+uint32_t bytesIn = 0;
+uint32_t bytesOut = 0;
+uint32_t ringFull = 0;    // Passes that found the ring full
+uint32_t framesOk = 0;
+uint32_t crcErrors = 0;
+uint32_t seqErrors = 0;
+
+#if ECHO_CHECK
+enum FrameState { WAIT_SYNC, GET_SEQ, GET_LEN, GET_DATA, GET_CRC_LO, GET_CRC_HI };
+
+FrameState frameState = WAIT_SYNC;
+uint8_t frameSeq;
+uint8_t frameLen;
+uint8_t frameCount;
+uint16_t frameCrc;
+uint16_t frameRxCrc;
+uint8_t nextSeq = 0;
+bool seqValid = false;
+bool statsPending = false;
+
+uint16_t crc16Update(uint16_t crc, uint8_t data) {
+  crc ^= (uint16_t)data << 8;
+  for (uint8_t i = 0; i < 8; i++) {
+    crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
+
+void frameEnd(void) {
+  if (frameRxCrc != frameCrc) {
+    crcErrors++;
+    return;
+  }
+  framesOk++;
+  if (seqValid && frameSeq != nextSeq) {
+    seqErrors++;
+  }
+  nextSeq = frameSeq + 1;
+  seqValid = true;
+  if (frameLen == 0) {
+    statsPending = true;
+  }
+}
+
+void checkByte(uint8_t data) {
+  switch (frameState) {
+  case WAIT_SYNC:
+    if (data == FRAME_SYNC) {
+      frameCrc = 0xFFFF;
+      frameState = GET_SEQ;
     }
-    // say what you got:
-    for (int j = 0; j < i; j++) {
-      Serial.print(incomingByte[j]);
+    break;
+  case GET_SEQ:
+    frameSeq = data;
+    frameCrc = crc16Update(frameCrc, data);
+    frameState = GET_LEN;
+    break;
+  case GET_LEN:
+    frameLen = data;
+    frameCount = 0;
+    frameCrc = crc16Update(frameCrc, data);
+    frameState = frameLen ? GET_DATA : GET_CRC_LO;
+    break;
+  case GET_DATA:
+    frameCrc = crc16Update(frameCrc, data);
+    if (++frameCount == frameLen) {
+      frameState = GET_CRC_LO;
     }
-  } 
+    break;
+  case GET_CRC_LO:
+    frameRxCrc = data;
+    frameState = GET_CRC_HI;
+    break;
+  case GET_CRC_HI:
+    frameRxCrc |= (uint16_t)data << 8;
+    frameEnd();
+    frameState = WAIT_SYNC;
+    break;
+  }
+}
+
+// Send the counters once the stats request itself has been echoed
+void sendStats(void) {
+  Serial.print(F("STATS in="));
+  Serial.print(bytesIn);
+  Serial.print(F(" out="));
+  Serial.print(bytesOut);
+  Serial.print(F(" full="));
+  Serial.print(ringFull);
+  Serial.print(F(" ok="));
+  Serial.print(framesOk);
+  Serial.print(F(" crc="));
+  Serial.print(crcErrors);
+  Serial.print(F(" seq="));
+  Serial.println(seqErrors);
+  statsPending = false;
+}
+#endif
+
+// Read what has arrived into the free part of the ring, up to the wrap
+void readBlock(void) {
+  uint16_t used = ringHead - ringTail;
+  uint16_t start = ringHead & ECHO_BUFFER_MASK;
+  int count = Serial.available();
+
+  if (count <= 0) {
+    return;
+  }
+  if (used == ECHO_BUFFER_SIZE) {
+    ringFull++;
+    return;
+  }
+  if (count > ECHO_BUFFER_SIZE - used) {
+    count = ECHO_BUFFER_SIZE - used;
+  }
+  if (count > ECHO_BUFFER_SIZE - start) {
+    count = ECHO_BUFFER_SIZE - start;
+  }
+
+  count = Serial.readBytes(&ringBuffer[start], count);
+#if ECHO_CHECK
+  for (int i = 0; i < count; i++) {
+    checkByte(ringBuffer[start + i]);
+  }
+#endif
+  ringHead += count;
+  bytesIn += count;
+}
+
+// Write as much of the ring as the transmit buffer takes, up to the wrap
+void writeBlock(void) {
+  uint16_t used = ringHead - ringTail;
+  uint16_t start = ringTail & ECHO_BUFFER_MASK;
+  int count = Serial.availableForWrite();
+
+  if (used == 0 || count <= 0) {
+    return;
+  }
+  if (count > used) {
+    count = used;
+  }
+  if (count > ECHO_BUFFER_SIZE - start) {
+    count = ECHO_BUFFER_SIZE - start;
+  }
+
+  count = Serial.write(&ringBuffer[start], count);
+  ringTail += count;
+  bytesOut += count;
+}
+
+void setup() {
+  Serial.begin(ECHO_BAUD);
+}
+
+void loop() {
+  readBlock();
+  writeBlock();
+#if ECHO_CHECK
+  // The ring holds nothing past the request once it is empty
+  if (statsPending && ringHead == ringTail) {
+    sendStats();
+  }
+#endif
 }
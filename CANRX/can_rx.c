@@ -5,6 +5,7 @@
  * This code receives a message on the CAN0 peripheral and outputs the lower 4 bits on
  * GPIO pins E0-E3. This is meant to be used in conjunction with the can_tx.c code
  * which transmits a 4 bit message, incrementing the value every transmission.
+ * Blocks sent over ISO-TP are reassembled and counted.
  *
  * The CAN0 peripheral is set up for pins E4 (RX) and E5 (TX).
  *
@@ -16,6 +17,8 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdarg.h>
+#include <string.h>
 #include "inc/hw_can.h"
 #include "inc/hw_ints.h"
 #include "inc/hw_memmap.h"
@@ -24,6 +27,18 @@
 #include "driverlib/pin_map.h"
 #include "driverlib/sysctl.h"
 #include "driverlib/interrupt.h"
+#include "driverlib/uart.h"
+#include "utils/ustdlib.h"
+
+#include "canrxfifo.h"
+#include "canbittiming.h"
+#include "canlatency.h"
+#include "canerr.h"
+#include "isotp.h"
+#include "candispatch.h"
+#include "canfilter.h"
+#include "canlog.h"
+#include "isrtrace.h"
 
 // Number of received messages
 volatile uint32_t g_ui32RXMsgCount = 0;
@@ -31,20 +46,50 @@ volatile uint32_t g_ui32RXMsgCount = 0;
 // Global receive flag
 volatile bool g_bRXFlag = 0;
 
-// Global error flags
-volatile uint32_t g_ui32ErrFlag = 0;
+// System clock set up in main() and the CAN0 bit timing derived from it.
+// The sample point is in tenths of a percent.
+#define SYSCLK_HZ               50000000
+#define CAN0_BITRATE            1000000
+#define CAN0_SAMPLE_POINT       875
 
-// CAN message object
-tCANMsgObject g_sCAN0RxMessage;
+CAN_BIT_TIMING_CHECK(SYSCLK_HZ, CAN0_BITRATE, CAN0_SAMPLE_POINT);
+static const tCANBitClkParms g_sCAN0BitClk =
+    CAN_BIT_TIMING(SYSCLK_HZ, CAN0_BITRATE, CAN0_SAMPLE_POINT);
 
-// Set RXID to 0 to receive all messages
-#define CAN0RXID                0
+// ID of the LED frames sent by can_tx.c
+#define CAN0LEDID               2
 
-// Set RXOBJECT to channel 1
-#define RXOBJECT                1
+// Last frame taken out of the receive FIFO
+tCANFrame g_sCAN0RxFrame;
 
-// Variable to hold received data
-uint8_t g_pui8RXMsgData[8];
+// ISO-TP blocks arrive on ISOTPRXID, flow control goes back on ISOTPTXID
+// from message object 32, which the receive FIFO does not use
+#define ISOTPRXID               0x7E0
+#define ISOTPTXID               0x7E8
+#define ISOTPTXOBJECT           32
+
+// Every ID this node wants, the receive filter is worked out from these
+static const uint32_t g_pui32CAN0RxIDs[] = { CAN0LEDID, ISOTPRXID };
+
+// Frames that got through the filter but have no handler
+volatile uint32_t g_ui32CAN0RxUnwanted = 0;
+
+// Every frame received or sent is logged and streamed out of UART0, which
+// is the virtual COM port of the debug USB connection
+#define CANLOG_BAUD             921600
+
+tISOTPLink g_sISOTPLink;
+
+// Reassembly buffer, the length and count of the blocks received in full
+#define ISOTP_BUFFER_SIZE       4096
+uint8_t g_pui8ISOTPBuffer[ISOTP_BUFFER_SIZE];
+volatile uint32_t g_ui32ISOTPBlockLen = 0;
+volatile uint32_t g_ui32ISOTPBlockCount = 0;
+
+// Time from the receive ISR to the frame being written to the LEDs. Watch it
+// in the debugger, or send any byte to UART0 to have it printed into the
+// capture log (tools/canlog.py dump shows it).
+tCANLatHist g_sCAN0RxLatency;
 
 //*****************************************************************************
 //
@@ -70,38 +115,114 @@ CAN0IntHandler(void)
      */
     unsigned long ulStatus;
 
+    ISRTRACE_ENTER(ISRTRACE_ID_CAN);
+
     ulStatus = CANIntStatus(CAN0_BASE, CAN_INT_STS_CAUSE);
-    switch(ulStatus)
+
+    // Status interrupt: the error module reads the status, which also
+    // acknowledges it
+    if(ulStatus == CAN_INT_INTID_STATUS)
+    {
+        CANErrStatusIntHandler();
+    }
+    // Message received: drain every FIFO object into the ring, the frames
+    // are handled in main()
+    else if(!CANRXFifoIntHandler(ulStatus))
     {
-    case RXOBJECT: // message received
+        // Nothing else should interrupt, just clear it
+        CANIntClear(CAN0_BASE, ulStatus);
+    }
 
-        // Set message data pointer
-        g_sCAN0RxMessage.pui8MsgData = g_pui8RXMsgData;
+    ISRTRACE_EXIT(ISRTRACE_ID_CAN);
+}
 
-        // Get message data
-        CANMessageGet(CAN0_BASE, RXOBJECT, &g_sCAN0RxMessage, 1);
+// Send an ISO-TP flow control frame. There is only one transmit object, so
+// refuse while the previous frame is still waiting to go out and let the
+// link try again.
+static bool ISOTPCANSend(uint32_t ui32ID, const uint8_t *pui8Data, uint32_t ui32Len) {
+    tCANMsgObject sMsg;
+    tCANFrame sFrame;
 
-        // Write received data to LEDs
-        writeLEDs(g_pui8RXMsgData[0]);
+    if (CANStatusGet(CAN0_BASE, CAN_STS_TXREQUEST) & (1UL << (ISOTPTXOBJECT - 1))) {
+        return false;
+    }
 
-        // Increment received message count
-        g_ui32RXMsgCount++;
-        break;
-    default: // status or other interrupt: clear it and set error flags
-        g_ui32ErrFlag |= CANStatusGet(CAN0_BASE, CAN_STS_CONTROL);
-        CANIntClear(CAN0_BASE, ulStatus);
+    sMsg.ui32MsgID = ui32ID;
+    sMsg.ui32MsgIDMask = 0;
+    sMsg.ui32Flags = 0;
+    sMsg.ui32MsgLen = ui32Len;
+    sMsg.pui8MsgData = (uint8_t *)pui8Data;
+    CANMessageSet(CAN0_BASE, ISOTPTXOBJECT, &sMsg, MSG_OBJ_TYPE_TX);
+
+    sFrame.ui32ID = ui32ID;
+    sFrame.ui32Len = ui32Len;
+    memcpy(sFrame.pui8Data, pui8Data, ui32Len);
+    sFrame.ui32Time = CANLatencyNow();
+    CANLogFrame(&sFrame, CANLOG_FLAG_TX);
+
+    return true;
+}
+
+// Hand one byte of the capture log to UART0 if there is room in its FIFO
+static bool UART0Put(uint8_t ui8Byte) {
+    return UARTCharPutNonBlocking(UART0_BASE, ui8Byte);
+}
+
+// printf into the capture log for CANLatencyDump(). The dump is only taken
+// on request, so wait for the UART to make room rather than lose lines.
+static void CANLogPrintf(const char *pcString, ...) {
+    char pcLine[64];
+    va_list vaArgs;
+
+    va_start(vaArgs, pcString);
+    uvsnprintf(pcLine, sizeof(pcLine), pcString, vaArgs);
+    va_end(vaArgs);
+
+    while(!CANLogText(CANLatencyNow(), pcLine)) {
+        CANLogDrain(UART0Put);
     }
 }
 
+// UART0 on PA0/PA1 for the capture log
+void InitUART0(void) {
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOA);
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_UART0);
+
+    GPIOPinConfigure(GPIO_PA0_U0RX);
+    GPIOPinConfigure(GPIO_PA1_U0TX);
+    GPIOPinTypeUART(GPIO_PORTA_BASE, GPIO_PIN_0 | GPIO_PIN_1);
+
+    UARTConfigSetExpClk(UART0_BASE, SYSCLK_HZ, CANLOG_BAUD,
+                        UART_CONFIG_WLEN_8 | UART_CONFIG_STOP_ONE | UART_CONFIG_PAR_NONE);
+}
+
 // Write LEDs to the message received on the CAN bus
 void writeLEDs(uint8_t leds) {
     GPIOPinWrite(GPIO_PORTE_BASE, GPIO_PIN_0 | GPIO_PIN_1 | GPIO_PIN_2 | GPIO_PIN_3, leds&0x0F);
 }
 
+// Show a received frame on the LEDs
+static void LEDFrameHandler(const tCANFrame *psFrame, void *pvArg) {
+    // Write received data to LEDs
+    writeLEDs(psFrame->pui8Data[0]);
+    CANLatencyRecord(&g_sCAN0RxLatency, psFrame->ui32Time, CANLatencyNow());
+
+    // Increment received message count
+    g_ui32RXMsgCount++;
+}
+
+// Pass a frame on to the ISO-TP link in pvArg
+static void ISOTPFrameHandler(const tCANFrame *psFrame, void *pvArg) {
+    ISOTPFrameReceived((tISOTPLink *)pvArg, psFrame, CANLatencyNow());
+}
+
 // Enable CAN0 to receive messages at 1MHz
 // Use PE4/PE5
 // Enable interrupts
 void InitCAN0(void) {
+    tCANFilter psFilters[CANRXFIFO_MAX_FILTERS];
+    uint32_t ui32NumFilters;
+
     // Enable port E
     SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOE);
 
@@ -125,7 +246,7 @@ void InitCAN0(void) {
     CANInit(CAN0_BASE);
 
     // Set CAN0 to run at 1Mbps
-    CANBitRateSet(CAN0_BASE, SysCtlClockGet(), 1000000);
+    CANBitTimingSet(CAN0_BASE, (tCANBitClkParms *)&g_sCAN0BitClk);
 
     // Enable interrupts, error interrupts, and status interrupts
     CANIntEnable(CAN0_BASE, CAN_INT_MASTER | CAN_INT_ERROR | CAN_INT_STATUS);
@@ -136,110 +257,17 @@ void InitCAN0(void) {
     // Enable CAN0
     CANEnable(CAN0_BASE);
 
-    // Set up receive message object
-    g_sCAN0RxMessage.ui32MsgID = 0x188;     // Accept any ID
-    g_sCAN0RxMessage.ui32MsgIDMask = 0; // Accept any ID
-    // Interrupt enable and use ID filter
-    g_sCAN0RxMessage.ui32Flags = MSG_OBJ_RX_INT_ENABLE | MSG_OBJ_USE_ID_FILTER;
-//    g_sCAN0RxMessage.ui32Flags = MSG_OBJ_RX_INT_ENABLE;
-    // Message length = 1 byte (g_ui8RXMsgData is 8 bits long)
-//    g_sCAN0RxMessage.ui32MsgLen = sizeof(g_ui8RXMsgData);
-    g_sCAN0RxMessage.ui32MsgLen = 0x02;
-    g_sCAN0RxMessage.pui8MsgData = (unsigned char *)&g_pui8RXMsgData;
-
-    // Load message 1 with g_sCAN0RxMessage settings
-    CANMessageSet(CAN0_BASE, RXOBJECT, &g_sCAN0RxMessage, MSG_OBJ_TYPE_RX);
-}
-
-// Error handler for CAN errors
-// Fill in with what to do
-void CANErrorHandler(void) {
-    // If the bus is off (Too many errors happened)
-    if(g_ui32ErrFlag & CAN_STATUS_BUS_OFF) {
-        // Clear the flag
-        g_ui32ErrFlag &= ~(CAN_STATUS_BUS_OFF);
-    }
-
-    // If there have been many of errors (more than 96)
-    if(g_ui32ErrFlag & CAN_STATUS_EWARN) {
-        // Clear the flag
-        g_ui32ErrFlag &= ~(CAN_STATUS_EWARN);
-    }
-
-    // If there have been a lot of errors (more than 127)
-    if(g_ui32ErrFlag & CAN_STATUS_EPASS) {
-        // Clear the flag
-        g_ui32ErrFlag &= ~(CAN_STATUS_EPASS);
-    }
-
-    // Received message successfully
-    if(g_ui32ErrFlag & CAN_STATUS_RXOK) {
-        // Clear the flag
-        g_ui32ErrFlag &= ~(CAN_STATUS_RXOK);
-    }
-
-    // Transmit message successfully
-    if(g_ui32ErrFlag & CAN_STATUS_TXOK) {
-        // Clear the flag
-        g_ui32ErrFlag &= ~(CAN_STATUS_TXOK);
-    }
-
-    // Check the LEC
-    if(g_ui32ErrFlag & CAN_STATUS_LEC_MSK) {
-        // Clear the flag
-        g_ui32ErrFlag &= ~(CAN_STATUS_LEC_MSK);
-    }
-
-    // Bit stuffing error
-    if(g_ui32ErrFlag & CAN_STATUS_LEC_STUFF) {
-        // Clear the flag
-        g_ui32ErrFlag &= ~(CAN_STATUS_LEC_STUFF);
-    }
-
-    // Formatting error
-    if(g_ui32ErrFlag & CAN_STATUS_LEC_FORM) {
-        // Clear the flag
-        g_ui32ErrFlag &= ~(CAN_STATUS_LEC_FORM);
-    }
-
-    // Acknowledge error
-    if(g_ui32ErrFlag & CAN_STATUS_LEC_ACK) {
-        // Clear the flag
-        g_ui32ErrFlag &= ~(CAN_STATUS_LEC_ACK);
-    }
-
-    // The bus remained a bit level of 1 for longer than is allowed.
-    if(g_ui32ErrFlag & CAN_STATUS_LEC_BIT1) {
-        // Clear the flag
-        g_ui32ErrFlag &= ~(CAN_STATUS_LEC_BIT1);
-    }
-
-    // The bus remained a bit level of 0 for longer than is allowed.
-    if(g_ui32ErrFlag & CAN_STATUS_LEC_BIT0) {
-        // Clear the flag
-        g_ui32ErrFlag &= ~(CAN_STATUS_LEC_BIT0);
-    }
-
-    // CRC error
-    if(g_ui32ErrFlag & CAN_STATUS_LEC_CRC) {
-        // Clear the flag
-        g_ui32ErrFlag &= ~(CAN_STATUS_LEC_CRC);
-    }
-
-    // LEC mask
-    if(g_ui32ErrFlag & CAN_STATUS_LEC_MASK) {
-        // Clear the flag
-        g_ui32ErrFlag &= ~(CAN_STATUS_LEC_MASK);
-    }
-
-    // If there are any bits still set in g_ui32ErrFlag then something unhandled has happened.
-    if(g_ui32ErrFlag !=0) {
-        // Handle this here, shouldn't ever get here
-    }
+    // Chain the receive message objects into a hardware FIFO per filter.
+    // With no more wanted IDs than filters each ID gets an exact filter,
+    // otherwise the merged filters let the fewest unwanted IDs through.
+    ui32NumFilters = CANFilterCompute(g_pui32CAN0RxIDs,
+                                      sizeof(g_pui32CAN0RxIDs) / sizeof(g_pui32CAN0RxIDs[0]),
+                                      psFilters, CANRXFIFO_MAX_FILTERS);
+    CANRXFifoInit(psFilters, ui32NumFilters);
 }
 
 // Set up the system, initialize CAN
-// Check flags for errors, if there are any call the error handler
+// Keep the error state machine running between frames
 int main(void) {
     // Disable interrupts so nothing bad happens while setting up peripherals
     IntMasterDisable();
@@ -247,21 +275,64 @@ int main(void) {
     // Set the clocking to run at 50MHz.
     SysCtlClockSet(SYSCTL_SYSDIV_4 | SYSCTL_USE_PLL | SYSCTL_XTAL_16MHZ | SYSCTL_OSC_MAIN);
 
+    // Start the timestamp timer before any frame can arrive
+    CANLatencyInit(SYSCLK_HZ);
+
+    // Trace CAN0IntHandler against the cycle counter
+    ISRTraceInit(SYSCLK_HZ);
+
+    // Stream a log of the bus out of UART0, stamped with the same timer
+    CANLogInit(SYSCLK_HZ);
+    InitUART0();
+
+    // Track the error state against the same timer
+    CANErrInit(CAN0_BASE, SYSCLK_HZ / 1000);
+
     // Initialize CAN0
     InitCAN0();
 
+    // Receive ISO-TP blocks straight into g_pui8ISOTPBuffer
+    ISOTPInit(&g_sISOTPLink, ISOTPTXID, ISOTPRXID, ISOTPCANSend, SYSCLK_HZ / 1000);
+    ISOTPRxBufferSet(&g_sISOTPLink, g_pui8ISOTPBuffer, ISOTP_BUFFER_SIZE);
+
+    // LED frames drive the LEDs and ISO-TP frames go to the link
+    CANDispatchInit();
+    CANDispatchRegister(CAN0LEDID, 0x7FF, LEDFrameHandler, 0);
+    CANDispatchRegister(ISOTPRXID, 0x7FF, ISOTPFrameHandler, &g_sISOTPLink);
+
     // Enable interrupts
     IntMasterEnable();
 
     while(1) {
-        // Check to see if there is an indication that some messages were lost.
-        if(g_sCAN0RxMessage.ui32Flags & MSG_OBJ_DATA_LOST) {
-            // Handle lost data here
+        // Handle every frame the ISR has queued. Lost frames are counted
+        // per ID by the FIFO, see CANRXFifoDropsGet().
+        while(CANRXFifoGet(&g_sCAN0RxFrame)) {
+            CANLogFrame(&g_sCAN0RxFrame, 0);
+
+            // Hand the frame to whatever is registered for its ID
+            if(!CANDispatch(&g_sCAN0RxFrame)) {
+                g_ui32CAN0RxUnwanted++;
+            }
         }
 
-        // Error Handling
-        if(g_ui32ErrFlag != 0) {
-            CANErrorHandler();
+        // Any byte received on UART0 asks for the LED latency histogram
+        if(UARTCharsAvail(UART0_BASE)) {
+            while(UARTCharGetNonBlocking(UART0_BASE) != -1) {
+            }
+            CANLatencyDump(&g_sCAN0RxLatency, "LED latency", CANLogPrintf);
         }
+
+        // Send as much of the log as the UART FIFO takes
+        CANLogDrain(UART0Put);
+
+        // Send pending flow control and pick up finished blocks
+        ISOTPPoll(&g_sISOTPLink, CANLatencyNow());
+        if(ISOTPRxStatus(&g_sISOTPLink, (uint32_t *)&g_ui32ISOTPBlockLen) == ISOTP_DONE) {
+            g_ui32ISOTPBlockCount++;
+            ISOTPRxBufferSet(&g_sISOTPLink, g_pui8ISOTPBuffer, ISOTP_BUFFER_SIZE);
+        }
+
+        // Follow the error counters and restart the controller after bus-off
+        CANErrUpdate(CANLatencyNow());
     }
 }
@@ -0,0 +1,152 @@
+/* canrxfifo.c
+ *
+ * Written for the EK-TM4C123GXL
+ *
+ * With a single receive object, a second frame arriving before the ISR has
+ * read the first one overwrites it. Here each acceptance filter gets a run
+ * of objects with the same ID/mask, all but the last with MSG_OBJ_FIFO set,
+ * so the controller fills them in order as a hardware FIFO. One interrupt
+ * drains every object that holds new data into a software ring, so back to
+ * back frames at 1 Mbit/s are kept as long as the main loop keeps up on
+ * average.
+ *
+ * When the controller reports MSG_OBJ_DATA_LOST the ID of the overwritten
+ * frame is gone, so the loss is charged to the ID that replaced it.
+ *
+ * Frames are stamped with CANLatencyNow() as they are read out in the ISR.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "inc/hw_can.h"
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+#include "driverlib/can.h"
+#include "driverlib/interrupt.h"
+
+#include "canrxfifo.h"
+#include "canfilter.h"
+#include "ringbuf.h"
+#include "canlatency.h"
+
+#define CANRXFIFO_LAST_OBJECT   (CANRXFIFO_FIRST_OBJECT + CANRXFIFO_OBJECTS - 1)
+
+// NEWDAT bits of the FIFO objects
+#define CANRXFIFO_OBJ_MASK      (((1UL << CANRXFIFO_OBJECTS) - 1) << (CANRXFIFO_FIRST_OBJECT - 1))
+
+// Per-ID drop counters, slot IDs are stored + 1 so that 0 means empty
+typedef struct {
+    uint32_t ui32Key;
+    uint32_t ui32Drops;
+} tCANRXDrop;
+
+static tCANRXDrop g_psCANRXFifoDrops[CANRXFIFO_DROP_IDS];
+
+volatile uint32_t g_ui32CANRXFifoDropsOther = 0;
+
+// Software ring, written by the ISR and read by the main loop
+static tCANFrame g_psCANRXFifoFrames[CANRXFIFO_RING_SIZE];
+static tRingBuf g_sCANRXFifoRing;
+
+// Count a lost frame against its ID
+static void CANRXFifoDrop(uint32_t ui32ID) {
+    uint32_t ui32Slot;
+    uint32_t ui32Try;
+
+    ui32Slot = ui32ID & (CANRXFIFO_DROP_IDS - 1);
+    for (ui32Try = 0; ui32Try < CANRXFIFO_DROP_IDS; ui32Try++) {
+        if (g_psCANRXFifoDrops[ui32Slot].ui32Key == 0) {
+            g_psCANRXFifoDrops[ui32Slot].ui32Key = ui32ID + 1;
+        }
+        if (g_psCANRXFifoDrops[ui32Slot].ui32Key == ui32ID + 1) {
+            g_psCANRXFifoDrops[ui32Slot].ui32Drops++;
+            return;
+        }
+        ui32Slot = (ui32Slot + 1) & (CANRXFIFO_DROP_IDS - 1);
+    }
+
+    g_ui32CANRXFifoDropsOther++;
+}
+
+bool CANRXFifoInit(const tCANFilter *psFilters, uint32_t ui32NumFilters) {
+    if ((ui32NumFilters == 0) || (ui32NumFilters > CANRXFIFO_MAX_FILTERS)) {
+        return false;
+    }
+
+    RingBufInit(&g_sCANRXFifoRing, g_psCANRXFifoFrames, sizeof(tCANFrame), CANRXFIFO_RING_SIZE);
+
+    // Objects left over from the division stay unused
+    CANFilterProgram(CAN0_BASE, CANRXFIFO_FIRST_OBJECT, psFilters, ui32NumFilters,
+                     CANRXFIFO_OBJECTS / ui32NumFilters, MSG_OBJ_RX_INT_ENABLE);
+
+    return true;
+}
+
+bool CANRXFifoIntHandler(uint32_t ui32Cause) {
+    tCANMsgObject sMsg;
+    tCANFrame *psFrame;
+    tCANFrame sDiscard;
+    uint32_t ui32NewData;
+    uint32_t ui32Obj;
+
+    if ((ui32Cause < CANRXFIFO_FIRST_OBJECT) || (ui32Cause > CANRXFIFO_LAST_OBJECT)) {
+        return false;
+    }
+
+    // Keep going until no FIFO object has new data, frames can land in the
+    // FIFO while it is being drained
+    while((ui32NewData = CANStatusGet(CAN0_BASE, CAN_STS_NEWDAT) & CANRXFIFO_OBJ_MASK) != 0) {
+        for (ui32Obj = CANRXFIFO_FIRST_OBJECT; ui32Obj <= CANRXFIFO_LAST_OBJECT; ui32Obj++) {
+            if (!(ui32NewData & (1UL << (ui32Obj - 1)))) {
+                continue;
+            }
+
+            // Read straight into the ring slot, or a scratch frame if full
+            psFrame = RingBufWritePtr(&g_sCANRXFifoRing);
+            if (psFrame == 0) {
+                psFrame = &sDiscard;
+            }
+
+            // Reading the object also clears its interrupt
+            sMsg.pui8MsgData = psFrame->pui8Data;
+            CANMessageGet(CAN0_BASE, ui32Obj, &sMsg, true);
+            psFrame->ui32ID = sMsg.ui32MsgID;
+            psFrame->ui32Len = sMsg.ui32MsgLen;
+            psFrame->ui32Time = CANLatencyNow();
+
+            if (sMsg.ui32Flags & MSG_OBJ_DATA_LOST) {
+                CANRXFifoDrop(sMsg.ui32MsgID);
+            }
+
+            if (psFrame == &sDiscard) {
+                CANRXFifoDrop(sMsg.ui32MsgID);
+            } else {
+                RingBufCommit(&g_sCANRXFifoRing);
+            }
+        }
+    }
+
+    return true;
+}
+
+bool CANRXFifoGet(tCANFrame *psFrame) {
+    return RingBufPop(&g_sCANRXFifoRing, psFrame);
+}
+
+uint32_t CANRXFifoDropsGet(uint32_t ui32ID) {
+    uint32_t ui32Slot;
+    uint32_t ui32Try;
+
+    ui32Slot = ui32ID & (CANRXFIFO_DROP_IDS - 1);
+    for (ui32Try = 0; ui32Try < CANRXFIFO_DROP_IDS; ui32Try++) {
+        if (g_psCANRXFifoDrops[ui32Slot].ui32Key == ui32ID + 1) {
+            return g_psCANRXFifoDrops[ui32Slot].ui32Drops;
+        }
+        if (g_psCANRXFifoDrops[ui32Slot].ui32Key == 0) {
+            break;
+        }
+        ui32Slot = (ui32Slot + 1) & (CANRXFIFO_DROP_IDS - 1);
+    }
+
+    return 0;
+}
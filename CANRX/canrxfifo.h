@@ -0,0 +1,53 @@
+/* canrxfifo.h
+ *
+ * CAN0 receive FIFO built from chained message objects, one chain per
+ * acceptance filter.
+ */
+
+#ifndef CANRXFIFO_H_
+#define CANRXFIFO_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "canframe.h"
+#include "canfilter.h"
+
+// Message objects 1-16 are shared evenly between the filters, each filter's
+// objects chained into a hardware FIFO of their own. Four filters still get
+// four objects each.
+#define CANRXFIFO_FIRST_OBJECT  1
+#define CANRXFIFO_OBJECTS       16
+#define CANRXFIFO_MAX_FILTERS   4
+
+// Frames the software ring can hold, must be a power of two
+#define CANRXFIFO_RING_SIZE     32
+
+// Number of IDs that get their own drop counter
+#define CANRXFIFO_DROP_IDS      16
+
+// Drops for IDs that did not fit in the per-ID table
+extern volatile uint32_t g_ui32CANRXFifoDropsOther;
+
+// Chain the FIFO message objects to accept the frames passed by psFilters,
+// from CANFilterCompute() for example. Returns false, programming nothing,
+// for no filters or more than CANRXFIFO_MAX_FILTERS. CAN0 must already be
+// initialized.
+extern bool CANRXFifoInit(const tCANFilter *psFilters, uint32_t ui32NumFilters);
+
+// Call from the CAN0 interrupt handler with the CAN_INT_STS_CAUSE value.
+// Returns true if ui32Cause was a FIFO object, in which case every object
+// holding new data has been read into the ring.
+extern bool CANRXFifoIntHandler(uint32_t ui32Cause);
+
+// Take the oldest frame out of the ring. Returns false if it is empty.
+// ui32Time holds the CANLatencyNow() value from when the ISR read it. Frames
+// that passed the same filter come out in the order they arrived, frames
+// from different filters may not.
+extern bool CANRXFifoGet(tCANFrame *psFrame);
+
+// Number of frames with ui32ID that were lost, either overwritten in the
+// hardware FIFO or dropped because the ring was full
+extern uint32_t CANRXFifoDropsGet(uint32_t ui32ID);
+
+#endif /* CANRXFIFO_H_ */
@@ -6,6 +6,7 @@
  * the transmitted data after every send.
  * This is meant to be used in conjunction with the can_rx.c code,
  * which receives a message and outputs the 4-bit contents on GPIO E0-E3
+ * Alongside each message a 1KB test block is sent to can_rx.c over ISO-TP.
  *
  * The CAN0 peripheral is set up for pins E4 (RX) and E5 (TX).
  *
@@ -26,24 +27,52 @@
 #include "driverlib/sysctl.h"
 #include "driverlib/interrupt.h"
 
+#include "cantxq.h"
+#include "canbittiming.h"
+#include "canlatency.h"
+#include "canerr.h"
+#include "canframe.h"
+#include "isrtrace.h"
+#include "ringbuf.h"
+#include "isotp.h"
+
 // Counter for number of transmitted messages
 volatile uint32_t g_ui32TXMsgCount = 0;
 
-// Global error flags
-volatile uint32_t g_ui32ErrFlag = 0;
+// System clock set up in main() and the CAN0 bit timing derived from it.
+// The sample point is in tenths of a percent.
+#define SYSCLK_HZ               50000000
+#define CAN0_BITRATE            1000000
+#define CAN0_SAMPLE_POINT       875
 
-// CAN message Object
-tCANMsgObject g_sCAN0TxMessage;
+CAN_BIT_TIMING_CHECK(SYSCLK_HZ, CAN0_BITRATE, CAN0_SAMPLE_POINT);
+static const tCANBitClkParms g_sCAN0BitClk =
+    CAN_BIT_TIMING(SYSCLK_HZ, CAN0_BITRATE, CAN0_SAMPLE_POINT);
 
 // Set TXID to 2
 #define CAN0TXID                2
 
-// Set TXOBJECT to channel 2
-#define TXOBJECT                2
-
 // Variable to hold transmitted data
 uint16_t g_ui8TXMsgData;
 
+// ISO-TP blocks go out on ISOTPTXID, CANRX answers with flow control frames
+// on ISOTPRXID, which are received in message object 1
+#define ISOTPTXID               0x7E0
+#define ISOTPRXID               0x7E8
+#define ISOTPRXOBJECT           1
+
+// Flow control frames from the ISR to the main loop
+#define ISOTP_RX_QUEUE_SIZE     4
+static tCANFrame g_psISOTPRxFrames[ISOTP_RX_QUEUE_SIZE];
+static tRingBuf g_sISOTPRxRing;
+
+tISOTPLink g_sISOTPLink;
+
+// Test block sent over ISO-TP, and the number sent in full
+#define ISOTP_BLOCK_SIZE        1024
+uint8_t g_pui8ISOTPBlock[ISOTP_BLOCK_SIZE];
+volatile uint32_t g_ui32ISOTPBlockCount = 0;
+
 //*****************************************************************************
 //
 // The error routine that is called if the driver library encounters an error.
@@ -63,6 +92,8 @@ CAN0IntHandler(void)
 {
     uint32_t ui32Status;
 
+    ISRTRACE_ENTER(ISRTRACE_ID_CAN);
+
     // Read the CAN interrupt status to find the cause of the interrupt
     //
     // CAN_INT_STS_CAUSE register values
@@ -72,39 +103,40 @@ CAN0IntHandler(void)
     // all other numbers are reserved and have no meaning in this system
     ui32Status = CANIntStatus(CAN0_BASE, CAN_INT_STS_CAUSE);
 
-    // If this was a status interrupt acknowledge it by reading the CAN
-    // controller status register.
+    // If this was a status interrupt, let the error module read the
+    // controller status, which also acknowledges it. Recovery is done later
+    // from the main loop.
     if(ui32Status == CAN_INT_INTID_STATUS)
     {
-        // Read the controller status.  This will return a field of status
-        // error bits that can indicate various errors. Refer to the
-        // API documentation for details about the error status bits.
-        // The act of reading this status will clear the interrupt.
-        ui32Status = CANStatusGet(CAN0_BASE, CAN_STS_CONTROL);
-
-        // Add ERROR flags to list of current errors. To be handled
-        // later, because it would take too much time here in the
-        // interrupt.
-        g_ui32ErrFlag |= ui32Status;
+        CANErrStatusIntHandler();
     }
 
-    // Check if the cause is message object TXOBJECT, which we are using
-    // for transmitting messages.
-    else if(ui32Status == TXOBJECT)
+    // Check if the cause is one of the message objects the transmit queue
+    // uses. The queue clears the interrupt and reloads the object from its
+    // backlog.
+    else if(CANTXQueueIntHandler(ui32Status))
     {
-        // Set message type to RX so that it doesn't continually transmit messages
-        // Could get away with using a shutdown or enable pin on transceiver, but
-        // TCAN332 doesn't have those features
-        CANMessageSet(CAN0_BASE, TXOBJECT, &g_sCAN0TxMessage, MSG_OBJ_TYPE_RX);
-
-        // Clear the message object interrupt.
-        CANIntClear(CAN0_BASE, TXOBJECT);
-
         // Increment a counter to keep track of how many messages have been transmitted.
         g_ui32TXMsgCount++;
+    }
 
-        // Since a message was transmitted, clear any error flags.
-        g_ui32ErrFlag = 0;
+    // Flow control frame for the ISO-TP link. Reading the object clears
+    // the interrupt.
+    else if(ui32Status == ISOTPRXOBJECT)
+    {
+        tCANMsgObject sMsg;
+        tCANFrame *psFrame;
+        uint8_t pui8Discard[8];
+
+        psFrame = RingBufWritePtr(&g_sISOTPRxRing);
+        sMsg.pui8MsgData = psFrame ? psFrame->pui8Data : pui8Discard;
+        CANMessageGet(CAN0_BASE, ISOTPRXOBJECT, &sMsg, true);
+        if(psFrame)
+        {
+            psFrame->ui32ID = sMsg.ui32MsgID;
+            psFrame->ui32Len = sMsg.ui32MsgLen;
+            RingBufCommit(&g_sISOTPRxRing);
+        }
     }
 
     // Otherwise, something unexpected caused the interrupt.  This should
@@ -113,12 +145,15 @@ CAN0IntHandler(void)
     {
         // Spurious interrupt handling can go here.
     }
+
+    ISRTRACE_EXIT(ISRTRACE_ID_CAN);
 }
 
 // Setup CAN0 to send messages at 1MHz
 // Use PE4 / PE5
 // Enable interrupts
 void InitCAN0(void) {
+    tCANMsgObject sMsgObjectRx;
 
     // Enable Port E
     SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOE);
@@ -137,7 +172,7 @@ void InitCAN0(void) {
     CANInit(CAN0_BASE);
 
     // Set CAN0 to run at 1Mbps
-    CANBitRateSet(CAN0_BASE, SysCtlClockGet(), 1000000);
+    CANBitTimingSet(CAN0_BASE, (tCANBitClkParms *)&g_sCAN0BitClk);
 
     // Enable interrupts, error interrupts, and status interrupts
     CANIntEnable(CAN0_BASE, CAN_INT_MASTER | CAN_INT_ERROR | CAN_INT_STATUS);
@@ -148,108 +183,28 @@ void InitCAN0(void) {
     // Enable CAN0
     CANEnable(CAN0_BASE);
 
-    // Initialize the transmit message object
-    // Set ID to 2
-    g_sCAN0TxMessage.ui32MsgID = CAN0TXID;
-
-    // Set mask to 0, doesn't matter for this
-    g_sCAN0TxMessage.ui32MsgIDMask = 0;
-
-    // Set TX interrupt flag
-    g_sCAN0TxMessage.ui32Flags = MSG_OBJ_TX_INT_ENABLE;
-
-    // Set length to 1 byte
-    g_sCAN0TxMessage.ui32MsgLen = sizeof(g_ui8TXMsgData);
-
-    // Set the message data pointer
-    g_sCAN0TxMessage.pui8MsgData = (uint8_t *)&g_ui8TXMsgData;
+    // Hand message objects 2-32 to the transmit queue
+    CANTXQueueInit();
+
+    // Receive ISO-TP flow control frames in object 1
+    RingBufInit(&g_sISOTPRxRing, g_psISOTPRxFrames, sizeof(tCANFrame), ISOTP_RX_QUEUE_SIZE);
+    sMsgObjectRx.ui32MsgID = ISOTPRXID;
+    sMsgObjectRx.ui32MsgIDMask = 0x7FF;
+    sMsgObjectRx.ui32Flags = MSG_OBJ_RX_INT_ENABLE | MSG_OBJ_USE_ID_FILTER;
+    sMsgObjectRx.ui32MsgLen = 8;
+    sMsgObjectRx.pui8MsgData = 0;
+    CANMessageSet(CAN0_BASE, ISOTPRXOBJECT, &sMsgObjectRx, MSG_OBJ_TYPE_RX);
 }
 
-// Error handler for CAN errors
-// Fill in with what to do
-void CANErrorHandler(void) {
-    // If the bus is off (Too many errors happened)
-    if(g_ui32ErrFlag & CAN_STATUS_BUS_OFF) {
-        // Clear the flag
-        g_ui32ErrFlag &= ~(CAN_STATUS_BUS_OFF);
-    }
-
-    // If there have been many of errors (more than 96)
-    if(g_ui32ErrFlag & CAN_STATUS_EWARN) {
-        // Clear the flag
-        g_ui32ErrFlag &= ~(CAN_STATUS_EWARN);
-    }
-
-    // If there have been a lot of errors (more than 127)
-    if(g_ui32ErrFlag & CAN_STATUS_EPASS) {
-        // Clear the flag
-        g_ui32ErrFlag &= ~(CAN_STATUS_EPASS);
-    }
-
-    // Received message successfully
-    if(g_ui32ErrFlag & CAN_STATUS_RXOK) {
-        // Clear the flag
-        g_ui32ErrFlag &= ~(CAN_STATUS_RXOK);
-    }
-
-    // Transmit message successfully
-    if(g_ui32ErrFlag & CAN_STATUS_TXOK) {
-        // Clear the flag
-        g_ui32ErrFlag &= ~(CAN_STATUS_TXOK);
-    }
-
-    // Check the LEC
-    if(g_ui32ErrFlag & CAN_STATUS_LEC_MSK) {
-        // Clear the flag
-        g_ui32ErrFlag &= ~(CAN_STATUS_LEC_MSK);
-    }
-
-    // Bit stuffing error
-    if(g_ui32ErrFlag & CAN_STATUS_LEC_STUFF) {
-        // Clear the flag
-        g_ui32ErrFlag &= ~(CAN_STATUS_LEC_STUFF);
-    }
-
-    // Formatting error
-    if(g_ui32ErrFlag & CAN_STATUS_LEC_FORM) {
-        // Clear the flag
-        g_ui32ErrFlag &= ~(CAN_STATUS_LEC_FORM);
-    }
-
-    // Acknowledge error
-    if(g_ui32ErrFlag & CAN_STATUS_LEC_ACK) {
-        // Clear the flag
-        g_ui32ErrFlag &= ~(CAN_STATUS_LEC_ACK);
-    }
-
-    // The bus remained a bit level of 1 for longer than is allowed.
-    if(g_ui32ErrFlag & CAN_STATUS_LEC_BIT1) {
-        // Clear the flag
-        g_ui32ErrFlag &= ~(CAN_STATUS_LEC_BIT1);
-    }
-
-    // The bus remained a bit level of 0 for longer than is allowed.
-    if(g_ui32ErrFlag & CAN_STATUS_LEC_BIT0) {
-        // Clear the flag
-        g_ui32ErrFlag &= ~(CAN_STATUS_LEC_BIT0);
-    }
-
-    // CRC error
-    if(g_ui32ErrFlag & CAN_STATUS_LEC_CRC) {
-        // Clear the flag
-        g_ui32ErrFlag &= ~(CAN_STATUS_LEC_CRC);
-    }
-
-    // LEC mask
-    if(g_ui32ErrFlag & CAN_STATUS_LEC_MASK) {
-        // Clear the flag
-        g_ui32ErrFlag &= ~(CAN_STATUS_LEC_MASK);
-    }
-
-    // If there are any bits still set in g_ui32ErrFlag then something unhandled has happened.
-    if(g_ui32ErrFlag !=0) {
-        // Handle this here, shouldn't ever get here
+// Send an ISO-TP frame through the transmit queue, as long as the error
+// state allows a frame now. A refused frame is tried again on the next
+// ISOTPPoll(), so the transfer waits out bus-off and is paced like the LED
+// frames while the error counters are high.
+static bool ISOTPCANSend(uint32_t ui32ID, const uint8_t *pui8Data, uint32_t ui32Len) {
+    if (!CANErrTxPermit(CANLatencyNow())) {
+        return false;
     }
+    return CANTXQueueSend(ui32ID, pui8Data, ui32Len);
 }
 
 // Set up the system, initialize CAN
@@ -263,12 +218,33 @@ main(void)
     // Set the clocking to 50MHz
     SysCtlClockSet(SYSCTL_SYSDIV_4 | SYSCTL_USE_PLL | SYSCTL_XTAL_16MHZ | SYSCTL_OSC_MAIN);
 
+    // Start the timestamp timer, the transmit queue stamps every frame.
+    // The queue to transmit complete latency collects in g_sCANTXQLatency.
+    CANLatencyInit(SYSCLK_HZ);
+
+    // Trace CAN0IntHandler against the cycle counter
+    ISRTraceInit(SYSCLK_HZ);
+
+    // Track the error state against the same timer
+    CANErrInit(CAN0_BASE, SYSCLK_HZ / 1000);
+
     // Initialize CAN0
     InitCAN0();
 
     // Local variables for timing everything
     unsigned int count = 0;
     uint8_t msg = 0;
+    unsigned int i;
+    tCANFrame sFrame;
+    tISOTPStatus eISOTPStatus;
+
+    // Set up the ISO-TP link and fill the test block with a counting pattern.
+    // The transmit queue keeps frames in order, so the link sends through it
+    // once the error state allows.
+    ISOTPInit(&g_sISOTPLink, ISOTPTXID, ISOTPRXID, ISOTPCANSend, SYSCLK_HZ / 1000);
+    for (i = 0; i < ISOTP_BLOCK_SIZE; i++) {
+        g_pui8ISOTPBlock[i] = i;
+    }
 
     IntMasterEnable();
 
@@ -276,22 +252,43 @@ main(void)
     while(1) {
         count++;
 
+        // Follow the error counters and restart the controller after bus-off
+        CANErrUpdate(CANLatencyNow());
+
+        // Feed flow control frames to the ISO-TP link and send what is due
+        while (RingBufPop(&g_sISOTPRxRing, &sFrame)) {
+            ISOTPFrameReceived(&g_sISOTPLink, &sFrame, CANLatencyNow());
+        }
+        ISOTPPoll(&g_sISOTPLink, CANLatencyNow());
+
         // When count has reached a big number
         if (count >= 4000000) {
             count = 0;
 
-            // Only transmit if there are no errors
-            if (g_ui32ErrFlag == 0) {
+            // Transmit unless bus-off, and less often while the error
+            // counters are high
+            if (CANErrTxPermit(CANLatencyNow())) {
 
-                // Set message data pointer
-                *g_sCAN0TxMessage.pui8MsgData = msg;
+                // Set message data
+                g_ui8TXMsgData = msg;
 
                 // increment message data value and mask it to 4 bits
                 msg++;
                 msg &= 0x000F;
 
-                // Send the CAN message using object number 2
-                CANMessageSet(CAN0_BASE, TXOBJECT, &g_sCAN0TxMessage, MSG_OBJ_TYPE_TX);
+                // Queue the CAN message, the queue picks a free message object
+                CANTXQueueSend(CAN0TXID, (uint8_t *)&g_ui8TXMsgData, sizeof(g_ui8TXMsgData));
+
+                // Start the next test block once the last one has finished.
+                // Reading DONE or ERROR returns the link to idle, so after an
+                // error the block is started again next time round.
+                eISOTPStatus = ISOTPTxStatus(&g_sISOTPLink);
+                if (eISOTPStatus == ISOTP_DONE) {
+                    g_ui32ISOTPBlockCount++;
+                }
+                if ((eISOTPStatus == ISOTP_IDLE) || (eISOTPStatus == ISOTP_DONE)) {
+                    ISOTPSend(&g_sISOTPLink, g_pui8ISOTPBlock, ISOTP_BLOCK_SIZE, CANLatencyNow());
+                }
             }
         }
     }
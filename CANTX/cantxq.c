@@ -0,0 +1,192 @@
+/* cantxq.c
+ *
+ * Written for the EK-TM4C123GXL
+ *
+ * Every transmit used to go through a single message object, so only one
+ * frame could be in flight and the main loop had to wait for the interrupt
+ * before sending the next one. This keeps up to 31 frames loaded in the
+ * controller at once and a RAM backlog behind them. When a frame finishes
+ * transmitting, the interrupt handler loads more from the backlog, so the
+ * bus stays busy without the main loop being involved.
+ *
+ * The controller always sends the lowest numbered pending object first.
+ * To keep frames in the order they were queued, objects are loaded in
+ * passes: each frame goes into the object after the previous one, and once
+ * object 32 is used the next pass only starts at object 2 when every frame
+ * of the current pass has gone. Anything pending is then always in a
+ * higher object than the frames queued before it. The price is one short
+ * gap on the bus every 31 frames under sustained load.
+ *
+ * Each frame is stamped when it is queued and the time until its transmit
+ * interrupt, both waiting in the queue and on the wire, goes into
+ * g_sCANTXQLatency.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "inc/hw_can.h"
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+#include "driverlib/can.h"
+#include "driverlib/interrupt.h"
+
+#include "cantxq.h"
+#include "canframe.h"
+#include "ringbuf.h"
+#include "canlatency.h"
+
+// Frames loaded into the current pass per interrupt, at most. Above one so
+// the number in flight builds up again after a pass restarts.
+#define CANTXQ_REFILL_MAX       2
+
+// Next message object of the current pass, CANTXQ_LAST_OBJECT + 1 once the
+// pass is used up
+static uint32_t g_ui32CANTXQNext;
+
+// Frames loaded into message objects and not yet sent
+static uint32_t g_ui32CANTXQInFlight;
+
+// Frames waiting for a free message object. The main loop pushes and the
+// interrupt handler pops.
+static tCANFrame g_psCANTXQFrames[CANTXQ_BACKLOG_SIZE];
+static tRingBuf g_sCANTXQBacklog;
+
+// Queue time of the frame loaded in each message object, indexed by object
+static uint32_t g_pui32CANTXQStamp[CANTXQ_LAST_OBJECT + 1];
+
+tCANLatHist g_sCANTXQLatency;
+
+// Load a frame into a message object and request transmission
+static void CANTXQueueLoad(uint32_t ui32Obj, uint32_t ui32ID, const uint8_t *pui8Data,
+                           uint32_t ui32Len, uint32_t ui32Stamp) {
+    tCANMsgObject sMsg;
+
+    g_pui32CANTXQStamp[ui32Obj] = ui32Stamp;
+
+    sMsg.ui32MsgID = ui32ID;
+    sMsg.ui32MsgIDMask = 0;
+    sMsg.ui32Flags = MSG_OBJ_TX_INT_ENABLE;
+    sMsg.ui32MsgLen = ui32Len;
+    sMsg.pui8MsgData = (uint8_t *)pui8Data;
+
+    // The data is copied into the message object here, the pointer is not kept
+    CANMessageSet(CAN0_BASE, ui32Obj, &sMsg, MSG_OBJ_TYPE_TX);
+}
+
+// Take the next message object of the pass, starting a new pass if the
+// last one has drained. Returns 0 if frames have to wait. Call with the
+// CAN0 interrupt masked or from the handler.
+static uint32_t CANTXQueueObject(void) {
+    if (g_ui32CANTXQNext > CANTXQ_LAST_OBJECT) {
+        if (g_ui32CANTXQInFlight != 0) {
+            return 0;
+        }
+        g_ui32CANTXQNext = CANTXQ_FIRST_OBJECT;
+    }
+    g_ui32CANTXQInFlight++;
+    return g_ui32CANTXQNext++;
+}
+
+// Mask the CAN0 interrupt and return whether it was enabled, so a caller
+// that already masked it, or runs before InitCAN0() enables it, gets it
+// back the way it was from CANTXQueueUnlock()
+static bool CANTXQueueLock(void) {
+    bool bEnabled = IntIsEnabled(INT_CAN0);
+
+    IntDisable(INT_CAN0);
+
+    return bEnabled;
+}
+
+static void CANTXQueueUnlock(bool bEnabled) {
+    if (bEnabled) {
+        IntEnable(INT_CAN0);
+    }
+}
+
+void CANTXQueueInit(void) {
+    g_ui32CANTXQNext = CANTXQ_FIRST_OBJECT;
+    g_ui32CANTXQInFlight = 0;
+
+    RingBufInit(&g_sCANTXQBacklog, g_psCANTXQFrames, sizeof(tCANFrame), CANTXQ_BACKLOG_SIZE);
+}
+
+bool CANTXQueueSend(uint32_t ui32ID, const uint8_t *pui8Data, uint32_t ui32Len) {
+    tCANFrame *psFrame;
+    uint32_t ui32Obj;
+    uint32_t ui32Stamp;
+    bool bEnabled;
+    bool bRet = true;
+
+    if (ui32Len > 8) {
+        return false;
+    }
+
+    ui32Stamp = CANLatencyNow();
+
+    // The backlog itself is lock free, but deciding between an object and
+    // the backlog has to be atomic with the interrupt handler finishing
+    // frames, or a frame could be left in the backlog with nothing in
+    // flight to pull it out
+    bEnabled = CANTXQueueLock();
+
+    // Frames already waiting go first
+    if ((RingBufCount(&g_sCANTXQBacklog) == 0) && ((ui32Obj = CANTXQueueObject()) != 0)) {
+        CANTXQueueLoad(ui32Obj, ui32ID, pui8Data, ui32Len, ui32Stamp);
+    } else if ((psFrame = RingBufWritePtr(&g_sCANTXQBacklog)) != 0) {
+        psFrame->ui32ID = ui32ID;
+        psFrame->ui32Len = ui32Len;
+        memcpy(psFrame->pui8Data, pui8Data, ui32Len);
+        psFrame->ui32Time = ui32Stamp;
+        RingBufCommit(&g_sCANTXQBacklog);
+    } else {
+        bRet = false;
+    }
+
+    CANTXQueueUnlock(bEnabled);
+
+    return bRet;
+}
+
+bool CANTXQueueIntHandler(uint32_t ui32Cause) {
+    tCANFrame *psFrame;
+    uint32_t ui32Obj;
+    uint32_t ui32Loaded;
+
+    if ((ui32Cause < CANTXQ_FIRST_OBJECT) || (ui32Cause > CANTXQ_LAST_OBJECT)) {
+        return false;
+    }
+
+    // The transmit request bit is cleared by the controller once the frame
+    // is acknowledged, so the object can be reused as is
+    CANIntClear(CAN0_BASE, ui32Cause);
+
+    CANLatencyRecord(&g_sCANTXQLatency, g_pui32CANTXQStamp[ui32Cause], CANLatencyNow());
+    g_ui32CANTXQInFlight--;
+
+    for (ui32Loaded = 0; ui32Loaded < CANTXQ_REFILL_MAX; ui32Loaded++) {
+        if ((psFrame = RingBufReadPtr(&g_sCANTXQBacklog)) == 0) {
+            break;
+        }
+        if ((ui32Obj = CANTXQueueObject()) == 0) {
+            break;
+        }
+        CANTXQueueLoad(ui32Obj, psFrame->ui32ID, psFrame->pui8Data, psFrame->ui32Len,
+                       psFrame->ui32Time);
+        RingBufRelease(&g_sCANTXQBacklog);
+    }
+
+    return true;
+}
+
+uint32_t CANTXQueuePending(void) {
+    uint32_t ui32Count;
+    bool bEnabled;
+
+    bEnabled = CANTXQueueLock();
+    ui32Count = RingBufCount(&g_sCANTXQBacklog) + g_ui32CANTXQInFlight;
+    CANTXQueueUnlock(bEnabled);
+
+    return ui32Count;
+}
@@ -0,0 +1,42 @@
+/* cantxq.h
+ *
+ * Transmit queue for CAN0 backed by a pool of message objects.
+ */
+
+#ifndef CANTXQ_H_
+#define CANTXQ_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "canlatency.h"
+
+// Message objects 2-32 are used for transmitting, object 1 is left for
+// receiving
+#define CANTXQ_FIRST_OBJECT     2
+#define CANTXQ_LAST_OBJECT      32
+
+// Number of frames that can wait in RAM for a free message object.
+// Must be a power of two.
+#define CANTXQ_BACKLOG_SIZE     64
+
+// Time from CANTXQueueSend() to the transmit interrupt for every frame sent.
+// Only updated by CANTXQueueIntHandler().
+extern tCANLatHist g_sCANTXQLatency;
+
+// Set up the message object pool. CAN0 and CANLatencyInit() must already be
+// initialized.
+extern void CANTXQueueInit(void);
+
+// Queue a frame with an 11 bit ID and up to 8 data bytes. Never blocks.
+// Returns false if both the message objects and the backlog are full.
+extern bool CANTXQueueSend(uint32_t ui32ID, const uint8_t *pui8Data, uint32_t ui32Len);
+
+// Call from the CAN0 interrupt handler with the CAN_INT_STS_CAUSE value.
+// Returns true if ui32Cause was one of the transmit objects, in which case
+// the interrupt has been cleared and waiting frames loaded.
+extern bool CANTXQueueIntHandler(uint32_t ui32Cause);
+
+// Number of frames queued or in flight
+extern uint32_t CANTXQueuePending(void);
+
+#endif /* CANTXQ_H_ */
@@ -0,0 +1,697 @@
+/*
+ * Copyright (c) 2015, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ *  ======== USBCOMP.c ========
+ *  Composite USB device with a boot keyboard, a boot mouse and a vendor
+ *  defined HID interface that streams telemetry in 64 byte reports.
+ *
+ *  The vendor interface uses its own descriptor sections so that both of
+ *  its interrupt endpoints are polled every 1 ms instead of the usblib
+ *  default of 16 ms. Reports are queued by USBCOMP_telemSend and written
+ *  from the TX complete callback, so senders never wait for the host.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/* XDCtools Header files */
+#include <xdc/std.h>
+#include <xdc/runtime/Error.h>
+#include <xdc/runtime/System.h>
+
+/* BIOS Header files */
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/gates/GateMutex.h>
+#include <ti/sysbios/hal/Hwi.h>
+#include <ti/sysbios/knl/Semaphore.h>
+
+/* driverlib Header files */
+#include <inc/hw_ints.h>
+#include <inc/hw_types.h>
+#include <driverlib/usb.h>
+
+/* usblib Header files */
+#include <usblib/usb-ids.h>
+#include <usblib/usblib.h>
+#include <usblib/usbhid.h>
+#include <usblib/device/usbdevice.h>
+#include <usblib/device/usbdcomp.h>
+#include <usblib/device/usbdhid.h>
+#include <usblib/device/usbdhidkeyb.h>
+#include <usblib/device/usbdhidmouse.h>
+
+/* Example/Board Header files */
+#include "USBCOMP.h"
+#include "isrtrace.h"
+
+#if !defined(TIVAWARE)
+#error "The composite device needs the TivaWare usblib"
+#endif
+
+#ifndef USB_PID_COMP_HID_HID
+#define USB_PID_COMP_HID_HID    0x0026
+#endif
+
+/* Sizes of the vendor interface descriptor sections */
+#define HIDINTERFACE_SIZE       9
+#define HIDENDPOINT_SIZE        7
+
+/* Interrupt endpoint polling interval in ms */
+#define TELEM_POLL_MS           1
+
+/* Room for the three interfaces in the composite configuration descriptor */
+#define DESCRIPTOR_DATA_SIZE    (COMPOSITE_DHID_SIZE * 3)
+
+/* Static variables and handles */
+static volatile bool connected;
+static GateMutex_Handle gateUSBWait;
+static Semaphore_Handle semUSBConnected;
+static USBCOMP_CommandFxn commandFxn;
+
+/*
+ * Telemetry queue. The head is written by USBCOMP_telemSend and the tail by
+ * the TX complete callback, both with INT_USB0 masked.
+ */
+static uint8_t telemQueue[USBCOMP_TELEM_QUEUE][USBCOMP_TELEM_SIZE];
+static unsigned int telemHead;
+static unsigned int telemTail;
+static volatile bool telemBusy;
+static uint16_t telemSequence;
+static USBCOMP_Stats stats;
+
+/* Buffer for OUT reports and SET_REPORT from the host */
+static uint8_t commandBuffer[USBCOMP_TELEM_SIZE];
+
+/* Memory for usblib to build the composite configuration descriptor in */
+static uint8_t descriptorData[DESCRIPTOR_DATA_SIZE];
+
+/* Function prototypes */
+static uint32_t cbCompositeHandler(void *cbData, uint32_t event,
+                                   uint32_t eventMsg, void *eventMsgPtr);
+static uint32_t cbClassHandler(void *cbData, uint32_t event,
+                               uint32_t eventMsg, void *eventMsgPtr);
+static uint32_t cbTelemRxHandler(void *cbData, uint32_t event,
+                                 uint32_t eventMsg, void *eventMsgPtr);
+static uint32_t cbTelemTxHandler(void *cbData, uint32_t event,
+                                 uint32_t eventMsg, void *eventMsgPtr);
+static Void USBCOMP_hwiHandler(UArg arg0);
+static void telemKick(void);
+void USBCOMP_init(USBCOMP_CommandFxn commandFxn);
+bool USBCOMP_waitForConnect(unsigned int timeout);
+bool USBCOMP_telemSend(uint8_t type, const void *data, unsigned int length);
+bool USBCOMP_keyStateChange(uint8_t modifiers, uint8_t usage, bool pressed);
+bool USBCOMP_mouseMove(int8_t deltaX, int8_t deltaY, uint8_t buttons);
+void USBCOMP_getStats(USBCOMP_Stats *stats);
+
+/* The languages supported by this device. */
+const unsigned char compLangDescriptor[] =
+{
+    4,
+    USB_DTYPE_STRING,
+    USBShort(USB_LANG_EN_US)
+};
+
+/* The manufacturer string. */
+const unsigned char compManufacturerString[] =
+{
+    (17 + 1) * 2,
+    USB_DTYPE_STRING,
+    'T', 0, 'e', 0, 'x', 0, 'a', 0, 's', 0, ' ', 0, 'I', 0, 'n', 0, 's', 0,
+    't', 0, 'r', 0, 'u', 0, 'm', 0, 'e', 0, 'n', 0, 't', 0, 's', 0,
+};
+
+/* The product string. */
+const unsigned char compProductString[] =
+{
+    (19 + 1) * 2,
+    USB_DTYPE_STRING,
+    'H', 0, 'I', 0, 'D', 0, ' ', 0, 'T', 0, 'e', 0, 'l', 0, 'e', 0, 'm', 0,
+    'e', 0, 't', 0, 'r', 0, 'y', 0, ' ', 0, 'D', 0, 'e', 0, 'v', 0, 'i', 0,
+    'c', 0, 'e', 0
+};
+
+/* The serial number string. */
+const unsigned char compSerialNumberString[] =
+{
+    (8 + 1) * 2,
+    USB_DTYPE_STRING,
+    '1', 0, '2', 0, '3', 0, '4', 0, '5', 0, '6', 0, '7', 0, '8', 0
+};
+
+/* The interface description string. */
+const unsigned char compInterfaceString[] =
+{
+    (13 + 1) * 2,
+    USB_DTYPE_STRING,
+    'H', 0, 'I', 0, 'D', 0, ' ', 0, 'I', 0, 'n', 0, 't', 0, 'e', 0, 'r', 0,
+    'f', 0, 'a', 0, 'c', 0, 'e', 0
+};
+
+/* The configuration description string. */
+const unsigned char compConfigString[] =
+{
+    (20 + 1) * 2,
+    USB_DTYPE_STRING,
+    'H', 0, 'I', 0, 'D', 0, ' ', 0, 'C', 0, 'o', 0, 'n', 0, 'f', 0, 'i', 0,
+    'g', 0, 'u', 0, 'r', 0, 'a', 0, 't', 0, 'i', 0, 'o', 0, 'n', 0, ' ', 0,
+    'H', 0, 'S', 0
+};
+
+/* The descriptor string table. */
+const unsigned char * const compStringDescriptors[] =
+{
+    compLangDescriptor,
+    compManufacturerString,
+    compProductString,
+    compSerialNumberString,
+    compInterfaceString,
+    compConfigString
+};
+
+#define STRINGDESCRIPTORSCOUNT (sizeof(compStringDescriptors) / \
+                                sizeof(unsigned char *))
+
+/*
+ * Report descriptor for the telemetry interface: one 64 byte vendor
+ * defined input report and one 64 byte output report, without report IDs.
+ */
+static const uint8_t telemReportDescriptor[] =
+{
+    0x06, 0x00, 0xFF,               /* Usage Page (Vendor Defined 0xFF00) */
+    Usage(0x01),
+    Collection(USB_HID_APPLICATION),
+        LogicalMinimum(0),
+        0x26, 0xFF, 0x00,           /* Logical Maximum (255) */
+        ReportSize(8),
+        ReportCount(USBCOMP_TELEM_SIZE),
+
+        Usage(0x01),
+        Input(USB_HID_INPUT_DATA | USB_HID_INPUT_VARIABLE |
+              USB_HID_INPUT_ABS),
+
+        Usage(0x02),
+        Output(USB_HID_OUTPUT_DATA | USB_HID_OUTPUT_VARIABLE |
+               USB_HID_OUTPUT_ABS),
+    EndCollection,
+};
+
+static const uint8_t * const telemClassDescriptors[] =
+{
+    telemReportDescriptor
+};
+
+static const tHIDDescriptor telemHIDDescriptor =
+{
+    9,                                  /* bLength */
+    USB_HID_DTYPE_HID,                  /* bDescriptorType */
+    0x111,                              /* bcdHID (version 1.11 compliant) */
+    0,                                  /* bCountryCode (not localized) */
+    1,                                  /* bNumDescriptors */
+    {
+        {
+            USB_HID_DTYPE_REPORT,       /* Report descriptor */
+            sizeof(telemReportDescriptor)
+        }
+    }
+};
+
+/* Telemetry only goes out when there is something new */
+static tHIDReportIdle telemReportIdle = { 0, 0, 0, 0 };
+
+/*
+ * Configuration descriptor sections for the telemetry interface. They
+ * follow usbdhid.c from usblib with both endpoints polled every 1 ms. The
+ * composite driver renumbers the interface and endpoints.
+ */
+static uint8_t telemConfigDescriptor[] =
+{
+    9,                          /* Size of the configuration descriptor */
+    USB_DTYPE_CONFIGURATION,    /* Type of this descriptor */
+    USBShort(41),               /* The total size of this full structure */
+    1,                          /* The number of interfaces */
+    1,                          /* The unique value for this configuration */
+    5,                          /* The configuration string index */
+    USB_CONF_ATTR_BUS_PWR,      /* Bus powered */
+    250,                        /* The maximum power in 2mA increments */
+};
+
+static uint8_t telemInterface[HIDINTERFACE_SIZE] =
+{
+    9,                          /* Size of the interface descriptor */
+    USB_DTYPE_INTERFACE,        /* Type of this descriptor */
+    0,                          /* The index for this interface */
+    0,                          /* The alternate setting */
+    2,                          /* The number of endpoints */
+    USB_CLASS_HID,              /* The interface class */
+    0,                          /* No subclass, not a boot device */
+    0,                          /* No protocol */
+    4,                          /* The string index for this interface */
+};
+
+static const uint8_t telemInEndpoint[HIDENDPOINT_SIZE] =
+{
+    7,                          /* The size of the endpoint descriptor */
+    USB_DTYPE_ENDPOINT,         /* Descriptor type is an endpoint */
+    USB_EP_DESC_IN | USBEPToIndex(USB_EP_1),
+    USB_EP_ATTR_INT,            /* Endpoint is an interrupt endpoint */
+    USBShort(USBFIFOSizeToBytes(USB_FIFO_SZ_64)),
+                                /* The maximum packet size */
+    TELEM_POLL_MS,              /* The polling interval */
+};
+
+static const uint8_t telemOutEndpoint[HIDENDPOINT_SIZE] =
+{
+    7,                          /* The size of the endpoint descriptor */
+    USB_DTYPE_ENDPOINT,         /* Descriptor type is an endpoint */
+    USB_EP_DESC_OUT | USBEPToIndex(USB_EP_1),
+    USB_EP_ATTR_INT,            /* Endpoint is an interrupt endpoint */
+    USBShort(USBFIFOSizeToBytes(USB_FIFO_SZ_64)),
+                                /* The maximum packet size */
+    TELEM_POLL_MS,              /* The polling interval */
+};
+
+static const tConfigSection telemConfigSection =
+{
+    sizeof(telemConfigDescriptor),
+    telemConfigDescriptor
+};
+
+static const tConfigSection telemInterfaceSection =
+{
+    sizeof(telemInterface),
+    telemInterface
+};
+
+static const tConfigSection telemHIDDescriptorSection =
+{
+    sizeof(telemHIDDescriptor),
+    (const uint8_t *)&telemHIDDescriptor
+};
+
+static const tConfigSection telemInEndpointSection =
+{
+    sizeof(telemInEndpoint),
+    telemInEndpoint
+};
+
+static const tConfigSection telemOutEndpointSection =
+{
+    sizeof(telemOutEndpoint),
+    telemOutEndpoint
+};
+
+static const tConfigSection *telemSections[] =
+{
+    &telemConfigSection,
+    &telemInterfaceSection,
+    &telemHIDDescriptorSection,
+    &telemInEndpointSection,
+    &telemOutEndpointSection
+};
+
+static tConfigHeader telemConfigHeader =
+{
+    sizeof(telemSections) / sizeof(telemSections[0]),
+    telemSections
+};
+
+static const tConfigHeader * const telemConfigDescriptors[] =
+{
+    &telemConfigHeader
+};
+
+/* The three class devices that make up the composite device */
+static tUSBDHIDKeyboardDevice keyboardDevice =
+{
+    USB_VID_TI_1CBE,
+    USB_PID_KEYBOARD,
+    0,
+    USB_CONF_ATTR_BUS_PWR,
+    cbClassHandler,
+    NULL,
+    compStringDescriptors,
+    STRINGDESCRIPTORSCOUNT
+};
+
+static tUSBDHIDMouseDevice mouseDevice =
+{
+    USB_VID_TI_1CBE,
+    USB_PID_MOUSE,
+    0,
+    USB_CONF_ATTR_BUS_PWR,
+    cbClassHandler,
+    NULL,
+    compStringDescriptors,
+    STRINGDESCRIPTORSCOUNT
+};
+
+static tUSBDHIDDevice telemDevice =
+{
+    USB_VID_TI_1CBE,
+    USB_PID_COMP_HID_HID,
+    0,
+    USB_CONF_ATTR_BUS_PWR,
+    USB_HID_SCLASS_NONE,
+    USB_HID_PROTOCOL_NONE,
+    1,
+    &telemReportIdle,
+    cbTelemRxHandler,
+    (void *)&telemDevice,
+    cbTelemTxHandler,
+    (void *)&telemDevice,
+    true,
+    &telemHIDDescriptor,
+    telemClassDescriptors,
+    compStringDescriptors,
+    STRINGDESCRIPTORSCOUNT,
+    telemConfigDescriptors
+};
+
+static tCompositeEntry compEntries[3];
+
+static tUSBDCompositeDevice compDevice =
+{
+    USB_VID_TI_1CBE,
+    USB_PID_COMP_HID_HID,
+    500,
+    USB_CONF_ATTR_BUS_PWR,
+    cbCompositeHandler,
+    compStringDescriptors,
+    STRINGDESCRIPTORSCOUNT,
+    3,
+    compEntries
+};
+
+/*
+ *  ======== cbCompositeHandler ========
+ *  Callback handler for the composite device as a whole.
+ */
+static uint32_t cbCompositeHandler(void *cbData, uint32_t event,
+                                   uint32_t eventMsg, void *eventMsgPtr)
+{
+    switch (event) {
+        case USB_EVENT_CONNECTED:
+            connected = true;
+            Semaphore_post(semUSBConnected);
+            break;
+
+        case USB_EVENT_DISCONNECTED:
+            connected = false;
+            break;
+
+        default:
+            break;
+    }
+
+    return (0);
+}
+
+/*
+ *  ======== cbClassHandler ========
+ *  Callback handler for the keyboard and mouse interfaces.
+ *
+ *  Both only report on demand, so there is nothing to track here.
+ */
+static uint32_t cbClassHandler(void *cbData, uint32_t event,
+                               uint32_t eventMsg, void *eventMsgPtr)
+{
+    return (0);
+}
+
+/*
+ *  ======== cbTelemRxHandler ========
+ *  Callback handler for requests and OUT reports on the telemetry interface.
+ */
+static uint32_t cbTelemRxHandler(void *cbData, uint32_t event,
+                                 uint32_t eventMsg, void *eventMsgPtr)
+{
+    unsigned int length;
+
+    switch (event) {
+        case USB_EVENT_CONNECTED:
+        case USB_EVENT_DISCONNECTED:
+            /* Anything still queued is stale */
+            telemTail = telemHead;
+            telemBusy = false;
+            break;
+
+        case USB_EVENT_RX_AVAILABLE:
+            length = USBDHIDPacketRead((void *)&telemDevice, commandBuffer,
+                                       sizeof(commandBuffer), true);
+            stats.commands++;
+            if (commandFxn) {
+                commandFxn(commandBuffer, length);
+            }
+            break;
+
+        case USBD_HID_EVENT_GET_REPORT_BUFFER:
+            /* SET_REPORT on the control endpoint lands in commandBuffer */
+            if (eventMsg > sizeof(commandBuffer)) {
+                return (0);
+            }
+            return ((uint32_t)(uintptr_t)commandBuffer);
+
+        case USBD_HID_EVENT_SET_REPORT:
+            stats.commands++;
+            if (commandFxn) {
+                commandFxn(commandBuffer, eventMsg);
+            }
+            break;
+
+        case USBD_HID_EVENT_GET_REPORT:
+            /* The last report sent, or zeros before the first one */
+            *(uint8_t **)eventMsgPtr =
+                telemQueue[(telemTail + USBCOMP_TELEM_QUEUE - 1) %
+                           USBCOMP_TELEM_QUEUE];
+            return (USBCOMP_TELEM_SIZE);
+
+        default:
+            break;
+    }
+
+    return (0);
+}
+
+/*
+ *  ======== cbTelemTxHandler ========
+ *  Callback handler called when the host has read a telemetry report.
+ */
+static uint32_t cbTelemTxHandler(void *cbData, uint32_t event,
+                                 uint32_t eventMsg, void *eventMsgPtr)
+{
+    if (event == USB_EVENT_TX_COMPLETE) {
+        telemTail = (telemTail + 1) % USBCOMP_TELEM_QUEUE;
+        telemBusy = false;
+        stats.sent++;
+
+        /* Keep the endpoint full while there is more queued */
+        telemKick();
+    }
+
+    return (0);
+}
+
+/*
+ *  ======== USBCOMP_hwiHandler ========
+ *  This function calls the USB library's device interrupt handler.
+ */
+static Void USBCOMP_hwiHandler(UArg arg0)
+{
+    ISRTRACE_ENTER(ISRTRACE_ID_USB);
+    USB0DeviceIntHandler();
+    ISRTRACE_EXIT(ISRTRACE_ID_USB);
+}
+
+/*
+ *  ======== telemKick ========
+ *  Function writes the oldest queued report if the endpoint is free.
+ *
+ *  The report stays in the queue until the host has read it. Must be called
+ *  from the USB callback or with INT_USB0 masked.
+ */
+static void telemKick(void)
+{
+    if (telemBusy || (telemTail == telemHead) || (!connected)) {
+        return;
+    }
+
+    if (USBDHIDReportWrite((void *)&telemDevice, telemQueue[telemTail],
+                           USBCOMP_TELEM_SIZE, true)) {
+        telemBusy = true;
+    }
+}
+
+/*
+ *  ======== USBCOMP_getStats ========
+ */
+void USBCOMP_getStats(USBCOMP_Stats *statsCopy)
+{
+    unsigned int key;
+
+    key = Hwi_disableInterrupt(INT_USB0);
+    *statsCopy = stats;
+    Hwi_restoreInterrupt(INT_USB0, key);
+}
+
+/*
+ *  ======== USBCOMP_init ========
+ */
+void USBCOMP_init(USBCOMP_CommandFxn fxn)
+{
+    Hwi_Handle hwi;
+    Error_Block eb;
+    Semaphore_Params semParams;
+
+    Error_init(&eb);
+
+    commandFxn = fxn;
+
+    /* Install interrupt handler */
+    hwi = Hwi_create(INT_USB0, USBCOMP_hwiHandler, NULL, &eb);
+    if (hwi == NULL) {
+        System_abort("Can't create USB Hwi");
+    }
+
+    /* RTOS primitives */
+    Semaphore_Params_init(&semParams);
+    semParams.mode = Semaphore_Mode_BINARY;
+    semUSBConnected = Semaphore_create(0, &semParams, &eb);
+    if (semUSBConnected == NULL) {
+        System_abort("Can't create USB semaphore");
+    }
+
+    gateUSBWait = GateMutex_create(NULL, &eb);
+    if (gateUSBWait == NULL) {
+        System_abort("Could not create USB Wait gate");
+    }
+
+    /* Set the USB stack mode to Device mode with VBUS monitoring */
+    USBStackModeSet(0, eUSBModeForceDevice, 0);
+
+    /*
+     * Set up each class as part of the composite device, then build the
+     * combined configuration descriptor and connect to the bus.
+     */
+    compDevice.psDevices[0].pvInstance =
+        USBDHIDKeyboardCompositeInit(0, &keyboardDevice, &compEntries[0]);
+    compDevice.psDevices[1].pvInstance =
+        USBDHIDMouseCompositeInit(0, &mouseDevice, &compEntries[1]);
+    compDevice.psDevices[2].pvInstance =
+        USBDHIDCompositeInit(0, &telemDevice, &compEntries[2]);
+
+    if (!USBDCompositeInit(0, &compDevice, DESCRIPTOR_DATA_SIZE,
+                           descriptorData)) {
+        System_abort("Error initializing the composite device");
+    }
+}
+
+/*
+ *  ======== USBCOMP_keyStateChange ========
+ */
+bool USBCOMP_keyStateChange(uint8_t modifiers, uint8_t usage, bool pressed)
+{
+    return (USBDHIDKeyboardKeyStateChange((void *)&keyboardDevice, modifiers,
+                                          usage, pressed) == KEYB_SUCCESS);
+}
+
+/*
+ *  ======== USBCOMP_mouseMove ========
+ */
+bool USBCOMP_mouseMove(int8_t deltaX, int8_t deltaY, uint8_t buttons)
+{
+    return (USBDHIDMouseStateChange((void *)&mouseDevice, deltaX, deltaY,
+                                    buttons) == MOUSE_SUCCESS);
+}
+
+/*
+ *  ======== USBCOMP_telemSend ========
+ */
+bool USBCOMP_telemSend(uint8_t type, const void *data, unsigned int length)
+{
+    USBCOMP_TelemHeader *header;
+    unsigned int next;
+    unsigned int key;
+    bool ret = false;
+
+    if (length > USBCOMP_TELEM_MAX_DATA) {
+        length = USBCOMP_TELEM_MAX_DATA;
+    }
+
+    key = Hwi_disableInterrupt(INT_USB0);
+
+    next = (telemHead + 1) % USBCOMP_TELEM_QUEUE;
+    if (connected && (next != telemTail)) {
+        header = (USBCOMP_TelemHeader *)telemQueue[telemHead];
+        header->type = type;
+        header->length = length;
+        header->sequence = telemSequence++;
+        memcpy(&telemQueue[telemHead][USBCOMP_TELEM_HDR_SIZE], data, length);
+        memset(&telemQueue[telemHead][USBCOMP_TELEM_HDR_SIZE + length], 0,
+               USBCOMP_TELEM_MAX_DATA - length);
+        telemHead = next;
+
+        telemKick();
+        ret = true;
+    }
+    else {
+        stats.dropped++;
+    }
+
+    Hwi_restoreInterrupt(INT_USB0, key);
+
+    return (ret);
+}
+
+/*
+ *  ======== USBCOMP_waitForConnect ========
+ */
+bool USBCOMP_waitForConnect(unsigned int timeout)
+{
+    bool ret = true;
+    unsigned int key;
+
+    /* Need exclusive access to prevent a race condition */
+    key = GateMutex_enter(gateUSBWait);
+
+    if (!connected) {
+        if (!Semaphore_pend(semUSBConnected, timeout)) {
+            ret = false;
+        }
+    }
+
+    GateMutex_leave(gateUSBWait, key);
+
+    return (ret);
+}
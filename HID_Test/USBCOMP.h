@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2015, Texas Instruments Incorporated
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * *  Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *
+ * *  Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * *  Neither the name of Texas Instruments Incorporated nor the names of
+ *    its contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+/*
+ *  ======== USBCOMP.h ========
+ */
+
+#ifndef USBCOMP_H_
+#define USBCOMP_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <xdc/std.h>
+
+/*
+ * The telemetry interface moves one 64 byte report per 1 ms frame in each
+ * direction, so it carries up to 64000 bytes/s with the stock hidraw
+ * driver on the host. Each report starts with a 4 byte header.
+ */
+#define USBCOMP_TELEM_SIZE      64
+#define USBCOMP_TELEM_HDR_SIZE  4
+#define USBCOMP_TELEM_MAX_DATA  (USBCOMP_TELEM_SIZE - USBCOMP_TELEM_HDR_SIZE)
+
+/* Telemetry reports queued between the sender and the USB interrupt */
+#ifndef USBCOMP_TELEM_QUEUE
+#define USBCOMP_TELEM_QUEUE     16
+#endif
+
+/* Report types, tools/hidtelem.py decodes the same values */
+#define USBCOMP_TELEM_TEST      0x01    /* uint32_t counters, for loss tests */
+#define USBCOMP_TELEM_ADC       0x02    /* uint16_t samples */
+#define USBCOMP_TELEM_STATS     0x03    /* uint32_t counters */
+
+/* Commands in the first byte of an OUT report from the host */
+#define USBCOMP_CMD_STREAM      0x01    /* byte 1: 0 stops, 1 starts */
+#define USBCOMP_CMD_RESET_STATS 0x02
+
+/* Header of each telemetry report, followed by up to 60 bytes of data */
+typedef struct {
+    uint8_t type;
+    uint8_t length;                     /* Bytes of data after the header */
+    uint16_t sequence;                  /* Counts every report queued */
+} USBCOMP_TelemHeader;
+
+typedef struct {
+    uint32_t sent;                      /* Reports taken by the host */
+    uint32_t dropped;                   /* Reports refused, queue full */
+    uint32_t commands;                  /* OUT reports received */
+} USBCOMP_Stats;
+
+/*
+ * Called from the USB interrupt with each OUT report or SET_REPORT from
+ * the host. It must not block.
+ */
+typedef Void (*USBCOMP_CommandFxn)(const uint8_t *data, unsigned int length);
+
+/*!
+ *  ======== USBCOMP_init ========
+ *  Function to initialize the composite keyboard, mouse and telemetry
+ *  device and connect it to the bus.
+ *
+ *  @param(commandFxn) Called with each report the host sends to the
+ *                     telemetry interface, or NULL.
+ *
+ *  Note: This function is not reentrant safe.
+ */
+extern void USBCOMP_init(USBCOMP_CommandFxn commandFxn);
+
+/*!
+ *  ======== USBCOMP_waitForConnect ========
+ *  This function blocks while the USB is not connected
+ */
+extern bool USBCOMP_waitForConnect(unsigned int timeout);
+
+/*!
+ *  ======== USBCOMP_telemSend ========
+ *  A NON-blocking function that queues a telemetry report.
+ *
+ *  @param(type)    One of the USBCOMP_TELEM_ report types
+ *
+ *  @param(data)    Report data, copied before the function returns
+ *
+ *  @param(length)  Bytes of data, at most USBCOMP_TELEM_MAX_DATA
+ *
+ *  @return         false if the device is not connected or the queue is
+ *                  full. The report is then counted as dropped.
+ */
+extern bool USBCOMP_telemSend(uint8_t type, const void *data,
+                              unsigned int length);
+
+/*!
+ *  ======== USBCOMP_keyStateChange ========
+ *  A NON-blocking function that presses or releases a boot keyboard key.
+ */
+extern bool USBCOMP_keyStateChange(uint8_t modifiers, uint8_t usage,
+                                   bool pressed);
+
+/*!
+ *  ======== USBCOMP_mouseMove ========
+ *  A NON-blocking function that reports mouse motion and buttons.
+ *
+ *  @return         false if the previous mouse report is still in flight
+ */
+extern bool USBCOMP_mouseMove(int8_t deltaX, int8_t deltaY, uint8_t buttons);
+
+/*!
+ *  ======== USBCOMP_getStats ========
+ *  Function copies the telemetry counters.
+ */
+extern void USBCOMP_getStats(USBCOMP_Stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* USBCOMP_H_ */
@@ -38,6 +38,7 @@
 
 /* XDCtools Header files */
 #include <xdc/std.h>
+#include <xdc/runtime/Types.h>
 
 /* BIOS Header files */
 #include <ti/sysbios/BIOS.h>
@@ -59,36 +60,27 @@
 #include "driverlib/sysctl.h"
 #include "driverlib/usb.h"
 
-#include "usblib/usblib.h"
-#include "usblib/usbhid.h"
-#include "usblib/device/usbdevice.h"
-#include "usblib/device/usbdhid.h"
-#include "usblib/usb-ids.h"
-
 /* Board Header file */
 #include "Board.h"
 
-#define TASKSTACKSIZE   512
-
-tHIDClassDescriptorInfo HID_Descriptor_Info {USB_HID_DTYPE_REPORT, // Set descriptor type
-                                             1
-
-}
-
-// HID Descriptor init
-tHIDDescriptor HID = {0x02,               // Set length to 2 (indicate long data type)
-                      USB_HID_DTYPE_HID,  // Set type of item to
-                      0x0111,             // Set version of HID used (1.11 = 0x0111)
-                      USB_HID_COUNTRY_US, // Set country code (US = 33)
-                      1,                  // Set number of descriptors (at least 1)
-                      HID_Descriptor_Info // Set descriptor information
+/* Composite keyboard, mouse and telemetry device */
+#include "USBCOMP.h"
+#include "isrtrace.h"
 
-};
+#define TASKSTACKSIZE   512
 
+/* Stream counters are sent every STATS_PERIOD test reports */
+#define STATS_PERIOD    1000
 
 Task_Struct task0Struct;
 Char task0Stack[TASKSTACKSIZE];
 
+Task_Struct task1Struct;
+Char task1Stack[TASKSTACKSIZE];
+
+/* Set by the host with USBCOMP_CMD_STREAM */
+volatile bool streaming = false;
+
 /*
  *  ======== heartBeatFxn ========
  *  Toggle the Board_LED0. The Task_sleep is determined by arg0 which
@@ -102,7 +94,83 @@ Void heartBeatFxn(UArg arg0, UArg arg1)
     }
 }
 
-void HID_Setup(void) {
+/*
+ *  ======== commandFxn ========
+ *  Handles reports from the host on the telemetry interface. Runs in the
+ *  USB interrupt.
+ */
+Void commandFxn(const uint8_t *data, unsigned int length)
+{
+    if (length == 0) {
+        return;
+    }
+
+    switch (data[0]) {
+        case USBCOMP_CMD_STREAM:
+            streaming = (length > 1) && (data[1] != 0);
+            break;
+
+        default:
+            break;
+    }
+}
+
+/*
+ *  ======== telemFxn ========
+ *  While the host has streaming on, keeps the telemetry queue full of test
+ *  reports carrying a running word counter, so the host can check the rate
+ *  and spot lost reports. Every STATS_PERIOD reports it also sends the
+ *  link counters.
+ */
+Void telemFxn(UArg arg0, UArg arg1)
+{
+    uint32_t words[USBCOMP_TELEM_MAX_DATA / sizeof(uint32_t)];
+    uint32_t counter = 0;
+    uint32_t reports = 0;
+    USBCOMP_Stats stats;
+    unsigned int i;
+
+    while (1) {
+        USBCOMP_waitForConnect(BIOS_WAIT_FOREVER);
+
+        if (!streaming) {
+            Task_sleep(10);
+            continue;
+        }
+
+        for (i = 0; i < sizeof(words) / sizeof(words[0]); i++) {
+            words[i] = counter + i;
+        }
+
+        /* The queue is full, the host takes one report per ms */
+        if (!USBCOMP_telemSend(USBCOMP_TELEM_TEST, words, sizeof(words))) {
+            Task_sleep(1);
+            continue;
+        }
+        counter += sizeof(words) / sizeof(words[0]);
+
+        if (++reports == STATS_PERIOD) {
+            reports = 0;
+            USBCOMP_getStats(&stats);
+            USBCOMP_telemSend(USBCOMP_TELEM_STATS, &stats, sizeof(stats));
+        }
+    }
+}
+
+/*
+ *  ======== HID_Setup ========
+ *  Starts the composite USB device and the telemetry task.
+ */
+void HID_Setup(void)
+{
+    Task_Params taskParams;
+
+    USBCOMP_init(commandFxn);
+
+    Task_Params_init(&taskParams);
+    taskParams.stackSize = TASKSTACKSIZE;
+    taskParams.stack = &task1Stack;
+    Task_construct(&task1Struct, (Task_FuncPtr)telemFxn, &taskParams, NULL);
 }
 
 /*
@@ -111,9 +179,15 @@ void HID_Setup(void) {
 int main(void)
 {
     Task_Params taskParams;
+    Types_FreqHz cpuFreq;
 
     /* Call board init functions */
     Board_initGeneral();
+
+    /* Trace the USB Hwi against the cycle counter, see common/isrtrace.h */
+    BIOS_getCpuFreq(&cpuFreq);
+    ISRTraceInit(cpuFreq.lo);
+
     Board_initGPIO();
     // Board_initI2C();
     // Board_initSDSPI();
@@ -139,6 +213,8 @@ int main(void)
     /* Setup pins for USB operation */
     GPIOPinTypeUSBAnalog(GPIO_PORTD_BASE, GPIO_PIN_4 | GPIO_PIN_5);
 
+    HID_Setup();
+
     /* Start BIOS */
     BIOS_start();
 
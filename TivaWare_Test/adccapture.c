@@ -0,0 +1,126 @@
+/* adccapture.c
+ *
+ * Written for the EK-TM4C123GXL
+ *
+ * Timer1 triggers ADC0 sequencer 0 directly (ADC_TRIGGER_TIMER), so there is
+ * no timer interrupt and no ADCProcessorTrigger call per sample. The sequencer
+ * FIFO is emptied by uDMA channel 14 in ping-pong mode: while one buffer is
+ * being filled the other one is handed to the main loop. On the TM4C123 the
+ * sequencer interrupt is raised by the uDMA done signal, so the CPU only sees
+ * one interrupt per ADC_CAPTURE_BUFFER_SIZE samples.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "inc/hw_adc.h"
+#include "inc/hw_memmap.h"
+#include "inc/hw_ints.h"
+#include "driverlib/adc.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/timer.h"
+#include "driverlib/udma.h"
+
+#include "adccapture.h"
+#include "dma.h"
+
+// Ping (0) and pong (1) sample buffers
+static uint16_t g_pui16ADCCaptureBuffer[2][ADC_CAPTURE_BUFFER_SIZE];
+
+// Buffers filled by uDMA and buffers released by the main loop. The ping and
+// pong halves always complete in turn, see pingpong.h.
+tPingPong g_sADCCapture;
+
+// Re-arm one half of the ping-pong transfer
+static void ADCCaptureArm(uint32_t ui32Half) {
+    uDMAChannelTransferSet(UDMA_CHANNEL_ADC0 | (ui32Half ? UDMA_ALT_SELECT : UDMA_PRI_SELECT),
+                           UDMA_MODE_PINGPONG,
+                           (void *)(ADC0_BASE + ADC_O_SSFIFO0),
+                           g_pui16ADCCaptureBuffer[ui32Half],
+                           ADC_CAPTURE_BUFFER_SIZE);
+}
+
+void ADCCaptureIntHandler(void) {
+    uint32_t ui32Half;
+
+    ADCIntClear(ADC0_BASE, 0);
+
+    // Service both halves in the order they complete in case the interrupt
+    // was held off for longer than one buffer period
+    while(1) {
+        ui32Half = PingPongNextFill(&g_sADCCapture);
+        if (uDMAChannelModeGet(UDMA_CHANNEL_ADC0 |
+                               (ui32Half ? UDMA_ALT_SELECT : UDMA_PRI_SELECT)) != UDMA_MODE_STOP) {
+            break;
+        }
+
+        // This half is done, the other one is already running
+        ADCCaptureArm(ui32Half);
+        PingPongFilled(&g_sADCCapture);
+    }
+}
+
+uint16_t *ADCCaptureBufferGet(void) {
+    uint32_t ui32Half;
+
+    if (!PingPongGet(&g_sADCCapture, &ui32Half)) {
+        return 0;
+    }
+    return g_pui16ADCCaptureBuffer[ui32Half];
+}
+
+void ADCCaptureBufferRelease(void) {
+    PingPongRelease(&g_sADCCapture);
+}
+
+void ADCCaptureInit(uint32_t ui32SampleRate) {
+    // Initialize ADC0 Module
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_ADC0);
+    while(!SysCtlPeripheralReady(SYSCTL_PERIPH_ADC0)) {
+    }
+
+    // Enable Timer1
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER1);
+    while(!SysCtlPeripheralReady(SYSCTL_PERIPH_TIMER1)) {
+    }
+
+    DMAInit();
+
+    ADCSequenceDisable(ADC0_BASE, 0);
+
+    // Trigger from the timer, one conversion per timeout
+    ADCSequenceConfigure(ADC0_BASE, 0, ADC_TRIGGER_TIMER, 0);
+    ADCSequenceStepConfigure(ADC0_BASE, 0, 0, ADC_CTL_CH3 | ADC_CTL_IE | ADC_CTL_END);
+
+    // Oversampling divides the conversion rate, so it has to be off to
+    // reach 1 Msps
+    ADCHardwareOversampleConfigure(ADC0_BASE, 0);
+
+    // Set up the ping-pong transfer from the sequencer FIFO
+    uDMAChannelAttributeDisable(UDMA_CHANNEL_ADC0, UDMA_ATTR_ALTSELECT |
+                                UDMA_ATTR_HIGH_PRIORITY | UDMA_ATTR_REQMASK);
+    uDMAChannelAttributeEnable(UDMA_CHANNEL_ADC0, UDMA_ATTR_USEBURST);
+    uDMAChannelControlSet(UDMA_CHANNEL_ADC0 | UDMA_PRI_SELECT,
+                          UDMA_SIZE_16 | UDMA_SRC_INC_NONE | UDMA_DST_INC_16 | UDMA_ARB_1);
+    uDMAChannelControlSet(UDMA_CHANNEL_ADC0 | UDMA_ALT_SELECT,
+                          UDMA_SIZE_16 | UDMA_SRC_INC_NONE | UDMA_DST_INC_16 | UDMA_ARB_1);
+
+    PingPongInit(&g_sADCCapture);
+    ADCCaptureArm(0);
+    ADCCaptureArm(1);
+    uDMAChannelEnable(UDMA_CHANNEL_ADC0);
+
+    ADCSequenceDMAEnable(ADC0_BASE, 0);
+    ADCSequenceEnable(ADC0_BASE, 0);
+
+    ADCIntClear(ADC0_BASE, 0);
+    ADCIntEnable(ADC0_BASE, 0);
+    ADCIntRegister(ADC0_BASE, 0, &ADCCaptureIntHandler);
+
+    // Full width periodic timer with its timeout routed to the ADC
+    TimerClockSourceSet(TIMER1_BASE, TIMER_CLOCK_SYSTEM);
+    TimerConfigure(TIMER1_BASE, TIMER_CFG_PERIODIC);
+    TimerLoadSet(TIMER1_BASE, TIMER_A, (SysCtlClockGet() / ui32SampleRate) - 1);
+    TimerControlTrigger(TIMER1_BASE, TIMER_A, true);
+    TimerEnable(TIMER1_BASE, TIMER_A);
+}
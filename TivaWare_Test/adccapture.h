@@ -0,0 +1,42 @@
+/* adccapture.h
+ *
+ * Timer-triggered ADC0 capture into uDMA ping-pong buffers.
+ */
+
+#ifndef ADCCAPTURE_H_
+#define ADCCAPTURE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "pingpong.h"
+
+// Number of samples in each of the ping and pong buffers
+#define ADC_CAPTURE_BUFFER_SIZE     256
+
+// Default sample rate in samples per second
+#define ADC_CAPTURE_RATE            1000000
+
+// Buffers filled and consumed. ui32Overruns counts the full buffers that
+// were overwritten before they were consumed.
+extern tPingPong g_sADCCapture;
+
+// Set up Timer1 to trigger ADC0 sequencer 0 at ui32SampleRate and let uDMA
+// move every conversion into the ping/pong buffers. The CPU is only
+// interrupted once per full buffer.
+extern void ADCCaptureInit(uint32_t ui32SampleRate);
+
+// ADC0 sequencer 0 interrupt handler for capture mode
+extern void ADCCaptureIntHandler(void);
+
+// Return the newest full buffer, or 0 if none is ready. An older full
+// buffer that was never consumed is already being overwritten, so it is
+// skipped and counted in g_sADCCapture.ui32Overruns. The buffer belongs to
+// the caller until ADCCaptureBufferRelease is called, which must happen
+// within one buffer period or the data is overwritten.
+extern uint16_t *ADCCaptureBufferGet(void);
+
+// Hand the buffer returned by ADCCaptureBufferGet back to the capture path
+extern void ADCCaptureBufferRelease(void);
+
+#endif /* ADCCAPTURE_H_ */
@@ -0,0 +1,42 @@
+/* dma.c
+ *
+ * Written for the EK-TM4C123GXL
+ *
+ * Owns the uDMA channel control table so that the ADC capture path and
+ * any other uDMA user in this project share a single controller setup.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "driverlib/sysctl.h"
+#include "driverlib/udma.h"
+
+#include "dma.h"
+
+// The control table has to be aligned on a 1024 byte boundary
+#if defined(ccs)
+#pragma DATA_ALIGN(g_pui8DMAControlTable, 1024)
+uint8_t g_pui8DMAControlTable[1024];
+#else
+uint8_t g_pui8DMAControlTable[1024] __attribute__ ((aligned(1024)));
+#endif
+
+// Set once the controller has been enabled
+static bool g_bDMAReady = false;
+
+void DMAInit(void) {
+    if (g_bDMAReady) {
+        return;
+    }
+
+    // Enable the uDMA peripheral
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_UDMA);
+    while(!SysCtlPeripheralReady(SYSCTL_PERIPH_UDMA)) {
+    }
+
+    // Turn on the controller and give it the channel control table
+    uDMAEnable();
+    uDMAControlBaseSet(g_pui8DMAControlTable);
+
+    g_bDMAReady = true;
+}
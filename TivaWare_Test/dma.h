@@ -0,0 +1,18 @@
+/* dma.h
+ *
+ * Shared uDMA controller setup for the TivaWare_Test project.
+ */
+
+#ifndef DMA_H_
+#define DMA_H_
+
+#include <stdint.h>
+
+// uDMA channel control table, must be 1024 byte aligned
+extern uint8_t g_pui8DMAControlTable[1024];
+
+// Enable the uDMA controller and point it at the control table.
+// Safe to call from every module that uses a uDMA channel.
+extern void DMAInit(void);
+
+#endif /* DMA_H_ */
@@ -0,0 +1,70 @@
+/* fixedpoint.h
+ *
+ * Q15 fixed-point helpers for the ADC -> PWM signal path.
+ *
+ * Values are held in 32 bits with 15 fraction bits, so gains above 1.0
+ * (like the 2.5 used for the PWM duty) fit without losing resolution.
+ * Everything here is integer math, safe to use inside an ISR without
+ * touching the FPU or the double precision runtime.
+ */
+
+#ifndef FIXEDPOINT_H_
+#define FIXEDPOINT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef int32_t q15_t;
+
+#define Q15_SHIFT               15
+#define Q15_ONE                 ((q15_t)1 << Q15_SHIFT)
+
+// Convert a constant to Q15. Only use this with constants so the compiler
+// folds the floating point math at build time.
+#define Q15(x)                  ((q15_t)((x) * Q15_ONE + (((x) >= 0) ? 0.5 : -0.5)))
+
+// Offset, gain and output limit for a sign/magnitude mapping
+typedef struct {
+    int32_t i32Offset;          // Subtracted from the input before scaling
+    q15_t q15Gain;              // Gain applied to the magnitude
+    uint32_t ui32Max;           // Output saturates at this value
+} tQ15Scale;
+
+// Multiply a value by a Q15 gain, saturating to the int32_t range.
+// The result is truncated toward zero, like a float to int cast.
+static inline int32_t Q15SatMul(int32_t i32Value, q15_t q15Gain) {
+    int64_t i64Product = (int64_t)i32Value * q15Gain;
+
+    if (i64Product < 0) {
+        i64Product = -((-i64Product) >> Q15_SHIFT);
+    } else {
+        i64Product >>= Q15_SHIFT;
+    }
+
+    if (i64Product > INT32_MAX) {
+        return INT32_MAX;
+    }
+    if (i64Product < INT32_MIN) {
+        return INT32_MIN;
+    }
+    return (int32_t)i64Product;
+}
+
+// Apply psScale to i32Input and return the magnitude of the result, clamped
+// to psScale->ui32Max. *pbNegative is set when the result was negative.
+static inline uint32_t Q15ScaleMagnitude(const tQ15Scale *psScale, int32_t i32Input,
+                                         bool *pbNegative) {
+    int32_t i32Scaled = Q15SatMul(i32Input - psScale->i32Offset, psScale->q15Gain);
+    uint32_t ui32Magnitude;
+
+    // Negate as unsigned so INT32_MIN does not overflow
+    *pbNegative = (i32Scaled < 0);
+    ui32Magnitude = *pbNegative ? 0u - (uint32_t)i32Scaled : (uint32_t)i32Scaled;
+
+    if (ui32Magnitude > psScale->ui32Max) {
+        return psScale->ui32Max;
+    }
+    return ui32Magnitude;
+}
+
+#endif /* FIXEDPOINT_H_ */
@@ -5,6 +5,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "inc/hw_can.h"
 #include "inc/hw_memmap.h"
@@ -20,16 +21,121 @@
 #include "driverlib/ssi.h"
 #include "driverlib/systick.h"
 #include "driverlib/timer.h"
+#include "driverlib/uart.h"
+#include "driverlib/udma.h"
+
+#include "adccapture.h"
+#include "fixedpoint.h"
+#include "mcp3202.h"
+#include "canframe.h"
+#include "ringbuf.h"
+#include "canbittiming.h"
+#include "candispatch.h"
+#include "usbstream.h"
+#include "dma.h"
+#include "uartlink.h"
+#include "isrtrace.h"
+#include "pcprof.h"
+#include "ramfunc.h"
+
+// Set to 1 to let Timer1 trigger ADC0 directly and move the samples with uDMA
+// (see adccapture.c). Set to 0 for one processor trigger per timer interrupt.
+#define ADC_CAPTURE_DMA         0
+
+// Set to 1 to stream the ADC0 and MCP3202 samples to a host over USB as a
+// virtual serial port (see usbstream.c, capture with tools/cdcstream.py)
+#define USB_STREAM              0
+
+// Capture rate while streaming. 1 MS/s of 16 bit samples is 2 MB/s, more
+// than full-speed USB carries, 400 kS/s leaves headroom below ~1.2 MB/s.
+#define USB_STREAM_ADC_RATE     400000
+
+// Samples per USB block in timer mode and for the MCP3202
+#define USB_STREAM_BLOCK_SIZE   64
+
+// Set to 1 to echo COBS/CRC framed messages on UART0, the ICDI virtual
+// serial port (see common/uartlink.c, benchmark with tools/uartframe.py).
+// Set to 2 to stream the interrupt trace there instead (common/isrtrace.h,
+// decode with tools/isrtrace.py), or 3 to send the PC profile about once a
+// second.
+#define UART_LINK               0
+#define UART_LINK_BAUD          1000000
+
+// Set to 1 to sample the interrupted PC from SysTick into a histogram (see
+// common/pcprof.h). Read g_sPCProf with the debugger or send it with
+// UART_LINK 3, then make a flat profile with tools/pcprof.py. The rate is
+// prime so it does not lock onto the timer or ADC interrupts.
+#define PC_PROFILE              0
+#define PC_PROFILE_RATE         997
+
+#if UART_LINK == 3 && !PC_PROFILE
+#error "UART_LINK 3 sends the PC profile, set PC_PROFILE too"
+#endif
+
+#if USB_STREAM && ADC_CAPTURE_DMA
+#define ADC_RATE                USB_STREAM_ADC_RATE
+#else
+#define ADC_RATE                ADC_CAPTURE_RATE
+#endif
+
+// Number of full capture buffers between LED/CAN updates in capture mode
+#define ADC_CAPTURE_LED_BUFFERS (ADC_RATE / ADC_CAPTURE_BUFFER_SIZE / 2)
+
+// Depth of the ISR -> main loop queues, must be powers of two
+#define ADC_SAMPLE_QUEUE_SIZE   16
+#define CAN_RX_QUEUE_SIZE       8
+
+// System clock set up in main() and the CAN0 bit timing derived from it.
+// The sample point is in tenths of a percent.
+#define SYSCLK_HZ               80000000
+#define CAN0_BITRATE            1000000
+#define CAN0_SAMPLE_POINT       875
+
+CAN_BIT_TIMING_CHECK(SYSCLK_HZ, CAN0_BITRATE, CAN0_SAMPLE_POINT);
+static const tCANBitClkParms g_sCAN0BitClk =
+    CAN_BIT_TIMING(SYSCLK_HZ, CAN0_BITRATE, CAN0_SAMPLE_POINT);
 
 tCANMsgObject sMsgObjectRx; // Receive  CAN message settings
 tCANMsgObject sMsgObjectTx; // Transmit CAN message settings
 uint8_t ui8CANMsgData;      // CAN message data
+uint8_t g_pui8CANRxData[8]; // Last received CAN message data
 
 uint32_t g_i32Value;        // Value from the ADC
 uint32_t g_ui32PWMValue;    // Value to PWM Generator
 uint32_t g_ui32SPIData;     // Vale from SPI ADC
 bool state = false;         // State of the ADC waveform pin
 
+// ADC readings from getADC and frames from CANISR, handled in main()
+static uint16_t g_pui16ADCSamples[ADC_SAMPLE_QUEUE_SIZE];
+static tRingBuf g_sADCSampleRing;
+static tCANFrame g_psCANRxFrames[CAN_RX_QUEUE_SIZE];
+static tRingBuf g_sCANRxRing;
+uint32_t g_ui32ADCSampleDrops;  // Readings lost because main() fell behind
+uint32_t g_ui32CANRxDrops;      // Frames lost because main() fell behind
+
+// Set by timerISR when it is time for the LED/CAN update
+volatile bool g_bLEDUpdate = false;
+
+#if USB_STREAM
+// Samples collected into blocks for usbstream
+typedef struct {
+    uint8_t ui8Source;
+    uint32_t ui32Count;
+    uint16_t pui16Samples[USB_STREAM_BLOCK_SIZE];
+} tSampleBlock;
+
+static tSampleBlock g_sADCBlock = { USB_STREAM_SRC_ADC0 };
+static tSampleBlock g_sSPIBlock = { USB_STREAM_SRC_MCP3202 };
+
+static void blockAdd(tSampleBlock *psBlock, uint16_t ui16Sample) {
+    psBlock->pui16Samples[psBlock->ui32Count++] = ui16Sample;
+    if (psBlock->ui32Count == USB_STREAM_BLOCK_SIZE) {
+        USBStreamBlock(psBlock->ui8Source, psBlock->pui16Samples, USB_STREAM_BLOCK_SIZE);
+        psBlock->ui32Count = 0;
+    }
+}
+#endif
+
 void setPins(void) {
     // Initialize PE0 as ADC input
     SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOE);
@@ -58,31 +164,61 @@ void setPins(void) {
     GPIOPinConfigure(GPIO_PE4_CAN0RX);
     GPIOPinConfigure(GPIO_PE5_CAN0TX);
     GPIOPinTypeCAN(GPIO_PORTE_BASE, GPIO_PIN_4 | GPIO_PIN_5);
+
+#if UART_LINK
+    // Initialize PA0 and PA1 as U0RX and U0TX
+    GPIOPinConfigure(GPIO_PA0_U0RX);
+    GPIOPinConfigure(GPIO_PA1_U0TX);
+    GPIOPinTypeUART(GPIO_PORTA_BASE, GPIO_PIN_0 | GPIO_PIN_1);
+#endif
+
+#if USB_STREAM
+    // Initialize PD4 and PD5 as USB0DM and USB0DP
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOD);
+    GPIOPinTypeUSBAnalog(GPIO_PORTD_BASE, GPIO_PIN_4 | GPIO_PIN_5);
+#endif
 }
 
-void getADC(void) {
+// ADC reading to PWM duty: |reading - 2048| * 2.5, limited to the 5120 period
+static const tQ15Scale g_sPWMScale = { 2048, Q15(2.5), 5120 };
+
+// Drive the PWM duty and direction pin from one ADC reading
+void updatePWM(uint32_t ui32Sample) {
+    bool bNegative;
+
+    g_i32Value = ui32Sample - 2048;
+    g_ui32PWMValue = Q15ScaleMagnitude(&g_sPWMScale, (int32_t)ui32Sample, &bNegative);
+    PWMPulseWidthSet(PWM0_BASE, PWM_GEN_0, g_ui32PWMValue);
+    GPIOPinWrite(GPIO_PORTB_BASE, GPIO_PIN_5, bNegative ? GPIO_PIN_5 : 0);
+}
+
+RAMFUNC void getADC(void) {
+    uint32_t ui32Sample;
+    uint16_t *pui16Slot;
+
+    ISRTRACE_ENTER(ISRTRACE_ID_ADC);
+
     // Clear ADC0SS0 interrupt
     ADCIntClear(ADC0_BASE, 0);
     // Reset P? to measure ADC frequency
     GPIOPinWrite(GPIO_PORTB_BASE, GPIO_PIN_1, 0);
     // Retrieve the reading
-    ADCSequenceDataGet(ADC0_BASE, 0, &g_i32Value);
+    ADCSequenceDataGet(ADC0_BASE, 0, &ui32Sample);
 
-    g_i32Value -= 2048;
-    if ((int) g_i32Value < 0) {
-        GPIOPinWrite(GPIO_PORTB_BASE, GPIO_PIN_5, GPIO_PIN_5);
-        g_ui32PWMValue = (int) g_i32Value*(-2.5);
-        PWMPulseWidthSet(PWM0_BASE, PWM_GEN_0, g_ui32PWMValue);
+    // The PWM is updated from main(). Write the queue slot in place rather
+    // than through RingBufPush, which would call memcpy in flash.
+    pui16Slot = RingBufWritePtr(&g_sADCSampleRing);
+    if (pui16Slot == 0) {
+        g_ui32ADCSampleDrops++;
     } else {
-        g_ui32PWMValue = g_i32Value*2.5;
-        PWMPulseWidthSet(PWM0_BASE, PWM_GEN_0, g_ui32PWMValue);
-        GPIOPinWrite(GPIO_PORTB_BASE, GPIO_PIN_5, 0);
+        *pui16Slot = ui32Sample;
+        RingBufCommit(&g_sADCSampleRing);
     }
 
-    SSIDataPut(SSI0_BASE, 0xD000);
-    while(SSIBusy(SSI0_BASE)) ;
-    SSIDataGet(SSI0_BASE, &g_ui32SPIData);
-    g_ui32SPIData &= 0x0FFF;
+    // Kick off the external ADC, the result is queued by MCP3202IntHandler
+    MCP3202StartConversion();
+
+    ISRTRACE_EXIT(ISRTRACE_ID_ADC);
 }
 
 void setADC(void) {
@@ -118,7 +254,7 @@ void setADC(void) {
     ADCIntRegister(ADC0_BASE, 0, &getADC);
 }
 
-void startADC(void) {
+RAMFUNC void startADC(void) {
     // Set PB1 to measure ADC frequency
     GPIOPinWrite(GPIO_PORTB_BASE, GPIO_PIN_1, GPIO_PIN_1);
     // Start the ADC in one-shot mode
@@ -142,19 +278,25 @@ void writeLED(void) {
     GPIOPinWrite(GPIO_PORTB_BASE, GPIO_PIN_0, led);
 }
 int count;
-void timerISR(void) {
+RAMFUNC void timerISR(void) {
+    ISRTRACE_ENTER(ISRTRACE_ID_TIMER);
     TimerIntClear(TIMER1_BASE, TIMER_TIMA_TIMEOUT);
     startADC();
     count++;
     if (count > 500) {
         count = 0;
-        writeLED();
-        sendCAN();
+        // Let main() do the LED write and CAN transmit
+        g_bLEDUpdate = true;
     }
+    ISRTRACE_EXIT(ISRTRACE_ID_TIMER);
 }
 
 void CANISR(void) {
     uint32_t ui32Status;
+    tCANMsgObject sMsg;
+    tCANFrame *psFrame;
+
+    ISRTRACE_ENTER(ISRTRACE_ID_CAN);
 
     //
     // Read the CAN interrupt status to find the cause of the interrupt
@@ -167,17 +309,50 @@ void CANISR(void) {
         ui32Status = CANStatusGet(CAN0_BASE, CAN_STS_CONTROL);
         break;
     case 1: // Message object 1 received message
-        // Clear interrupt
-        CANIntClear(CAN0_BASE, 1);
-
-        // Read in message (don't normally do this in ISR)
-        CANMessageSet(CAN0_BASE, 1, &sMsgObjectRx, MSG_OBJ_TYPE_RX);
+        psFrame = RingBufWritePtr(&g_sCANRxRing);
+        if (psFrame == 0) {
+            // No room, just clear the interrupt
+            CANIntClear(CAN0_BASE, 1);
+            g_ui32CANRxDrops++;
+            break;
+        }
+
+        // Copy the message into the queue, this also clears the interrupt.
+        // It is handled in main().
+        sMsg.pui8MsgData = psFrame->pui8Data;
+        CANMessageGet(CAN0_BASE, 1, &sMsg, true);
+        psFrame->ui32ID = sMsg.ui32MsgID;
+        psFrame->ui32Len = sMsg.ui32MsgLen;
+        RingBufCommit(&g_sCANRxRing);
         break;
     default:
         break;
     }
+
+    ISRTRACE_EXIT(ISRTRACE_ID_CAN);
+}
+
+#if UART_LINK
+void setUARTLink(void) {
+    static const tUARTLinkHW sUART0 = UARTLINK_UART0;
+
+    // Receive and transmit run on uDMA channels 8 and 9
+    DMAInit();
+    UARTIntRegister(UART0_BASE, UARTLinkIntHandler);
+    UARTLinkInit(&sUART0, SYSCLK_HZ, UART_LINK_BAUD);
+}
+
+// Hand one byte of the interrupt trace or PC profile to the UART queue
+static bool uartPut(uint8_t ui8Byte) {
+    return UARTLinkWrite(&ui8Byte, 1) == 1;
 }
 
+#if UART_LINK == 3
+// Sample count at which the next profile dump is due
+static uint32_t g_ui32ProfileDumpAt = 0;
+#endif
+#endif
+
 void setTimer(void) {
     // Enable Timer1
     SysCtlPeripheralEnable(SYSCTL_PERIPH_TIMER1);
@@ -221,25 +396,9 @@ void setPWM(void) {
     PWMGenEnable(PWM0_BASE, PWM_GEN_0);
 }
 
-void setSSI(void) {
-    // Enable peripheral
-    SysCtlPeripheralEnable(SYSCTL_PERIPH_SSI0);
-
-    // Set clock to system clock
-    SSIClockSourceSet(SSI0_BASE, SSI_CLOCK_SYSTEM);
-
-    /*  Configure SSI:
-     *  Clock speed -> System clock
-     *  Mode -> polarity 0, phase 0
-     *
-     */
-    SSIConfigSetExpClk(SSI0_BASE, SysCtlClockGet(), SSI_FRF_MOTO_MODE_0, SSI_MODE_MASTER, 500000, 16);
-    SSIEnable(SSI0_BASE);
-
-    // Initialize MCP3202
-    SSIDataPut(SSI0_BASE, 0xD000);
-    while(SSIBusy(SSI0_BASE)) ;
-    SSIDataGet(SSI0_BASE, &g_ui32SPIData);
+// Keep the data of the latest received CAN message
+static void CANDataHandler(const tCANFrame *psFrame, void *pvArg) {
+    memcpy(g_pui8CANRxData, psFrame->pui8Data, sizeof(g_pui8CANRxData));
 }
 
 void setCAN(void) {
@@ -250,16 +409,22 @@ void setCAN(void) {
     CANInit(CAN0_BASE);
 
     // Configure controller for 1Mbit operation
-    CANBitRateSet(CAN0_BASE, SysCtlClockGet(), 1000000);
+    CANBitTimingSet(CAN0_BASE, (tCANBitClkParms *)&g_sCAN0BitClk);
 
     // Initialize object to accept messages with ID
     sMsgObjectRx.ui32MsgID = (0x400);   // Look for messages with ID     = 1XX_XXXX_XXXX
     sMsgObjectRx.ui32MsgIDMask = 0x7E0; // Filter out messages with mask = 000_0000_0111
     // Filter IDs with mask and enables Rx interrupt
     sMsgObjectRx.ui32Flags = MSG_OBJ_USE_ID_FILTER | MSG_OBJ_RX_INT_ENABLE;
+    sMsgObjectRx.ui32MsgLen = sizeof(g_pui8CANRxData);
+    sMsgObjectRx.pui8MsgData = g_pui8CANRxData;
 
     // set up CAN objects with settings in sMsgObjectRx as receive message objects
     CANMessageSet(CAN0_BASE, 1, &sMsgObjectRx, MSG_OBJ_TYPE_RX); // CAN object 1
+
+    // Handle the same IDs in main()
+    CANDispatchInit();
+    CANDispatchRegister(sMsgObjectRx.ui32MsgID, sMsgObjectRx.ui32MsgIDMask, CANDataHandler, 0);
 //    CANMessageSet(CAN0_BASE, 2, &sMsgObjectRx, MSG_OBJ_TYPE_RX); // CAN object 2
 //    CANMessageSet(CAN0_BASE, 3, &sMsgObjectRx, MSG_OBJ_TYPE_RX); // CAN object 3
 
@@ -297,15 +462,123 @@ int main(void) {
     // Set clock speed to 40MHz ?
     SysCtlClockSet(SYSCTL_SYSDIV_2_5|SYSCTL_USE_PLL|SYSCTL_OSC_MAIN|SYSCTL_XTAL_16MHZ);
 
+    // Trace the interrupt handlers against the cycle counter
+    ISRTraceInit(SYSCLK_HZ);
+
+    RingBufInit(&g_sADCSampleRing, g_pui16ADCSamples, sizeof(uint16_t), ADC_SAMPLE_QUEUE_SIZE);
+    RingBufInit(&g_sCANRxRing, g_psCANRxFrames, sizeof(tCANFrame), CAN_RX_QUEUE_SIZE);
+
     setPins();
     led = (GPIOPinRead(GPIO_PORTB_BASE, GPIO_PIN_2)) >> 2;
+#if ADC_CAPTURE_DMA
+    ADCCaptureInit(ADC_RATE);
+#else
     setADC();
+#endif
     setPWM();
+#if !ADC_CAPTURE_DMA
     setTimer();
-    setSSI();
+#endif
+    MCP3202Init(SysCtlClockGet());
     setCAN();
+#if USB_STREAM
+    USBStreamInit();
+#endif
+#if UART_LINK
+    setUARTLink();
+#endif
+#if PC_PROFILE
+    // SysTick cannot preempt handlers at its own priority 0, so move them
+    // down. Samples inside them would otherwise wait for them to return.
+    IntPrioritySet(INT_TIMER1A, 0x20);
+    IntPrioritySet(INT_ADC0SS0, 0x20);
+    IntPrioritySet(INT_SSI0, 0x20);
+    IntPrioritySet(INT_CAN0, 0x20);
+    IntPrioritySet(INT_UART0, 0x20);
+    IntPrioritySet(INT_USB0, 0x20);
+    SysTickIntRegister(PCProfIntHandler);
+    PCProfInit(SYSCLK_HZ, PC_PROFILE_RATE);
+#endif
     IntMasterEnable();
     while(1) {
-
+        uint16_t ui16SPISample;
+        uint16_t ui16Sample;
+        tCANFrame sFrame;
+#if ADC_CAPTURE_DMA
+        uint16_t *pui16Buffer;
+#endif
+
+        // Keep the latest external ADC reading
+        while(MCP3202SampleGet(&ui16SPISample)) {
+            g_ui32SPIData = ui16SPISample;
+#if USB_STREAM
+            blockAdd(&g_sSPIBlock, ui16SPISample);
+#endif
+        }
+
+        // Drive the PWM from every internal ADC reading
+        while(RingBufPop(&g_sADCSampleRing, &ui16Sample)) {
+            updatePWM(ui16Sample);
+#if USB_STREAM
+            blockAdd(&g_sADCBlock, ui16Sample);
+#endif
+        }
+
+#if UART_LINK == 2
+        // Send as much of the interrupt trace as the UART queue takes
+        ISRTraceDrain(uartPut);
+#elif UART_LINK == 3
+        // A dump is 3 KB, ~31 ms at 1 Mbaud, so once a second is plenty
+        if (((int32_t)(g_sPCProf.ui32Samples - g_ui32ProfileDumpAt) >= 0) &&
+            PCProfDump(uartPut)) {
+            g_ui32ProfileDumpAt = g_sPCProf.ui32Samples + PC_PROFILE_RATE;
+        }
+#elif UART_LINK
+        // Send every good frame straight back, waiting for room if needed
+        {
+            const uint8_t *pui8Frame;
+            uint32_t ui32FrameLen;
+
+            if (UARTLinkFrameGet(&pui8Frame, &ui32FrameLen)) {
+                while (!UARTLinkFrameSend(pui8Frame, ui32FrameLen)) {
+                }
+            }
+        }
+#endif
+
+        // Hand received CAN messages to their handlers
+        while(RingBufPop(&g_sCANRxRing, &sFrame)) {
+            CANDispatch(&sFrame);
+        }
+
+        if (g_bLEDUpdate) {
+            g_bLEDUpdate = false;
+            writeLED();
+            sendCAN();
+        }
+
+#if ADC_CAPTURE_DMA
+        pui16Buffer = ADCCaptureBufferGet();
+
+        if (pui16Buffer) {
+            // Follow the newest sample in the block
+            updatePWM(pui16Buffer[ADC_CAPTURE_BUFFER_SIZE - 1]);
+#if USB_STREAM
+            // The whole buffer goes out as one block
+            USBStreamBlock(USB_STREAM_SRC_ADC0, pui16Buffer, ADC_CAPTURE_BUFFER_SIZE);
+#endif
+            ADCCaptureBufferRelease();
+
+            // Sample the external ADC once per block
+            MCP3202StartConversion();
+
+            // Same LED/CAN housekeeping timerISR does every 500 samples
+            count++;
+            if (count > ADC_CAPTURE_LED_BUFFERS) {
+                count = 0;
+                g_bLEDUpdate = true;
+            }
+        }
+#endif
     }
 }
@@ -0,0 +1,123 @@
+/* mcp3202.c
+ *
+ * Written for the EK-TM4C123GXL
+ *
+ * The MCP3202 used to be read by putting the command word and spinning on
+ * SSIBusy inside the ADC interrupt, which at 500 kHz holds that ISR for more
+ * than 30 us per sample. Here the command word is dropped into the TX FIFO
+ * and uDMA channel 10 (SSI0 RX) picks the answer out of the RX FIFO. On the
+ * TM4C123 the uDMA done signal is delivered on the SSI0 interrupt vector, so
+ * MCP3202IntHandler only runs once the result is already in memory.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "inc/hw_memmap.h"
+#include "inc/hw_ints.h"
+#include "inc/hw_ssi.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/ssi.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/udma.h"
+
+#include "mcp3202.h"
+#include "dma.h"
+#include "ringbuf.h"
+#include "ramfunc.h"
+
+// Word the uDMA channel writes the received frame into
+static volatile uint16_t g_ui16MCP3202Rx;
+
+// Set while a conversion is in flight
+static volatile bool g_bMCP3202Active = false;
+
+// Sample queue, written by the ISR and read by the main loop
+static uint16_t g_pui16MCP3202Queue[MCP3202_QUEUE_SIZE];
+static tRingBuf g_sMCP3202Ring;
+
+volatile uint32_t g_ui32MCP3202Overruns = 0;
+volatile uint32_t g_ui32MCP3202Busy = 0;
+
+void MCP3202Init(uint32_t ui32SysClock) {
+    uint32_t ui32Data;
+
+    RingBufInit(&g_sMCP3202Ring, g_pui16MCP3202Queue, sizeof(uint16_t), MCP3202_QUEUE_SIZE);
+
+    // Enable peripheral
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_SSI0);
+
+    // Set clock to system clock
+    SSIClockSourceSet(SSI0_BASE, SSI_CLOCK_SYSTEM);
+
+    // Mode 0, master, 500 kHz, 16 bit frames
+    SSIConfigSetExpClk(SSI0_BASE, ui32SysClock, SSI_FRF_MOTO_MODE_0, SSI_MODE_MASTER, 500000, 16);
+    SSIEnable(SSI0_BASE);
+
+    // Flush anything left in the RX FIFO
+    while(SSIDataGetNonBlocking(SSI0_BASE, &ui32Data)) {
+    }
+
+    // Initialize MCP3202, the first conversion is only done once at start up
+    // so it is fine to wait for it here
+    SSIDataPut(SSI0_BASE, MCP3202_CMD_CH0);
+    while(SSIBusy(SSI0_BASE)) ;
+    SSIDataGet(SSI0_BASE, &ui32Data);
+
+    // One 16 bit word from the data register per conversion
+    DMAInit();
+    uDMAChannelAttributeDisable(UDMA_CHANNEL_SSI0RX, UDMA_ATTR_ALTSELECT | UDMA_ATTR_USEBURST |
+                                UDMA_ATTR_HIGH_PRIORITY | UDMA_ATTR_REQMASK);
+    uDMAChannelControlSet(UDMA_CHANNEL_SSI0RX | UDMA_PRI_SELECT,
+                          UDMA_SIZE_16 | UDMA_SRC_INC_NONE | UDMA_DST_INC_NONE | UDMA_ARB_1);
+    SSIDMAEnable(SSI0_BASE, SSI_DMA_RX);
+
+    // Register the ISR MCP3202IntHandler()
+    SSIIntRegister(SSI0_BASE, MCP3202IntHandler);
+    IntEnable(INT_SSI0);
+}
+
+RAMFUNC bool MCP3202StartConversion(void) {
+    if (g_bMCP3202Active) {
+        g_ui32MCP3202Busy++;
+        return false;
+    }
+    g_bMCP3202Active = true;
+
+    // Arm the receive side first so the answer can't be missed
+    uDMAChannelTransferSet(UDMA_CHANNEL_SSI0RX | UDMA_PRI_SELECT, UDMA_MODE_BASIC,
+                           (void *)(SSI0_BASE + SSI_O_DR), (void *)&g_ui16MCP3202Rx, 1);
+    uDMAChannelEnable(UDMA_CHANNEL_SSI0RX);
+
+    // The TX FIFO is empty whenever no conversion is active
+    SSIDataPutNonBlocking(SSI0_BASE, MCP3202_CMD_CH0);
+    return true;
+}
+
+RAMFUNC void MCP3202IntHandler(void) {
+    uint32_t ui32Status;
+    uint16_t *pui16Slot;
+
+    // Clear whatever SSI sources are pending, the uDMA done signal has no
+    // status bit of its own on this part
+    ui32Status = SSIIntStatus(SSI0_BASE, true);
+    SSIIntClear(SSI0_BASE, ui32Status);
+
+    if (!g_bMCP3202Active ||
+        (uDMAChannelModeGet(UDMA_CHANNEL_SSI0RX | UDMA_PRI_SELECT) != UDMA_MODE_STOP)) {
+        return;
+    }
+
+    pui16Slot = RingBufWritePtr(&g_sMCP3202Ring);
+    if (pui16Slot == 0) {
+        g_ui32MCP3202Overruns++;
+    } else {
+        *pui16Slot = g_ui16MCP3202Rx & 0x0FFF;
+        RingBufCommit(&g_sMCP3202Ring);
+    }
+
+    g_bMCP3202Active = false;
+}
+
+bool MCP3202SampleGet(uint16_t *pui16Sample) {
+    return RingBufPop(&g_sMCP3202Ring, pui16Sample);
+}
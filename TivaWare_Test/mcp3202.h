@@ -0,0 +1,39 @@
+/* mcp3202.h
+ *
+ * Non-blocking MCP3202 reads over SSI0.
+ */
+
+#ifndef MCP3202_H_
+#define MCP3202_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Number of samples the queue can hold, must be a power of two
+#define MCP3202_QUEUE_SIZE      16
+
+// Command word for a single-ended conversion of CH0, MSB first
+#define MCP3202_CMD_CH0         0xD000
+
+// Samples dropped because the queue was full
+extern volatile uint32_t g_ui32MCP3202Overruns;
+
+// Conversions skipped because the previous one had not finished
+extern volatile uint32_t g_ui32MCP3202Busy;
+
+// Set up SSI0 at 500 kHz, 16 bit frames, with the receive side handled by
+// uDMA channel 10. Pins are configured by the caller.
+extern void MCP3202Init(uint32_t ui32SysClock);
+
+// Start a conversion and return immediately. The result is queued by
+// MCP3202IntHandler once the frame has been clocked in. Returns false if a
+// conversion is still in flight.
+extern bool MCP3202StartConversion(void);
+
+// SSI0 interrupt handler, runs when the uDMA receive transfer completes
+extern void MCP3202IntHandler(void);
+
+// Pull the oldest 12-bit sample out of the queue. Returns false if empty.
+extern bool MCP3202SampleGet(uint16_t *pui16Sample);
+
+#endif /* MCP3202_H_ */
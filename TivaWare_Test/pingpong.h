@@ -0,0 +1,68 @@
+/* pingpong.h
+ *
+ * Bookkeeping for two buffers that the hardware fills in turn while the
+ * main loop reads the other one, kept apart from the uDMA calls so it can
+ * be tested on the host.
+ *
+ * The ISR counts every buffer the hardware completes and re-arms it at
+ * once, so it is written again as soon as the other one is complete. The
+ * reader only ever gets the newest full buffer; one older than that is
+ * already being overwritten, so it is skipped and counted as an overrun.
+ * The counts only go up, so the low bit of each is the buffer index.
+ */
+
+#ifndef PINGPONG_H_
+#define PINGPONG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    volatile uint32_t ui32Filled;   // Buffers the hardware has completed
+    volatile uint32_t ui32Consumed; // Buffers released or skipped by the reader
+    volatile uint32_t ui32Overruns; // Full buffers skipped before they were read
+} tPingPong;
+
+static inline void PingPongInit(tPingPong *psPingPong) {
+    psPingPong->ui32Filled = 0;
+    psPingPong->ui32Consumed = 0;
+    psPingPong->ui32Overruns = 0;
+}
+
+// Index of the buffer the hardware completes next. ISR only.
+static inline uint32_t PingPongNextFill(const tPingPong *psPingPong) {
+    return psPingPong->ui32Filled & 1;
+}
+
+// The buffer PingPongNextFill() named is complete. ISR only.
+static inline void PingPongFilled(tPingPong *psPingPong) {
+    psPingPong->ui32Filled++;
+}
+
+// Find the newest full buffer. Returns false if there is none, otherwise
+// sets *pui32Index and skips the older one if it was never read. Main loop
+// only.
+static inline bool PingPongGet(tPingPong *psPingPong, uint32_t *pui32Index) {
+    uint32_t ui32Filled = psPingPong->ui32Filled;
+    uint32_t ui32Waiting = ui32Filled - psPingPong->ui32Consumed;
+
+    if (ui32Waiting == 0) {
+        return false;
+    }
+    if (ui32Waiting > 1) {
+        psPingPong->ui32Overruns += ui32Waiting - 1;
+        psPingPong->ui32Consumed = ui32Filled - 1;
+    }
+
+    *pui32Index = psPingPong->ui32Consumed & 1;
+    return true;
+}
+
+// Hand back the buffer PingPongGet() returned. Main loop only.
+static inline void PingPongRelease(tPingPong *psPingPong) {
+    if (psPingPong->ui32Consumed != psPingPong->ui32Filled) {
+        psPingPong->ui32Consumed++;
+    }
+}
+
+#endif /* PINGPONG_H_ */
@@ -0,0 +1,33 @@
+/* ramfunc.h
+ *
+ * Run selected functions from SRAM.
+ *
+ * At 80 MHz the flash needs wait states and only its prefetch buffer hides
+ * them, so every branch in an interrupt handler can stall. SRAM has none.
+ * RAMFUNC puts a function in .TI.ramfunc, the section the TI compiler's
+ * own ramfunc attribute uses. tm4c123gh6pm.cmd keeps that section's image
+ * in flash and lists it in the BINIT copy table, which the boot code
+ * (_c_int00) copies to SRAM before main(). The driverlib functions the
+ * tagged handlers call are pulled into the same section by name there,
+ * which needs --gen_func_subsections; the inline helpers they use from
+ * common/ are forced inline instead.
+ *
+ * tools/ramfunc.py report lists what ended up in SRAM and any calls from it
+ * that still go to flash. The RAMFunc_Report build configuration, a copy of
+ * Debug, runs it with --strict after every build, so such a call fails the
+ * build; Debug and Release leave it out so they build without python3. To
+ * measure the gain, link once more with --define=RAMFUNC_FLASH, which
+ * leaves the section in flash, capture an interrupt trace from each build
+ * (isrtrace.h) and run tools/ramfunc.py compare on the two.
+ */
+
+#ifndef RAMFUNC_H_
+#define RAMFUNC_H_
+
+#if defined(__TI_COMPILER_VERSION__)
+#define RAMFUNC                 __attribute__((section(".TI.ramfunc")))
+#else
+#define RAMFUNC
+#endif
+
+#endif /* RAMFUNC_H_ */
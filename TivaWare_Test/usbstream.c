@@ -0,0 +1,338 @@
+/* usbstream.c
+ *
+ * Written for the EK-TM4C123GXL
+ *
+ * USB CDC-ACM device that streams sample blocks on its bulk IN endpoint.
+ *
+ * The main loop packs blocks into a queue of 64 byte packets and the USB
+ * interrupt moves them to the endpoint. usblib's CDC class only accepts a
+ * new packet once the last one has gone, so the data endpoint is driven
+ * here instead: its FIFO is set up double buffered and both halves are
+ * kept loaded. The host can then take a packet on every IN token while the
+ * interrupt refills the other half, which is what gets full-speed bulk
+ * close to its 19 packets per frame (about 1.2 MB/s).
+ *
+ * The stream runs while the host has the port open (DTR set). The serial
+ * settings from the host are accepted and ignored.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/usb.h"
+#include "usblib/usblib.h"
+#include "usblib/usbcdc.h"
+#include "usblib/usb-ids.h"
+#include "usblib/device/usbdevice.h"
+#include "usblib/device/usbdcdc.h"
+
+#include "ringbuf.h"
+#include "usbstream.h"
+
+// usbdcdc.c puts the bulk data endpoints of a single CDC device on EP1
+#define USB_STREAM_EP           USB_EP_1
+#define USB_STREAM_PACKET_SIZE  64
+
+// The double buffered IN FIFO goes above the FIFOs usblib hands out from
+// the bottom of the 2 KB FIFO RAM
+#define USB_STREAM_FIFO_ADDR    1024
+
+typedef struct {
+    uint32_t ui32Len;
+    uint8_t pui8Data[USB_STREAM_PACKET_SIZE];
+} tUSBStreamPacket;
+
+static tUSBStreamPacket g_psUSBStreamPackets[USB_STREAM_PACKETS];
+static tRingBuf g_sUSBStreamRing;
+
+// Bytes already in the packet at the write end of the ring, not committed
+static uint32_t g_ui32USBStreamFill = 0;
+
+// Block counters per source
+static uint16_t g_pui16USBStreamSeq[2];
+
+static volatile bool g_bUSBStreamConnected = false;
+static volatile bool g_bUSBStreamOpen = false;
+
+volatile uint32_t g_ui32USBStreamDrops = 0;
+volatile uint32_t g_ui32USBStreamPackets = 0;
+
+static uint32_t USBStreamControlHandler(void *pvCBData, uint32_t ui32Event,
+                                        uint32_t ui32MsgValue, void *pvMsgData);
+static uint32_t USBStreamRxHandler(void *pvCBData, uint32_t ui32Event,
+                                   uint32_t ui32MsgValue, void *pvMsgData);
+static uint32_t USBStreamTxHandler(void *pvCBData, uint32_t ui32Event,
+                                   uint32_t ui32MsgValue, void *pvMsgData);
+
+//*****************************************************************************
+//
+// String descriptors.
+//
+//*****************************************************************************
+static const uint8_t g_pui8LangDescriptor[] =
+{
+    4,
+    USB_DTYPE_STRING,
+    USBShort(USB_LANG_EN_US)
+};
+
+static const uint8_t g_pui8ManufacturerString[] =
+{
+    (17 + 1) * 2,
+    USB_DTYPE_STRING,
+    'T', 0, 'e', 0, 'x', 0, 'a', 0, 's', 0, ' ', 0, 'I', 0, 'n', 0, 's', 0,
+    't', 0, 'r', 0, 'u', 0, 'm', 0, 'e', 0, 'n', 0, 't', 0, 's', 0,
+};
+
+static const uint8_t g_pui8ProductString[] =
+{
+    (10 + 1) * 2,
+    USB_DTYPE_STRING,
+    'A', 0, 'D', 0, 'C', 0, ' ', 0, 'S', 0, 't', 0, 'r', 0, 'e', 0,
+    'a', 0, 'm', 0
+};
+
+static const uint8_t g_pui8SerialNumberString[] =
+{
+    (8 + 1) * 2,
+    USB_DTYPE_STRING,
+    '1', 0, '2', 0, '3', 0, '4', 0, '5', 0, '6', 0, '7', 0, '8', 0
+};
+
+static const uint8_t g_pui8ControlInterfaceString[] =
+{
+    (21 + 1) * 2,
+    USB_DTYPE_STRING,
+    'A', 0, 'C', 0, 'M', 0, ' ', 0, 'C', 0, 'o', 0, 'n', 0, 't', 0,
+    'r', 0, 'o', 0, 'l', 0, ' ', 0, 'I', 0, 'n', 0, 't', 0, 'e', 0,
+    'r', 0, 'f', 0, 'a', 0, 'c', 0, 'e', 0
+};
+
+static const uint8_t g_pui8ConfigString[] =
+{
+    (11 + 1) * 2,
+    USB_DTYPE_STRING,
+    'B', 0, 'u', 0, 's', 0, ' ', 0, 'P', 0, 'o', 0, 'w', 0, 'e', 0,
+    'r', 0, 'e', 0, 'd', 0
+};
+
+static const uint8_t * const g_ppui8StringDescriptors[] =
+{
+    g_pui8LangDescriptor,
+    g_pui8ManufacturerString,
+    g_pui8ProductString,
+    g_pui8SerialNumberString,
+    g_pui8ControlInterfaceString,
+    g_pui8ConfigString
+};
+
+#define NUM_STRING_DESCRIPTORS (sizeof(g_ppui8StringDescriptors) /                \
+                                sizeof(uint8_t *))
+
+static tUSBDCDCDevice g_sUSBStreamDevice =
+{
+    USB_VID_TI_1CBE,
+    USB_PID_SERIAL,
+    0,
+    USB_CONF_ATTR_SELF_PWR,
+    USBStreamControlHandler,
+    (void *)&g_sUSBStreamDevice,
+    USBStreamRxHandler,
+    (void *)&g_sUSBStreamDevice,
+    USBStreamTxHandler,
+    (void *)&g_sUSBStreamDevice,
+    g_ppui8StringDescriptors,
+    NUM_STRING_DESCRIPTORS
+};
+
+// Keep both halves of the IN FIFO loaded. Runs in the USB interrupt or with
+// it masked, and is the only consumer of the packet ring.
+static void USBStreamFill(void) {
+    tUSBStreamPacket *psPacket;
+
+    if (!g_bUSBStreamConnected || !g_bUSBStreamOpen) {
+        return;
+    }
+
+    // With double buffering TXPKTRDY only stays set once both halves are full
+    while (!(USBEndpointStatus(USB0_BASE, USB_STREAM_EP) & USB_DEV_TX_TXPKTRDY)) {
+        psPacket = RingBufReadPtr(&g_sUSBStreamRing);
+        if (psPacket == 0) {
+            break;
+        }
+        USBEndpointDataPut(USB0_BASE, USB_STREAM_EP, psPacket->pui8Data, psPacket->ui32Len);
+        USBEndpointDataSend(USB0_BASE, USB_STREAM_EP, USB_TRANS_IN);
+        RingBufRelease(&g_sUSBStreamRing);
+        g_ui32USBStreamPackets++;
+    }
+}
+
+// Throw away anything queued before the host opened the port
+static void USBStreamDiscard(void) {
+    while (RingBufReadPtr(&g_sUSBStreamRing)) {
+        RingBufRelease(&g_sUSBStreamRing);
+    }
+}
+
+static uint32_t USBStreamControlHandler(void *pvCBData, uint32_t ui32Event,
+                                        uint32_t ui32MsgValue, void *pvMsgData) {
+    tLineCoding *psLineCoding;
+
+    switch (ui32Event) {
+    case USB_EVENT_CONNECTED:
+        // usblib has just set up the endpoint FIFOs for this configuration,
+        // give the data IN endpoint its double buffered FIFO
+        USBFIFOConfigSet(USB0_BASE, USB_STREAM_EP, USB_STREAM_FIFO_ADDR,
+                         USB_FIFO_SZ_64_DB, USB_EP_DEV_IN);
+        USBFIFOFlush(USB0_BASE, USB_STREAM_EP, USB_EP_DEV_IN);
+        g_bUSBStreamConnected = true;
+        break;
+
+    case USB_EVENT_DISCONNECTED:
+        g_bUSBStreamConnected = false;
+        g_bUSBStreamOpen = false;
+        break;
+
+    case USBD_CDC_EVENT_SET_CONTROL_LINE_STATE:
+        // The host sets DTR when it opens the port and clears it on close
+        if ((ui32MsgValue & USB_CDC_ACTIVATE_CARRIER) && !g_bUSBStreamOpen) {
+            USBStreamDiscard();
+            g_bUSBStreamOpen = true;
+            USBStreamFill();
+        }
+        else if (!(ui32MsgValue & USB_CDC_ACTIVATE_CARRIER)) {
+            g_bUSBStreamOpen = false;
+        }
+        break;
+
+    case USBD_CDC_EVENT_GET_LINE_CODING:
+        // Report 115200 8N1, the rate means nothing on USB
+        psLineCoding = pvMsgData;
+        psLineCoding->ui32Rate = 115200;
+        psLineCoding->ui8Databits = 8;
+        psLineCoding->ui8Parity = USB_CDC_PARITY_NONE;
+        psLineCoding->ui8Stop = USB_CDC_STOP_BITS_1;
+        break;
+
+    case USBD_CDC_EVENT_SET_LINE_CODING:
+    case USBD_CDC_EVENT_SEND_BREAK:
+    case USBD_CDC_EVENT_CLEAR_BREAK:
+    case USB_EVENT_SUSPEND:
+    case USB_EVENT_RESUME:
+    default:
+        break;
+    }
+
+    return 0;
+}
+
+// Anything the host writes to the port is read and dropped
+static uint32_t USBStreamRxHandler(void *pvCBData, uint32_t ui32Event,
+                                   uint32_t ui32MsgValue, void *pvMsgData) {
+    uint8_t pui8Discard[USB_STREAM_PACKET_SIZE];
+
+    switch (ui32Event) {
+    case USB_EVENT_RX_AVAILABLE:
+        return USBDCDCPacketRead(pvCBData, pui8Discard, sizeof(pui8Discard), true);
+
+    case USB_EVENT_DATA_REMAINING:
+    default:
+        return 0;
+    }
+}
+
+// Called each time the endpoint has sent a packet, which frees one half of
+// the FIFO
+static uint32_t USBStreamTxHandler(void *pvCBData, uint32_t ui32Event,
+                                   uint32_t ui32MsgValue, void *pvMsgData) {
+    if (ui32Event == USB_EVENT_TX_COMPLETE) {
+        USBStreamFill();
+    }
+
+    return 0;
+}
+
+// Append bytes to the packet queue. Space has already been checked.
+static void USBStreamWrite(const uint8_t *pui8Data, uint32_t ui32Len) {
+    tUSBStreamPacket *psPacket;
+    uint32_t ui32Chunk;
+
+    while (ui32Len) {
+        psPacket = RingBufWritePtr(&g_sUSBStreamRing);
+        ui32Chunk = USB_STREAM_PACKET_SIZE - g_ui32USBStreamFill;
+        if (ui32Chunk > ui32Len) {
+            ui32Chunk = ui32Len;
+        }
+        memcpy(&psPacket->pui8Data[g_ui32USBStreamFill], pui8Data, ui32Chunk);
+        g_ui32USBStreamFill += ui32Chunk;
+        pui8Data += ui32Chunk;
+        ui32Len -= ui32Chunk;
+
+        if (g_ui32USBStreamFill == USB_STREAM_PACKET_SIZE) {
+            psPacket->ui32Len = USB_STREAM_PACKET_SIZE;
+            RingBufCommit(&g_sUSBStreamRing);
+            g_ui32USBStreamFill = 0;
+        }
+    }
+}
+
+bool USBStreamBlock(uint8_t ui8Source, const uint16_t *pui16Samples,
+                    uint32_t ui32Count) {
+    tUSBStreamHeader sHeader;
+    uint32_t ui32Bytes;
+    uint32_t ui32Free;
+
+    if (!USBStreamActive()) {
+        return false;
+    }
+
+    // Room left, counting the part filled packet at the write end
+    ui32Bytes = sizeof(sHeader) + ui32Count * sizeof(uint16_t);
+    ui32Free = (USB_STREAM_PACKETS - RingBufCount(&g_sUSBStreamRing)) *
+               USB_STREAM_PACKET_SIZE - g_ui32USBStreamFill;
+    if (ui32Bytes > ui32Free) {
+        g_ui32USBStreamDrops++;
+        g_pui16USBStreamSeq[ui8Source & 1]++;
+        return false;
+    }
+
+    sHeader.ui16Sync = USB_STREAM_SYNC;
+    sHeader.ui8Source = ui8Source;
+    sHeader.ui8Reserved = 0;
+    sHeader.ui16Count = ui32Count;
+    sHeader.ui16Seq = g_pui16USBStreamSeq[ui8Source & 1]++;
+
+    USBStreamWrite((const uint8_t *)&sHeader, sizeof(sHeader));
+    USBStreamWrite((const uint8_t *)pui16Samples, ui32Count * sizeof(uint16_t));
+
+    // If the endpoint has drained everything, send the tail of this block as
+    // a short packet rather than hold it until the next block. Under load the
+    // queue is never empty here and every packet goes out full.
+    IntDisable(INT_USB0);
+    if (g_ui32USBStreamFill && RingBufCount(&g_sUSBStreamRing) == 0) {
+        ((tUSBStreamPacket *)RingBufWritePtr(&g_sUSBStreamRing))->ui32Len = g_ui32USBStreamFill;
+        RingBufCommit(&g_sUSBStreamRing);
+        g_ui32USBStreamFill = 0;
+    }
+    USBStreamFill();
+    IntEnable(INT_USB0);
+
+    return true;
+}
+
+bool USBStreamActive(void) {
+    return g_bUSBStreamConnected && g_bUSBStreamOpen;
+}
+
+void USBStreamInit(void) {
+    RingBufInit(&g_sUSBStreamRing, g_psUSBStreamPackets, sizeof(tUSBStreamPacket),
+                USB_STREAM_PACKETS);
+
+    USBStackModeSet(0, eUSBModeForceDevice, 0);
+    USBIntRegister(USB0_BASE, USB0DeviceIntHandler);
+    USBDCDCInit(0, &g_sUSBStreamDevice);
+}
@@ -0,0 +1,50 @@
+/* usbstream.h
+ *
+ * Stream ADC sample blocks to a host over a USB CDC-ACM (virtual serial)
+ * bulk IN endpoint.
+ */
+
+#ifndef USBSTREAM_H_
+#define USBSTREAM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// 64 byte packets queued for the USB interrupt, must be a power of two.
+// 64 packets hold about 4 ms of data at the full-speed bulk rate.
+#define USB_STREAM_PACKETS      64
+
+// Every block starts with this header, little-endian like the samples.
+// tools/cdcstream.py resyncs on ui16Sync if the capture starts mid-block.
+#define USB_STREAM_SYNC         0xA55A
+#define USB_STREAM_SRC_ADC0     0
+#define USB_STREAM_SRC_MCP3202  1
+
+typedef struct {
+    uint16_t ui16Sync;          // USB_STREAM_SYNC
+    uint8_t ui8Source;          // USB_STREAM_SRC_
+    uint8_t ui8Reserved;
+    uint16_t ui16Count;         // Number of 16 bit samples after the header
+    uint16_t ui16Seq;           // Counts blocks per source, gaps are drops
+} tUSBStreamHeader;
+
+// Blocks dropped because the packet queue was full
+extern volatile uint32_t g_ui32USBStreamDrops;
+
+// Packets handed to the endpoint
+extern volatile uint32_t g_ui32USBStreamPackets;
+
+// Start the CDC device on USB0 and connect to the bus. The caller sets up
+// the USB pins (D4, D5) and runs the system clock from the PLL.
+extern void USBStreamInit(void);
+
+// True while a host has the serial port open
+extern bool USBStreamActive(void);
+
+// Queue a block of samples. The whole block is queued or, if it does not
+// fit, dropped and counted, so the stream never holds a partial block.
+// Call from the main loop only.
+extern bool USBStreamBlock(uint8_t ui8Source, const uint16_t *pui16Samples,
+                           uint32_t ui32Count);
+
+#endif /* USBSTREAM_H_ */
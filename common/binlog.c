@@ -0,0 +1,103 @@
+/* binlog.c
+ *
+ * Written for the EK-TM4C123GXL
+ *
+ * The reader zeroes each record after copying it and only then moves the
+ * tail on, so a writer never claims words that are still being read, and
+ * a zero word 0 always means a claimed record that is not finished yet.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "binlog.h"
+
+tBinLogBuf g_sBinLog;
+
+// Reader state: stream header still to send, drops already reported
+static bool g_bBinLogHeader;
+static uint32_t g_ui32BinLogReported;
+
+void BinLogInit(void) {
+    uint32_t ui32Index;
+
+    g_sBinLog.ui32Magic = BINLOG_MAGIC;
+    g_sBinLog.ui32Size = BINLOG_WORDS;
+    g_sBinLog.ui32Head = 0;
+    g_sBinLog.ui32Tail = 0;
+    g_sBinLog.ui32Dropped = 0;
+    for (ui32Index = 0; ui32Index < BINLOG_WORDS; ui32Index++) {
+        g_sBinLog.pui32Words[ui32Index] = 0;
+    }
+
+    g_bBinLogHeader = true;
+    g_ui32BinLogReported = 0;
+}
+
+void BinLogDrop(void) {
+#if defined(__TI_COMPILER_VERSION__)
+    uint32_t ui32Dropped;
+
+    do {
+        ui32Dropped = __ldrex((void *)&g_sBinLog.ui32Dropped);
+    } while (__strex(ui32Dropped + 1, (void *)&g_sBinLog.ui32Dropped));
+#else
+    __atomic_fetch_add(&g_sBinLog.ui32Dropped, 1, __ATOMIC_RELAXED);
+#endif
+}
+
+// Store a word little endian
+static uint8_t *BinLogPut(uint8_t *pui8Buf, uint32_t ui32Word) {
+    pui8Buf[0] = (uint8_t)ui32Word;
+    pui8Buf[1] = (uint8_t)(ui32Word >> 8);
+    pui8Buf[2] = (uint8_t)(ui32Word >> 16);
+    pui8Buf[3] = (uint8_t)(ui32Word >> 24);
+    return pui8Buf + 4;
+}
+
+uint32_t BinLogRead(uint8_t *pui8Buf, uint32_t ui32Max) {
+    uint8_t *pui8Out = pui8Buf;
+    uint8_t *pui8End = pui8Buf + ui32Max;
+    uint32_t ui32Tail;
+    uint32_t ui32Word;
+    uint32_t ui32Words;
+    uint32_t ui32Dropped;
+
+    if (g_bBinLogHeader) {
+        pui8Out = BinLogPut(pui8Out, BINLOG_MAGIC);
+        pui8Out = BinLogPut(pui8Out, 0);
+        pui8Out = BinLogPut(pui8Out, 0);
+        pui8Out = BinLogPut(pui8Out, 0);
+        g_bBinLogHeader = false;
+    }
+
+    // Say how many records were lost since the last report
+    ui32Dropped = g_sBinLog.ui32Dropped;
+    if ((ui32Dropped != g_ui32BinLogReported) && (pui8End - pui8Out >= 8)) {
+        pui8Out = BinLogPut(pui8Out, BINLOG_SYNC | (1 << 16) | BINLOG_INDEX_DROPPED);
+        pui8Out = BinLogPut(pui8Out, ui32Dropped - g_ui32BinLogReported);
+        g_ui32BinLogReported = ui32Dropped;
+    }
+
+    ui32Tail = g_sBinLog.ui32Tail;
+    while (ui32Tail != g_sBinLog.ui32Head) {
+        ui32Word = g_sBinLog.pui32Words[ui32Tail & (BINLOG_WORDS - 1)];
+        if (ui32Word == 0) {
+            // Claimed but still being written
+            break;
+        }
+        ui32Words = 1 + ((ui32Word >> 16) & 0xFF);
+        if (pui8End - pui8Out < 4 * ui32Words) {
+            break;
+        }
+
+        while (ui32Words--) {
+            pui8Out = BinLogPut(pui8Out, g_sBinLog.pui32Words[ui32Tail & (BINLOG_WORDS - 1)]);
+            g_sBinLog.pui32Words[ui32Tail & (BINLOG_WORDS - 1)] = 0;
+            ui32Tail++;
+        }
+        g_sBinLog.ui32Tail = ui32Tail;
+    }
+
+    return pui8Out - pui8Buf;
+}
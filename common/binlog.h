@@ -0,0 +1,162 @@
+/* binlog.h
+ *
+ * Binary logging with the formatting done on the host.
+ *
+ *   BINLOG1("Sent %d bytes\n", ui32Count);
+ *
+ * puts the format string in the .binlog section and writes only its
+ * address and the raw arguments to a RAM ring, one 32 bit word each:
+ *
+ *   word 0     0xB0 << 24 | argument count << 16 | format address
+ *   word 1..n  arguments
+ *
+ * .binlog is linked as a COPY section at address 0. It is kept in the ELF
+ * file but never loaded, so the strings cost no flash, and a format's
+ * address is a 16 bit index. tools/binlog.py reads the strings back out of
+ * the .out file and prints the messages.
+ *
+ * Writers claim space in the ring with LDREX/STREX on the head index, fill
+ * in the arguments and store word 0 last, which commits the record. No
+ * interrupts are masked, any task or ISR can log, and a log call is a few
+ * tens of cycles. When the ring is full the record is dropped and counted.
+ *
+ * BinLogRead() hands out finished records for the application to send,
+ * e.g. a low priority task writing to the UART. It starts with a 16 byte
+ * header (magic "BLOG", ring size 0) that marks a restart. The decoder
+ * does not need it: the sync byte in word 0 lets it pick up a stream at
+ * any record. A debugger memory dump of g_sBinLog has the same header with
+ * the real ring size and decodes too.
+ *
+ * Arguments are 32 bit integers, so %d, %u, %x, %c and %p work. %s works
+ * for strings the decoder can find in the ELF file, i.e. constants.
+ */
+
+#ifndef BINLOG_H_
+#define BINLOG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Set to 0 to compile the log calls out
+#ifndef BINLOG_ENABLE
+#define BINLOG_ENABLE           1
+#endif
+
+// Words in the ring, must be a power of two
+#ifndef BINLOG_WORDS
+#define BINLOG_WORDS            256
+#endif
+
+#define BINLOG_MAGIC            0x474F4C42  // "BLOG"
+#define BINLOG_SYNC             0xB0000000
+#define BINLOG_ARGS_MAX         4
+#define BINLOG_RECORD_MAX       (4 * (1 + BINLOG_ARGS_MAX))
+
+// Format index of the record BinLogRead() inserts when records were
+// dropped, its argument is how many
+#define BINLOG_INDEX_DROPPED    0xFFFF
+
+typedef struct {
+    uint32_t ui32Magic;
+    uint32_t ui32Size;          // BINLOG_WORDS
+    volatile uint32_t ui32Head; // Words claimed, free running
+    volatile uint32_t ui32Tail; // Words read
+    volatile uint32_t ui32Dropped;
+    volatile uint32_t pui32Words[BINLOG_WORDS];
+} tBinLogBuf;
+
+extern tBinLogBuf g_sBinLog;
+
+// Count a record that did not fit
+extern void BinLogDrop(void);
+
+// Claim ui32Words words, returning the first, or false if the ring is full.
+// The tail is read before the head: the reader may move it on in between,
+// but never past the head.
+static inline bool BinLogClaim(uint32_t ui32Words, uint32_t *pui32Head) {
+    uint32_t ui32Tail;
+    uint32_t ui32Head;
+
+#if defined(__TI_COMPILER_VERSION__)
+    do {
+        ui32Tail = g_sBinLog.ui32Tail;
+        ui32Head = __ldrex((void *)&g_sBinLog.ui32Head);
+        if (ui32Head + ui32Words - ui32Tail > BINLOG_WORDS) {
+            return false;
+        }
+    } while (__strex(ui32Head + ui32Words, (void *)&g_sBinLog.ui32Head));
+#else
+    do {
+        ui32Tail = g_sBinLog.ui32Tail;
+        ui32Head = g_sBinLog.ui32Head;
+        if (ui32Head + ui32Words - ui32Tail > BINLOG_WORDS) {
+            return false;
+        }
+    } while (!__atomic_compare_exchange_n(&g_sBinLog.ui32Head, &ui32Head,
+                                          ui32Head + ui32Words, true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+#endif
+
+    *pui32Head = ui32Head;
+    return true;
+}
+
+// Write one record. ui32Args is a constant in every caller, so the unused
+// argument stores drop out once this is inlined.
+static inline void BinLogWrite(const char *pcFormat, uint32_t ui32Args,
+                               uint32_t ui32A, uint32_t ui32B,
+                               uint32_t ui32C, uint32_t ui32D) {
+    volatile uint32_t *pui32Words = g_sBinLog.pui32Words;
+    uint32_t ui32Head;
+
+    if (!BinLogClaim(ui32Args + 1, &ui32Head)) {
+        BinLogDrop();
+        return;
+    }
+
+    if (ui32Args > 0) {
+        pui32Words[(ui32Head + 1) & (BINLOG_WORDS - 1)] = ui32A;
+    }
+    if (ui32Args > 1) {
+        pui32Words[(ui32Head + 2) & (BINLOG_WORDS - 1)] = ui32B;
+    }
+    if (ui32Args > 2) {
+        pui32Words[(ui32Head + 3) & (BINLOG_WORDS - 1)] = ui32C;
+    }
+    if (ui32Args > 3) {
+        pui32Words[(ui32Head + 4) & (BINLOG_WORDS - 1)] = ui32D;
+    }
+
+    // Word 0 last, the reader takes the record once it is non-zero
+    pui32Words[ui32Head & (BINLOG_WORDS - 1)] =
+        BINLOG_SYNC | (ui32Args << 16) | ((uintptr_t)pcFormat & 0xFFFF);
+}
+
+#if BINLOG_ENABLE
+#define BINLOG_RECORD(pcFormat, ui32Args, a, b, c, d)                       \
+    do {                                                                    \
+        static const char g_pcBinLogFormat[]                                \
+            __attribute__((section(".binlog"))) = pcFormat;                 \
+        BinLogWrite(g_pcBinLogFormat, ui32Args, (uint32_t)(a),              \
+                    (uint32_t)(b), (uint32_t)(c), (uint32_t)(d));           \
+    } while (0)
+#else
+#define BINLOG_RECORD(pcFormat, ui32Args, a, b, c, d)
+#endif
+
+#define BINLOG(pcFormat)            BINLOG_RECORD(pcFormat, 0, 0, 0, 0, 0)
+#define BINLOG1(pcFormat, a)        BINLOG_RECORD(pcFormat, 1, a, 0, 0, 0)
+#define BINLOG2(pcFormat, a, b)     BINLOG_RECORD(pcFormat, 2, a, b, 0, 0)
+#define BINLOG3(pcFormat, a, b, c)  BINLOG_RECORD(pcFormat, 3, a, b, c, 0)
+#define BINLOG4(pcFormat, a, b, c, d)                                       \
+                                    BINLOG_RECORD(pcFormat, 4, a, b, c, d)
+
+// Empty the ring and start a new stream
+extern void BinLogInit(void);
+
+// Copy the stream header, then whole records oldest first, into pui8Buf
+// and return the byte count. ui32Max must be at least BINLOG_RECORD_MAX.
+// Call from one context only.
+extern uint32_t BinLogRead(uint8_t *pui8Buf, uint32_t ui32Max);
+
+#endif /* BINLOG_H_ */
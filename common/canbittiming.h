@@ -0,0 +1,83 @@
+/* canbittiming.h
+ *
+ * Compile-time CAN bit timing for the TM4C123 CAN controller.
+ *
+ * CANBitRateSet() searches for a bit timing at run time on every init and
+ * gives no say over the sample point. CAN_BIT_TIMING() works out the same
+ * tCANBitClkParms from the system clock, bit rate and sample point as a
+ * constant initializer, so init is a single CANBitTimingSet() call.
+ *
+ *     CAN_BIT_TIMING_CHECK(50000000, 1000000, 875);
+ *     static const tCANBitClkParms g_sCANBitClk =
+ *         CAN_BIT_TIMING(50000000, 1000000, 875);
+ *
+ * The bit is split into the sync+prop+phase1 segment (2-16 quanta) and the
+ * phase2 segment (1-8 quanta), with a prescaler of 1-1024. The largest
+ * number of quanta per bit that divides the clock evenly and puts the
+ * sample point within CAN_BIT_TIMING_SP_TOLERANCE of the target is used.
+ * CAN_BIT_TIMING_CHECK() stops the build if there is no such setting.
+ *
+ * Sample points are given in tenths of a percent (875 = 87.5%).
+ */
+
+#ifndef CANBITTIMING_H_
+#define CANBITTIMING_H_
+
+// Allowed distance between the requested and achieved sample point
+#ifndef CAN_BIT_TIMING_SP_TOLERANCE
+#define CAN_BIT_TIMING_SP_TOLERANCE 50
+#endif
+
+// Sync+prop+phase1 and phase2 quanta for n quanta per bit
+#define CANBT_TSEG1(n, sp)      ((((n) * (sp)) + 500) / 1000)
+#define CANBT_TSEG2(n, sp)      ((n) - CANBT_TSEG1(n, sp))
+
+// Achieved sample point minus the requested one, in tenths of a percent
+#define CANBT_SP_ERR(n, sp)     ((CANBT_TSEG1(n, sp) * 1000) / (n) - (sp))
+
+// True if n quanta per bit gives a legal setting
+#define CANBT_FITS(clk, br, n, sp)                                            \
+    ((((clk) % ((br) * (n))) == 0) &&                                         \
+     (((clk) / ((br) * (n))) <= 1024) &&                                      \
+     (CANBT_TSEG1(n, sp) >= 2) && (CANBT_TSEG1(n, sp) <= 16) &&               \
+     (CANBT_TSEG2(n, sp) >= 1) && (CANBT_TSEG2(n, sp) <= 8) &&                \
+     (CANBT_SP_ERR(n, sp) <= CAN_BIT_TIMING_SP_TOLERANCE) &&                  \
+     (CANBT_SP_ERR(n, sp) >= -CAN_BIT_TIMING_SP_TOLERANCE))
+
+// Quanta per bit, largest legal value from 24 down to 3, 0 if none fits
+#define CAN_BIT_TIMING_QUANTA(clk, br, sp)                                    \
+    (CANBT_FITS(clk, br, 24, sp) ? 24 : CANBT_FITS(clk, br, 23, sp) ? 23 :    \
+     CANBT_FITS(clk, br, 22, sp) ? 22 : CANBT_FITS(clk, br, 21, sp) ? 21 :    \
+     CANBT_FITS(clk, br, 20, sp) ? 20 : CANBT_FITS(clk, br, 19, sp) ? 19 :    \
+     CANBT_FITS(clk, br, 18, sp) ? 18 : CANBT_FITS(clk, br, 17, sp) ? 17 :    \
+     CANBT_FITS(clk, br, 16, sp) ? 16 : CANBT_FITS(clk, br, 15, sp) ? 15 :    \
+     CANBT_FITS(clk, br, 14, sp) ? 14 : CANBT_FITS(clk, br, 13, sp) ? 13 :    \
+     CANBT_FITS(clk, br, 12, sp) ? 12 : CANBT_FITS(clk, br, 11, sp) ? 11 :    \
+     CANBT_FITS(clk, br, 10, sp) ? 10 : CANBT_FITS(clk, br, 9, sp) ? 9 :      \
+     CANBT_FITS(clk, br, 8, sp) ? 8 : CANBT_FITS(clk, br, 7, sp) ? 7 :        \
+     CANBT_FITS(clk, br, 6, sp) ? 6 : CANBT_FITS(clk, br, 5, sp) ? 5 :        \
+     CANBT_FITS(clk, br, 4, sp) ? 4 : CANBT_FITS(clk, br, 3, sp) ? 3 : 0)
+
+// Fields of tCANBitClkParms
+#define CAN_BIT_TIMING_TSEG1(clk, br, sp)                                     \
+    CANBT_TSEG1(CAN_BIT_TIMING_QUANTA(clk, br, sp), sp)
+#define CAN_BIT_TIMING_TSEG2(clk, br, sp)                                     \
+    (CAN_BIT_TIMING_QUANTA(clk, br, sp) - CAN_BIT_TIMING_TSEG1(clk, br, sp))
+#define CAN_BIT_TIMING_SJW(clk, br, sp)                                       \
+    ((CAN_BIT_TIMING_TSEG2(clk, br, sp) < 4) ? CAN_BIT_TIMING_TSEG2(clk, br, sp) : 4)
+#define CAN_BIT_TIMING_PRESCALER(clk, br, sp)                                 \
+    ((clk) / ((br) * CAN_BIT_TIMING_QUANTA(clk, br, sp)))
+
+// Initializer for a tCANBitClkParms
+#define CAN_BIT_TIMING(clk, br, sp)                                           \
+    { CAN_BIT_TIMING_TSEG1(clk, br, sp), CAN_BIT_TIMING_TSEG2(clk, br, sp),   \
+      CAN_BIT_TIMING_SJW(clk, br, sp), CAN_BIT_TIMING_PRESCALER(clk, br, sp) }
+
+// Fail the build if no legal setting exists
+#define CANBT_PASTE2(a, b)      a##b
+#define CANBT_PASTE(a, b)       CANBT_PASTE2(a, b)
+#define CAN_BIT_TIMING_CHECK(clk, br, sp)                                     \
+    typedef char CANBT_PASTE(g_pcCANBitTimingCheck, __LINE__)                 \
+        [(CAN_BIT_TIMING_QUANTA(clk, br, sp) != 0) ? 1 : -1]
+
+#endif /* CANBITTIMING_H_ */
@@ -0,0 +1,76 @@
+/* candispatch.c
+ *
+ * Written for the EK-TM4C123GXL
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "candispatch.h"
+
+#define CANDISPATCH_IDS         2048
+
+typedef struct {
+    tCANDispatchHandler pfnHandler;
+    void *pvArg;
+} tCANDispatchEntry;
+
+// Handler slot for each ID, 0 means no handler
+static uint8_t g_pui8CANDispatchIndex[CANDISPATCH_IDS];
+
+// Slot 0 is never used
+static tCANDispatchEntry g_psCANDispatchHandlers[CANDISPATCH_MAX_HANDLERS + 1];
+static uint32_t g_ui32CANDispatchCount;
+
+void CANDispatchInit(void) {
+    memset(g_pui8CANDispatchIndex, 0, sizeof(g_pui8CANDispatchIndex));
+    g_ui32CANDispatchCount = 0;
+}
+
+bool CANDispatchRegister(uint32_t ui32ID, uint32_t ui32Mask,
+                         tCANDispatchHandler pfnHandler, void *pvArg) {
+    uint32_t ui32Slot;
+    uint32_t ui32Idx;
+
+    // Share the slot of an identical handler/argument pair
+    for (ui32Slot = 1; ui32Slot <= g_ui32CANDispatchCount; ui32Slot++) {
+        if ((g_psCANDispatchHandlers[ui32Slot].pfnHandler == pfnHandler) &&
+            (g_psCANDispatchHandlers[ui32Slot].pvArg == pvArg)) {
+            break;
+        }
+    }
+
+    if (ui32Slot > g_ui32CANDispatchCount) {
+        if (g_ui32CANDispatchCount == CANDISPATCH_MAX_HANDLERS) {
+            return false;
+        }
+        ui32Slot = ++g_ui32CANDispatchCount;
+        g_psCANDispatchHandlers[ui32Slot].pfnHandler = pfnHandler;
+        g_psCANDispatchHandlers[ui32Slot].pvArg = pvArg;
+    }
+
+    ui32ID &= ui32Mask & (CANDISPATCH_IDS - 1);
+    for (ui32Idx = 0; ui32Idx < CANDISPATCH_IDS; ui32Idx++) {
+        if ((ui32Idx & ui32Mask) == ui32ID) {
+            g_pui8CANDispatchIndex[ui32Idx] = ui32Slot;
+        }
+    }
+
+    return true;
+}
+
+bool CANDispatch(const tCANFrame *psFrame) {
+    const tCANDispatchEntry *psEntry;
+    uint32_t ui32Slot;
+
+    ui32Slot = g_pui8CANDispatchIndex[psFrame->ui32ID & (CANDISPATCH_IDS - 1)];
+    if (ui32Slot == 0) {
+        return false;
+    }
+
+    psEntry = &g_psCANDispatchHandlers[ui32Slot];
+    psEntry->pfnHandler(psFrame, psEntry->pvArg);
+
+    return true;
+}
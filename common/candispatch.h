@@ -0,0 +1,40 @@
+/* candispatch.h
+ *
+ * Table driven dispatch of received CAN frames to handlers by ID.
+ *
+ * Every 11 bit ID has a one byte entry in a 2048 entry table naming its
+ * handler, so finding the handler for a frame is a single table load no
+ * matter how many IDs are registered. Registering an ID/mask pair fills in
+ * every ID it matches, which is done once at start up.
+ */
+
+#ifndef CANDISPATCH_H_
+#define CANDISPATCH_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "canframe.h"
+
+// Number of distinct handler/argument pairs, at most 255
+#ifndef CANDISPATCH_MAX_HANDLERS
+#define CANDISPATCH_MAX_HANDLERS    16
+#endif
+
+typedef void (*tCANDispatchHandler)(const tCANFrame *psFrame, void *pvArg);
+
+// Forget every registration
+extern void CANDispatchInit(void);
+
+// Send frames whose ID matches ui32ID in the bits set in ui32Mask to
+// pfnHandler. A mask of 0x7FF matches one ID, 0 matches all of them. Where
+// registrations overlap the later one wins, so register catch-alls first.
+// Returns false if the handler table is full.
+extern bool CANDispatchRegister(uint32_t ui32ID, uint32_t ui32Mask,
+                                tCANDispatchHandler pfnHandler, void *pvArg);
+
+// Call the handler registered for the frame's ID. Returns false if there
+// is none.
+extern bool CANDispatch(const tCANFrame *psFrame);
+
+#endif /* CANDISPATCH_H_ */
@@ -0,0 +1,171 @@
+/* canerr.c
+ *
+ * Written for the EK-TM4C123GXL
+ *
+ * When the transmit error counter passes 255 the controller goes bus-off and
+ * sets its INIT bit, which stops it until software clears INIT again. After
+ * that it still has to see 128 runs of 11 recessive bits before it takes part
+ * in the bus, and only then does BOFF clear. Restarting straight away can
+ * keep a broken node bouncing on and off the bus, so the restart waits a
+ * backoff that grows while bus-offs keep coming back.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "inc/hw_can.h"
+#include "inc/hw_memmap.h"
+#include "driverlib/can.h"
+
+#include "canerr.h"
+
+tCANErrStats g_sCANErrStats;
+
+static uint32_t g_ui32CANErrBase;
+static uint32_t g_ui32CANErrTicksPerMs;
+
+// State bits from the most recent status interrupt
+static volatile uint32_t g_ui32CANErrStatus;
+
+// Bus-off time, restart time and recovery time of the current episode
+static uint32_t g_ui32CANErrBusOffAt;
+static uint32_t g_ui32CANErrRestartAt;
+static uint32_t g_ui32CANErrRecoveredAt;
+static bool g_bCANErrRecovered;
+
+// Earliest time the next throttled frame may go, only valid while
+// g_bCANErrTxWait is set
+static uint32_t g_ui32CANErrNextTx;
+static bool g_bCANErrTxWait;
+
+// True once ui32Now has reached ui32Time, allowing for wrap
+static bool CANErrReached(uint32_t ui32Now, uint32_t ui32Time) {
+    return (int32_t)(ui32Now - ui32Time) >= 0;
+}
+
+void CANErrInit(uint32_t ui32Base, uint32_t ui32TicksPerMs) {
+    uint32_t ui32Idx;
+
+    g_ui32CANErrBase = ui32Base;
+    g_ui32CANErrTicksPerMs = ui32TicksPerMs;
+    g_ui32CANErrStatus = 0;
+    g_bCANErrRecovered = false;
+    g_bCANErrTxWait = false;
+
+    g_sCANErrStats.eState = CANERR_ACTIVE;
+    g_sCANErrStats.ui32TEC = 0;
+    g_sCANErrStats.ui32REC = 0;
+    for (ui32Idx = 0; ui32Idx < 8; ui32Idx++) {
+        g_sCANErrStats.pui32LEC[ui32Idx] = 0;
+    }
+    g_sCANErrStats.ui32BusOffs = 0;
+    g_sCANErrStats.ui32Recoveries = 0;
+    g_sCANErrStats.ui32BackoffMs = CANERR_BACKOFF_MIN_MS;
+    g_sCANErrStats.ui32LastRecovery = 0;
+    g_sCANErrStats.ui32TxThrottled = 0;
+}
+
+void CANErrStatusIntHandler(void) {
+    uint32_t ui32Status;
+    uint32_t ui32LEC;
+
+    // Reading the status clears the interrupt and resets the LEC field
+    ui32Status = CANStatusGet(g_ui32CANErrBase, CAN_STS_CONTROL);
+
+    // 0 is no error and 7 means no bus event since the last read, neither
+    // is worth counting
+    ui32LEC = ui32Status & CAN_STATUS_LEC_MSK;
+    if ((ui32LEC != CAN_STATUS_LEC_NONE) && (ui32LEC != CAN_STATUS_LEC_MASK)) {
+        g_sCANErrStats.pui32LEC[ui32LEC]++;
+    }
+
+    g_ui32CANErrStatus = ui32Status & (CAN_STATUS_BUS_OFF | CAN_STATUS_EPASS | CAN_STATUS_EWARN);
+}
+
+void CANErrUpdate(uint32_t ui32Now) {
+    uint32_t ui32Status;
+    uint32_t ui32Rx;
+    uint32_t ui32Tx;
+
+    CANErrCntrGet(g_ui32CANErrBase, &ui32Rx, &ui32Tx);
+    g_sCANErrStats.ui32TEC = ui32Tx;
+    g_sCANErrStats.ui32REC = ui32Rx;
+
+    ui32Status = g_ui32CANErrStatus;
+
+    switch (g_sCANErrStats.eState) {
+    case CANERR_BUSOFF:
+        // Clearing INIT starts the 128 x 11 bit recovery sequence
+        if (CANErrReached(ui32Now, g_ui32CANErrRestartAt)) {
+            CANEnable(g_ui32CANErrBase);
+            g_sCANErrStats.eState = CANERR_RECOVERING;
+        }
+        return;
+
+    case CANERR_RECOVERING:
+        if (ui32Status & CAN_STATUS_BUS_OFF) {
+            return;
+        }
+        g_sCANErrStats.ui32Recoveries++;
+        g_sCANErrStats.ui32LastRecovery = ui32Now - g_ui32CANErrBusOffAt;
+        g_ui32CANErrRecoveredAt = ui32Now;
+        g_bCANErrRecovered = true;
+        break;
+
+    default:
+        break;
+    }
+
+    if (ui32Status & CAN_STATUS_BUS_OFF) {
+        // A bus-off soon after the last recovery means whatever caused it is
+        // still there, so wait longer this time
+        if (g_bCANErrRecovered &&
+            !CANErrReached(ui32Now, g_ui32CANErrRecoveredAt + CANERR_STABLE_MS * g_ui32CANErrTicksPerMs)) {
+            g_sCANErrStats.ui32BackoffMs *= 2;
+            if (g_sCANErrStats.ui32BackoffMs > CANERR_BACKOFF_MAX_MS) {
+                g_sCANErrStats.ui32BackoffMs = CANERR_BACKOFF_MAX_MS;
+            }
+        } else {
+            g_sCANErrStats.ui32BackoffMs = CANERR_BACKOFF_MIN_MS;
+        }
+
+        g_sCANErrStats.ui32BusOffs++;
+        g_sCANErrStats.eState = CANERR_BUSOFF;
+        g_ui32CANErrBusOffAt = ui32Now;
+        g_ui32CANErrRestartAt = ui32Now + g_sCANErrStats.ui32BackoffMs * g_ui32CANErrTicksPerMs;
+    } else if ((ui32Status & CAN_STATUS_EPASS) || (ui32Tx > 127) || (ui32Rx > 127)) {
+        g_sCANErrStats.eState = CANERR_PASSIVE;
+    } else if ((ui32Status & CAN_STATUS_EWARN) || (ui32Tx >= 96) || (ui32Rx >= 96)) {
+        g_sCANErrStats.eState = CANERR_WARNING;
+    } else {
+        g_sCANErrStats.eState = CANERR_ACTIVE;
+    }
+}
+
+bool CANErrTxPermit(uint32_t ui32Now) {
+    uint32_t ui32IntervalMs;
+
+    switch (g_sCANErrStats.eState) {
+    case CANERR_ACTIVE:
+        g_bCANErrTxWait = false;
+        return true;
+    case CANERR_WARNING:
+        ui32IntervalMs = CANERR_WARN_TX_MS;
+        break;
+    case CANERR_PASSIVE:
+        ui32IntervalMs = CANERR_PASSIVE_TX_MS;
+        break;
+    default:
+        g_bCANErrTxWait = false;
+        g_sCANErrStats.ui32TxThrottled++;
+        return false;
+    }
+
+    if (g_bCANErrTxWait && !CANErrReached(ui32Now, g_ui32CANErrNextTx)) {
+        g_sCANErrStats.ui32TxThrottled++;
+        return false;
+    }
+
+    g_ui32CANErrNextTx = ui32Now + ui32IntervalMs * g_ui32CANErrTicksPerMs;
+    g_bCANErrTxWait = true;
+    return true;
+}
@@ -0,0 +1,82 @@
+/* canerr.h
+ *
+ * CAN error state tracking and automatic bus-off recovery.
+ *
+ * The interrupt handler passes status interrupts to CANErrStatusIntHandler(),
+ * which counts the last error code and remembers the controller state. The
+ * main loop calls CANErrUpdate() with the current time, which reads the error
+ * counters, restarts the controller after a bus-off once the backoff has run
+ * out, and decides how often CANErrTxPermit() lets a frame through.
+ *
+ * Times are in ticks of whatever free running counter the caller uses,
+ * CANLatencyNow() for example. Only differences are used, so the counter may
+ * wrap.
+ */
+
+#ifndef CANERR_H_
+#define CANERR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// First wait after a bus-off before restarting the controller, in ms. The
+// wait doubles for every bus-off that follows a recovery within
+// CANERR_STABLE_MS, up to CANERR_BACKOFF_MAX_MS.
+#ifndef CANERR_BACKOFF_MIN_MS
+#define CANERR_BACKOFF_MIN_MS   10
+#endif
+#ifndef CANERR_BACKOFF_MAX_MS
+#define CANERR_BACKOFF_MAX_MS   1000
+#endif
+#ifndef CANERR_STABLE_MS
+#define CANERR_STABLE_MS        5000
+#endif
+
+// Minimum time between transmitted frames in the error warning and error
+// passive states, in ms. There is no limit in the error active state.
+#ifndef CANERR_WARN_TX_MS
+#define CANERR_WARN_TX_MS       10
+#endif
+#ifndef CANERR_PASSIVE_TX_MS
+#define CANERR_PASSIVE_TX_MS    100
+#endif
+
+typedef enum {
+    CANERR_ACTIVE,              // Both counters below 96
+    CANERR_WARNING,             // A counter has reached 96
+    CANERR_PASSIVE,             // A counter has passed 127
+    CANERR_BUSOFF,              // Waiting out the backoff
+    CANERR_RECOVERING           // Restarted, waiting for 128 idle sequences
+} tCANErrState;
+
+typedef struct {
+    tCANErrState eState;
+    uint32_t ui32TEC;           // Transmit error counter at the last update
+    uint32_t ui32REC;           // Receive error counter at the last update
+    uint32_t pui32LEC[8];       // Count per last error code, CAN_STATUS_LEC_*
+    uint32_t ui32BusOffs;       // Number of times the node went bus-off
+    uint32_t ui32Recoveries;    // Number of completed recoveries
+    uint32_t ui32BackoffMs;     // Backoff that will be used for the next bus-off
+    uint32_t ui32LastRecovery;  // Ticks from bus-off to error active again
+    uint32_t ui32TxThrottled;   // Frames refused by CANErrTxPermit()
+} tCANErrStats;
+
+// Telemetry, read it from the main loop or the debugger
+extern tCANErrStats g_sCANErrStats;
+
+// Start tracking the controller at ui32Base. ui32TicksPerMs is the rate of
+// the time passed to CANErrUpdate() and CANErrTxPermit().
+extern void CANErrInit(uint32_t ui32Base, uint32_t ui32TicksPerMs);
+
+// Call from the CAN interrupt handler for CAN_INT_INTID_STATUS. Reads (and so
+// clears) the controller status.
+extern void CANErrStatusIntHandler(void);
+
+// Run the state machine. Call regularly from the main loop.
+extern void CANErrUpdate(uint32_t ui32Now);
+
+// Returns true if a frame may be queued now, and starts the throttle interval
+// if so. Always false while bus-off or recovering.
+extern bool CANErrTxPermit(uint32_t ui32Now);
+
+#endif /* CANERR_H_ */
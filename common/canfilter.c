@@ -0,0 +1,194 @@
+/* canfilter.c
+ *
+ * Written for the EK-TM4C123GXL
+ *
+ * Merging two filters keeps the mask bits on which both agree, so the
+ * result accepts 2^(11 - mask bits) IDs. The cost of a merge is how many of
+ * those are not wanted. The search is O(n^3) in the number of IDs, which is
+ * fine for the tens of IDs an application listens to at start up.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "inc/hw_can.h"
+#include "inc/hw_memmap.h"
+#include "driverlib/can.h"
+
+#include "canfilter.h"
+
+#define CANFILTER_ID_MASK       0x7FF
+
+// True if the filter accepts ui32ID
+static bool CANFilterMatch(const tCANFilter *psFilter, uint32_t ui32ID) {
+    return (ui32ID & psFilter->ui32Mask) == psFilter->ui32ID;
+}
+
+// Unwanted IDs let through by one filter. pui32IDs must not repeat an ID,
+// or the wanted count can exceed the accepted one.
+static uint32_t CANFilterCost(const tCANFilter *psFilter, const uint32_t *pui32IDs,
+                              uint32_t ui32Count) {
+    uint32_t ui32Accepted;
+    uint32_t ui32Wanted;
+    uint32_t ui32Idx;
+    uint32_t ui32Bits;
+
+    ui32Bits = 0;
+    for (ui32Idx = 0; ui32Idx < 11; ui32Idx++) {
+        if (!(psFilter->ui32Mask & (1UL << ui32Idx))) {
+            ui32Bits++;
+        }
+    }
+    ui32Accepted = 1UL << ui32Bits;
+
+    ui32Wanted = 0;
+    for (ui32Idx = 0; ui32Idx < ui32Count; ui32Idx++) {
+        if (CANFilterMatch(psFilter, pui32IDs[ui32Idx])) {
+            ui32Wanted++;
+        }
+    }
+
+    return ui32Accepted - ui32Wanted;
+}
+
+static void CANFilterMerge(const tCANFilter *psA, const tCANFilter *psB, tCANFilter *psOut) {
+    psOut->ui32Mask = psA->ui32Mask & psB->ui32Mask & ~(psA->ui32ID ^ psB->ui32ID);
+    psOut->ui32ID = psA->ui32ID & psOut->ui32Mask;
+}
+
+uint32_t CANFilterCompute(const uint32_t *pui32IDs, uint32_t ui32Count,
+                          tCANFilter *psFilters, uint32_t ui32MaxFilters) {
+    static tCANFilter psWork[CANFILTER_MAX_IDS];
+    static uint32_t pui32Cost[CANFILTER_MAX_IDS];
+    static uint32_t pui32Distinct[CANFILTER_MAX_IDS];
+    tCANFilter sMerged;
+    tCANFilter sBest;
+    uint32_t ui32Num;
+    uint32_t ui32Distinct;
+    uint32_t ui32Idx;
+    uint32_t ui32A;
+    uint32_t ui32B;
+    uint32_t ui32Cost;
+    uint32_t ui32Old;
+    uint32_t ui32BestCost;
+
+    if ((ui32Count == 0) || (ui32Count > CANFILTER_MAX_IDS) || (ui32MaxFilters == 0)) {
+        return 0;
+    }
+
+    // Start with one exact filter per distinct ID
+    ui32Num = 0;
+    for (ui32Idx = 0; ui32Idx < ui32Count; ui32Idx++) {
+        for (ui32A = 0; ui32A < ui32Num; ui32A++) {
+            if (psWork[ui32A].ui32ID == (pui32IDs[ui32Idx] & CANFILTER_ID_MASK)) {
+                break;
+            }
+        }
+        if (ui32A == ui32Num) {
+            psWork[ui32Num].ui32ID = pui32IDs[ui32Idx] & CANFILTER_ID_MASK;
+            psWork[ui32Num].ui32Mask = CANFILTER_ID_MASK;
+            pui32Cost[ui32Num] = 0;
+            pui32Distinct[ui32Num] = psWork[ui32Num].ui32ID;
+            ui32Num++;
+        }
+    }
+    ui32Distinct = ui32Num;
+
+    while (ui32Num > ui32MaxFilters) {
+        // Find the pair whose merge adds the fewest unwanted IDs
+        ui32BestCost = 0xFFFFFFFF;
+        for (ui32A = 0; ui32A < ui32Num; ui32A++) {
+            for (ui32B = ui32A + 1; ui32B < ui32Num; ui32B++) {
+                CANFilterMerge(&psWork[ui32A], &psWork[ui32B], &sMerged);
+                ui32Cost = CANFilterCost(&sMerged, pui32Distinct, ui32Distinct);
+                ui32Old = pui32Cost[ui32A] + pui32Cost[ui32B];
+                ui32Cost = (ui32Cost > ui32Old) ? ui32Cost - ui32Old : 0;
+                if (ui32Cost < ui32BestCost) {
+                    ui32BestCost = ui32Cost;
+                    sBest = sMerged;
+                }
+            }
+        }
+
+        // Replace every filter the merged one covers, which is at least
+        // the two that were merged
+        ui32B = 0;
+        for (ui32A = 0; ui32A < ui32Num; ui32A++) {
+            if (((psWork[ui32A].ui32Mask & sBest.ui32Mask) == sBest.ui32Mask) &&
+                ((psWork[ui32A].ui32ID & sBest.ui32Mask) == sBest.ui32ID)) {
+                continue;
+            }
+            psWork[ui32B] = psWork[ui32A];
+            pui32Cost[ui32B] = pui32Cost[ui32A];
+            ui32B++;
+        }
+        psWork[ui32B] = sBest;
+        pui32Cost[ui32B] = CANFilterCost(&sBest, pui32Distinct, ui32Distinct);
+        ui32Num = ui32B + 1;
+    }
+
+    for (ui32Idx = 0; ui32Idx < ui32Num; ui32Idx++) {
+        psFilters[ui32Idx] = psWork[ui32Idx];
+    }
+
+    return ui32Num;
+}
+
+uint32_t CANFilterFalsePositives(const tCANFilter *psFilters, uint32_t ui32NumFilters,
+                                 const uint32_t *pui32IDs, uint32_t ui32Count) {
+    uint32_t ui32ID;
+    uint32_t ui32Idx;
+    uint32_t ui32Unwanted;
+    bool bAccepted;
+
+    ui32Unwanted = 0;
+    for (ui32ID = 0; ui32ID <= CANFILTER_ID_MASK; ui32ID++) {
+        bAccepted = false;
+        for (ui32Idx = 0; ui32Idx < ui32NumFilters; ui32Idx++) {
+            if (CANFilterMatch(&psFilters[ui32Idx], ui32ID)) {
+                bAccepted = true;
+                break;
+            }
+        }
+        if (!bAccepted) {
+            continue;
+        }
+        for (ui32Idx = 0; ui32Idx < ui32Count; ui32Idx++) {
+            if ((pui32IDs[ui32Idx] & CANFILTER_ID_MASK) == ui32ID) {
+                bAccepted = false;
+                break;
+            }
+        }
+        if (bAccepted) {
+            ui32Unwanted++;
+        }
+    }
+
+    return ui32Unwanted;
+}
+
+void CANFilterProgram(uint32_t ui32Base, uint32_t ui32FirstObj,
+                      const tCANFilter *psFilters, uint32_t ui32NumFilters,
+                      uint32_t ui32Depth, uint32_t ui32Flags) {
+    tCANMsgObject sMsg;
+    uint32_t ui32Idx;
+    uint32_t ui32Obj;
+
+    for (ui32Idx = 0; ui32Idx < ui32NumFilters; ui32Idx++) {
+        sMsg.ui32MsgID = psFilters[ui32Idx].ui32ID;
+        sMsg.ui32MsgIDMask = psFilters[ui32Idx].ui32Mask;
+        sMsg.ui32MsgLen = 8;
+        sMsg.pui8MsgData = 0;
+
+        // Every object of a chain but the last one points on to the next.
+        // The IDE bit is compared too, or a 29 bit frame whose top 11 bits
+        // pass the filter would be taken as well.
+        for (ui32Obj = 0; ui32Obj < ui32Depth; ui32Obj++) {
+            sMsg.ui32Flags = MSG_OBJ_USE_EXT_FILTER | ui32Flags;
+            if (ui32Obj != ui32Depth - 1) {
+                sMsg.ui32Flags |= MSG_OBJ_FIFO;
+            }
+            CANMessageSet(ui32Base, ui32FirstObj + ui32Idx * ui32Depth + ui32Obj, &sMsg,
+                          MSG_OBJ_TYPE_RX);
+        }
+    }
+}
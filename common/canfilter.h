@@ -0,0 +1,47 @@
+/* canfilter.h
+ *
+ * Works out receive acceptance filters from the list of CAN IDs an
+ * application wants, and programs them into message objects, one object or
+ * a chain of them forming a hardware FIFO per filter.
+ *
+ * Each message object has one ID/mask pair. When there are more wanted IDs
+ * than objects, pairs are merged greedily, each time picking the merge that
+ * lets the fewest unwanted IDs through, until they fit.
+ */
+
+#ifndef CANFILTER_H_
+#define CANFILTER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Largest number of wanted IDs CANFilterCompute() accepts
+#ifndef CANFILTER_MAX_IDS
+#define CANFILTER_MAX_IDS       64
+#endif
+
+typedef struct {
+    uint32_t ui32ID;
+    uint32_t ui32Mask;          // Set bits must match ui32ID
+} tCANFilter;
+
+// Compute at most ui32MaxFilters filters accepting every 11 bit ID in
+// pui32IDs, which may list an ID more than once. Returns the number of
+// filters written to psFilters, or 0 if there are no IDs or more than
+// CANFILTER_MAX_IDS.
+extern uint32_t CANFilterCompute(const uint32_t *pui32IDs, uint32_t ui32Count,
+                                 tCANFilter *psFilters, uint32_t ui32MaxFilters);
+
+// Number of 11 bit IDs the filters accept that are not in pui32IDs
+extern uint32_t CANFilterFalsePositives(const tCANFilter *psFilters, uint32_t ui32NumFilters,
+                                        const uint32_t *pui32IDs, uint32_t ui32Count);
+
+// Program the filters as receive objects starting at ui32FirstObj, each
+// into ui32Depth consecutive objects chained as a hardware FIFO (a depth of
+// 1 is a plain object). The objects only take 11 bit frames. ui32Flags is
+// added to MSG_OBJ_USE_EXT_FILTER, MSG_OBJ_RX_INT_ENABLE for example.
+extern void CANFilterProgram(uint32_t ui32Base, uint32_t ui32FirstObj,
+                             const tCANFilter *psFilters, uint32_t ui32NumFilters,
+                             uint32_t ui32Depth, uint32_t ui32Flags);
+
+#endif /* CANFILTER_H_ */
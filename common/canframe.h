@@ -0,0 +1,18 @@
+/* canframe.h
+ *
+ * A CAN frame as it is passed between interrupt handlers and the main loop.
+ */
+
+#ifndef CANFRAME_H_
+#define CANFRAME_H_
+
+#include <stdint.h>
+
+typedef struct {
+    uint32_t ui32ID;            // 11 bit identifier
+    uint32_t ui32Len;           // Number of data bytes, 0-8
+    uint8_t pui8Data[8];        // Payload
+    uint32_t ui32Time;          // Timestamp, see canlatency.h
+} tCANFrame;
+
+#endif /* CANFRAME_H_ */
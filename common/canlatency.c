@@ -0,0 +1,106 @@
+/* canlatency.c
+ *
+ * Written for the EK-TM4C123GXL
+ *
+ * The histograms are kept in timer ticks so recording a sample is one divide
+ * and one increment, and everything is converted to microseconds only when
+ * the histogram is read.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "inc/hw_memmap.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/timer.h"
+
+#include "canlatency.h"
+
+// Timer ticks per microsecond and per bucket
+static uint32_t g_ui32CANLatTicksPerUs = 1;
+static uint32_t g_ui32CANLatTicksPerBucket = CANLAT_BUCKET_US;
+
+void CANLatencyInit(uint32_t ui32SysClock) {
+    g_ui32CANLatTicksPerUs = ui32SysClock / 1000000;
+    g_ui32CANLatTicksPerBucket = g_ui32CANLatTicksPerUs * CANLAT_BUCKET_US;
+
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_WTIMER5);
+    while(!SysCtlPeripheralReady(SYSCTL_PERIPH_WTIMER5)) {
+    }
+
+    // Count up through the whole 64 bit range, no interrupts
+    TimerConfigure(WTIMER5_BASE, TIMER_CFG_PERIODIC_UP);
+    TimerLoadSet64(WTIMER5_BASE, 0xFFFFFFFFFFFFFFFFULL);
+    TimerEnable(WTIMER5_BASE, TIMER_A);
+}
+
+void CANLatencyRecord(tCANLatHist *psHist, uint32_t ui32Start, uint32_t ui32End) {
+    uint32_t ui32Ticks;
+    uint32_t ui32Bucket;
+
+    // Unsigned subtraction handles the low word wrapping
+    ui32Ticks = ui32End - ui32Start;
+
+    ui32Bucket = ui32Ticks / g_ui32CANLatTicksPerBucket;
+    if (ui32Bucket >= CANLAT_BUCKETS) {
+        ui32Bucket = CANLAT_BUCKETS - 1;
+    }
+
+    psHist->pui32Count[ui32Bucket]++;
+    psHist->ui32Total++;
+    if (ui32Ticks > psHist->ui32Max) {
+        psHist->ui32Max = ui32Ticks;
+    }
+}
+
+void CANLatencyReset(tCANLatHist *psHist) {
+    memset(psHist, 0, sizeof(tCANLatHist));
+}
+
+uint32_t CANLatencyPercentile(const tCANLatHist *psHist, uint32_t ui32Permille) {
+    uint32_t ui32Target;
+    uint32_t ui32Sum;
+    uint32_t ui32Bucket;
+
+    if (psHist->ui32Total == 0) {
+        return 0;
+    }
+
+    // Rank of the sample we are after, rounded up and at least 1
+    ui32Target = (uint32_t)(((uint64_t)psHist->ui32Total * ui32Permille + 999) / 1000);
+    if (ui32Target == 0) {
+        ui32Target = 1;
+    }
+
+    ui32Sum = 0;
+    for (ui32Bucket = 0; ui32Bucket < CANLAT_BUCKETS - 1; ui32Bucket++) {
+        ui32Sum += psHist->pui32Count[ui32Bucket];
+        if (ui32Sum >= ui32Target) {
+            return (ui32Bucket + 1) * CANLAT_BUCKET_US;
+        }
+    }
+
+    // Somewhere in the overflow bucket, the maximum is the best bound we have
+    return CANLatencyMax(psHist);
+}
+
+uint32_t CANLatencyMax(const tCANLatHist *psHist) {
+    return (psHist->ui32Max + g_ui32CANLatTicksPerUs - 1) / g_ui32CANLatTicksPerUs;
+}
+
+void CANLatencyDump(const tCANLatHist *psHist, const char *pcName,
+                    tCANLatPrintf pfnPrintf) {
+    uint32_t ui32Bucket;
+
+    pfnPrintf("%s: n=%u p50=%uus p99=%uus max=%uus\n", pcName, psHist->ui32Total,
+              CANLatencyPercentile(psHist, 500), CANLatencyPercentile(psHist, 990),
+              CANLatencyMax(psHist));
+
+    // One line per non-empty bucket: lower edge in us and count
+    for (ui32Bucket = 0; ui32Bucket < CANLAT_BUCKETS; ui32Bucket++) {
+        if (psHist->pui32Count[ui32Bucket] != 0) {
+            pfnPrintf("  %s%u %u\n", (ui32Bucket == CANLAT_BUCKETS - 1) ? ">=" : "",
+                      ui32Bucket * CANLAT_BUCKET_US, psHist->pui32Count[ui32Bucket]);
+        }
+    }
+}
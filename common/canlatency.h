@@ -0,0 +1,68 @@
+/* canlatency.h
+ *
+ * Timestamps for CAN frames and fixed bucket latency histograms.
+ *
+ * WTIMER5 runs as a free running 64 bit up counter at the system clock. Only
+ * the low 32 bits are used as a timestamp, which is plenty for differences
+ * (the low word wraps after 85 seconds at 50MHz) and keeps the stamp a single
+ * load in the interrupt handlers.
+ */
+
+#ifndef CANLATENCY_H_
+#define CANLATENCY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "inc/hw_memmap.h"
+#include "inc/hw_timer.h"
+#include "inc/hw_types.h"
+
+// Number of histogram buckets, the last one also counts everything beyond it
+#ifndef CANLAT_BUCKETS
+#define CANLAT_BUCKETS          128
+#endif
+
+// Width of one bucket in microseconds
+#ifndef CANLAT_BUCKET_US
+#define CANLAT_BUCKET_US        16
+#endif
+
+typedef struct {
+    uint32_t pui32Count[CANLAT_BUCKETS];
+    uint32_t ui32Total;         // Number of samples
+    uint32_t ui32Max;           // Largest sample in timer ticks
+} tCANLatHist;
+
+// printf style output function, UARTprintf for example
+typedef void (*tCANLatPrintf)(const char *pcString, ...);
+
+// Start WTIMER5. ui32SysClock is the timer clock in Hz and sets the bucket
+// width.
+extern void CANLatencyInit(uint32_t ui32SysClock);
+
+// Current timestamp in timer ticks
+static inline uint32_t CANLatencyNow(void) {
+    return HWREG(WTIMER5_BASE + TIMER_O_TAV);
+}
+
+// Add the time from ui32Start to ui32End to the histogram. Each histogram
+// must only be updated from one context.
+extern void CANLatencyRecord(tCANLatHist *psHist, uint32_t ui32Start, uint32_t ui32End);
+
+// Zero a histogram
+extern void CANLatencyReset(tCANLatHist *psHist);
+
+// Latency below which ui32Permille of the samples fall, in microseconds.
+// This is the upper edge of the bucket, so it is rounded up to the bucket
+// width. Returns 0 for an empty histogram.
+extern uint32_t CANLatencyPercentile(const tCANLatHist *psHist, uint32_t ui32Permille);
+
+// Largest sample in microseconds
+extern uint32_t CANLatencyMax(const tCANLatHist *psHist);
+
+// Print p50, p99, max and the non-empty buckets. The histogram can change
+// while it is printed, so take a copy first if the numbers must agree.
+extern void CANLatencyDump(const tCANLatHist *psHist, const char *pcName,
+                           tCANLatPrintf pfnPrintf);
+
+#endif /* CANLATENCY_H_ */
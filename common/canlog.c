@@ -0,0 +1,137 @@
+/* canlog.c
+ *
+ * Written for the EK-TM4C123GXL
+ *
+ * The drain side sends a record straight out of its ring slot and only
+ * releases the slot once the last byte has been taken, so a slow output
+ * never needs a second copy of the record. The header is kept outside the
+ * ring and slipped in between records by the drain side, so it takes no
+ * ring space.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "canlog.h"
+#include "ringbuf.h"
+
+volatile uint32_t g_ui32CANLogOverruns = 0;
+
+static tCANLogRecord g_psCANLogRecords[CANLOG_RECORDS];
+static tRingBuf g_sCANLogRing;
+
+// Set when records were lost, the next record carries CANLOG_FLAG_OVERRUN
+static bool g_bCANLogLost;
+
+// Bytes of the record being drained already sent
+static uint32_t g_ui32CANLogOffset;
+
+// Header record and the records drained since it was last sent
+static tCANLogRecord g_sCANLogHeader;
+static uint32_t g_ui32CANLogSinceHeader;
+
+void CANLogInit(uint32_t ui32TickHz) {
+    RingBufInit(&g_sCANLogRing, g_psCANLogRecords, sizeof(tCANLogRecord), CANLOG_RECORDS);
+    g_bCANLogLost = false;
+    g_ui32CANLogOffset = 0;
+
+    g_sCANLogHeader.ui32Time = 0;
+    g_sCANLogHeader.ui16ID = CANLOG_ID_HEADER;
+    g_sCANLogHeader.ui8Flags = 0;
+    g_sCANLogHeader.ui8Len = 8;
+    memcpy(g_sCANLogHeader.pui8Data, "CANL", 4);
+    g_sCANLogHeader.pui8Data[4] = ui32TickHz & 0xFF;
+    g_sCANLogHeader.pui8Data[5] = (ui32TickHz >> 8) & 0xFF;
+    g_sCANLogHeader.pui8Data[6] = (ui32TickHz >> 16) & 0xFF;
+    g_sCANLogHeader.pui8Data[7] = ui32TickHz >> 24;
+
+    // Header first
+    g_ui32CANLogSinceHeader = CANLOG_HEADER_INTERVAL;
+}
+
+bool CANLogFrame(const tCANFrame *psFrame, uint8_t ui8Flags) {
+    tCANLogRecord *psRecord;
+    uint32_t ui32Len;
+
+    psRecord = RingBufWritePtr(&g_sCANLogRing);
+    if (psRecord == 0) {
+        g_ui32CANLogOverruns++;
+        g_bCANLogLost = true;
+        return false;
+    }
+
+    ui32Len = (psFrame->ui32Len > 8) ? 8 : psFrame->ui32Len;
+
+    psRecord->ui32Time = psFrame->ui32Time;
+    psRecord->ui16ID = psFrame->ui32ID & 0x7FF;
+    psRecord->ui8Flags = ui8Flags | (g_bCANLogLost ? CANLOG_FLAG_OVERRUN : 0);
+    psRecord->ui8Len = ui32Len;
+    memcpy(psRecord->pui8Data, psFrame->pui8Data, ui32Len);
+    memset(psRecord->pui8Data + ui32Len, 0, 8 - ui32Len);
+    RingBufCommit(&g_sCANLogRing);
+
+    g_bCANLogLost = false;
+
+    return true;
+}
+
+bool CANLogText(uint32_t ui32Time, const char *pcText) {
+    tCANLogRecord *psRecord;
+    uint32_t ui32Left;
+    uint32_t ui32Len;
+
+    // All or nothing, a message cut short would run into the next one
+    ui32Left = strlen(pcText);
+    if ((ui32Left + 7) / 8 > CANLOG_RECORDS - RingBufCount(&g_sCANLogRing)) {
+        return false;
+    }
+
+    while (ui32Left != 0) {
+        ui32Len = (ui32Left > 8) ? 8 : ui32Left;
+
+        psRecord = RingBufWritePtr(&g_sCANLogRing);
+        psRecord->ui32Time = ui32Time;
+        psRecord->ui16ID = CANLOG_ID_TEXT;
+        psRecord->ui8Flags = 0;
+        psRecord->ui8Len = ui32Len;
+        memcpy(psRecord->pui8Data, pcText, ui32Len);
+        memset(psRecord->pui8Data + ui32Len, 0, 8 - ui32Len);
+        RingBufCommit(&g_sCANLogRing);
+
+        pcText += ui32Len;
+        ui32Left -= ui32Len;
+    }
+
+    return true;
+}
+
+// Send the rest of a record, returning true once all of it has gone
+static bool CANLogSend(const uint8_t *pui8Record, tCANLogPut pfnPut) {
+    while (g_ui32CANLogOffset < sizeof(tCANLogRecord)) {
+        if (!pfnPut(pui8Record[g_ui32CANLogOffset])) {
+            return false;
+        }
+        g_ui32CANLogOffset++;
+    }
+    g_ui32CANLogOffset = 0;
+    return true;
+}
+
+void CANLogDrain(tCANLogPut pfnPut) {
+    const uint8_t *pui8Record;
+
+    while ((pui8Record = RingBufReadPtr(&g_sCANLogRing)) != 0) {
+        if (g_ui32CANLogSinceHeader >= CANLOG_HEADER_INTERVAL) {
+            if (!CANLogSend((const uint8_t *)&g_sCANLogHeader, pfnPut)) {
+                return;
+            }
+            g_ui32CANLogSinceHeader = 0;
+        }
+        if (!CANLogSend(pui8Record, pfnPut)) {
+            return;
+        }
+        g_ui32CANLogSinceHeader++;
+        RingBufRelease(&g_sCANLogRing);
+    }
+}
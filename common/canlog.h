@@ -0,0 +1,82 @@
+/* canlog.h
+ *
+ * Binary capture log of CAN frames.
+ *
+ * Frames are stored as fixed 16 byte records in a RAM ring and drained a
+ * byte at a time to UART, USB or anything else that takes bytes. All
+ * fields are little endian:
+ *
+ *   offset 0   uint32  timestamp in ticks (CANLatencyNow())
+ *          4   uint16  11 bit ID, or CANLOG_ID_HEADER
+ *          6   uint8   CANLOG_FLAG_* bits
+ *          7   uint8   data length, 0-8
+ *          8   uint8   data[8], unused bytes are 0
+ *
+ * A header record with CANLOG_ID_HEADER, "CANL" in data[0..3] and the tick
+ * rate in Hz in data[4..7] goes out before the first record and again
+ * after every CANLOG_HEADER_INTERVAL records. A capture started at any time
+ * can be decoded, and a lost byte only garbles the records up to the next
+ * header.
+ *
+ * Text records with CANLOG_ID_TEXT carry up to 8 characters of a message
+ * in data, with the length in the length field. A message can span several
+ * records and lines end with '\n'. tools/canlog.py reads this format.
+ */
+
+#ifndef CANLOG_H_
+#define CANLOG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "canframe.h"
+
+// Records the ring holds, must be a power of two
+#ifndef CANLOG_RECORDS
+#define CANLOG_RECORDS          128
+#endif
+
+// Records between headers
+#ifndef CANLOG_HEADER_INTERVAL
+#define CANLOG_HEADER_INTERVAL  64
+#endif
+
+#define CANLOG_ID_HEADER        0xFFFF
+#define CANLOG_ID_TEXT          0xFFFE
+
+// Record flags
+#define CANLOG_FLAG_TX          0x01    // Sent by this node
+#define CANLOG_FLAG_OVERRUN     0x02    // Log records were lost before it
+
+typedef struct {
+    uint32_t ui32Time;
+    uint16_t ui16ID;
+    uint8_t ui8Flags;
+    uint8_t ui8Len;
+    uint8_t pui8Data[8];
+} tCANLogRecord;
+
+// Write one byte, returning false if it cannot be taken right now
+typedef bool (*tCANLogPut)(uint8_t ui8Byte);
+
+// Empty the ring and set up the header record. ui32TickHz is the rate of
+// the frame timestamps.
+extern void CANLogInit(uint32_t ui32TickHz);
+
+// Add a frame, using its ui32Time as the timestamp. All frames must be
+// logged from the same context. Returns false if the ring was full.
+extern bool CANLogFrame(const tCANFrame *psFrame, uint8_t ui8Flags);
+
+// Add a text message stamped ui32Time, from the same context as
+// CANLogFrame(). Returns false, logging nothing, if the ring has no room
+// for all of it.
+extern bool CANLogText(uint32_t ui32Time, const char *pcText);
+
+// Pass bytes to pfnPut until it refuses or the ring is empty. Can be
+// called from a different context than CANLogFrame().
+extern void CANLogDrain(tCANLogPut pfnPut);
+
+// Records lost because the ring was full
+extern volatile uint32_t g_ui32CANLogOverruns;
+
+#endif /* CANLOG_H_ */
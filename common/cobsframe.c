@@ -0,0 +1,142 @@
+/* cobsframe.c
+ *
+ * Written for the EK-TM4C123GXL
+ *
+ * The encoder works in one pass straight into the output buffer: each COBS
+ * code byte is left as a hole and filled in once the length of its block
+ * is known. The decoder takes bytes in any sized pieces, so it can be fed
+ * straight from a receive ring without copying.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cobsframe.h"
+#include "crc16.h"
+
+uint32_t COBSFrameEncode(const uint8_t *pui8Data, uint32_t ui32Len,
+                         uint8_t *pui8Out) {
+    uint8_t pui8CRC[2];
+    uint16_t ui16CRC;
+    uint32_t ui32Code;
+    uint32_t ui32Out;
+    uint32_t ui32Index;
+    uint8_t ui8Byte;
+
+    ui16CRC = CRC16Update(CRC16_INIT, pui8Data, ui32Len);
+    pui8CRC[0] = ui16CRC & 0xFF;
+    pui8CRC[1] = ui16CRC >> 8;
+
+    ui32Code = 0;
+    ui32Out = 1;
+    for (ui32Index = 0; ui32Index < ui32Len + 2; ui32Index++) {
+        ui8Byte = (ui32Index < ui32Len) ? pui8Data[ui32Index] : pui8CRC[ui32Index - ui32Len];
+
+        if (ui8Byte != 0) {
+            pui8Out[ui32Out++] = ui8Byte;
+        }
+
+        // A zero or a full block of 254 ends the block
+        if (ui8Byte == 0 || ui32Out - ui32Code == 0xFF) {
+            pui8Out[ui32Code] = ui32Out - ui32Code;
+            ui32Code = ui32Out++;
+        }
+    }
+    pui8Out[ui32Code] = ui32Out - ui32Code;
+    pui8Out[ui32Out++] = 0;
+
+    return ui32Out;
+}
+
+void COBSFrameDecoderInit(tCOBSDecoder *psDecoder, uint8_t *pui8Buf,
+                          uint32_t ui32Size) {
+    psDecoder->pui8Buf = pui8Buf;
+    psDecoder->ui32Size = ui32Size;
+    psDecoder->ui32Len = 0;
+    psDecoder->ui32Fill = 0;
+    psDecoder->ui8Code = 0xFF;
+    psDecoder->ui8Left = 0;
+    psDecoder->bDiscard = false;
+    psDecoder->ui32Frames = 0;
+    psDecoder->ui32CRCErrors = 0;
+    psDecoder->ui32Errors = 0;
+}
+
+// A delimiter arrived, check what has been decoded since the last one
+static bool COBSFrameEnd(tCOBSDecoder *psDecoder) {
+    uint32_t ui32Len;
+    uint16_t ui16CRC;
+
+    ui32Len = psDecoder->ui32Fill;
+    if (psDecoder->bDiscard || psDecoder->ui8Left || ui32Len < 2) {
+        // Back to back delimiters are allowed as idle fill
+        if (psDecoder->bDiscard || ui32Len || psDecoder->ui8Left) {
+            psDecoder->ui32Errors++;
+        }
+        return false;
+    }
+
+    ui16CRC = CRC16Update(CRC16_INIT, psDecoder->pui8Buf, ui32Len - 2);
+    if (psDecoder->pui8Buf[ui32Len - 2] != (ui16CRC & 0xFF) ||
+        psDecoder->pui8Buf[ui32Len - 1] != (ui16CRC >> 8)) {
+        psDecoder->ui32CRCErrors++;
+        return false;
+    }
+
+    psDecoder->ui32Frames++;
+    psDecoder->ui32Len = ui32Len - 2;
+
+    return true;
+}
+
+uint32_t COBSFrameDecode(tCOBSDecoder *psDecoder, const uint8_t *pui8Data,
+                         uint32_t ui32Len, bool *pbFrame) {
+    uint32_t ui32Index;
+    uint8_t ui8Byte;
+
+    *pbFrame = false;
+
+    for (ui32Index = 0; ui32Index < ui32Len; ui32Index++) {
+        ui8Byte = pui8Data[ui32Index];
+
+        if (ui8Byte == 0) {
+            *pbFrame = COBSFrameEnd(psDecoder);
+            psDecoder->ui32Fill = 0;
+            psDecoder->ui8Code = 0xFF;
+            psDecoder->ui8Left = 0;
+            psDecoder->bDiscard = false;
+            if (*pbFrame) {
+                return ui32Index + 1;
+            }
+            continue;
+        }
+
+        if (psDecoder->bDiscard) {
+            continue;
+        }
+
+        if (psDecoder->ui8Left == 0) {
+            // Code byte. Every block but a full one stands for a zero after
+            // its data, which is only written once more data follows.
+            if (psDecoder->ui8Code != 0xFF) {
+                if (psDecoder->ui32Fill == psDecoder->ui32Size) {
+                    psDecoder->bDiscard = true;
+                    continue;
+                }
+                psDecoder->pui8Buf[psDecoder->ui32Fill++] = 0;
+            }
+            psDecoder->ui8Code = ui8Byte;
+            psDecoder->ui8Left = ui8Byte - 1;
+        }
+        else {
+            if (psDecoder->ui32Fill == psDecoder->ui32Size) {
+                psDecoder->bDiscard = true;
+                continue;
+            }
+            psDecoder->pui8Buf[psDecoder->ui32Fill++] = ui8Byte;
+            psDecoder->ui8Left--;
+        }
+    }
+
+    return ui32Len;
+}
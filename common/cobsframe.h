@@ -0,0 +1,60 @@
+/* cobsframe.h
+ *
+ * Message framing for byte streams such as a UART.
+ *
+ * A frame is the payload followed by its CRC-16 (crc16.h, little endian),
+ * COBS encoded so that it contains no zero bytes, then a single 0x00
+ * delimiter:
+ *
+ *   COBS(payload, crcLo, crcHi) 0x00
+ *
+ * A receiver that starts mid-stream or sees a corrupted byte loses at most
+ * the frame it is in: everything up to the next 0x00 is dropped and
+ * decoding starts over. The CRC catches corruption that still decodes.
+ * tools/uartframe.py speaks the same format.
+ */
+
+#ifndef COBSFRAME_H_
+#define COBSFRAME_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Encoded size of a frame with ui32Len payload bytes, including the CRC,
+// the COBS overhead of one byte per 254 and the delimiter
+#define COBSFRAME_ENCODED_MAX(ui32Len) \
+    ((ui32Len) + 2 + ((ui32Len) + 2) / 254 + 2)
+
+typedef struct {
+    uint8_t *pui8Buf;           // Decoded payload and CRC
+    uint32_t ui32Size;          // Size of pui8Buf
+    uint32_t ui32Len;           // Payload bytes of the last good frame
+    uint32_t ui32Fill;          // Bytes decoded since the last delimiter
+    uint8_t ui8Code;            // Code byte of the current COBS block
+    uint8_t ui8Left;            // Data bytes left in the current block
+    bool bDiscard;              // Skip to the next delimiter
+
+    // Counters
+    uint32_t ui32Frames;        // Good frames
+    uint32_t ui32CRCErrors;     // Decoded but failed the CRC
+    uint32_t ui32Errors;        // Too long, truncated or badly encoded
+} tCOBSDecoder;
+
+// Encode a frame into pui8Out, which holds COBSFRAME_ENCODED_MAX(ui32Len)
+// bytes. Returns the encoded length including the delimiter.
+extern uint32_t COBSFrameEncode(const uint8_t *pui8Data, uint32_t ui32Len,
+                                uint8_t *pui8Out);
+
+// Set up a decoder over pui8Buf. Frames with more than ui32Size - 2 payload
+// bytes are dropped.
+extern void COBSFrameDecoderInit(tCOBSDecoder *psDecoder, uint8_t *pui8Buf,
+                                 uint32_t ui32Size);
+
+// Decode from pui8Data until a good frame ends or the data runs out, and
+// return the number of bytes used. *pbFrame is set when a good frame is in
+// psDecoder->pui8Buf with psDecoder->ui32Len payload bytes; it stays there
+// until the next call.
+extern uint32_t COBSFrameDecode(tCOBSDecoder *psDecoder, const uint8_t *pui8Data,
+                                uint32_t ui32Len, bool *pbFrame);
+
+#endif /* COBSFRAME_H_ */
@@ -0,0 +1,18 @@
+/* crc16.h
+ *
+ * CRC-16/CCITT-FALSE: polynomial 0x1021, initial value 0xFFFF, no
+ * reflection, no final XOR. The check value for "123456789" is 0x29B1.
+ * This is the CRC the Arduino echo sketch and tools/ use.
+ */
+
+#ifndef CRC16_H_
+#define CRC16_H_
+
+#include <stdint.h>
+
+#define CRC16_INIT              0xFFFF
+
+// Continue ui16CRC over ui32Len bytes. Start a new CRC with CRC16_INIT.
+extern uint16_t CRC16Update(uint16_t ui16CRC, const uint8_t *pui8Data, uint32_t ui32Len);
+
+#endif /* CRC16_H_ */
@@ -0,0 +1,399 @@
+/* isotp.c
+ *
+ * Written for the EK-TM4C123GXL
+ *
+ * Frame layouts, normal addressing, first byte is the protocol control info:
+ *   single frame       0x0L, L data bytes (1-7)
+ *   first frame        0x1H LL, 6 data bytes, length 0xHLL (8-4095)
+ *                      0x10 00 LLLLLLLL, 2 data bytes, 32 bit length
+ *   consecutive frame  0x2N, 7 data bytes, N counts 1..15, 0, 1...
+ *   flow control       0x3S BS ST, S is 0 continue, 1 wait, 2 overflow
+ *
+ * Every frame is padded to 8 bytes.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "isotp.h"
+
+// Protocol control info types
+#define ISOTP_PCI_SF            0x00
+#define ISOTP_PCI_FF            0x10
+#define ISOTP_PCI_CF            0x20
+#define ISOTP_PCI_FC            0x30
+
+// Flow status values
+#define ISOTP_FS_CTS            0
+#define ISOTP_FS_WAIT           1
+#define ISOTP_FS_OVFLW          2
+#define ISOTP_FS_NONE           0xFF
+
+// Transmit states
+#define ISOTP_TX_IDLE           0
+#define ISOTP_TX_FIRST          1   // Single or first frame not sent yet
+#define ISOTP_TX_WAIT_FC        2
+#define ISOTP_TX_CF             3
+
+// Receive states
+#define ISOTP_RX_IDLE           0
+#define ISOTP_RX_CF             1
+#define ISOTP_RX_DONE           2
+
+// True once ui32Now has reached ui32Time, allowing for wrap
+static bool ISOTPReached(uint32_t ui32Now, uint32_t ui32Time) {
+    return (int32_t)(ui32Now - ui32Time) >= 0;
+}
+
+// Convert an STmin byte to ticks. Reserved values mean the longest time.
+static uint32_t ISOTPSTminTicks(const tISOTPLink *psLink, uint8_t ui8STmin) {
+    if (ui8STmin <= 0x7F) {
+        return ui8STmin * psLink->ui32TicksPerMs;
+    }
+    if ((ui8STmin >= 0xF1) && (ui8STmin <= 0xF9)) {
+        return ((ui8STmin - 0xF0) * 100 * psLink->ui32TicksPerMs) / 1000;
+    }
+    return 0x7F * psLink->ui32TicksPerMs;
+}
+
+// Send a frame made of ui32HeadLen protocol bytes and ui32DataLen payload
+// bytes, padded out to 8
+static bool ISOTPFrameSend(tISOTPLink *psLink, const uint8_t *pui8Head, uint32_t ui32HeadLen,
+                           const uint8_t *pui8Data, uint32_t ui32DataLen) {
+    uint8_t pui8Frame[8];
+
+    memcpy(pui8Frame, pui8Head, ui32HeadLen);
+    memcpy(pui8Frame + ui32HeadLen, pui8Data, ui32DataLen);
+    memset(pui8Frame + ui32HeadLen + ui32DataLen, ISOTP_PADDING, 8 - ui32HeadLen - ui32DataLen);
+
+    return psLink->pfnSend(psLink->ui32TxID, pui8Frame, 8);
+}
+
+static void ISOTPTxFinish(tISOTPLink *psLink, tISOTPStatus eStatus) {
+    psLink->ui8TxState = ISOTP_TX_IDLE;
+    psLink->eTxStatus = eStatus;
+}
+
+static void ISOTPRxAbort(tISOTPLink *psLink) {
+    psLink->ui8RxState = ISOTP_RX_IDLE;
+    psLink->ui8RxFlowStatus = ISOTP_FS_NONE;
+    psLink->eRxStatus = ISOTP_ERROR;
+    psLink->ui32RxDropped++;
+}
+
+void ISOTPInit(tISOTPLink *psLink, uint32_t ui32TxID, uint32_t ui32RxID,
+               tISOTPSend pfnSend, uint32_t ui32TicksPerMs) {
+    memset(psLink, 0, sizeof(tISOTPLink));
+
+    psLink->ui32TxID = ui32TxID;
+    psLink->ui32RxID = ui32RxID;
+    psLink->pfnSend = pfnSend;
+    psLink->ui32TicksPerMs = ui32TicksPerMs;
+    psLink->eTxStatus = ISOTP_IDLE;
+    psLink->eRxStatus = ISOTP_IDLE;
+    psLink->ui8RxFlowStatus = ISOTP_FS_NONE;
+}
+
+void ISOTPConfigure(tISOTPLink *psLink, uint8_t ui8BlockSize, uint8_t ui8STmin) {
+    psLink->ui8BlockSize = ui8BlockSize;
+    psLink->ui8STmin = ui8STmin;
+}
+
+void ISOTPRxBufferSet(tISOTPLink *psLink, uint8_t *pui8Buf, uint32_t ui32Size) {
+    psLink->pui8RxBuf = pui8Buf;
+    psLink->ui32RxSize = ui32Size;
+    psLink->ui8RxState = ISOTP_RX_IDLE;
+    psLink->ui8RxFlowStatus = ISOTP_FS_NONE;
+    psLink->eRxStatus = ISOTP_IDLE;
+}
+
+bool ISOTPSend(tISOTPLink *psLink, const uint8_t *pui8Data, uint32_t ui32Len,
+               uint32_t ui32Now) {
+    if ((psLink->ui8TxState != ISOTP_TX_IDLE) || (ui32Len == 0)) {
+        return false;
+    }
+
+    psLink->pui8TxData = pui8Data;
+    psLink->ui32TxLen = ui32Len;
+    psLink->ui32TxPos = 0;
+    psLink->ui8TxState = ISOTP_TX_FIRST;
+    psLink->eTxStatus = ISOTP_BUSY;
+
+    ISOTPPoll(psLink, ui32Now);
+
+    return true;
+}
+
+// Handle a received flow control frame
+static void ISOTPFlowControl(tISOTPLink *psLink, const tCANFrame *psFrame, uint32_t ui32Now) {
+    if ((psLink->ui8TxState != ISOTP_TX_WAIT_FC) || (psFrame->ui32Len < 3)) {
+        return;
+    }
+
+    switch (psFrame->pui8Data[0] & 0x0F) {
+    case ISOTP_FS_CTS:
+        psLink->ui8TxBlockLeft = psFrame->pui8Data[1];
+        psLink->ui32TxSTmin = ISOTPSTminTicks(psLink, psFrame->pui8Data[2]);
+        psLink->ui8TxWaits = 0;
+        psLink->ui8TxState = ISOTP_TX_CF;
+        psLink->ui32TxTime = ui32Now;
+        break;
+
+    case ISOTP_FS_WAIT:
+        if (++psLink->ui8TxWaits > ISOTP_MAX_WAITS) {
+            ISOTPTxFinish(psLink, ISOTP_ERROR);
+        } else {
+            psLink->ui32TxTime = ui32Now + ISOTP_TIMEOUT_MS * psLink->ui32TicksPerMs;
+        }
+        break;
+
+    default:
+        // Overflow or a reserved flow status, the peer will not take it
+        ISOTPTxFinish(psLink, ISOTP_ERROR);
+        break;
+    }
+}
+
+void ISOTPFrameReceived(tISOTPLink *psLink, const tCANFrame *psFrame, uint32_t ui32Now) {
+    const uint8_t *pui8Data = psFrame->pui8Data;
+    uint32_t ui32Len;
+    uint32_t ui32Off;
+    uint32_t ui32Count;
+
+    if (psFrame->ui32Len == 0) {
+        return;
+    }
+
+    switch (pui8Data[0] & 0xF0) {
+    case ISOTP_PCI_SF:
+        ui32Len = pui8Data[0] & 0x0F;
+        if ((ui32Len == 0) || (ui32Len > psFrame->ui32Len - 1)) {
+            return;
+        }
+
+        // A new message replaces one still being received, but not one the
+        // caller has not collected yet
+        if ((psLink->ui8RxState == ISOTP_RX_DONE) || (psLink->pui8RxBuf == 0) ||
+            (ui32Len > psLink->ui32RxSize)) {
+            psLink->ui32RxDropped++;
+            return;
+        }
+
+        memcpy(psLink->pui8RxBuf, pui8Data + 1, ui32Len);
+        psLink->ui32RxLen = ui32Len;
+        psLink->ui8RxState = ISOTP_RX_DONE;
+        psLink->ui8RxFlowStatus = ISOTP_FS_NONE;
+        psLink->eRxStatus = ISOTP_DONE;
+        break;
+
+    case ISOTP_PCI_FF:
+        if (psFrame->ui32Len < 8) {
+            return;
+        }
+
+        ui32Len = ((pui8Data[0] & 0x0F) << 8) | pui8Data[1];
+        ui32Off = 2;
+        if (ui32Len == 0) {
+            ui32Len = ((uint32_t)pui8Data[2] << 24) | ((uint32_t)pui8Data[3] << 16) |
+                      ((uint32_t)pui8Data[4] << 8) | pui8Data[5];
+            ui32Off = 6;
+        }
+        if (ui32Len < 8) {
+            return;
+        }
+
+        // No room, tell the sender to give up
+        if ((psLink->ui8RxState == ISOTP_RX_DONE) || (psLink->pui8RxBuf == 0) ||
+            (ui32Len > psLink->ui32RxSize)) {
+            if (psLink->ui8RxState == ISOTP_RX_CF) {
+                psLink->ui8RxState = ISOTP_RX_IDLE;
+                psLink->eRxStatus = ISOTP_ERROR;
+            }
+            psLink->ui8RxFlowStatus = ISOTP_FS_OVFLW;
+            psLink->ui32RxDropped++;
+            break;
+        }
+
+        memcpy(psLink->pui8RxBuf, pui8Data + ui32Off, 8 - ui32Off);
+        psLink->ui32RxLen = ui32Len;
+        psLink->ui32RxPos = 8 - ui32Off;
+        psLink->ui8RxSeq = 1;
+        psLink->ui8RxState = ISOTP_RX_CF;
+        psLink->ui8RxFlowStatus = ISOTP_FS_CTS;
+        psLink->eRxStatus = ISOTP_BUSY;
+        break;
+
+    case ISOTP_PCI_CF:
+        // Ignore frames that are not expected, including ones that arrive
+        // before our flow control has gone out
+        if ((psLink->ui8RxState != ISOTP_RX_CF) || (psLink->ui8RxFlowStatus != ISOTP_FS_NONE)) {
+            return;
+        }
+
+        if ((pui8Data[0] & 0x0F) != psLink->ui8RxSeq) {
+            ISOTPRxAbort(psLink);
+            return;
+        }
+
+        ui32Count = psLink->ui32RxLen - psLink->ui32RxPos;
+        if (ui32Count > 7) {
+            ui32Count = 7;
+        }
+        if (ui32Count > psFrame->ui32Len - 1) {
+            ISOTPRxAbort(psLink);
+            return;
+        }
+
+        memcpy(psLink->pui8RxBuf + psLink->ui32RxPos, pui8Data + 1, ui32Count);
+        psLink->ui32RxPos += ui32Count;
+        psLink->ui8RxSeq = (psLink->ui8RxSeq + 1) & 0x0F;
+        psLink->ui32RxTime = ui32Now + ISOTP_TIMEOUT_MS * psLink->ui32TicksPerMs;
+
+        if (psLink->ui32RxPos == psLink->ui32RxLen) {
+            psLink->ui8RxState = ISOTP_RX_DONE;
+            psLink->eRxStatus = ISOTP_DONE;
+        } else if (psLink->ui8BlockSize && (--psLink->ui8RxBlockLeft == 0)) {
+            psLink->ui8RxFlowStatus = ISOTP_FS_CTS;
+        }
+        break;
+
+    case ISOTP_PCI_FC:
+        ISOTPFlowControl(psLink, psFrame, ui32Now);
+        break;
+
+    default:
+        break;
+    }
+
+    // Get a flow control frame out straight away if one is due
+    ISOTPPoll(psLink, ui32Now);
+}
+
+// Send the single or first frame
+static void ISOTPTxFirst(tISOTPLink *psLink, uint32_t ui32Now) {
+    uint8_t pui8Head[6];
+    uint32_t ui32HeadLen;
+    uint32_t ui32Len = psLink->ui32TxLen;
+
+    if (ui32Len <= 7) {
+        pui8Head[0] = ISOTP_PCI_SF | ui32Len;
+        if (ISOTPFrameSend(psLink, pui8Head, 1, psLink->pui8TxData, ui32Len)) {
+            ISOTPTxFinish(psLink, ISOTP_DONE);
+        }
+        return;
+    }
+
+    if (ui32Len <= 4095) {
+        pui8Head[0] = ISOTP_PCI_FF | (ui32Len >> 8);
+        pui8Head[1] = ui32Len & 0xFF;
+        ui32HeadLen = 2;
+    } else {
+        pui8Head[0] = ISOTP_PCI_FF;
+        pui8Head[1] = 0;
+        pui8Head[2] = ui32Len >> 24;
+        pui8Head[3] = (ui32Len >> 16) & 0xFF;
+        pui8Head[4] = (ui32Len >> 8) & 0xFF;
+        pui8Head[5] = ui32Len & 0xFF;
+        ui32HeadLen = 6;
+    }
+
+    if (ISOTPFrameSend(psLink, pui8Head, ui32HeadLen, psLink->pui8TxData, 8 - ui32HeadLen)) {
+        psLink->ui32TxPos = 8 - ui32HeadLen;
+        psLink->ui8TxSeq = 1;
+        psLink->ui8TxWaits = 0;
+        psLink->ui8TxState = ISOTP_TX_WAIT_FC;
+        psLink->ui32TxTime = ui32Now + ISOTP_TIMEOUT_MS * psLink->ui32TicksPerMs;
+    }
+}
+
+// Send consecutive frames until the block ends, STmin holds the next one
+// back, or the send hook refuses
+static void ISOTPTxConsecutive(tISOTPLink *psLink, uint32_t ui32Now) {
+    uint8_t ui8Head;
+    uint32_t ui32Count;
+
+    while (ISOTPReached(ui32Now, psLink->ui32TxTime)) {
+        ui32Count = psLink->ui32TxLen - psLink->ui32TxPos;
+        if (ui32Count > 7) {
+            ui32Count = 7;
+        }
+
+        ui8Head = ISOTP_PCI_CF | psLink->ui8TxSeq;
+        if (!ISOTPFrameSend(psLink, &ui8Head, 1, psLink->pui8TxData + psLink->ui32TxPos, ui32Count)) {
+            return;
+        }
+
+        psLink->ui32TxPos += ui32Count;
+        psLink->ui8TxSeq = (psLink->ui8TxSeq + 1) & 0x0F;
+        psLink->ui32TxTime = ui32Now + psLink->ui32TxSTmin;
+
+        if (psLink->ui32TxPos == psLink->ui32TxLen) {
+            ISOTPTxFinish(psLink, ISOTP_DONE);
+            return;
+        }
+
+        if (psLink->ui8TxBlockLeft && (--psLink->ui8TxBlockLeft == 0)) {
+            psLink->ui8TxState = ISOTP_TX_WAIT_FC;
+            psLink->ui32TxTime = ui32Now + ISOTP_TIMEOUT_MS * psLink->ui32TicksPerMs;
+            return;
+        }
+    }
+}
+
+void ISOTPPoll(tISOTPLink *psLink, uint32_t ui32Now) {
+    uint8_t pui8FC[3];
+
+    switch (psLink->ui8TxState) {
+    case ISOTP_TX_FIRST:
+        ISOTPTxFirst(psLink, ui32Now);
+        break;
+    case ISOTP_TX_WAIT_FC:
+        if (ISOTPReached(ui32Now, psLink->ui32TxTime)) {
+            ISOTPTxFinish(psLink, ISOTP_ERROR);
+        }
+        break;
+    case ISOTP_TX_CF:
+        ISOTPTxConsecutive(psLink, ui32Now);
+        break;
+    default:
+        break;
+    }
+
+    if (psLink->ui8RxFlowStatus != ISOTP_FS_NONE) {
+        pui8FC[0] = ISOTP_PCI_FC | psLink->ui8RxFlowStatus;
+        pui8FC[1] = psLink->ui8BlockSize;
+        pui8FC[2] = psLink->ui8STmin;
+        if (ISOTPFrameSend(psLink, pui8FC, 3, 0, 0)) {
+            // The consecutive frame timeout runs from when the sender is
+            // told to go ahead
+            psLink->ui8RxFlowStatus = ISOTP_FS_NONE;
+            psLink->ui8RxBlockLeft = psLink->ui8BlockSize;
+            psLink->ui32RxTime = ui32Now + ISOTP_TIMEOUT_MS * psLink->ui32TicksPerMs;
+        }
+    } else if ((psLink->ui8RxState == ISOTP_RX_CF) && ISOTPReached(ui32Now, psLink->ui32RxTime)) {
+        ISOTPRxAbort(psLink);
+    }
+}
+
+tISOTPStatus ISOTPTxStatus(tISOTPLink *psLink) {
+    tISOTPStatus eStatus = psLink->eTxStatus;
+
+    if ((eStatus == ISOTP_DONE) || (eStatus == ISOTP_ERROR)) {
+        psLink->eTxStatus = ISOTP_IDLE;
+    }
+
+    return eStatus;
+}
+
+tISOTPStatus ISOTPRxStatus(tISOTPLink *psLink, uint32_t *pui32Len) {
+    tISOTPStatus eStatus = psLink->eRxStatus;
+
+    if (eStatus == ISOTP_DONE) {
+        *pui32Len = psLink->ui32RxLen;
+    } else if (eStatus == ISOTP_ERROR) {
+        psLink->eRxStatus = ISOTP_IDLE;
+    }
+
+    return eStatus;
+}
@@ -0,0 +1,122 @@
+/* isotp.h
+ *
+ * ISO 15765-2 (ISO-TP) transport for messages longer than one CAN frame.
+ *
+ * Normal addressing with 11 bit IDs. A link sends data and its own flow
+ * control frames on ui32TxID and takes the peer's frames from ui32RxID.
+ * Messages up to 4095 bytes use the classic first frame, longer ones the
+ * 32 bit length escape from the 2016 edition.
+ *
+ * Nothing is copied: ISOTPSend() transmits straight out of the caller's
+ * buffer, which must stay untouched until the transfer finishes, and
+ * received data is reassembled straight into the buffer given to
+ * ISOTPRxBufferSet().
+ *
+ * All calls for a link must come from the same context, normally the main
+ * loop. Times are ticks of a free running counter such as CANLatencyNow().
+ */
+
+#ifndef ISOTP_H_
+#define ISOTP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "canframe.h"
+
+// Byte used to fill frames out to 8 bytes
+#ifndef ISOTP_PADDING
+#define ISOTP_PADDING           0xCC
+#endif
+
+// N_Bs / N_Cr: how long to wait for a flow control or consecutive frame
+#ifndef ISOTP_TIMEOUT_MS
+#define ISOTP_TIMEOUT_MS        1000
+#endif
+
+// Flow control WAIT frames accepted in a row before giving up
+#ifndef ISOTP_MAX_WAITS
+#define ISOTP_MAX_WAITS         10
+#endif
+
+// Queue a CAN frame for transmission, returning false if it could not be
+// queued right now. It is tried again on the next ISOTPPoll(). Frames must
+// go out in the order they are passed in.
+typedef bool (*tISOTPSend)(uint32_t ui32ID, const uint8_t *pui8Data, uint32_t ui32Len);
+
+typedef enum {
+    ISOTP_IDLE,                 // Nothing going on
+    ISOTP_BUSY,                 // Transfer in progress
+    ISOTP_DONE,                 // Transfer finished
+    ISOTP_ERROR                 // Timeout, overflow or sequence error
+} tISOTPStatus;
+
+typedef struct {
+    // Fixed by ISOTPInit() and ISOTPConfigure()
+    uint32_t ui32TxID;
+    uint32_t ui32RxID;
+    tISOTPSend pfnSend;
+    uint32_t ui32TicksPerMs;
+    uint8_t ui8BlockSize;       // Advertised in our flow control frames
+    uint8_t ui8STmin;
+
+    // Transmit side
+    tISOTPStatus eTxStatus;
+    uint8_t ui8TxState;
+    uint8_t ui8TxSeq;
+    uint8_t ui8TxBlockLeft;     // Frames left in the block, 0 = no limit
+    uint8_t ui8TxWaits;
+    const uint8_t *pui8TxData;
+    uint32_t ui32TxLen;
+    uint32_t ui32TxPos;
+    uint32_t ui32TxSTmin;       // Peer's separation time in ticks
+    uint32_t ui32TxTime;        // Next frame time or flow control deadline
+
+    // Receive side
+    tISOTPStatus eRxStatus;
+    uint8_t ui8RxState;
+    uint8_t ui8RxSeq;
+    uint8_t ui8RxBlockLeft;
+    uint8_t ui8RxFlowStatus;    // Flow control frame waiting to be sent
+    uint8_t *pui8RxBuf;
+    uint32_t ui32RxSize;
+    uint32_t ui32RxLen;
+    uint32_t ui32RxPos;
+    uint32_t ui32RxTime;        // Consecutive frame deadline
+    uint32_t ui32RxDropped;     // Messages refused or aborted
+} tISOTPLink;
+
+// Set up a link. ui32TicksPerMs is the rate of the times passed in later.
+extern void ISOTPInit(tISOTPLink *psLink, uint32_t ui32TxID, uint32_t ui32RxID,
+                      tISOTPSend pfnSend, uint32_t ui32TicksPerMs);
+
+// Block size and STmin (raw ISO-TP encoding) to ask the sender for. The
+// default is 0 and 0, everything back to back.
+extern void ISOTPConfigure(tISOTPLink *psLink, uint8_t ui8BlockSize, uint8_t ui8STmin);
+
+// Give the link a buffer to receive the next message into. Messages that
+// do not fit are refused with an overflow flow control.
+extern void ISOTPRxBufferSet(tISOTPLink *psLink, uint8_t *pui8Buf, uint32_t ui32Size);
+
+// Start sending ui32Len bytes from pui8Data. Returns false if a transfer is
+// already running or the length is 0.
+extern bool ISOTPSend(tISOTPLink *psLink, const uint8_t *pui8Data, uint32_t ui32Len,
+                      uint32_t ui32Now);
+
+// Pass in every frame received with the link's ui32RxID
+extern void ISOTPFrameReceived(tISOTPLink *psLink, const tCANFrame *psFrame, uint32_t ui32Now);
+
+// Send what is due and check timeouts. Call often, the consecutive frame
+// rate depends on it.
+extern void ISOTPPoll(tISOTPLink *psLink, uint32_t ui32Now);
+
+// State of the current or last transmit. Reading ISOTP_DONE or ISOTP_ERROR
+// returns the transmit side to ISOTP_IDLE.
+extern tISOTPStatus ISOTPTxStatus(tISOTPLink *psLink);
+
+// State of the receive side. On ISOTP_DONE the message length is stored in
+// *pui32Len and the buffer belongs to the caller until ISOTPRxBufferSet() is
+// called again. Reading ISOTP_ERROR returns the receive side to ISOTP_IDLE.
+extern tISOTPStatus ISOTPRxStatus(tISOTPLink *psLink, uint32_t *pui32Len);
+
+#endif /* ISOTP_H_ */
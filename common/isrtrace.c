@@ -0,0 +1,125 @@
+/* isrtrace.c
+ *
+ * Written for the EK-TM4C123GXL
+ *
+ * The drain side copies a record out of the ring before sending it and
+ * checks afterwards that the writers have not lapped it in the meantime,
+ * so it never needs to mask interrupts itself.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "isrtrace.h"
+
+// Debug and DWT registers, not covered by the TivaWare headers
+#define ISRTRACE_DEMCR          (*(volatile uint32_t *)0xE000EDFC)
+#define ISRTRACE_DEMCR_TRCENA   0x01000000
+#define ISRTRACE_DWT_CTRL       (*(volatile uint32_t *)0xE0001000)
+#define ISRTRACE_DWT_CYCCNT     (*(volatile uint32_t *)0xE0001004)
+#define ISRTRACE_DWT_CYCCNTENA  0x00000001
+
+tISRTraceBuf g_sISRTrace;
+
+// Drain state: next record to send, the copy being sent and its progress,
+// and the stream header when one is due
+static uint32_t g_ui32ISRTraceTail;
+static tISRTraceRecord g_sISRTraceOut;
+static uint32_t g_ui32ISRTraceOffset;
+static uint32_t g_pui32ISRTraceHeader[4];
+static bool g_bISRTraceHeader;
+static uint32_t g_ui32ISRTraceSinceHeader;
+
+// Queue the stream header, ui32Repeat is 0 for the first one
+static void ISRTraceHeader(uint32_t ui32Repeat) {
+    g_pui32ISRTraceHeader[0] = ISRTRACE_MAGIC;
+    g_pui32ISRTraceHeader[1] = g_sISRTrace.ui32ClockHz;
+    g_pui32ISRTraceHeader[2] = 0;
+    g_pui32ISRTraceHeader[3] = ui32Repeat;
+    g_bISRTraceHeader = true;
+    g_ui32ISRTraceOffset = 0;
+    g_ui32ISRTraceSinceHeader = 0;
+}
+
+void ISRTraceInit(uint32_t ui32ClockHz) {
+    g_sISRTrace.ui32Magic = ISRTRACE_MAGIC;
+    g_sISRTrace.ui32ClockHz = ui32ClockHz;
+    g_sISRTrace.ui32Size = ISRTRACE_RECORDS;
+    g_sISRTrace.ui32Head = 0;
+
+    g_ui32ISRTraceTail = 0;
+    ISRTraceHeader(0);
+
+#ifndef ISRTRACE_NO_DWT
+    // The cycle counter needs trace enabled in the debug block
+    ISRTRACE_DEMCR |= ISRTRACE_DEMCR_TRCENA;
+    ISRTRACE_DWT_CYCCNT = 0;
+    ISRTRACE_DWT_CTRL |= ISRTRACE_DWT_CYCCNTENA;
+#endif
+}
+
+// Copy the next record to send, skipping any that were overwritten
+static bool ISRTraceNext(void) {
+    uint32_t ui32Head;
+
+    for (;;) {
+        ui32Head = g_sISRTrace.ui32Head;
+        if (ui32Head - g_ui32ISRTraceTail > ISRTRACE_RECORDS) {
+            g_ui32ISRTraceTail = ui32Head - ISRTRACE_RECORDS;
+        }
+        if (ui32Head == g_ui32ISRTraceTail) {
+            return false;
+        }
+
+        g_sISRTraceOut = g_sISRTrace.psRecords[g_ui32ISRTraceTail & (ISRTRACE_RECORDS - 1)];
+
+        // A writer may have reused the slot while it was copied. The record
+        // number in the copy tells, and the next pass moves on to the oldest
+        // record still intact.
+        if ((uint16_t)(g_sISRTraceOut.ui32Tag >> 16) == (uint16_t)g_ui32ISRTraceTail) {
+            g_ui32ISRTraceTail++;
+            return true;
+        }
+    }
+}
+
+// Send the rest of ui32Size bytes, returning true once all have gone
+static bool ISRTraceSend(const void *pvData, uint32_t ui32Size, tISRTracePut pfnPut) {
+    const uint8_t *pui8Out = pvData;
+
+    while (g_ui32ISRTraceOffset < ui32Size) {
+        if (!pfnPut(pui8Out[g_ui32ISRTraceOffset])) {
+            return false;
+        }
+        g_ui32ISRTraceOffset++;
+    }
+    return true;
+}
+
+void ISRTraceDrain(tISRTracePut pfnPut) {
+    for (;;) {
+        if (g_bISRTraceHeader) {
+            if (!ISRTraceSend(g_pui32ISRTraceHeader, sizeof(g_pui32ISRTraceHeader), pfnPut)) {
+                return;
+            }
+            g_bISRTraceHeader = false;
+            g_ui32ISRTraceOffset = sizeof(tISRTraceRecord);
+        }
+
+        if (g_ui32ISRTraceOffset == sizeof(tISRTraceRecord)) {
+            if (g_ui32ISRTraceSinceHeader >= ISRTRACE_HEADER_INTERVAL) {
+                ISRTraceHeader(1);
+                continue;
+            }
+            if (!ISRTraceNext()) {
+                return;
+            }
+            g_ui32ISRTraceOffset = 0;
+            g_ui32ISRTraceSinceHeader++;
+        }
+
+        if (!ISRTraceSend(&g_sISRTraceOut, sizeof(tISRTraceRecord), pfnPut)) {
+            return;
+        }
+    }
+}
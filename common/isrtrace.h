@@ -0,0 +1,150 @@
+/* isrtrace.h
+ *
+ * Interrupt entry/exit trace stamped with the Cortex-M4 DWT cycle counter.
+ *
+ * ISRTRACE_ENTER() and ISRTRACE_EXIT() at the top and bottom of a handler
+ * add one 8 byte record to a RAM ring, overwriting the oldest:
+ *
+ *   offset 0   uint32  DWT cycle count
+ *          4   uint8   event ID, ISRTRACE_ID_*
+ *          5   uint8   record type, ISRTRACE_TYPE_*
+ *          6   uint16  record number, low 16 bits
+ *
+ * A record is a cycle counter load, two stores and the index update, with
+ * interrupts masked for those few cycles so nested handlers cannot tear
+ * each other's records.
+ *
+ * g_sISRTrace starts with a 16 byte header (magic "ISRT", clock in Hz,
+ * ring size, records written), so a debugger memory dump of it can be
+ * decoded as is. ISRTraceDrain() streams records oldest first behind the
+ * same header with a ring size of 0, and repeats the header every
+ * ISRTRACE_HEADER_INTERVAL records so a capture can start at any time. The
+ * last word of a stream header is 0 in the first one after ISRTraceInit()
+ * and 1 in the repeats. tools/isrtrace.py reads both.
+ *
+ * Everything is little endian. The cycle counter wraps every 53 s at
+ * 80 MHz; the decoder unwraps it, so there must be at least one record per
+ * wrap.
+ *
+ * For a build without a DWT, a host simulation for example, define
+ * ISRTRACE_NO_DWT and supply ISRTRACE_CYCLES(), and ISRTRACE_LOCK() and
+ * ISRTRACE_UNLOCK() if needed; the output stays the same.
+ */
+
+#ifndef ISRTRACE_H_
+#define ISRTRACE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Set to 0 to compile the trace points out
+#ifndef ISRTRACE_ENABLE
+#define ISRTRACE_ENABLE         1
+#endif
+
+// Records in the ring, must be a power of two
+#ifndef ISRTRACE_RECORDS
+#define ISRTRACE_RECORDS        256
+#endif
+
+// Records streamed between headers
+#ifndef ISRTRACE_HEADER_INTERVAL
+#define ISRTRACE_HEADER_INTERVAL 256
+#endif
+
+#define ISRTRACE_MAGIC          0x54525349  // "ISRT"
+
+// Event IDs, kept in step with the names in tools/isrtrace.py
+#define ISRTRACE_ID_TIMER       1   // TivaWare_Test timerISR
+#define ISRTRACE_ID_ADC         2   // TivaWare_Test getADC
+#define ISRTRACE_ID_CAN         3   // CANISR, CAN0IntHandler in CANTX/CANRX
+#define ISRTRACE_ID_USB         4   // USB0 Hwi in the TI-RTOS projects
+#define ISRTRACE_ID_USER        16  // First ID free for the application
+
+// Record types
+#define ISRTRACE_TYPE_ENTRY     0
+#define ISRTRACE_TYPE_EXIT      1
+#define ISRTRACE_TYPE_MARK      2   // A single point in time
+
+typedef struct {
+    uint32_t ui32Cycles;
+    uint32_t ui32Tag;           // ID, type << 8, record number << 16
+} tISRTraceRecord;
+
+typedef struct {
+    uint32_t ui32Magic;
+    uint32_t ui32ClockHz;
+    uint32_t ui32Size;          // ISRTRACE_RECORDS
+    volatile uint32_t ui32Head; // Records written, free running
+    tISRTraceRecord psRecords[ISRTRACE_RECORDS];
+} tISRTraceBuf;
+
+extern tISRTraceBuf g_sISRTrace;
+
+// Write one byte, returning false if it cannot be taken right now
+typedef bool (*tISRTracePut)(uint8_t ui8Byte);
+
+// Cycle counter
+#ifndef ISRTRACE_CYCLES
+#define ISRTRACE_CYCLES()       (*(volatile uint32_t *)0xE0001004)
+#endif
+
+// Mask interrupts around a record and put the previous state back
+#ifndef ISRTRACE_LOCK
+#if defined(__TI_COMPILER_VERSION__)
+#define ISRTRACE_LOCK(ui32Key)      ui32Key = _disable_interrupts()
+#define ISRTRACE_UNLOCK(ui32Key)    _restore_interrupts(ui32Key)
+#elif defined(__GNUC__) && defined(__arm__)
+#define ISRTRACE_LOCK(ui32Key)                                              \
+    __asm volatile ("mrs %0, primask\n\tcpsid i" : "=r" (ui32Key) : : "memory")
+#define ISRTRACE_UNLOCK(ui32Key)                                            \
+    __asm volatile ("msr primask, %0" : : "r" (ui32Key) : "memory")
+#else
+#define ISRTRACE_LOCK(ui32Key)      (void)(ui32Key = 0)
+#define ISRTRACE_UNLOCK(ui32Key)    (void)(ui32Key)
+#endif
+#endif
+
+// Forced inline so a handler running from SRAM (TivaWare_Test/ramfunc.h)
+// does not call back into flash for it in an unoptimized build
+#if defined(__TI_COMPILER_VERSION__) || defined(__GNUC__)
+#define ISRTRACE_INLINE         static inline __attribute__((always_inline))
+#else
+#define ISRTRACE_INLINE         static inline
+#endif
+
+ISRTRACE_INLINE void ISRTraceEvent(uint32_t ui32Tag) {
+    tISRTraceRecord *psRecord;
+    uint32_t ui32Key;
+    uint32_t ui32Head;
+
+    ISRTRACE_LOCK(ui32Key);
+    ui32Head = g_sISRTrace.ui32Head;
+    psRecord = &g_sISRTrace.psRecords[ui32Head & (ISRTRACE_RECORDS - 1)];
+    psRecord->ui32Cycles = ISRTRACE_CYCLES();
+    psRecord->ui32Tag = ui32Tag | (ui32Head << 16);
+    g_sISRTrace.ui32Head = ui32Head + 1;
+    ISRTRACE_UNLOCK(ui32Key);
+}
+
+#if ISRTRACE_ENABLE
+#define ISRTRACE_ENTER(ui8ID)   ISRTraceEvent((ui8ID) | (ISRTRACE_TYPE_ENTRY << 8))
+#define ISRTRACE_EXIT(ui8ID)    ISRTraceEvent((ui8ID) | (ISRTRACE_TYPE_EXIT << 8))
+#define ISRTRACE_POINT(ui8ID)   ISRTraceEvent((ui8ID) | (ISRTRACE_TYPE_MARK << 8))
+#else
+#define ISRTRACE_ENTER(ui8ID)
+#define ISRTRACE_EXIT(ui8ID)
+#define ISRTRACE_POINT(ui8ID)
+#endif
+
+// Start the DWT cycle counter and empty the ring. ui32ClockHz is the
+// processor clock, recorded for the decoder.
+extern void ISRTraceInit(uint32_t ui32ClockHz);
+
+// Pass the stream header, then records oldest first with the header
+// repeated every ISRTRACE_HEADER_INTERVAL records, to pfnPut until it
+// refuses or the ring is empty. Records overwritten before they were sent
+// show up as a gap in the record numbers. Call from one context only.
+extern void ISRTraceDrain(tISRTracePut pfnPut);
+
+#endif /* ISRTRACE_H_ */
@@ -0,0 +1,161 @@
+/* pcprof.c
+ *
+ * Written for the EK-TM4C123GXL
+ *
+ * The handler has to find the exception frame before any C code moves the
+ * stack pointer, so it is a few instructions of assembly: bit 2 of the
+ * EXC_RETURN value in LR says whether the interrupted code was on the main
+ * or the process stack, and that stack pointer goes to PCProfSample(). The
+ * stacked PC is word 6 of the frame, with or without the FPU state.
+ */
+
+#if defined(PCPROF_HOST)
+// For the register names in ucontext_t
+#define _GNU_SOURCE
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "pcprof.h"
+
+#if defined(PCPROF_HOST)
+#include <signal.h>
+#include <string.h>
+#include <sys/time.h>
+#include <ucontext.h>
+#else
+#include "inc/hw_ints.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/systick.h"
+#endif
+
+tPCProfBuf g_sPCProf;
+
+// Dump progress in bytes, 0 when no dump is under way
+static uint32_t g_ui32PCProfOffset;
+
+// Count one sample
+static void PCProfCount(uint32_t ui32PC) {
+    uint32_t ui32Bucket;
+    uint32_t ui32Index;
+
+    g_sPCProf.ui32Samples++;
+
+    ui32Bucket = (ui32PC - PCPROF_BASE) >> PCPROF_SHIFT;
+    if (ui32Bucket >= PCPROF_BUCKETS) {
+        // The SRAM buckets follow the flash ones
+        ui32Bucket = (ui32PC - PCPROF_RAM_BASE) >> PCPROF_SHIFT;
+        if (ui32Bucket >= PCPROF_RAM_BUCKETS) {
+            g_sPCProf.ui32Outside++;
+            return;
+        }
+        ui32Bucket += PCPROF_BUCKETS;
+    }
+
+    if (++g_sPCProf.pui16Counts[ui32Bucket] == 0xFFFF) {
+        for (ui32Index = 0; ui32Index < PCPROF_BUCKETS + PCPROF_RAM_BUCKETS; ui32Index++) {
+            g_sPCProf.pui16Counts[ui32Index] >>= 1;
+        }
+        g_sPCProf.ui32Outside >>= 1;
+        g_sPCProf.ui32Halved++;
+    }
+}
+
+#if defined(PCPROF_HOST)
+// SIGPROF handler, the interrupted PC is in the saved context
+static void PCProfSignal(int iSignal, siginfo_t *psInfo, void *pvContext) {
+    ucontext_t *psContext = pvContext;
+
+    (void)iSignal;
+    (void)psInfo;
+#if defined(__x86_64__)
+    PCProfCount((uint32_t)psContext->uc_mcontext.gregs[REG_RIP]);
+#elif defined(__aarch64__)
+    PCProfCount((uint32_t)psContext->uc_mcontext.pc);
+#else
+#error "PCPROF_HOST needs the PC register name for this host"
+#endif
+}
+#else
+// Called from PCProfIntHandler with the exception frame
+void PCProfSample(uint32_t *pui32Frame) {
+    PCProfCount(pui32Frame[6]);
+}
+
+#if defined(__TI_COMPILER_VERSION__)
+void PCProfIntHandler(void) {
+    __asm("    tst     lr, #4\n"
+          "    ite     eq\n"
+          "    mrseq   r0, msp\n"
+          "    mrsne   r0, psp\n"
+          "    b       PCProfSample\n");
+}
+#else
+void __attribute__((naked)) PCProfIntHandler(void) {
+    __asm volatile ("    tst     lr, #4\n"
+                    "    ite     eq\n"
+                    "    mrseq   r0, msp\n"
+                    "    mrsne   r0, psp\n"
+                    "    b       PCProfSample\n");
+}
+#endif
+#endif
+
+void PCProfInit(uint32_t ui32ClockHz, uint32_t ui32RateHz) {
+    uint32_t ui32Index;
+
+    g_sPCProf.ui32Magic = PCPROF_MAGIC;
+    g_sPCProf.ui32RateHz = ui32RateHz;
+    g_sPCProf.ui32Base = PCPROF_BASE;
+    g_sPCProf.ui32Shift = PCPROF_SHIFT;
+    g_sPCProf.ui32Buckets = PCPROF_BUCKETS;
+    g_sPCProf.ui32Samples = 0;
+    g_sPCProf.ui32Outside = 0;
+    g_sPCProf.ui32Halved = 0;
+    g_sPCProf.ui32RAMBase = PCPROF_RAM_BASE;
+    g_sPCProf.ui32RAMBuckets = PCPROF_RAM_BUCKETS;
+    for (ui32Index = 0; ui32Index < PCPROF_BUCKETS + PCPROF_RAM_BUCKETS; ui32Index++) {
+        g_sPCProf.pui16Counts[ui32Index] = 0;
+    }
+    g_ui32PCProfOffset = 0;
+
+#if defined(PCPROF_HOST)
+    {
+        struct sigaction sAction;
+        struct itimerval sTimer;
+
+        (void)ui32ClockHz;
+        memset(&sAction, 0, sizeof(sAction));
+        sAction.sa_sigaction = PCProfSignal;
+        sAction.sa_flags = SA_SIGINFO | SA_RESTART;
+        sigaction(SIGPROF, &sAction, 0);
+
+        // ITIMER_PROF counts the CPU time the process uses
+        sTimer.it_interval.tv_sec = 0;
+        sTimer.it_interval.tv_usec = 1000000 / ui32RateHz;
+        sTimer.it_value = sTimer.it_interval;
+        setitimer(ITIMER_PROF, &sTimer, 0);
+    }
+#else
+    // Highest priority, handlers moved below it are sampled too
+    IntPrioritySet(FAULT_SYSTICK, 0);
+    SysTickPeriodSet(ui32ClockHz / ui32RateHz);
+    SysTickIntEnable();
+    SysTickEnable();
+#endif
+}
+
+bool PCProfDump(tPCProfPut pfnPut) {
+    const uint8_t *pui8Out = (const uint8_t *)&g_sPCProf;
+
+    while (g_ui32PCProfOffset < sizeof(g_sPCProf)) {
+        if (!pfnPut(pui8Out[g_ui32PCProfOffset])) {
+            return false;
+        }
+        g_ui32PCProfOffset++;
+    }
+
+    g_ui32PCProfOffset = 0;
+    return true;
+}
@@ -0,0 +1,110 @@
+/* pcprof.h
+ *
+ * Statistical profiler: SysTick interrupts at a fixed rate and the handler
+ * counts the PC it interrupted, taken from the exception stack frame, in a
+ * histogram of PCPROF_BUCKETS buckets of 1 << PCPROF_SHIFT bytes each from
+ * PCPROF_BASE. A second histogram of PCPROF_RAM_BUCKETS buckets of the same
+ * size from PCPROF_RAM_BASE covers code running from SRAM, such as the
+ * RAMFUNC handlers in TivaWare_Test. PCs outside both ranges, ROM calls for
+ * example, are counted separately.
+ *
+ * PCProfInit() gives SysTick priority 0, the highest, but it only preempts
+ * handlers of a lower priority, and every interrupt is at 0 after reset.
+ * Move the other interrupts down (IntPrioritySet() with 0x20 or more)
+ * before profiling, as TivaWare_Test does with PC_PROFILE. A handler left
+ * at 0 runs to the end before the sample is taken, and its time is
+ * charged to the code it interrupted.
+ *
+ * g_sPCProf is laid out as the dump format:
+ *
+ *   offset 0   uint32  magic "PCPF"
+ *          4   uint32  sample rate in Hz
+ *          8   uint32  PCPROF_BASE
+ *         12   uint32  PCPROF_SHIFT
+ *         16   uint32  PCPROF_BUCKETS
+ *         20   uint32  samples taken
+ *         24   uint32  samples outside the histogram
+ *         28   uint32  times the counts were halved
+ *         32   uint32  PCPROF_RAM_BASE
+ *         36   uint32  PCPROF_RAM_BUCKETS
+ *         40   uint16  counts[PCPROF_BUCKETS], then counts[PCPROF_RAM_BUCKETS]
+ *
+ * so a debugger memory dump of it and the bytes from PCProfDump() read the
+ * same. A bucket reaching 65535 halves every count, keeping the ratios.
+ * tools/pcprof.py turns a dump into a flat profile using the ELF file.
+ *
+ * Pick a rate that is not a multiple or divisor of any periodic interrupt
+ * being profiled, or the samples keep landing on the same part of it.
+ *
+ * A host build defines PCPROF_HOST and samples on SIGPROF from setitimer()
+ * instead; link it with -no-pie and set PCPROF_BASE to the start of .text.
+ * The SRAM histogram is left out there unless PCPROF_RAM_BUCKETS is set.
+ * Linux may deliver the signals more slowly than asked, at its scheduler
+ * tick, which changes the sample count but not the proportions.
+ */
+
+#ifndef PCPROF_H_
+#define PCPROF_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Histogram placement, the defaults cover the first 64 KB of flash
+#ifndef PCPROF_BASE
+#define PCPROF_BASE             0x00000000
+#endif
+#ifndef PCPROF_SHIFT
+#define PCPROF_SHIFT            6
+#endif
+#ifndef PCPROF_BUCKETS
+#define PCPROF_BUCKETS          1024
+#endif
+
+// SRAM histogram, the default covers all 32 KB of the TM4C123GH6PM's SRAM
+// so code copied there is counted wherever the linker put it
+#ifndef PCPROF_RAM_BASE
+#define PCPROF_RAM_BASE         0x20000000
+#endif
+#ifndef PCPROF_RAM_BUCKETS
+#if defined(PCPROF_HOST)
+#define PCPROF_RAM_BUCKETS      0
+#else
+#define PCPROF_RAM_BUCKETS      512
+#endif
+#endif
+
+#define PCPROF_MAGIC            0x46504350  // "PCPF"
+
+typedef struct {
+    uint32_t ui32Magic;
+    uint32_t ui32RateHz;
+    uint32_t ui32Base;
+    uint32_t ui32Shift;
+    uint32_t ui32Buckets;
+    volatile uint32_t ui32Samples;
+    volatile uint32_t ui32Outside;
+    volatile uint32_t ui32Halved;
+    uint32_t ui32RAMBase;
+    uint32_t ui32RAMBuckets;
+    volatile uint16_t pui16Counts[PCPROF_BUCKETS + PCPROF_RAM_BUCKETS];
+} tPCProfBuf;
+
+extern tPCProfBuf g_sPCProf;
+
+// Write one byte, returning false if it cannot be taken right now
+typedef bool (*tPCProfPut)(uint8_t ui8Byte);
+
+// Clear the histogram and start sampling at ui32RateHz. On the target
+// PCProfIntHandler must already be the SysTick handler and ui32ClockHz is
+// the processor clock; the slowest rate is ui32ClockHz / 2^24.
+extern void PCProfInit(uint32_t ui32ClockHz, uint32_t ui32RateHz);
+
+// SysTick handler
+extern void PCProfIntHandler(void);
+
+// Pass a dump of g_sPCProf to pfnPut until it refuses, carrying on from
+// there on the next call. Returns true once a whole dump has gone, the next
+// call starts another. Call from one context only.
+extern bool PCProfDump(tPCProfPut pfnPut);
+
+#endif /* PCPROF_H_ */
@@ -0,0 +1,50 @@
+/* ringbuf.c
+ *
+ * Single-producer / single-consumer lock-free ring buffer, see ringbuf.h.
+ * Shared by the CANTX, CANRX and TivaWare_Test projects.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "ringbuf.h"
+
+bool RingBufInit(tRingBuf *psRing, void *pvBuf, uint32_t ui32ElemSize,
+                 uint32_t ui32Count) {
+    if ((ui32Count == 0) || (ui32Count & (ui32Count - 1))) {
+        return false;
+    }
+
+    psRing->ui32Head = 0;
+    psRing->ui32Tail = 0;
+    psRing->ui32Mask = ui32Count - 1;
+    psRing->ui32ElemSize = ui32ElemSize;
+    psRing->pui8Buf = (uint8_t *)pvBuf;
+
+    return true;
+}
+
+bool RingBufPush(tRingBuf *psRing, const void *pvElem) {
+    void *pvSlot = RingBufWritePtr(psRing);
+
+    if (pvSlot == 0) {
+        return false;
+    }
+
+    memcpy(pvSlot, pvElem, psRing->ui32ElemSize);
+    RingBufCommit(psRing);
+    return true;
+}
+
+bool RingBufPop(tRingBuf *psRing, void *pvElem) {
+    void *pvSlot = RingBufReadPtr(psRing);
+
+    if (pvSlot == 0) {
+        return false;
+    }
+
+    memcpy(pvElem, pvSlot, psRing->ui32ElemSize);
+    RingBufRelease(psRing);
+    return true;
+}
@@ -0,0 +1,95 @@
+/* ringbuf.h
+ *
+ * Single-producer / single-consumer lock-free ring buffer.
+ *
+ * One side (usually an ISR) only pushes and the other side (usually the main
+ * loop) only pops. Each side only writes its own index, and aligned 32 bit
+ * loads and stores are atomic on the Cortex-M4, so no interrupt masking is
+ * needed. The capacity is a power of two and the storage is supplied by the
+ * caller, nothing is allocated.
+ */
+
+#ifndef RINGBUF_H_
+#define RINGBUF_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Keep the element copy and the index update in program order. A DMB is not
+// strictly needed on a single core Cortex-M4, but it also stops the compiler
+// from moving the copy past the index store.
+#if defined(__TI_COMPILER_VERSION__)
+#define RINGBUF_BARRIER()       __asm(" dmb")
+#elif defined(__GNUC__)
+#define RINGBUF_BARRIER()       __sync_synchronize()
+#else
+#define RINGBUF_BARRIER()
+#endif
+
+// The producer side is called from handlers that run from SRAM (see
+// TivaWare_Test/ramfunc.h). Unoptimized builds do not inline a plain static
+// inline, and the out-of-line copy would sit in flash, so force it.
+#if defined(__TI_COMPILER_VERSION__) || defined(__GNUC__)
+#define RINGBUF_ALWAYS_INLINE   static inline __attribute__((always_inline))
+#else
+#define RINGBUF_ALWAYS_INLINE   static inline
+#endif
+
+typedef struct {
+    volatile uint32_t ui32Head; // Only written by the producer
+    volatile uint32_t ui32Tail; // Only written by the consumer
+    uint32_t ui32Mask;          // Capacity - 1
+    uint32_t ui32ElemSize;      // Bytes per element
+    uint8_t *pui8Buf;           // Capacity * ui32ElemSize bytes
+} tRingBuf;
+
+// Set up psRing over pvBuf, which holds ui32Count elements of ui32ElemSize
+// bytes. Returns false if ui32Count is not a power of two.
+extern bool RingBufInit(tRingBuf *psRing, void *pvBuf, uint32_t ui32ElemSize,
+                        uint32_t ui32Count);
+
+// Producer side. Copy one element in, returns false if the ring is full.
+extern bool RingBufPush(tRingBuf *psRing, const void *pvElem);
+
+// Consumer side. Copy one element out, returns false if the ring is empty.
+extern bool RingBufPop(tRingBuf *psRing, void *pvElem);
+
+// Producer side, zero copy. Returns the next free slot or 0 if full. The
+// element only becomes visible to the consumer after RingBufCommit.
+RINGBUF_ALWAYS_INLINE void *RingBufWritePtr(tRingBuf *psRing) {
+    uint32_t ui32Head = psRing->ui32Head;
+
+    if ((ui32Head - psRing->ui32Tail) > psRing->ui32Mask) {
+        return 0;
+    }
+    return &psRing->pui8Buf[(ui32Head & psRing->ui32Mask) * psRing->ui32ElemSize];
+}
+
+RINGBUF_ALWAYS_INLINE void RingBufCommit(tRingBuf *psRing) {
+    RINGBUF_BARRIER();
+    psRing->ui32Head = psRing->ui32Head + 1;
+}
+
+// Consumer side, zero copy. Returns the oldest element or 0 if empty. The
+// slot stays owned by the consumer until RingBufRelease.
+static inline void *RingBufReadPtr(tRingBuf *psRing) {
+    uint32_t ui32Tail = psRing->ui32Tail;
+
+    if (ui32Tail == psRing->ui32Head) {
+        return 0;
+    }
+    RINGBUF_BARRIER();
+    return &psRing->pui8Buf[(ui32Tail & psRing->ui32Mask) * psRing->ui32ElemSize];
+}
+
+static inline void RingBufRelease(tRingBuf *psRing) {
+    RINGBUF_BARRIER();
+    psRing->ui32Tail = psRing->ui32Tail + 1;
+}
+
+// Number of elements waiting. Exact from either side, a snapshot otherwise.
+static inline uint32_t RingBufCount(const tRingBuf *psRing) {
+    return psRing->ui32Head - psRing->ui32Tail;
+}
+
+#endif /* RINGBUF_H_ */
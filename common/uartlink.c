@@ -0,0 +1,348 @@
+/* uartlink.c
+ *
+ * Written for the EK-TM4C123GXL
+ *
+ * Both buffers use free running 32 bit byte counts, masked on access. The
+ * receive side counts bytes written by the hardware and bytes read by the
+ * main loop; if the hardware gets a whole buffer ahead the reader skips
+ * forward to the oldest data that is still intact and the frame decoder
+ * drops the frame it was in.
+ *
+ * In DMA mode the bytes written are worked out from how many halves have
+ * finished and how far the active half has got, so no interrupt is taken
+ * per byte or per frame.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "inc/hw_memmap.h"
+#include "inc/hw_ints.h"
+#include "inc/hw_uart.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/uart.h"
+#include "driverlib/udma.h"
+
+#include "uartlink.h"
+
+#define UARTLINK_RX_MASK        (UARTLINK_RX_SIZE - 1)
+#define UARTLINK_RX_HALF        (UARTLINK_RX_SIZE / 2)
+#define UARTLINK_TX_MASK        (UARTLINK_TX_SIZE - 1)
+
+// Largest uDMA transfer
+#define UARTLINK_DMA_MAX        1024
+
+tCOBSDecoder g_sUARTLinkDecoder;
+volatile uint32_t g_ui32UARTLinkRxOverruns = 0;
+
+static tUARTLinkHW g_sUARTLinkHW;
+
+static uint8_t g_pui8UARTLinkRx[UARTLINK_RX_SIZE];
+static volatile uint32_t g_ui32UARTLinkRxRead;  // Main loop only
+
+static uint8_t g_pui8UARTLinkTx[UARTLINK_TX_SIZE];
+static volatile uint32_t g_ui32UARTLinkTxHead;  // Main loop only
+static volatile uint32_t g_ui32UARTLinkTxTail;  // Interrupt only
+
+#if UARTLINK_DMA
+static volatile uint32_t g_ui32UARTLinkRxHalves;    // RX halves filled
+static volatile uint32_t g_ui32UARTLinkTxBusy;      // Bytes in the TX transfer
+#else
+static volatile uint32_t g_ui32UARTLinkRxHead;      // Bytes received
+#endif
+
+// Decoded frame and the encoded frame being queued
+static uint8_t g_pui8UARTLinkFrame[UARTLINK_FRAME_MAX + 2];
+static uint8_t g_pui8UARTLinkEncoded[COBSFRAME_ENCODED_MAX(UARTLINK_FRAME_MAX)];
+
+#if UARTLINK_DMA
+// Point one half of the receive buffer at the UART data register
+static void UARTLinkRxArm(uint32_t ui32Select, uint32_t ui32Half) {
+    uDMAChannelTransferSet((g_sUARTLinkHW.ui32RxChannel & 0xFF) | ui32Select,
+                           UDMA_MODE_PINGPONG,
+                           (void *)(uintptr_t)(g_sUARTLinkHW.ui32Base + UART_O_DR),
+                           &g_pui8UARTLinkRx[ui32Half * UARTLINK_RX_HALF],
+                           UARTLINK_RX_HALF);
+}
+#endif
+
+// Start sending queued bytes. Called from the interrupt or with it masked.
+static void UARTLinkTxStart(void) {
+    uint32_t ui32Count;
+    uint32_t ui32Start;
+
+    ui32Count = g_ui32UARTLinkTxHead - g_ui32UARTLinkTxTail;
+
+#if UARTLINK_DMA
+    if (g_ui32UARTLinkTxBusy || ui32Count == 0) {
+        return;
+    }
+
+    // One contiguous run, up to the end of the buffer
+    ui32Start = g_ui32UARTLinkTxTail & UARTLINK_TX_MASK;
+    if (ui32Count > UARTLINK_TX_SIZE - ui32Start) {
+        ui32Count = UARTLINK_TX_SIZE - ui32Start;
+    }
+    if (ui32Count > UARTLINK_DMA_MAX) {
+        ui32Count = UARTLINK_DMA_MAX;
+    }
+
+    uDMAChannelTransferSet((g_sUARTLinkHW.ui32TxChannel & 0xFF) | UDMA_PRI_SELECT,
+                           UDMA_MODE_BASIC, &g_pui8UARTLinkTx[ui32Start],
+                           (void *)(uintptr_t)(g_sUARTLinkHW.ui32Base + UART_O_DR), ui32Count);
+    g_ui32UARTLinkTxBusy = ui32Count;
+    uDMAChannelEnable(g_sUARTLinkHW.ui32TxChannel & 0xFF);
+#else
+    (void)ui32Start;
+
+    while (ui32Count && UARTSpaceAvail(g_sUARTLinkHW.ui32Base)) {
+        UARTCharPutNonBlocking(g_sUARTLinkHW.ui32Base,
+                               g_pui8UARTLinkTx[g_ui32UARTLinkTxTail & UARTLINK_TX_MASK]);
+        g_ui32UARTLinkTxTail++;
+        ui32Count--;
+    }
+
+    // The FIFO interrupt refills it while there is more
+    if (ui32Count) {
+        UARTIntEnable(g_sUARTLinkHW.ui32Base, UART_INT_TX);
+    }
+    else {
+        UARTIntDisable(g_sUARTLinkHW.ui32Base, UART_INT_TX);
+    }
+#endif
+}
+
+void UARTLinkIntHandler(void) {
+    uint32_t ui32Status;
+
+    ui32Status = UARTIntStatus(g_sUARTLinkHW.ui32Base, true);
+    UARTIntClear(g_sUARTLinkHW.ui32Base, ui32Status);
+
+    if (ui32Status & UART_INT_OE) {
+        g_ui32UARTLinkRxOverruns++;
+    }
+
+#if UARTLINK_DMA
+    // The UART interrupt also fires when one of its uDMA channels finishes.
+    // Re-arm a receive half once it has filled; the other half is already
+    // taking bytes.
+    if (uDMAChannelModeGet((g_sUARTLinkHW.ui32RxChannel & 0xFF) | UDMA_PRI_SELECT) == UDMA_MODE_STOP) {
+        UARTLinkRxArm(UDMA_PRI_SELECT, 0);
+        g_ui32UARTLinkRxHalves++;
+    }
+    if (uDMAChannelModeGet((g_sUARTLinkHW.ui32RxChannel & 0xFF) | UDMA_ALT_SELECT) == UDMA_MODE_STOP) {
+        UARTLinkRxArm(UDMA_ALT_SELECT, 1);
+        g_ui32UARTLinkRxHalves++;
+    }
+
+    if (g_ui32UARTLinkTxBusy && !uDMAChannelIsEnabled(g_sUARTLinkHW.ui32TxChannel & 0xFF)) {
+        g_ui32UARTLinkTxTail += g_ui32UARTLinkTxBusy;
+        g_ui32UARTLinkTxBusy = 0;
+        UARTLinkTxStart();
+    }
+#else
+    // Empty the RX FIFO, dropping bytes if the main loop is a buffer behind
+    while (UARTCharsAvail(g_sUARTLinkHW.ui32Base)) {
+        uint8_t ui8Byte = UARTCharGetNonBlocking(g_sUARTLinkHW.ui32Base);
+
+        if (g_ui32UARTLinkRxHead - g_ui32UARTLinkRxRead < UARTLINK_RX_SIZE) {
+            g_pui8UARTLinkRx[g_ui32UARTLinkRxHead & UARTLINK_RX_MASK] = ui8Byte;
+            g_ui32UARTLinkRxHead++;
+        }
+        else {
+            g_ui32UARTLinkRxOverruns++;
+        }
+    }
+
+    if (ui32Status & UART_INT_TX) {
+        UARTLinkTxStart();
+    }
+#endif
+}
+
+// Bytes received so far, as a free running count
+static uint32_t UARTLinkRxWritten(void) {
+#if UARTLINK_DMA
+    uint32_t ui32Halves;
+    uint32_t ui32Alt;
+    uint32_t ui32Left;
+
+    IntDisable(g_sUARTLinkHW.ui32Int);
+    ui32Halves = g_ui32UARTLinkRxHalves;
+    ui32Alt = (uDMAChannelAttributeGet(g_sUARTLinkHW.ui32RxChannel & 0xFF) & UDMA_ATTR_ALTSELECT) ? 1 : 0;
+    ui32Left = uDMAChannelSizeGet((g_sUARTLinkHW.ui32RxChannel & 0xFF) |
+                                  (ui32Alt ? UDMA_ALT_SELECT : UDMA_PRI_SELECT));
+    IntEnable(g_sUARTLinkHW.ui32Int);
+
+    // The halves alternate, so the active one follows from the count unless
+    // a half finished while the interrupt was masked
+    if (ui32Alt != (ui32Halves & 1)) {
+        ui32Halves++;
+    }
+
+    return ui32Halves * UARTLINK_RX_HALF + UARTLINK_RX_HALF - ui32Left;
+#else
+    return g_ui32UARTLinkRxHead;
+#endif
+}
+
+// Contiguous received bytes at the read position
+static uint32_t UARTLinkRxAvailable(const uint8_t **ppui8Data) {
+    uint32_t ui32Written;
+    uint32_t ui32Count;
+    uint32_t ui32Start;
+
+    ui32Written = UARTLinkRxWritten();
+    ui32Count = ui32Written - g_ui32UARTLinkRxRead;
+
+#if UARTLINK_DMA
+    // The hardware lapped the reader. The half being written and the one
+    // before it are intact, skip to the older of them.
+    if (ui32Count > UARTLINK_RX_SIZE) {
+        g_ui32UARTLinkRxRead = (ui32Written & ~(uint32_t)(UARTLINK_RX_HALF - 1)) - UARTLINK_RX_HALF;
+        g_ui32UARTLinkRxOverruns += ui32Count - (ui32Written - g_ui32UARTLinkRxRead);
+        g_sUARTLinkDecoder.bDiscard = true;
+        ui32Count = ui32Written - g_ui32UARTLinkRxRead;
+    }
+#endif
+
+    ui32Start = g_ui32UARTLinkRxRead & UARTLINK_RX_MASK;
+    if (ui32Count > UARTLINK_RX_SIZE - ui32Start) {
+        ui32Count = UARTLINK_RX_SIZE - ui32Start;
+    }
+    *ppui8Data = &g_pui8UARTLinkRx[ui32Start];
+
+    return ui32Count;
+}
+
+uint32_t UARTLinkRead(uint8_t *pui8Buf, uint32_t ui32Max) {
+    const uint8_t *pui8Data;
+    uint32_t ui32Count;
+    uint32_t ui32Total = 0;
+
+    // At most two runs, before and after the end of the buffer
+    while (ui32Total < ui32Max && (ui32Count = UARTLinkRxAvailable(&pui8Data)) != 0) {
+        if (ui32Count > ui32Max - ui32Total) {
+            ui32Count = ui32Max - ui32Total;
+        }
+        memcpy(pui8Buf + ui32Total, pui8Data, ui32Count);
+        g_ui32UARTLinkRxRead += ui32Count;
+        ui32Total += ui32Count;
+    }
+
+    return ui32Total;
+}
+
+bool UARTLinkFrameGet(const uint8_t **ppui8Data, uint32_t *pui32Len) {
+    const uint8_t *pui8Data;
+    uint32_t ui32Count;
+    bool bFrame;
+
+    // Decode straight out of the receive buffer
+    while ((ui32Count = UARTLinkRxAvailable(&pui8Data)) != 0) {
+        g_ui32UARTLinkRxRead += COBSFrameDecode(&g_sUARTLinkDecoder, pui8Data, ui32Count, &bFrame);
+        if (bFrame) {
+            *ppui8Data = g_sUARTLinkDecoder.pui8Buf;
+            *pui32Len = g_sUARTLinkDecoder.ui32Len;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+uint32_t UARTLinkTxFree(void) {
+    return UARTLINK_TX_SIZE - (g_ui32UARTLinkTxHead - g_ui32UARTLinkTxTail);
+}
+
+uint32_t UARTLinkWrite(const uint8_t *pui8Data, uint32_t ui32Len) {
+    uint32_t ui32Start;
+    uint32_t ui32Chunk;
+    uint32_t ui32Free;
+
+    ui32Free = UARTLinkTxFree();
+    if (ui32Len > ui32Free) {
+        ui32Len = ui32Free;
+    }
+
+    // Copy in up to two pieces around the end of the buffer
+    ui32Start = g_ui32UARTLinkTxHead & UARTLINK_TX_MASK;
+    ui32Chunk = UARTLINK_TX_SIZE - ui32Start;
+    if (ui32Chunk > ui32Len) {
+        ui32Chunk = ui32Len;
+    }
+    memcpy(&g_pui8UARTLinkTx[ui32Start], pui8Data, ui32Chunk);
+    memcpy(g_pui8UARTLinkTx, pui8Data + ui32Chunk, ui32Len - ui32Chunk);
+    g_ui32UARTLinkTxHead += ui32Len;
+
+    IntDisable(g_sUARTLinkHW.ui32Int);
+    UARTLinkTxStart();
+    IntEnable(g_sUARTLinkHW.ui32Int);
+
+    return ui32Len;
+}
+
+bool UARTLinkFrameSend(const uint8_t *pui8Data, uint32_t ui32Len) {
+    uint32_t ui32Encoded;
+
+    if (ui32Len > UARTLINK_FRAME_MAX || UARTLinkTxFree() < COBSFRAME_ENCODED_MAX(ui32Len)) {
+        return false;
+    }
+
+    ui32Encoded = COBSFrameEncode(pui8Data, ui32Len, g_pui8UARTLinkEncoded);
+    UARTLinkWrite(g_pui8UARTLinkEncoded, ui32Encoded);
+
+    return true;
+}
+
+void UARTLinkInit(const tUARTLinkHW *psHW, uint32_t ui32SysClk, uint32_t ui32Baud) {
+    g_sUARTLinkHW = *psHW;
+    g_ui32UARTLinkRxRead = 0;
+    g_ui32UARTLinkTxHead = 0;
+    g_ui32UARTLinkTxTail = 0;
+    COBSFrameDecoderInit(&g_sUARTLinkDecoder, g_pui8UARTLinkFrame, sizeof(g_pui8UARTLinkFrame));
+
+    SysCtlPeripheralEnable(psHW->ui32Periph);
+    while(!SysCtlPeripheralReady(psHW->ui32Periph)) {
+    }
+
+    UARTConfigSetExpClk(psHW->ui32Base, ui32SysClk, ui32Baud,
+                        UART_CONFIG_WLEN_8 | UART_CONFIG_STOP_ONE | UART_CONFIG_PAR_NONE);
+    UARTFIFOLevelSet(psHW->ui32Base, UART_FIFO_TX4_8, UART_FIFO_RX4_8);
+    UARTFIFOEnable(psHW->ui32Base);
+
+#if UARTLINK_DMA
+    g_ui32UARTLinkRxHalves = 0;
+    g_ui32UARTLinkTxBusy = 0;
+
+    uDMAChannelAssign(psHW->ui32RxChannel);
+    uDMAChannelAssign(psHW->ui32TxChannel);
+
+    // Receive: single requests, so each byte moves as soon as it arrives
+    // instead of waiting for the FIFO to reach its trigger level
+    uDMAChannelAttributeDisable(psHW->ui32RxChannel & 0xFF, UDMA_ATTR_ALL);
+    uDMAChannelControlSet((psHW->ui32RxChannel & 0xFF) | UDMA_PRI_SELECT,
+                          UDMA_SIZE_8 | UDMA_SRC_INC_NONE | UDMA_DST_INC_8 | UDMA_ARB_4);
+    uDMAChannelControlSet((psHW->ui32RxChannel & 0xFF) | UDMA_ALT_SELECT,
+                          UDMA_SIZE_8 | UDMA_SRC_INC_NONE | UDMA_DST_INC_8 | UDMA_ARB_4);
+    UARTLinkRxArm(UDMA_PRI_SELECT, 0);
+    UARTLinkRxArm(UDMA_ALT_SELECT, 1);
+    uDMAChannelEnable(psHW->ui32RxChannel & 0xFF);
+
+    // Transmit: bursts of four whenever the TX FIFO is half empty
+    uDMAChannelAttributeDisable(psHW->ui32TxChannel & 0xFF, UDMA_ATTR_ALL);
+    uDMAChannelControlSet((psHW->ui32TxChannel & 0xFF) | UDMA_PRI_SELECT,
+                          UDMA_SIZE_8 | UDMA_SRC_INC_8 | UDMA_DST_INC_NONE | UDMA_ARB_4);
+
+    UARTDMAEnable(psHW->ui32Base, UART_DMA_RX | UART_DMA_TX);
+    UARTIntEnable(psHW->ui32Base, UART_INT_OE);
+#else
+    g_ui32UARTLinkRxHead = 0;
+
+    UARTTxIntModeSet(psHW->ui32Base, UART_TXINT_MODE_FIFO);
+    UARTIntEnable(psHW->ui32Base, UART_INT_RX | UART_INT_RT | UART_INT_OE);
+#endif
+
+    IntEnable(psHW->ui32Int);
+}
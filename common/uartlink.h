@@ -0,0 +1,93 @@
+/* uartlink.h
+ *
+ * Buffered UART driver carrying COBS/CRC framed messages (cobsframe.h).
+ *
+ * Receive: with UARTLINK_DMA set, uDMA moves every byte from the UART into
+ * a circular buffer as it arrives, using ping-pong mode on the two halves
+ * of the buffer. The interrupt only re-arms a half once it fills, so the
+ * processor is not involved per byte, and the main loop reads straight
+ * out of the buffer. Without UARTLINK_DMA the RX FIFO interrupt fills the
+ * same buffer.
+ *
+ * Transmit: bytes are queued in a second circular buffer and sent by uDMA
+ * in contiguous runs, or by the TX FIFO interrupt without UARTLINK_DMA.
+ *
+ * One link per build. Read and write from the main loop. In DMA mode the
+ * caller enables the uDMA controller and sets its control table first
+ * (DMAInit() in TivaWare_Test). The caller also sets up the pins and
+ * routes the UART interrupt to UARTLinkIntHandler(), either in the startup
+ * vector table or with UARTIntRegister().
+ */
+
+#ifndef UARTLINK_H_
+#define UARTLINK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "cobsframe.h"
+
+// Set to 0 to use the FIFO interrupts instead of uDMA
+#ifndef UARTLINK_DMA
+#define UARTLINK_DMA            1
+#endif
+
+// Buffer sizes, must be powers of two. Each RX half is one uDMA transfer,
+// so UARTLINK_RX_SIZE can be at most 2048. 512 bytes is 5 ms at 1 Mbaud.
+#ifndef UARTLINK_RX_SIZE
+#define UARTLINK_RX_SIZE        512
+#endif
+#ifndef UARTLINK_TX_SIZE
+#define UARTLINK_TX_SIZE        1024
+#endif
+
+// Largest frame payload
+#ifndef UARTLINK_FRAME_MAX
+#define UARTLINK_FRAME_MAX      256
+#endif
+
+typedef struct {
+    uint32_t ui32Periph;        // SYSCTL_PERIPH_UARTn
+    uint32_t ui32Base;          // UARTn_BASE
+    uint32_t ui32Int;           // INT_UARTn
+    uint32_t ui32RxChannel;     // UDMA_CHx_UARTnRX
+    uint32_t ui32TxChannel;     // UDMA_CHx_UARTnTX
+} tUARTLinkHW;
+
+// Hardware of the UARTs on the EK-TM4C123GXL headers. UART0 is the ICDI
+// virtual serial port on PA0/PA1, UART1 is on PB0/PB1.
+#define UARTLINK_UART0 \
+    { SYSCTL_PERIPH_UART0, UART0_BASE, INT_UART0, UDMA_CH8_UART0RX, UDMA_CH9_UART0TX }
+#define UARTLINK_UART1 \
+    { SYSCTL_PERIPH_UART1, UART1_BASE, INT_UART1, UDMA_CH22_UART1RX, UDMA_CH23_UART1TX }
+
+// Frame decoder state and counters
+extern tCOBSDecoder g_sUARTLinkDecoder;
+
+// Received bytes lost because the buffer or the UART FIFO overflowed
+extern volatile uint32_t g_ui32UARTLinkRxOverruns;
+
+// Set up the UART at ui32Baud, 8N1, and start receiving
+extern void UARTLinkInit(const tUARTLinkHW *psHW, uint32_t ui32SysClk, uint32_t ui32Baud);
+
+extern void UARTLinkIntHandler(void);
+
+// Copy up to ui32Max received bytes, returning how many were copied. Use
+// either this or UARTLinkFrameGet(), they take from the same buffer.
+extern uint32_t UARTLinkRead(uint8_t *pui8Buf, uint32_t ui32Max);
+
+// Queue up to ui32Len bytes to send, returning how many were queued
+extern uint32_t UARTLinkWrite(const uint8_t *pui8Data, uint32_t ui32Len);
+
+// Bytes that can be queued right now
+extern uint32_t UARTLinkTxFree(void);
+
+// Queue a framed message, all or nothing. Returns false if it is longer
+// than UARTLINK_FRAME_MAX or there is not enough room.
+extern bool UARTLinkFrameSend(const uint8_t *pui8Data, uint32_t ui32Len);
+
+// Decode received bytes until a good frame is found. Its payload stays
+// valid until the next call.
+extern bool UARTLinkFrameGet(const uint8_t **ppui8Data, uint32_t *pui32Len);
+
+#endif /* UARTLINK_H_ */
@@ -54,4 +54,9 @@ SECTIONS
     .bss    :   > SRAM
     .sysmem :   > SRAM
     .stack  :   > SRAM
+
+    /* Log format strings, see common/binlog.h. Kept in the .out for
+     * tools/binlog.py but never loaded; placed at 0 so each string's
+     * address is its 16 bit index. */
+    .binlog :   load = 0x00000000, type = COPY
 }
@@ -62,6 +62,7 @@
 
 /* Example/Board Header files */
 #include "USBKBD.h"
+#include "isrtrace.h"
 
 #if defined(TIVAWARE)
 typedef uint32_t            USBKBDEventType;
@@ -86,6 +87,32 @@ static GateMutex_Handle gateUSBWait;
 static Semaphore_Handle semKeyboard;
 static Semaphore_Handle semUSBConnected;
 
+/*
+ * Fast typing keeps track of the keyboard class the same way usblib does
+ * internally: txBusy while a report is in flight, and changePending when
+ * keys have changed since then, so usblib will send one more report when
+ * the current one completes.
+ */
+static volatile bool txBusy;
+static volatile bool changePending;
+
+/* Keys held down by the fast typing path */
+static unsigned char heldKeys[6];
+static unsigned int heldCount;
+static unsigned char heldModifier;
+
+/*
+ * Write queue filled by USBKBD_write and drained from the USB callback.
+ * txHead and txTail run freely and are masked on access.
+ */
+static char txQueue[USBKBD_TXQUEUE_SIZE];
+static volatile unsigned int txHead;
+static volatile unsigned int txTail;
+static volatile bool writeActive;
+static volatile bool taskActive;
+static unsigned int writeCount;
+static USBKBD_WriteCallback writeCallback;
+
 /* Function prototypes */
 static USBKBDEventType cbKeyboardHandler(void *cbData, USBKBDEventType event,
 		                                 USBKBDEventType eventMsg,
@@ -93,10 +120,32 @@ static USBKBDEventType cbKeyboardHandler(void *cbData, USBKBDEventType event,
 static Void USBKBD_hwiHandler(UArg arg0);
 static int sendChar(int ch, unsigned int timeout);
 static bool waitUntilSent(unsigned int timeout);
+static bool lookupKey(int ch, unsigned char *modifier, unsigned char *usage);
+static bool waitForReports(volatile bool *busy, unsigned int timeout);
+static void stageKeys(unsigned char modifier, const unsigned char *keys,
+                      unsigned int numKeys);
+static bool changeKeys(unsigned char modifier, const unsigned char *keys,
+                       unsigned int numKeys, unsigned int timeout);
+static unsigned int collectKeys(const char *buf, unsigned int index,
+                                unsigned int end, unsigned int mask,
+                                unsigned char *modifier, unsigned char *keys,
+                                unsigned int *numKeys);
+static bool needsRelease(unsigned char modifier, const unsigned char *keys,
+                         unsigned int numKeys);
+static int putStringFast(String chArray, unsigned int length,
+                         unsigned int timeout);
+static void writeStep(void);
+static void writeStart(void);
+static bool claimKeyboard(unsigned int timeout);
+static void releaseKeyboard(void);
+static bool wakeHost(unsigned int timeout);
 void USBKBD_getState(USBKBD_State *keyboardState);
 void USBKBD_init(void);
 int USBKBD_putChar(int ch, unsigned int timeout);
 int USBKBD_putString(String chArray, unsigned int length, unsigned int timeout);
+unsigned int USBKBD_write(String chArray, unsigned int length,
+                          USBKBD_WriteCallback callback);
+bool USBKBD_flush(unsigned int timeout);
 bool USBKBD_waitForConnect(unsigned int timeout);
 
 /* The languages supported by this device. */
@@ -324,11 +373,41 @@ static USBKBDEventType cbKeyboardHandler(void *cbData, USBKBDEventType event,
 
         case USB_EVENT_DISCONNECTED:
             state = USBKBD_STATE_UNCONFIGURED;
+
+            /* Whatever is left in the write queue is dropped */
+            if (writeActive) {
+                txTail = txHead;
+                heldCount = 0;
+                txBusy = false;
+                changePending = false;
+                writeActive = false;
+                if (writeCallback) {
+                    writeCallback(writeCount);
+                }
+                Semaphore_post(semKeyboard);
+            }
             break;
 
         case USB_EVENT_TX_COMPLETE:
-            state = USBKBD_STATE_IDLE;
-            Semaphore_post(semKeyboard);
+            /*
+             * If keys changed while the report was in flight, usblib has
+             * already sent the next one before calling us
+             */
+            if (changePending) {
+                changePending = false;
+            }
+            else {
+                txBusy = false;
+                state = USBKBD_STATE_IDLE;
+            }
+
+            /* The write queue is drained here without waking any task */
+            if (writeActive) {
+                writeStep();
+            }
+            else {
+                Semaphore_post(semKeyboard);
+            }
             break;
 
         case USB_EVENT_SUSPEND:
@@ -337,7 +416,14 @@ static USBKBDEventType cbKeyboardHandler(void *cbData, USBKBDEventType event,
 
         case USB_EVENT_RESUME:
             state = USBKBD_STATE_IDLE;
-            Semaphore_post(semKeyboard);
+            if (writeActive) {
+                if (!txBusy) {
+                    writeStep();
+                }
+            }
+            else {
+                Semaphore_post(semKeyboard);
+            }
             break;
 
         case USBD_HID_KEYB_EVENT_SET_LEDS:
@@ -357,7 +443,9 @@ static USBKBDEventType cbKeyboardHandler(void *cbData, USBKBDEventType event,
  */
 static Void USBKBD_hwiHandler(UArg arg0)
 {
+    ISRTRACE_ENTER(ISRTRACE_ID_USB);
     USB0DeviceIntHandler();
+    ISRTRACE_EXIT(ISRTRACE_ID_USB);
 }
 
 /*
@@ -439,6 +527,383 @@ static int sendChar(int ch, unsigned int timeout)
 
 }
 
+/*
+ *  ======== lookupKey ========
+ *  Function finds the modifier and usage code that type a character.
+ *
+ *  @return         false if no key types the character
+ */
+static bool lookupKey(int ch, unsigned char *modifier, unsigned char *usage)
+{
+    if ((ch >= ' ') && (ch <= '~')) {
+        *modifier = keyUsageCodes[ch - ' '][0];
+        *usage = keyUsageCodes[ch - ' '][1];
+        return (true);
+    }
+    else if ((ch == '\n') || (ch == '\r')) {
+        *modifier = 0;
+        *usage = HID_KEYB_USAGE_ENTER;
+        return (true);
+    }
+
+    return (false);
+}
+
+/*
+ *  ======== waitForReports ========
+ *  Function blocks until *busy is cleared by the TX complete callback.
+ *
+ *  @return         0: Timed out (likely a disconnect)
+ *                  1: Successful
+ */
+static bool waitForReports(volatile bool *busy, unsigned int timeout)
+{
+    while (*busy) {
+        if (!Semaphore_pend(semKeyboard, timeout)) {
+            state = USBKBD_STATE_UNCONFIGURED;
+            txBusy = false;
+            changePending = false;
+            return (false);
+        }
+    }
+
+    return (true);
+}
+
+/*
+ *  ======== stageKeys ========
+ *  Function releases the held keys and presses up to six new ones.
+ *
+ *  usblib sends a report straight away when a key changes while no report
+ *  is in flight, and otherwise folds every change into one report that it
+ *  sends when the current one completes. So once the previous change has
+ *  gone out, all the changes made here share a single report, and the next
+ *  one can be set up while this one is on the bus. Only when nothing is in
+ *  flight does the first change go out on its own. That is a release when
+ *  keys are held, or the first key of the batch, so it never reorders what
+ *  the host sees.
+ *
+ *  Passing no keys releases everything, including the modifier. The caller
+ *  must run from the USB callback or with INT_USB0 masked, and only when no
+ *  change is pending.
+ */
+static void stageKeys(unsigned char modifier, const unsigned char *keys,
+                      unsigned int numKeys)
+{
+    unsigned int changes = 0;
+    unsigned int i;
+
+    state = USBKBD_STATE_SENDING;
+    for (i = 0; i < heldCount; i++) {
+        USBDHIDKeyboardKeyStateChange((void *)&keyboardDevice,
+                                      ((numKeys == 0) && (i == heldCount - 1)) ?
+                                          0 : heldModifier,
+                                      heldKeys[i],
+                                      false);
+        changes++;
+    }
+    for (i = 0; i < numKeys; i++) {
+        USBDHIDKeyboardKeyStateChange((void *)&keyboardDevice,
+                                      modifier,
+                                      keys[i],
+                                      true);
+        heldKeys[i] = keys[i];
+        changes++;
+    }
+    heldCount = numKeys;
+    heldModifier = modifier;
+
+    if (txBusy) {
+        changePending = (changes != 0);
+    }
+    else if (changes != 0) {
+        txBusy = true;
+        changePending = (changes > 1);
+    }
+}
+
+/*
+ *  ======== changeKeys ========
+ *  Function waits for the last change to leave and then stages a new one.
+ *
+ *  @return         0: A report was not sent
+ *                  1: Successful
+ */
+static bool changeKeys(unsigned char modifier, const unsigned char *keys,
+                       unsigned int numKeys, unsigned int timeout)
+{
+    unsigned int key;
+
+    /* Wait for the last set of changes to leave */
+    if (!waitForReports(&changePending, timeout)) {
+        heldCount = 0;
+        return (false);
+    }
+
+    key = Hwi_disableInterrupt(INT_USB0);
+    stageKeys(modifier, keys, numKeys);
+    Hwi_restoreInterrupt(INT_USB0, key);
+
+    return (true);
+}
+
+/*
+ *  ======== collectKeys ========
+ *  Function gathers the next batch of keys that can share a report.
+ *
+ *  Consecutive characters that share a modifier and do not repeat a key are
+ *  pressed together, up to the six keys a boot keyboard report holds. The
+ *  host handles new keys in the order they appear in the report, which is
+ *  the order they were pressed. Characters are read from buf[index & mask]
+ *  up to end or a NULL character, so the same code walks a string and the
+ *  write queue. Non-printable characters are skipped as sendChar does.
+ *
+ *  @return         Index of the first character not in the batch
+ */
+static unsigned int collectKeys(const char *buf, unsigned int index,
+                                unsigned int end, unsigned int mask,
+                                unsigned char *modifier, unsigned char *keys,
+                                unsigned int *numKeys)
+{
+    unsigned char charModifier;
+    unsigned char usage;
+    unsigned int i;
+
+    *modifier = 0;
+    *numKeys = 0;
+    while ((index != end) && (buf[index & mask]) && (*numKeys < 6)) {
+        if (!lookupKey(buf[index & mask], &charModifier, &usage)) {
+            index++;
+            continue;
+        }
+
+        if (*numKeys == 0) {
+            *modifier = charModifier;
+        }
+        else if (charModifier != *modifier) {
+            break;
+        }
+
+        for (i = 0; i < *numKeys; i++) {
+            if (keys[i] == usage) {
+                break;
+            }
+        }
+        if (i != *numKeys) {
+            break;
+        }
+
+        keys[(*numKeys)++] = usage;
+        index++;
+    }
+
+    return (index);
+}
+
+/*
+ *  ======== needsRelease ========
+ *  Function decides if the held keys have to come up before a batch.
+ *
+ *  Keys are only all released between batches when the next batch repeats a
+ *  held key or needs a different modifier.
+ */
+static bool needsRelease(unsigned char modifier, const unsigned char *keys,
+                         unsigned int numKeys)
+{
+    unsigned int i;
+    unsigned int j;
+
+    if (heldCount == 0) {
+        return (false);
+    }
+    if (modifier != heldModifier) {
+        return (true);
+    }
+    for (i = 0; i < heldCount; i++) {
+        for (j = 0; j < numKeys; j++) {
+            if (heldKeys[i] == keys[j]) {
+                return (true);
+            }
+        }
+    }
+
+    return (false);
+}
+
+/*
+ *  ======== putStringFast ========
+ *  Function types a string several keys per report.
+ *
+ *  @return         Number of characters sent
+ */
+static int putStringFast(String chArray, unsigned int length,
+                         unsigned int timeout)
+{
+    unsigned char keys[6];
+    unsigned char modifier;
+    unsigned int numKeys;
+    unsigned int next;
+    unsigned int count = 0;
+
+    while ((count < length) && (chArray[count])) {
+        next = collectKeys(chArray, count, length, ~0u,
+                           &modifier, keys, &numKeys);
+
+        if (numKeys && needsRelease(modifier, keys, numKeys)) {
+            if (!changeKeys(0, NULL, 0, timeout)) {
+                break;
+            }
+        }
+
+        if (numKeys && !changeKeys(modifier, keys, numKeys, timeout)) {
+            break;
+        }
+
+        count = next;
+    }
+
+    /* Let go of everything and wait for it to reach the host */
+    if (changeKeys(0, NULL, 0, timeout) && waitForReports(&txBusy, timeout)) {
+        /* Drop any post the slow path could mistake for its own report */
+        Semaphore_pend(semKeyboard, 0);
+        state = USBKBD_STATE_IDLE;
+    }
+
+    return (count);
+}
+
+/*
+ *  ======== writeStep ========
+ *  Function stages the next change for the write queue.
+ *
+ *  It is called from the USB callback each time a report completes and no
+ *  change is pending, so the queue drains without waking the writing task.
+ *  When the queue is empty and the last release has reached the host, the
+ *  write callback is called and semKeyboard is posted for USBKBD_flush.
+ */
+static void writeStep(void)
+{
+    unsigned char keys[6];
+    unsigned char modifier;
+    unsigned int numKeys;
+    unsigned int next;
+
+    next = collectKeys(txQueue, txTail, txHead, USBKBD_TXQUEUE_SIZE - 1,
+                       &modifier, keys, &numKeys);
+
+    if (numKeys && needsRelease(modifier, keys, numKeys)) {
+        stageKeys(0, NULL, 0);
+        return;
+    }
+
+    writeCount += next - txTail;
+    txTail = next;
+
+    if (numKeys) {
+        stageKeys(modifier, keys, numKeys);
+    }
+    else if (heldCount) {
+        stageKeys(0, NULL, 0);
+    }
+    else if (!txBusy) {
+        writeActive = false;
+        state = USBKBD_STATE_IDLE;
+        if (writeCallback) {
+            writeCallback(writeCount);
+        }
+        Semaphore_post(semKeyboard);
+    }
+}
+
+/*
+ *  ======== writeStart ========
+ *  Function hands the keyboard to the write queue.
+ *
+ *  Must be called with INT_USB0 masked.
+ */
+static void writeStart(void)
+{
+    writeActive = true;
+    writeCount = 0;
+
+    if (state == USBKBD_STATE_SUSPENDED) {
+        /* The queue starts draining on USB_EVENT_RESUME */
+        state = USBKBD_STATE_SENDING;
+        USBDHIDKeyboardRemoteWakeupRequest((void *)&keyboardDevice);
+    }
+    else {
+        writeStep();
+    }
+}
+
+/*
+ *  ======== claimKeyboard ========
+ *  Function takes the keyboard from the write queue for a blocking call.
+ *
+ *  The queue stops being started while the keyboard is claimed, and any
+ *  transfer already running is waited for. Must be called with gateKeyboard
+ *  held.
+ *
+ *  @return         0: The running transfer did not finish in time
+ *                  1: Successful
+ */
+static bool claimKeyboard(unsigned int timeout)
+{
+    unsigned int key;
+
+    key = Hwi_disableInterrupt(INT_USB0);
+    taskActive = true;
+    Hwi_restoreInterrupt(INT_USB0, key);
+
+    while (writeActive) {
+        if (!Semaphore_pend(semKeyboard, timeout)) {
+            return (false);
+        }
+    }
+
+    /* Nothing is in flight, so any post left over is stale */
+    Semaphore_pend(semKeyboard, 0);
+
+    return (true);
+}
+
+/*
+ *  ======== releaseKeyboard ========
+ *  Function gives the keyboard back and restarts the write queue.
+ */
+static void releaseKeyboard(void)
+{
+    unsigned int key;
+
+    key = Hwi_disableInterrupt(INT_USB0);
+    taskActive = false;
+    if ((txHead != txTail) && (!writeActive) &&
+        (state != USBKBD_STATE_UNCONFIGURED)) {
+        writeStart();
+    }
+    Hwi_restoreInterrupt(INT_USB0, key);
+}
+
+/*
+ *  ======== wakeHost ========
+ *  Function asks a suspended host to resume and waits for it.
+ *
+ *  @return         0: The host did not resume
+ *                  1: Successful
+ */
+static bool wakeHost(unsigned int timeout)
+{
+    /* The write queue may already have woken it */
+    if (state != USBKBD_STATE_SUSPENDED) {
+        return (true);
+    }
+
+    state = USBKBD_STATE_SENDING;
+    USBDHIDKeyboardRemoteWakeupRequest((void *)&keyboardDevice);
+
+    return (waitUntilSent(timeout));
+}
+
 /*
  *  ======== waitUntilSent ========
  *  Function will determine if the last key press/release was sent to the host
@@ -552,14 +1017,12 @@ int USBKBD_putChar(int ch, unsigned int timeout)
             /* Acquire lock */
             key = GateMutex_enter(gateKeyboard);
 
-            state = USBKBD_STATE_SENDING;
-            USBDHIDKeyboardRemoteWakeupRequest((void *)&keyboardDevice);
-
-            if (waitUntilSent(timeout)) {
+            if (claimKeyboard(timeout) && wakeHost(timeout)) {
                 retValue = sendChar(ch, timeout);
             }
 
             /* Release lock */
+            releaseKeyboard();
             GateMutex_leave(gateKeyboard, key);
             break;
 
@@ -568,9 +1031,12 @@ int USBKBD_putChar(int ch, unsigned int timeout)
             /* Acquire lock */
             key = GateMutex_enter(gateKeyboard);
 
-            retValue = sendChar(ch, timeout);
+            if (claimKeyboard(timeout)) {
+                retValue = sendChar(ch, timeout);
+            }
 
             /* Release lock */
+            releaseKeyboard();
             GateMutex_leave(gateKeyboard, key);
             break;
 
@@ -586,6 +1052,48 @@ int USBKBD_putChar(int ch, unsigned int timeout)
  */
 int USBKBD_putString(String chArray, unsigned int length, unsigned int timeout)
 {
+#if USBKBD_FAST_TYPING
+    int count = 0;
+    unsigned int key;
+
+    switch (state) {
+        case USBKBD_STATE_UNCONFIGURED:
+            USBKBD_waitForConnect(timeout);
+            break;
+
+        case USBKBD_STATE_SUSPENDED:
+            /* Acquire lock */
+            key = GateMutex_enter(gateKeyboard);
+
+            if (claimKeyboard(timeout) && wakeHost(timeout)) {
+                count = putStringFast(chArray, length, timeout);
+            }
+
+            /* Release lock */
+            releaseKeyboard();
+            GateMutex_leave(gateKeyboard, key);
+            break;
+
+        case USBKBD_STATE_SENDING:
+        case USBKBD_STATE_IDLE:
+            /* Acquire lock */
+            key = GateMutex_enter(gateKeyboard);
+
+            if (claimKeyboard(timeout)) {
+                count = putStringFast(chArray, length, timeout);
+            }
+
+            /* Release lock */
+            releaseKeyboard();
+            GateMutex_leave(gateKeyboard, key);
+            break;
+
+        default:
+            break;
+    }
+
+    return (count);
+#else
     int ch;
     int count = 0;
 
@@ -603,6 +1111,70 @@ int USBKBD_putString(String chArray, unsigned int length, unsigned int timeout)
     }
 
     return (count);
+#endif
+}
+
+/*
+ *  ======== USBKBD_write ========
+ */
+unsigned int USBKBD_write(String chArray, unsigned int length,
+                          USBKBD_WriteCallback callback)
+{
+    unsigned int count = 0;
+    unsigned int key;
+
+    if (state == USBKBD_STATE_UNCONFIGURED) {
+        return (0);
+    }
+
+    key = Hwi_disableInterrupt(INT_USB0);
+
+    while ((count < length) && (chArray[count]) &&
+           (txHead - txTail < USBKBD_TXQUEUE_SIZE)) {
+        txQueue[txHead & (USBKBD_TXQUEUE_SIZE - 1)] = chArray[count];
+        txHead++;
+        count++;
+    }
+
+    if (count) {
+        writeCallback = callback;
+
+        /* A blocking call restarts the queue when it is done */
+        if ((!writeActive) && (!taskActive)) {
+            writeStart();
+        }
+    }
+
+    Hwi_restoreInterrupt(INT_USB0, key);
+
+    return (count);
+}
+
+/*
+ *  ======== USBKBD_flush ========
+ */
+bool USBKBD_flush(unsigned int timeout)
+{
+    bool ret = true;
+    unsigned int key;
+
+    /* Blocking calls share semKeyboard */
+    key = GateMutex_enter(gateKeyboard);
+
+    while (writeActive) {
+        if (!Semaphore_pend(semKeyboard, timeout)) {
+            ret = false;
+            break;
+        }
+    }
+
+    if (state == USBKBD_STATE_UNCONFIGURED) {
+        ret = false;
+    }
+
+    GateMutex_leave(gateKeyboard, key);
+
+    return (ret);
 }
 
 /*
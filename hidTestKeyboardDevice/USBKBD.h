@@ -43,6 +43,19 @@ extern "C" {
 
 #include <xdc/std.h>
 
+/*
+ * Set to 1 to let USBKBD_putString press up to six keys per report instead
+ * of sending a press and a release report for every character.
+ */
+#ifndef USBKBD_FAST_TYPING
+#define USBKBD_FAST_TYPING  1
+#endif
+
+/* Size of the USBKBD_write queue in characters, must be a power of two */
+#ifndef USBKBD_TXQUEUE_SIZE
+#define USBKBD_TXQUEUE_SIZE 256
+#endif
+
 /* Data structure used to specify the current state of the LEDs */
 typedef struct {
     bool numLED;
@@ -50,6 +63,13 @@ typedef struct {
     bool scrollLED;
 } USBKBD_State;
 
+/*
+ * Called from the USB interrupt once USBKBD_write has nothing left to send,
+ * with the number of characters taken from the queue since it started.
+ * It must not block.
+ */
+typedef Void (*USBKBD_WriteCallback)(unsigned int count);
+
 /*!
  *  ======== USBKBD_getState ========
  *  Function is a NON-blocking function that returns the status of the keyboard.
@@ -90,7 +110,8 @@ extern int USBKBD_putChar(int ch, unsigned int timeout);
  *  A blocking function that sends a NULL terminated string to the host.
  *
  *  Function to simulates a keyboard press and release sequence for an array of
- *  characters to the host.
+ *  characters to the host. With USBKBD_FAST_TYPING several characters share
+ *  a report where the keys and modifiers allow it.
  *
  *  @param(chArray) The printable character that will be sent to the host
  *
@@ -104,6 +125,38 @@ extern int USBKBD_putString(String chArray,
                             unsigned int length,
                             unsigned int timeout);
 
+/*!
+ *  ======== USBKBD_write ========
+ *  A NON-blocking function that queues a string to be typed to the host.
+ *
+ *  Function copies as much of the string as fits into the write queue and
+ *  returns straight away. The queue is typed from the USB interrupt, several
+ *  keys per report, so the calling task is not woken for each report.
+ *  Blocking calls made in the meantime wait for the queue to drain first.
+ *
+ *  @param(chArray)  The printable characters to queue
+ *
+ *  @param(length)   Maximum number of characters to queue. Queuing also stops
+ *                   at a NULL character.
+ *
+ *  @param(callback) Called when the queue has drained, or NULL. It replaces
+ *                   the callback of any earlier write still in the queue.
+ *
+ *  @return          Number of characters queued, 0 if the device is not
+ *                   connected.
+ */
+extern unsigned int USBKBD_write(String chArray,
+                                 unsigned int length,
+                                 USBKBD_WriteCallback callback);
+
+/*!
+ *  ======== USBKBD_flush ========
+ *  A blocking function that waits for the USBKBD_write queue to drain.
+ *
+ *  @return         false on a timeout or a disconnect
+ */
+extern bool USBKBD_flush(unsigned int timeout);
+
 /*!
  *  ======== USBKBD_waitForConnect ========
  *  This function blocks while the USB is not connected
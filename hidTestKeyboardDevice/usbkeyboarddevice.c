@@ -40,6 +40,7 @@
 #include <xdc/std.h>
 #include <xdc/runtime/Error.h>
 #include <xdc/runtime/System.h>
+#include <xdc/runtime/Types.h>
 
 /* BIOS Header files */
 #include <ti/sysbios/BIOS.h>
@@ -47,19 +48,37 @@
 
 /* TI-RTOS Header files */
 #include <ti/drivers/GPIO.h>
+#include <ti/drivers/UART.h>
 
 /* Example/Board Header files */
 #include "Board.h"
 
 /* USB Reference Module Header file */
 #include "USBKBD.h"
+#include "isrtrace.h"
+#include "binlog.h"
 
 #define TASKSTACKSIZE   768
+#define LOGSTACKSIZE    512
 
 const unsigned char text[] = "TI-RTOS controls USB.\n";
 
 Task_Struct task0Struct;
 Char task0Stack[TASKSTACKSIZE];
+Task_Struct task1Struct;
+Char task1Stack[LOGSTACKSIZE];
+
+/* Characters typed by the last USBKBD_write, -1 while it is still typing */
+volatile int written = -1;
+
+/*
+ *  ======== writeDone ========
+ *  Called from the USB interrupt when the text has been typed.
+ */
+Void writeDone(unsigned int count)
+{
+    written = count;
+}
 /*
  *  ======== taskFxn ========
  */
@@ -89,16 +108,56 @@ Void taskFxn (UArg arg0, UArg arg1)
         currButton = GPIO_read(Board_BUTTON0);
         if((currButton == 0) && (prevButton != 0))
         {
-            sent = USBKBD_putString((String)text, sizeof(text), BIOS_WAIT_FOREVER);
-            System_printf("Sent %d bytes\n", sent);
+            /* Queue the text, the task carries on while it is typed */
+            sent = USBKBD_write((String)text, sizeof(text), writeDone);
+            BINLOG1("Queued %d bytes\n", sent);
         }
         prevButton = currButton;
 
+        if (written >= 0) {
+            BINLOG1("Sent %d bytes\n", written);
+            written = -1;
+        }
+
         /* When connected, poll the pin once every 100ms */
         Task_sleep(100);
     }
 }
 
+/*
+ *  ======== logTaskFxn ========
+ *  Sends the binary log out of UART0, the ICDI virtual serial port, at the
+ *  lowest priority. Decode it with tools/binlog.py and this build's .out.
+ */
+Void logTaskFxn(UArg arg0, UArg arg1)
+{
+    UART_Handle uart;
+    UART_Params uartParams;
+    uint8_t buf[64];
+    uint32_t count;
+
+    UART_Params_init(&uartParams);
+    uartParams.writeDataMode = UART_DATA_BINARY;
+    uartParams.readDataMode = UART_DATA_BINARY;
+    uartParams.readReturnMode = UART_RETURN_FULL;
+    uartParams.readEcho = UART_ECHO_OFF;
+    uartParams.baudRate = 115200;
+    uart = UART_open(Board_UART0, &uartParams);
+    if (uart == NULL) {
+        System_abort("Error opening the UART");
+    }
+
+    while (true) {
+        count = BinLogRead(buf, sizeof(buf));
+        if (count > 0) {
+            UART_write(uart, buf, count);
+        }
+        else {
+            Task_sleep(10);
+        }
+    }
+}
+
 /*
  *  ======== main ========
  */
@@ -106,12 +165,21 @@ int main(void)
 {
     /* Construct BIOS objects */
     Task_Params taskParams;
+    Types_FreqHz cpuFreq;
 
     /* Call board init functions */
     Board_initGeneral();
+
+    /* Trace the USB Hwi against the cycle counter, see common/isrtrace.h */
+    BIOS_getCpuFreq(&cpuFreq);
+    ISRTraceInit(cpuFreq.lo);
     Board_initGPIO();
+    Board_initUART();
     Board_initUSB(Board_USBDEVICE);
 
+    /* Log calls are only a few stores, see common/binlog.h */
+    BinLogInit();
+
     /* Construct keyboard Task thread */
     Task_Params_init(&taskParams);
     taskParams.stackSize = TASKSTACKSIZE;
@@ -119,14 +187,17 @@ int main(void)
     taskParams.priority = 2;
     Task_construct(&task0Struct, (Task_FuncPtr)taskFxn, &taskParams, NULL);
 
+    /* Construct the log Task below everything else */
+    Task_Params_init(&taskParams);
+    taskParams.stackSize = LOGSTACKSIZE;
+    taskParams.stack = &task1Stack;
+    taskParams.priority = 1;
+    Task_construct(&task1Struct, (Task_FuncPtr)logTaskFxn, &taskParams, NULL);
+
     /* Turn on user LED */
     GPIO_write(Board_LED0, Board_LED_ON);
 
-    System_printf("Starting the USB Keyboard Device example\nSystem provider is "
-                  "set to SysMin. Halt the target to view any SysMin contents"
-                  " in ROV.\n");
-    /* SysMin will only print to the console when you call flush or exit */
-    System_flush();
+    BINLOG("Starting the USB Keyboard Device example\n");
 
     USBKBD_init();
 
@@ -1,8 +1,206 @@
-//put usbmousehid test in this directory and usbmousedevice.c with this file
+/* usbhidmouse.c
+ *
+ * Written for the EK-TM4C123GXL
+ *
+ * USB boot mouse with a wheel, built from the usblib generic HID class.
+ *
+ * The interrupt IN endpoint is polled every 1 ms. Motion passed to
+ * USBMouseMove() is added to X, Y and wheel accumulators, and a report is
+ * only written when the endpoint is free. So however fast the motion
+ * arrives it is merged into the next report instead of being queued, and
+ * anything over the +/-127 a report can carry is left in the accumulators
+ * for the report after it. At most one report is ever in flight.
+ *
+ * The descriptor sections follow usbdhidmouse.c from usblib, with the
+ * polling interval cut from 16 ms to 1 ms.
+ */
 
+#include <stdint.h>
+#include <stdbool.h>
+#include "inc/hw_ints.h"
+#include "inc/hw_types.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/usb.h"
+#include "usblib/usb-ids.h"
+#include "usblib/usblib.h"
+#include "usblib/usbhid.h"
+#include "usblib/device/usbdevice.h"
+#include "usblib/device/usbdhid.h"
 
+#include "usbhidmouse.h"
 
+#ifndef USB_HID_WHEEL
+#define USB_HID_WHEEL           0x38
+#endif
 
+// Sizes of the fixed descriptor sections
+#define HIDINTERFACE_SIZE       9
+#define HIDINENDPOINT_SIZE      7
+
+// Report protocol sends the wheel, boot protocol stops after Y
+#define MOUSE_REPORT_SIZE       4
+#define MOUSE_BOOT_REPORT_SIZE  3
+
+// Interrupt IN endpoint polling interval in ms
+#define MOUSE_POLL_MS           1
+
+//*****************************************************************************
+//
+// Motion waiting to be reported, and the state of the endpoint. Written
+// from USBMouseMove() with the USB interrupt masked and from the USB
+// callbacks.
+//
+//*****************************************************************************
+static volatile int32_t g_i32AccX;
+static volatile int32_t g_i32AccY;
+static volatile int32_t g_i32AccWheel;
+static volatile uint8_t g_ui8Buttons;
+static volatile uint8_t g_ui8SentButtons;
+static volatile bool g_bTxBusy;
+static volatile bool g_bConnected;
+static volatile uint8_t g_ui8Protocol = USB_HID_PROTOCOL_REPORT;
+
+// Last report written, also returned for GET_REPORT
+static uint8_t g_pui8Report[MOUSE_REPORT_SIZE];
+
+tUSBMouseStats g_sUSBMouseStats;
+
+//*****************************************************************************
+//
+// The languages, strings and report descriptors for the mouse.
+//
+//*****************************************************************************
+static const uint8_t g_pui8LangDescriptor[] =
+{
+    4,
+    USB_DTYPE_STRING,
+    USBShort(USB_LANG_EN_US)
+};
+
+static const uint8_t g_pui8ManufacturerString[] =
+{
+    (17 + 1) * 2,
+    USB_DTYPE_STRING,
+    'T', 0, 'e', 0, 'x', 0, 'a', 0, 's', 0, ' ', 0, 'I', 0, 'n', 0, 's', 0,
+    't', 0, 'r', 0, 'u', 0, 'm', 0, 'e', 0, 'n', 0, 't', 0, 's', 0,
+};
+
+static const uint8_t g_pui8ProductString[] =
+{
+    (9 + 1) * 2,
+    USB_DTYPE_STRING,
+    'M', 0, 'o', 0, 'u', 0, 's', 0, 'e', 0, ' ', 0, '1', 0, 'm', 0, 's', 0,
+};
+
+static const uint8_t g_pui8SerialNumberString[] =
+{
+    (8 + 1) * 2,
+    USB_DTYPE_STRING,
+    '1', 0, '2', 0, '3', 0, '4', 0, '5', 0, '6', 0, '7', 0, '8', 0
+};
+
+static const uint8_t g_pui8HIDInterfaceString[] =
+{
+    (19 + 1) * 2,
+    USB_DTYPE_STRING,
+    'H', 0, 'I', 0, 'D', 0, ' ', 0, 'M', 0, 'o', 0, 'u', 0, 's', 0,
+    'e', 0, ' ', 0, 'I', 0, 'n', 0, 't', 0, 'e', 0, 'r', 0, 'f', 0,
+    'a', 0, 'c', 0, 'e', 0
+};
+
+static const uint8_t g_pui8ConfigString[] =
+{
+    (23 + 1) * 2,
+    USB_DTYPE_STRING,
+    'H', 0, 'I', 0, 'D', 0, ' ', 0, 'M', 0, 'o', 0, 'u', 0, 's', 0,
+    'e', 0, ' ', 0, 'C', 0, 'o', 0, 'n', 0, 'f', 0, 'i', 0, 'g', 0,
+    'u', 0, 'r', 0, 'a', 0, 't', 0, 'i', 0, 'o', 0, 'n', 0
+};
+
+static const uint8_t * const g_pStringDescriptors[] =
+{
+    g_pui8LangDescriptor,
+    g_pui8ManufacturerString,
+    g_pui8ProductString,
+    g_pui8SerialNumberString,
+    g_pui8HIDInterfaceString,
+    g_pui8ConfigString
+};
+
+#define NUM_STRING_DESCRIPTORS  (sizeof(g_pStringDescriptors) /               \
+                                 sizeof(g_pStringDescriptors[0]))
+
+//*****************************************************************************
+//
+// Report descriptor for a three button mouse with a wheel. The first three
+// bytes match the boot protocol report.
+//
+//*****************************************************************************
+static const uint8_t g_pui8MouseReportDescriptor[] =
+{
+    UsagePage(USB_HID_GENERIC_DESKTOP),
+    Usage(USB_HID_MOUSE),
+    Collection(USB_HID_APPLICATION),
+        Usage(USB_HID_POINTER),
+        Collection(USB_HID_PHYSICAL),
+
+            //
+            // The three buttons, padded to a byte.
+            //
+            UsagePage(USB_HID_BUTTONS),
+            UsageMinimum(1),
+            UsageMaximum(3),
+            LogicalMinimum(0),
+            LogicalMaximum(1),
+            ReportSize(1),
+            ReportCount(3),
+            Input(USB_HID_INPUT_DATA | USB_HID_INPUT_VARIABLE |
+                  USB_HID_INPUT_ABS),
+            ReportSize(5),
+            ReportCount(1),
+            Input(USB_HID_INPUT_CONSTANT),
+
+            //
+            // X, Y and wheel as signed relative bytes.
+            //
+            UsagePage(USB_HID_GENERIC_DESKTOP),
+            Usage(USB_HID_X),
+            Usage(USB_HID_Y),
+            Usage(USB_HID_WHEEL),
+            LogicalMinimum(-127),
+            LogicalMaximum(127),
+            ReportSize(8),
+            ReportCount(3),
+            Input(USB_HID_INPUT_DATA | USB_HID_INPUT_VARIABLE |
+                  USB_HID_INPUT_RELATIVE),
+
+        EndCollection,
+    EndCollection,
+};
+
+static const uint8_t * const g_pMouseClassDescriptors[] =
+{
+    g_pui8MouseReportDescriptor
+};
+
+static const tHIDDescriptor g_sMouseHIDDescriptor =
+{
+    9,                                  // bLength
+    USB_HID_DTYPE_HID,                  // bDescriptorType
+    0x111,                              // bcdHID (version 1.11 compliant)
+    0,                                  // bCountryCode (not localized)
+    1,                                  // bNumDescriptors
+    {
+        {
+            USB_HID_DTYPE_REPORT,       // Report descriptor
+            sizeof(g_pui8MouseReportDescriptor)
+                                        // Size of report descriptor
+        }
+    }
+};
+
+// A mouse only reports on motion, so the idle rate is infinite
+static tHIDReportIdle g_sReportIdle = { 0, 0, 0, 0 };
 
 //*****************************************************************************
 //
@@ -59,6 +257,7 @@ uint8_t g_pui8HIDInterface[HIDINTERFACE_SIZE] =
     4,                          // The string index for this interface.
 };
  
+// The endpoint is polled every MOUSE_POLL_MS, the fastest full speed allows
 const uint8_t g_pui8HIDInEndpoint[HIDINENDPOINT_SIZE] =
 {
     //
@@ -70,7 +269,7 @@ const uint8_t g_pui8HIDInEndpoint[HIDINENDPOINT_SIZE] =
     USB_EP_ATTR_INT,            // Endpoint is an interrupt endpoint.
     USBShort(USBFIFOSizeToBytes(USB_FIFO_SZ_64)),
                                 // The maximum packet size.
-    16,                         // The polling interval for this endpoint.
+    MOUSE_POLL_MS,              // The polling interval for this endpoint.
 };
  
  
@@ -159,11 +358,278 @@ const tConfigHeader * const g_ppsHIDConfigDescriptors[] =
 };
  
 /////////// end of Config descriptors
- 
-tUSBDHIDDevice g_sUsbCanCh =
+
+static uint32_t MouseRxHandler(void *pvCBData, uint32_t ui32Event,
+                               uint32_t ui32MsgData, void *pvMsgData);
+static uint32_t MouseTxHandler(void *pvCBData, uint32_t ui32Event,
+                               uint32_t ui32MsgData, void *pvMsgData);
+
+tUSBDHIDDevice g_sMouseDevice =
 {
-    // ...
+    USB_VID_TI_1CBE,
+    USB_PID_MOUSE,
+    500,
+    USB_CONF_ATTR_BUS_PWR,
+    USB_HID_SCLASS_BOOT,
+    USB_HID_PROTOCOL_MOUSE,
+    1,
+    &g_sReportIdle,
+    MouseRxHandler,
+    (void *)&g_sMouseDevice,
+    MouseTxHandler,
+    (void *)&g_sMouseDevice,
+    false,
+    &g_sMouseHIDDescriptor,
+    g_pMouseClassDescriptors,
     g_pStringDescriptors,
     NUM_STRING_DESCRIPTORS,
     g_ppsHIDConfigDescriptors,
-};
\ No newline at end of file
+};
+
+//*****************************************************************************
+//
+// Take up to +/-127 from an accumulator and leave the rest for later.
+//
+//*****************************************************************************
+static int8_t
+TakeDelta(volatile int32_t *pi32Acc)
+{
+    int32_t i32Delta = *pi32Acc;
+
+    if(i32Delta > 127)
+    {
+        i32Delta = 127;
+    }
+    else if(i32Delta < -127)
+    {
+        i32Delta = -127;
+    }
+    *pi32Acc -= i32Delta;
+
+    return((int8_t)i32Delta);
+}
+
+//*****************************************************************************
+//
+// Write a report if the endpoint is free and there is anything to say. Must
+// be called with the USB interrupt masked or from a USB callback.
+//
+//*****************************************************************************
+static void
+MouseSendReport(void)
+{
+    int32_t i32X, i32Y, i32Wheel;
+    uint32_t ui32Size;
+
+    if(g_bTxBusy || !g_bConnected)
+    {
+        return;
+    }
+    if((g_i32AccX == 0) && (g_i32AccY == 0) && (g_i32AccWheel == 0) &&
+       (g_ui8Buttons == g_ui8SentButtons))
+    {
+        return;
+    }
+
+    i32X = g_i32AccX;
+    i32Y = g_i32AccY;
+    i32Wheel = g_i32AccWheel;
+
+    g_pui8Report[0] = g_ui8Buttons;
+    g_pui8Report[1] = (uint8_t)TakeDelta(&g_i32AccX);
+    g_pui8Report[2] = (uint8_t)TakeDelta(&g_i32AccY);
+
+    // The boot protocol has no wheel, so wheel motion is dropped
+    if(g_ui8Protocol == USB_HID_PROTOCOL_BOOT)
+    {
+        ui32Size = MOUSE_BOOT_REPORT_SIZE;
+        g_pui8Report[3] = 0;
+        g_i32AccWheel = 0;
+    }
+    else
+    {
+        ui32Size = MOUSE_REPORT_SIZE;
+        g_pui8Report[3] = (uint8_t)TakeDelta(&g_i32AccWheel);
+    }
+
+    if(USBDHIDReportWrite((void *)&g_sMouseDevice, g_pui8Report, ui32Size,
+                          false))
+    {
+        g_bTxBusy = true;
+        g_ui8SentButtons = g_ui8Buttons;
+        g_sUSBMouseStats.ui32Reports++;
+    }
+    else
+    {
+        // Put the motion back for the next attempt
+        g_i32AccX = i32X;
+        g_i32AccY = i32Y;
+        g_i32AccWheel = i32Wheel;
+    }
+}
+
+//*****************************************************************************
+//
+// Mask the USB interrupt, returning whether it was enabled.
+//
+//*****************************************************************************
+static bool
+MouseLock(void)
+{
+    bool bEnabled = IntIsEnabled(INT_USB0);
+
+    IntDisable(INT_USB0);
+
+    return(bEnabled);
+}
+
+static void
+MouseUnlock(bool bEnabled)
+{
+    if(bEnabled)
+    {
+        IntEnable(INT_USB0);
+    }
+}
+
+//*****************************************************************************
+//
+// Handles requests and events from the host on the control endpoint.
+//
+//*****************************************************************************
+static uint32_t
+MouseRxHandler(void *pvCBData, uint32_t ui32Event, uint32_t ui32MsgData,
+               void *pvMsgData)
+{
+    switch(ui32Event)
+    {
+        case USB_EVENT_CONNECTED:
+        {
+            g_bConnected = true;
+            g_bTxBusy = false;
+            g_ui8Protocol = USB_HID_PROTOCOL_REPORT;
+            break;
+        }
+
+        case USB_EVENT_DISCONNECTED:
+        {
+            // Nothing is listening, so drop whatever has built up
+            g_bConnected = false;
+            g_bTxBusy = false;
+            g_i32AccX = 0;
+            g_i32AccY = 0;
+            g_i32AccWheel = 0;
+            g_ui8SentButtons = g_ui8Buttons;
+            break;
+        }
+
+        case USBD_HID_EVENT_GET_REPORT:
+        {
+            *(uint8_t **)pvMsgData = g_pui8Report;
+            return((g_ui8Protocol == USB_HID_PROTOCOL_BOOT) ?
+                   MOUSE_BOOT_REPORT_SIZE : MOUSE_REPORT_SIZE);
+        }
+
+        case USBD_HID_EVENT_SET_PROTOCOL:
+        {
+            g_ui8Protocol = (uint8_t)ui32MsgData;
+            break;
+        }
+
+        case USBD_HID_EVENT_GET_PROTOCOL:
+        {
+            return(g_ui8Protocol);
+        }
+
+        default:
+        {
+            break;
+        }
+    }
+
+    return(0);
+}
+
+//*****************************************************************************
+//
+// Called when a report has been read by the host. Anything that came in
+// while it was in flight goes out in the next one.
+//
+//*****************************************************************************
+static uint32_t
+MouseTxHandler(void *pvCBData, uint32_t ui32Event, uint32_t ui32MsgData,
+               void *pvMsgData)
+{
+    if(ui32Event == USB_EVENT_TX_COMPLETE)
+    {
+        g_bTxBusy = false;
+        MouseSendReport();
+    }
+
+    return(0);
+}
+
+//*****************************************************************************
+//
+// Start the mouse on USB controller 0. The USB pins and interrupt handler
+// are set up by the caller.
+//
+//*****************************************************************************
+void
+USBMouseInit(void)
+{
+    USBStackModeSet(0, eUSBModeForceDevice, 0);
+
+    //
+    // The default usblib HID configuration polls every 16 ms, so the device
+    // carries its own descriptor sections through ppsConfigDescriptor.
+    //
+    USBDHIDInit(0, &g_sMouseDevice);
+}
+
+//*****************************************************************************
+//
+// Add motion to the next report and send it if the endpoint is free. Never
+// blocks. Returns false, without taking any motion, if the buttons changed
+// and the previous button change has not been sent yet, so that a click is
+// never merged away; call again later.
+//
+//*****************************************************************************
+bool
+USBMouseMove(int32_t i32DeltaX, int32_t i32DeltaY, int32_t i32DeltaWheel,
+             uint8_t ui8Buttons)
+{
+    bool bEnabled;
+
+    bEnabled = MouseLock();
+
+    if((ui8Buttons != g_ui8Buttons) && (g_ui8Buttons != g_ui8SentButtons))
+    {
+        MouseUnlock(bEnabled);
+        g_sUSBMouseStats.ui32ButtonRetries++;
+        return(false);
+    }
+
+    g_i32AccX += i32DeltaX;
+    g_i32AccY += i32DeltaY;
+    g_i32AccWheel += i32DeltaWheel;
+    g_ui8Buttons = ui8Buttons;
+    g_sUSBMouseStats.ui32Moves++;
+
+    MouseSendReport();
+
+    MouseUnlock(bEnabled);
+
+    return(true);
+}
+
+//*****************************************************************************
+//
+// Returns true while a host has the mouse configured.
+//
+//*****************************************************************************
+bool
+USBMouseConnected(void)
+{
+    return(g_bConnected);
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+/* usbhidmouse.h
+ *
+ * Written for the EK-TM4C123GXL
+ *
+ * USB boot mouse polled every 1 ms. Motion is accumulated between polls
+ * and sent without blocking the caller.
+ */
+
+#ifndef USBHIDMOUSE_H_
+#define USBHIDMOUSE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Button bits for USBMouseMove()
+#define MOUSE_BUTTON_LEFT       0x01
+#define MOUSE_BUTTON_RIGHT      0x02
+#define MOUSE_BUTTON_MIDDLE     0x04
+
+typedef struct {
+    uint32_t ui32Moves;         // USBMouseMove() calls that were taken
+    uint32_t ui32Reports;       // Reports written to the endpoint
+    uint32_t ui32ButtonRetries; // Calls turned away by an unsent click
+} tUSBMouseStats;
+
+extern tUSBMouseStats g_sUSBMouseStats;
+
+// Start the mouse on USB controller 0. The caller sets up the USB pins and
+// points the USB0 vector at USB0DeviceIntHandler.
+extern void USBMouseInit(void);
+
+// Add relative motion and set the buttons. Safe to call from any context at
+// any rate. Returns false if a button change is still waiting to be sent,
+// in which case nothing was taken and the call should be repeated.
+extern bool USBMouseMove(int32_t i32DeltaX, int32_t i32DeltaY,
+                         int32_t i32DeltaWheel, uint8_t ui8Buttons);
+
+extern bool USBMouseConnected(void);
+
+#endif /* USBHIDMOUSE_H_ */
@@ -0,0 +1,104 @@
+/* usbmousedevice.c
+ *
+ * Written for the EK-TM4C123GXL
+ *
+ * Moves the pointer around a square using the 1 ms USB mouse in
+ * usbhidmouse.c, and clicks the left button while SW1 (PF4) is held.
+ *
+ * Motion is fed in from SysTick at 8 kHz, one count per tick, which is
+ * faster than the host polls. The mouse merges it into one report per
+ * 1 ms poll, so the pointer moves 8 counts per report and nothing queues.
+ *
+ * The USB device pins are D4 (DM) and D5 (DP).
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "inc/hw_memmap.h"
+#include "inc/hw_types.h"
+#include "driverlib/gpio.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/pin_map.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/systick.h"
+#include "driverlib/usb.h"
+#include "usblib/usblib.h"
+#include "usblib/device/usbdevice.h"
+
+#include "usbhidmouse.h"
+
+#define SYSCLK_HZ               50000000
+
+// Motion feed rate and the side of the square in counts
+#define MOVE_HZ                 8000
+#define SQUARE_SIDE             800
+
+//*****************************************************************************
+//
+// The error routine that is called if the driver library encounters an error.
+//
+//*****************************************************************************
+#ifdef DEBUG
+void
+__error__(char *pcFilename, uint32_t ui32Line)
+{
+}
+#endif
+
+// Feeds one count of motion per tick, walking the sides of the square
+void
+SysTickIntHandler(void)
+{
+    static uint32_t ui32Step = 0;
+    static const int8_t pi8DX[4] = { 1, 0, -1, 0 };
+    static const int8_t pi8DY[4] = { 0, 1, 0, -1 };
+    uint32_t ui32Side;
+    uint8_t ui8Buttons;
+
+    if(!USBMouseConnected())
+    {
+        return;
+    }
+
+    // SW1 pulls PF4 low when pressed
+    ui8Buttons = GPIOPinRead(GPIO_PORTF_BASE, GPIO_PIN_4) ? 0 :
+                 MOUSE_BUTTON_LEFT;
+
+    ui32Side = (ui32Step / SQUARE_SIDE) & 3;
+    if(USBMouseMove(pi8DX[ui32Side], pi8DY[ui32Side], 0, ui8Buttons))
+    {
+        ui32Step++;
+    }
+}
+
+int
+main(void)
+{
+    SysCtlClockSet(SYSCTL_SYSDIV_4 | SYSCTL_USE_PLL | SYSCTL_XTAL_16MHZ | SYSCTL_OSC_MAIN);
+
+    // USB pins
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOD);
+    GPIOPinTypeUSBAnalog(GPIO_PORTD_BASE, GPIO_PIN_4 | GPIO_PIN_5);
+
+    // SW1 on PF4 with a pull-up
+    SysCtlPeripheralEnable(SYSCTL_PERIPH_GPIOF);
+    GPIOPinTypeGPIOInput(GPIO_PORTF_BASE, GPIO_PIN_4);
+    GPIOPadConfigSet(GPIO_PORTF_BASE, GPIO_PIN_4, GPIO_STRENGTH_2MA,
+                     GPIO_PIN_TYPE_STD_WPU);
+
+    // No startup file in this directory, so the handlers go in the RAM
+    // vector table
+    USBIntRegister(USB0_BASE, USB0DeviceIntHandler);
+    SysTickIntRegister(SysTickIntHandler);
+
+    USBMouseInit();
+
+    SysTickPeriodSet(SYSCLK_HZ / MOVE_HZ);
+    SysTickIntEnable();
+    SysTickEnable();
+    IntMasterEnable();
+
+    while(1)
+    {
+    }
+}
@@ -0,0 +1,199 @@
+/* bench.h
+ *
+ * Timing for the handler benchmarks, which run the firmware on the
+ * driverlib fake (fake/fake.h) to give a repeatable baseline to compare
+ * changes against.
+ *
+ * A benchmark includes its project's main source, with main() renamed, so
+ * it can repeat the set up main() does and reach the handlers and queues
+ * that are static. BenchWrap() then puts a timing wrapper in a handler's
+ * place in the vector table. The wrapper reads the host's monotonic clock
+ * around each call and takes off what reading the clock costs. A handler
+ * pended by the one being timed runs after it returns and is timed on its
+ * own if it is wrapped as well. Functions called from thread mode are
+ * timed with BenchNow() and BenchRecord().
+ *
+ * Every benchmark takes
+ *
+ *   -n calls   stimuli per handler, 100000 by default
+ *   -r rate    stimuli per second. 0, the default, runs them back to back;
+ *              otherwise they are paced against the host clock and the
+ *              simulated clock moves on 1/rate s before each.
+ *
+ * and prints, for each handler, the number of calls, the mean and longest
+ * time per call in ns, and calls per second of wall time over its run.
+ */
+
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "inc/hw_ints.h"
+#include "driverlib/interrupt.h"
+
+#define BENCH_HANDLERS          8
+
+typedef struct {
+    const char *pcName;
+    void (*pfnHandler)(void);
+    uint64_t ui64Calls;
+    uint64_t ui64TotalNs;
+    uint64_t ui64MaxNs;
+    uint64_t ui64StartNs;       // Wall clock over the handler's run
+    uint64_t ui64EndNs;
+} tBenchHandler;
+
+static tBenchHandler g_psBench[BENCH_HANDLERS];
+static uint32_t g_ui32BenchHandlers;
+static tBenchHandler *g_ppsBenchVector[NUM_INTERRUPTS];
+static uint64_t g_ui64BenchOverheadNs;
+static uint32_t g_ui32BenchCalls = 100000;
+static uint32_t g_ui32BenchRate;
+
+static inline uint64_t BenchNow(void) {
+    struct timespec sTime;
+
+    clock_gettime(CLOCK_MONOTONIC, &sTime);
+    return (uint64_t)sTime.tv_sec * 1000000000u + (uint64_t)sTime.tv_nsec;
+}
+
+// Add a handler to the report
+static inline tBenchHandler *BenchAdd(const char *pcName) {
+    tBenchHandler *psBench;
+
+    if (g_ui32BenchHandlers == BENCH_HANDLERS) {
+        fprintf(stderr, "bench: too many handlers\n");
+        exit(1);
+    }
+    psBench = &g_psBench[g_ui32BenchHandlers++];
+    psBench->pcName = pcName;
+    return psBench;
+}
+
+// Account for one call that started at ui64StartNs, less ui64ExceptNs
+// spent in wrapped handlers that ran during it
+static inline void BenchRecordExcept(tBenchHandler *psBench, uint64_t ui64StartNs,
+                                     uint64_t ui64ExceptNs) {
+    uint64_t ui64Now = BenchNow();
+    uint64_t ui64Ns = ui64Now - ui64StartNs;
+
+    ui64ExceptNs += g_ui64BenchOverheadNs;
+    ui64Ns = (ui64Ns > ui64ExceptNs) ? ui64Ns - ui64ExceptNs : 0;
+    if (psBench->ui64Calls++ == 0) {
+        psBench->ui64StartNs = ui64StartNs;
+    }
+    psBench->ui64EndNs = ui64Now;
+    psBench->ui64TotalNs += ui64Ns;
+    if (ui64Ns > psBench->ui64MaxNs) {
+        psBench->ui64MaxNs = ui64Ns;
+    }
+}
+
+// Account for one call that started at ui64StartNs
+static inline void BenchRecord(tBenchHandler *psBench, uint64_t ui64StartNs) {
+    BenchRecordExcept(psBench, ui64StartNs, 0);
+}
+
+// Vector of every wrapped interrupt
+static inline void BenchVector(void) {
+    tBenchHandler *psBench = g_ppsBenchVector[FakeIntActive()];
+    uint64_t ui64Start = BenchNow();
+
+    psBench->pfnHandler();
+    BenchRecord(psBench, ui64Start);
+}
+
+// Time pfnHandler each time ui32Int is taken. Call after the firmware has
+// registered its own handler.
+static inline tBenchHandler *BenchWrap(uint32_t ui32Int, const char *pcName,
+                                       void (*pfnHandler)(void)) {
+    tBenchHandler *psBench = BenchAdd(pcName);
+
+    psBench->pfnHandler = pfnHandler;
+    g_ppsBenchVector[ui32Int] = psBench;
+    IntRegister(ui32Int, BenchVector);
+    return psBench;
+}
+
+// Parse the command line and measure the cost of reading the clock
+static inline void BenchInit(int argc, char *argv[]) {
+    uint64_t ui64Min = UINT64_MAX;
+    uint64_t ui64Start;
+    uint32_t ui32Idx;
+    int iOpt;
+
+    while ((iOpt = getopt(argc, argv, "n:r:")) != -1) {
+        switch (iOpt) {
+        case 'n':
+            g_ui32BenchCalls = (uint32_t)strtoul(optarg, 0, 0);
+            break;
+        case 'r':
+            g_ui32BenchRate = (uint32_t)strtoul(optarg, 0, 0);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n calls] [-r calls per second]\n", argv[0]);
+            exit(2);
+        }
+    }
+
+    for (ui32Idx = 0; ui32Idx < 1000; ui32Idx++) {
+        ui64Start = BenchNow();
+        ui64Start = BenchNow() - ui64Start;
+        if (ui64Start < ui64Min) {
+            ui64Min = ui64Start;
+        }
+    }
+    g_ui64BenchOverheadNs = ui64Min;
+}
+
+// Wait for the slot of stimulus ui32Call of a run that started at
+// ui64StartNs, and move the simulated clock on by the same step
+static inline void BenchPace(uint32_t ui32Call, uint64_t ui64StartNs) {
+    uint64_t ui64Due;
+
+    if (g_ui32BenchRate == 0) {
+        return;
+    }
+
+    ui64Due = ui64StartNs + (uint64_t)ui32Call * 1000000000u / g_ui32BenchRate;
+    while (BenchNow() < ui64Due) {
+    }
+    FakeTicksAdvance(FakeClockHz() / g_ui32BenchRate);
+}
+
+static inline void BenchReport(const char *pcName) {
+    const tBenchHandler *psBench;
+    uint32_t ui32Idx;
+    double dWall;
+
+    printf("%s: %" PRIu32 " stimuli at ", pcName, g_ui32BenchCalls);
+    if (g_ui32BenchRate) {
+        printf("%" PRIu32 "/s", g_ui32BenchRate);
+    } else {
+        printf("full speed");
+    }
+    printf(", clock read %" PRIu64 " ns\n", g_ui64BenchOverheadNs);
+
+    for (ui32Idx = 0; ui32Idx < g_ui32BenchHandlers; ui32Idx++) {
+        psBench = &g_psBench[ui32Idx];
+        if (psBench->ui64Calls == 0) {
+            printf("  %-20s not called\n", psBench->pcName);
+            continue;
+        }
+        dWall = (double)(psBench->ui64EndNs - psBench->ui64StartNs) / 1e9;
+        printf("  %-20s %9" PRIu64 " calls %9.1f ns/call %9" PRIu64 " ns max %12.0f calls/s\n",
+               psBench->pcName, psBench->ui64Calls,
+               (double)psBench->ui64TotalNs / (double)psBench->ui64Calls,
+               psBench->ui64MaxNs,
+               (dWall > 0) ? (double)psBench->ui64Calls / dWall : 0.0);
+    }
+}
+
+#endif /* BENCH_H_ */
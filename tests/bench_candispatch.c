@@ -0,0 +1,85 @@
+/* bench_candispatch.c
+ *
+ * CANDispatch() with 1, 32 and 512 registered IDs, see bench.h and
+ * common/candispatch.h. Each call is a batch of 256 frames over the
+ * registered IDs in a scrambled order, since one dispatch is shorter than
+ * a clock read; the time per frame is printed after the report. The
+ * handlers only count, spread over the 16 handler slots.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "candispatch.h"
+#include "bench.h"
+
+#define BATCH                   256
+
+static const uint32_t g_pui32Counts[] = { 1, 32, 512 };
+static const char *g_ppcNames[] = { "1 ID", "32 IDs", "512 IDs" };
+
+static uint64_t g_pui64Calls[CANDISPATCH_MAX_HANDLERS];
+static tCANFrame g_psFrames[BATCH];
+
+static void handler(const tCANFrame *psFrame, void *pvArg) {
+    (void)psFrame;
+    (*(uint64_t *)pvArg)++;
+}
+
+int main(int argc, char *argv[]) {
+    tBenchHandler *psBench[3];
+    uint64_t ui64Start;
+    uint64_t ui64Call;
+    uint64_t ui64Frames;
+    uint32_t ui32Run;
+    uint32_t ui32Count;
+    uint32_t ui32Call;
+    uint32_t ui32Idx;
+
+    BenchInit(argc, argv);
+
+    for (ui32Run = 0; ui32Run < 3; ui32Run++) {
+        psBench[ui32Run] = BenchAdd(g_ppcNames[ui32Run]);
+        ui32Count = g_pui32Counts[ui32Run];
+
+        // IDs spread over the 11 bit range
+        CANDispatchInit();
+        for (ui32Idx = 0; ui32Idx < ui32Count; ui32Idx++) {
+            CANDispatchRegister(ui32Idx * (0x800 / ui32Count), 0x7FF, handler,
+                                &g_pui64Calls[ui32Idx % CANDISPATCH_MAX_HANDLERS]);
+        }
+        for (ui32Idx = 0; ui32Idx < BATCH; ui32Idx++) {
+            g_psFrames[ui32Idx].ui32ID = ((ui32Idx * 167) % ui32Count) * (0x800 / ui32Count);
+            g_psFrames[ui32Idx].ui32Len = 8;
+        }
+
+        ui64Start = BenchNow();
+        for (ui32Call = 0; ui32Call < g_ui32BenchCalls; ui32Call++) {
+            BenchPace(ui32Call, ui64Start);
+            ui64Call = BenchNow();
+            for (ui32Idx = 0; ui32Idx < BATCH; ui32Idx++) {
+                CANDispatch(&g_psFrames[ui32Idx]);
+            }
+            BenchRecord(psBench[ui32Run], ui64Call);
+        }
+    }
+
+    BenchReport("bench_candispatch");
+    for (ui32Run = 0; ui32Run < 3; ui32Run++) {
+        ui64Frames = psBench[ui32Run]->ui64Calls * BATCH;
+        printf("  %-8s %.2f ns/frame\n", g_ppcNames[ui32Run],
+               (double)psBench[ui32Run]->ui64TotalNs / (double)ui64Frames);
+    }
+
+    // Every frame reached a handler
+    ui64Frames = 0;
+    for (ui32Idx = 0; ui32Idx < CANDISPATCH_MAX_HANDLERS; ui32Idx++) {
+        ui64Frames += g_pui64Calls[ui32Idx];
+    }
+    if (ui64Frames != (uint64_t)3 * g_ui32BenchCalls * BATCH) {
+        printf("  %" PRIu64 " frames handled, expected %" PRIu64 "\n", ui64Frames,
+               (uint64_t)3 * g_ui32BenchCalls * BATCH);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,129 @@
+/* bench_echo.cpp
+ *
+ * Arduino_Serial_UART_Echo on the fake Arduino core, see
+ * fake/arduino/Arduino.h, benchmarked with tools/serialecho.py over a pty.
+ * The sketch is built with ECHO_CHECK, so it checks every frame as it
+ * echoes it and the tool ends with the sketch's counter line.
+ *
+ * The line runs at the sketch's 115200 baud with the AVR core's 64 byte
+ * buffers. The sketch is run as it is, and then with loop() stalled 3 ms
+ * and 5 ms every 20 ms; 64 bytes last 5.6 ms at 115200, so neither stall
+ * may lose a byte. Each run prints the tool's throughput and latency and
+ * the bytes the receive buffer dropped, and fails if the echo differs from
+ * what was sent.
+ *
+ *   -n frames  frames of 60 payload bytes per run, 300 by default
+ *
+ * The sketch is forked for each run, so every run starts from setup().
+ * Needs python3 and a pty.
+ */
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "Arduino.h"
+
+#define SERIALECHO              "../tools/serialecho.py"
+
+static const char *g_pcFrames = "300";
+
+static void stop(int iSignal) {
+    (void)iSignal;
+    FakeArduinoStop();
+}
+
+// Run the sketch on a new pty and the tool against it, returning the
+// tool's exit status, or 1 if the sketch dropped anything
+static int run(uint32_t ui32StallMs, uint32_t ui32EveryMs) {
+    struct termios sTerm;
+    const char *pcName;
+    pid_t iSketch;
+    pid_t iTool;
+    int iMaster;
+    int iSlave;
+    int iStatus;
+    int iSketchStatus;
+
+    iMaster = posix_openpt(O_RDWR | O_NOCTTY);
+    if ((iMaster < 0) || grantpt(iMaster) || unlockpt(iMaster) ||
+        !(pcName = ptsname(iMaster))) {
+        perror("bench_echo: pty");
+        exit(1);
+    }
+
+    // Hold the slave open, raw, so the line stays up between the sketch
+    // starting and the tool opening it
+    iSlave = open(pcName, O_RDWR | O_NOCTTY);
+    tcgetattr(iSlave, &sTerm);
+    cfmakeraw(&sTerm);
+    tcsetattr(iSlave, TCSANOW, &sTerm);
+    fcntl(iMaster, F_SETFL, fcntl(iMaster, F_GETFL) | O_NONBLOCK);
+
+    if (ui32StallMs) {
+        printf("loop() stalled %u ms every %u ms:\n", (unsigned)ui32StallMs,
+               (unsigned)ui32EveryMs);
+    } else {
+        printf("loop() not stalled:\n");
+    }
+    fflush(stdout);
+
+    iSketch = fork();
+    if (iSketch == 0) {
+        close(iSlave);
+        signal(SIGTERM, stop);
+        FakeArduinoRun(iMaster, ui32StallMs, ui32EveryMs);
+        printf("%u bytes lost to receive overruns\n", (unsigned)FakeArduinoOverruns());
+        fflush(stdout);
+        _exit(FakeArduinoOverruns() ? 1 : 0);
+    }
+
+    iTool = fork();
+    if (iTool == 0) {
+        execlp("python3", "python3", SERIALECHO, "bench", pcName, "-n", g_pcFrames,
+               "--settle", "0", "--timeout", "20", "--stats", (char *)0);
+        perror("bench_echo: python3");
+        _exit(1);
+    }
+
+    // A sketch that crashes takes the tool down with it rather than leave
+    // it waiting for the echo
+    if (wait(&iStatus) == iSketch) {
+        iSketchStatus = iStatus;
+        kill(iTool, SIGTERM);
+        waitpid(iTool, &iStatus, 0);
+    } else {
+        kill(iSketch, SIGTERM);
+        waitpid(iSketch, &iSketchStatus, 0);
+    }
+    close(iSlave);
+    close(iMaster);
+
+    if (!WIFEXITED(iStatus) || WEXITSTATUS(iStatus)) {
+        return 1;
+    }
+    return (WIFEXITED(iSketchStatus) && !WEXITSTATUS(iSketchStatus)) ? 0 : 1;
+}
+
+int main(int argc, char *argv[]) {
+    int iFailed = 0;
+    int iOpt;
+
+    while ((iOpt = getopt(argc, argv, "n:")) != -1) {
+        if (iOpt == 'n') {
+            g_pcFrames = optarg;
+        } else {
+            fprintf(stderr, "usage: %s [-n frames]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    iFailed |= run(0, 0);
+    iFailed |= run(3, 20);
+    iFailed |= run(5, 20);
+    return iFailed;
+}
@@ -0,0 +1,96 @@
+/* bench_tivaware.c
+ *
+ * TivaWare_Test handlers on the driverlib fake, see bench.h. The timer
+ * timeout runs timerISR, which triggers the ADC, so getADC and the MCP3202
+ * completion follow it as on the board. CANISR is driven with frames the
+ * object 1 filter takes. Between stimuli the main loop's work is done, so
+ * the queues drain as they would.
+ */
+
+#define main TivaWareTestMain
+#include "../TivaWare_Test/main.c"
+#undef main
+
+#include "bench.h"
+
+// One pass of the main() loop in the default build
+static void MainLoopPass(void) {
+    uint16_t ui16SPISample;
+    uint16_t ui16Sample;
+    tCANFrame sFrame;
+    tFakeCANFrame sTx;
+
+    while (MCP3202SampleGet(&ui16SPISample)) {
+        g_ui32SPIData = ui16SPISample;
+    }
+    while (RingBufPop(&g_sADCSampleRing, &ui16Sample)) {
+        updatePWM(ui16Sample);
+    }
+    while (RingBufPop(&g_sCANRxRing, &sFrame)) {
+        CANDispatch(&sFrame);
+    }
+    if (g_bLEDUpdate) {
+        g_bLEDUpdate = false;
+        writeLED();
+        sendCAN();
+    }
+
+    // The bus takes whatever was queued
+    while (FakeCANTransmit(CAN0_BASE, &sTx)) {
+    }
+}
+
+int main(int argc, char *argv[]) {
+    tFakeCANFrame sFrame = { 0x400, false, 1, { 0 } };
+    uint64_t ui64Start;
+    uint32_t ui32Call;
+
+    BenchInit(argc, argv);
+    FakeReset();
+
+    // main() up to its loop
+    IntMasterDisable();
+    SysCtlClockSet(SYSCTL_SYSDIV_2_5|SYSCTL_USE_PLL|SYSCTL_OSC_MAIN|SYSCTL_XTAL_16MHZ);
+    ISRTraceInit(SYSCLK_HZ);
+    RingBufInit(&g_sADCSampleRing, g_pui16ADCSamples, sizeof(uint16_t), ADC_SAMPLE_QUEUE_SIZE);
+    RingBufInit(&g_sCANRxRing, g_psCANRxFrames, sizeof(tCANFrame), CAN_RX_QUEUE_SIZE);
+    setPins();
+    led = (GPIOPinRead(GPIO_PORTB_BASE, GPIO_PIN_2)) >> 2;
+    setADC();
+    setPWM();
+    setTimer();
+    MCP3202Init(SysCtlClockGet());
+    setCAN();
+
+    BenchWrap(INT_TIMER1A, "timerISR", timerISR);
+    BenchWrap(INT_ADC0SS0, "getADC", getADC);
+    BenchWrap(INT_SSI0, "MCP3202IntHandler", MCP3202IntHandler);
+    BenchWrap(INT_CAN0, "CANISR", CANISR);
+    IntMasterEnable();
+
+    // Timer timeouts, with a reading that sweeps the PWM range
+    ui64Start = BenchNow();
+    for (ui32Call = 0; ui32Call < g_ui32BenchCalls; ui32Call++) {
+        BenchPace(ui32Call, ui64Start);
+        FakeADCInput(ADC0_BASE, ui32Call & 0xFFF);
+        FakeSSIInput((ui32Call * 7) & 0xFFF);
+        FakeTimerTimeout(TIMER1_BASE);
+        MainLoopPass();
+    }
+
+    // Frames for object 1, 0x400-0x41F
+    ui64Start = BenchNow();
+    for (ui32Call = 0; ui32Call < g_ui32BenchCalls; ui32Call++) {
+        BenchPace(ui32Call, ui64Start);
+        sFrame.ui32ID = 0x400 | (ui32Call & 0x1F);
+        sFrame.pui8Data[0] = (uint8_t)ui32Call;
+        FakeCANReceive(CAN0_BASE, &sFrame);
+        MainLoopPass();
+    }
+
+    BenchReport("bench_tivaware");
+    printf("  ADC readings dropped %u, CAN frames dropped %u, PWM %u\n",
+           (unsigned)g_ui32ADCSampleDrops, (unsigned)g_ui32CANRxDrops,
+           (unsigned)g_ui32PWMValue);
+    return 0;
+}
@@ -0,0 +1,261 @@
+/* bench_uartlink.c
+ *
+ * common/uartlink.c echoing frames as TivaWare_Test does with UART_LINK
+ * set, on the UART0 and uDMA fake, benchmarked with tools/uartframe.py
+ * over a pty. bench_uartlink is built with uDMA, bench_uartlink_fifo with
+ * UARTLINK_DMA 0.
+ *
+ * The wire runs at the baud rate, 10 bits a byte, on the host clock. Bytes
+ * the tool writes reach the UART one byte time apart, and bytes the UART
+ * sends leave its transmit FIFO the same way. Line time moves at most
+ * 200 us between two passes of the main loop, so time the host spends
+ * running something else is not taken for a stalled loop.
+ *
+ * At 115200 and 1000000 baud, frames of 64 bytes are echoed with up to 1 KB
+ * in flight, then 100 one at a time for the round trip latency. At 1 Mbaud
+ * they are echoed once more with the main loop stalled 10 ms every 50 ms,
+ * longer than the 512 byte receive ring lasts: frames are lost, but none
+ * may fail the CRC and the echo must carry on. Each run ends with the
+ * firmware's decoder counters.
+ *
+ *   -n frames  frames per throughput run, 400 by default
+ *
+ * Fails if a frame is lost without stalls or the firmware sees a CRC error.
+ * The firmware is forked for each run, so every run starts from reset.
+ * Needs python3 and a pty.
+ */
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/uart.h"
+#include "driverlib/udma.h"
+
+#include "uartlink.h"
+
+#define UARTFRAME               "../tools/uartframe.py"
+
+#define LINE_GAP_NS             200000
+#define STALL_MS                10
+#define STALL_EVERY_MS          50
+
+static const char *g_pcFrames = "400";
+
+static int g_iFd;
+static uint64_t g_ui64ByteNs;
+static uint64_t g_ui64LineNs;
+static uint64_t g_ui64HostNs;
+static uint64_t g_ui64RxNs;
+static uint64_t g_ui64TxNs;
+static volatile sig_atomic_t g_bStop;
+
+static uint64_t nowNs(void) {
+    struct timespec sTime;
+
+    clock_gettime(CLOCK_MONOTONIC, &sTime);
+    return (uint64_t)sTime.tv_sec * 1000000000u + (uint64_t)sTime.tv_nsec;
+}
+
+static uint64_t lineNs(void) {
+    uint64_t ui64Host = nowNs();
+    uint64_t ui64Delta = ui64Host - g_ui64HostNs;
+
+    g_ui64HostNs = ui64Host;
+    g_ui64LineNs += (ui64Delta < LINE_GAP_NS) ? ui64Delta : LINE_GAP_NS;
+    return g_ui64LineNs;
+}
+
+// Move what the wire has carried each way since the last call
+static void wire(void) {
+    uint8_t pui8Buf[256];
+    uint64_t ui64Now = lineNs();
+    uint64_t ui64Bytes;
+    uint32_t ui32Sent;
+    ssize_t iLen;
+
+    // Receive until the tool has nothing more on the line. What the UART
+    // has no room for is lost, and flagged as an overrun.
+    ui64Bytes = (ui64Now - g_ui64RxNs) / g_ui64ByteNs;
+    while (ui64Bytes) {
+        iLen = read(g_iFd, pui8Buf,
+                    (ui64Bytes < sizeof(pui8Buf)) ? ui64Bytes : sizeof(pui8Buf));
+        if (iLen <= 0) {
+            g_ui64RxNs = ui64Now;
+            break;
+        }
+        FakeUARTRxPut(UART0_BASE, pui8Buf, iLen);
+        g_ui64RxNs += iLen * g_ui64ByteNs;
+        ui64Bytes -= iLen;
+    }
+
+    // Transmit one byte time apart while the FIFO has any
+    ui64Bytes = (ui64Now - g_ui64TxNs) / g_ui64ByteNs;
+    iLen = FakeUARTTxGet(UART0_BASE, pui8Buf,
+                         (ui64Bytes < sizeof(pui8Buf)) ? ui64Bytes : sizeof(pui8Buf));
+    for (ui32Sent = 0; ui32Sent < (uint32_t)iLen;) {
+        ssize_t iDone = write(g_iFd, &pui8Buf[ui32Sent], iLen - ui32Sent);
+
+        if (iDone > 0) {
+            ui32Sent += iDone;
+        }
+    }
+    if ((uint64_t)iLen < ui64Bytes) {
+        g_ui64TxNs = ui64Now;
+    } else {
+        g_ui64TxNs += iLen * g_ui64ByteNs;
+    }
+}
+
+static void stop(int iSignal) {
+    (void)iSignal;
+    g_bStop = 1;
+}
+
+// TivaWare_Test's main loop with UART_LINK set, on the wire until stopped
+static void firmware(int iFd, uint32_t ui32Baud, uint32_t ui32StallMs) {
+    static const tUARTLinkHW sUART0 = UARTLINK_UART0;
+    struct timespec sStall = { 0, (long)ui32StallMs * 1000000 };
+    const uint8_t *pui8Frame;
+    uint32_t ui32FrameLen;
+    uint64_t ui64NextNs;
+
+    FakeReset();
+    SysCtlClockSet(SYSCTL_SYSDIV_2_5 | SYSCTL_USE_PLL | SYSCTL_OSC_MAIN | SYSCTL_XTAL_16MHZ);
+    uDMAEnable();
+    UARTIntRegister(UART0_BASE, UARTLinkIntHandler);
+    UARTLinkInit(&sUART0, FakeClockHz(), ui32Baud);
+
+    g_iFd = iFd;
+    g_ui64ByteNs = 10 * 1000000000ull / ui32Baud;
+    g_ui64HostNs = nowNs();
+    g_ui64RxNs = g_ui64TxNs = g_ui64LineNs;
+
+    ui64NextNs = nowNs() + STALL_EVERY_MS * 1000000ull;
+    while (!g_bStop) {
+        wire();
+        if (UARTLinkFrameGet(&pui8Frame, &ui32FrameLen)) {
+            while (!UARTLinkFrameSend(pui8Frame, ui32FrameLen)) {
+                wire();
+            }
+        }
+
+        // The wire moves on by the stall exactly, with uDMA or the receive
+        // interrupt still taking what arrives
+        if (ui32StallMs && (nowNs() >= ui64NextNs)) {
+            lineNs();
+            nanosleep(&sStall, 0);
+            g_ui64LineNs += ui32StallMs * 1000000ull;
+            g_ui64HostNs = nowNs();
+            ui64NextNs += STALL_EVERY_MS * 1000000ull;
+        }
+    }
+
+    printf("  firmware: %u frames, %u CRC errors, %u framing errors, %u bytes overrun\n",
+           (unsigned)g_sUARTLinkDecoder.ui32Frames, (unsigned)g_sUARTLinkDecoder.ui32CRCErrors,
+           (unsigned)g_sUARTLinkDecoder.ui32Errors, (unsigned)g_ui32UARTLinkRxOverruns);
+    fflush(stdout);
+    _exit(g_sUARTLinkDecoder.ui32CRCErrors ? 1 : 0);
+}
+
+// Run the firmware on a new pty and uartframe.py bench against it.
+// Returns true if the tool found every frame, or bStallOk, and the
+// firmware saw no CRC error.
+static bool run(uint32_t ui32Baud, uint32_t ui32StallMs, const char *pcFrames,
+                const char *pcWindow, bool bStallOk) {
+    struct termios sTerm;
+    const char *pcName;
+    char pcBaud[16];
+    pid_t iFirmware;
+    pid_t iTool;
+    int iMaster;
+    int iSlave;
+    int iStatus;
+    int iFirmwareStatus;
+
+    iMaster = posix_openpt(O_RDWR | O_NOCTTY);
+    if ((iMaster < 0) || grantpt(iMaster) || unlockpt(iMaster) ||
+        !(pcName = ptsname(iMaster))) {
+        perror("bench_uartlink: pty");
+        exit(1);
+    }
+
+    // Hold the slave open, raw, so the line stays up until the tool opens it
+    iSlave = open(pcName, O_RDWR | O_NOCTTY);
+    tcgetattr(iSlave, &sTerm);
+    cfmakeraw(&sTerm);
+    tcsetattr(iSlave, TCSANOW, &sTerm);
+    fcntl(iMaster, F_SETFL, fcntl(iMaster, F_GETFL) | O_NONBLOCK);
+
+    if (ui32StallMs) {
+        printf("main loop stalled %u ms every %u ms:\n", (unsigned)ui32StallMs, STALL_EVERY_MS);
+    }
+    fflush(stdout);
+
+    iFirmware = fork();
+    if (iFirmware == 0) {
+        close(iSlave);
+        signal(SIGTERM, stop);
+        firmware(iMaster, ui32Baud, ui32StallMs);
+    }
+
+    snprintf(pcBaud, sizeof(pcBaud), "%u", (unsigned)ui32Baud);
+    iTool = fork();
+    if (iTool == 0) {
+        execlp("python3", "python3", UARTFRAME, "bench", pcName, "-b", pcBaud, "-n", pcFrames,
+               "-w", pcWindow, "--settle", "0", "--timeout", "30", (char *)0);
+        perror("bench_uartlink: python3");
+        _exit(1);
+    }
+
+    // Firmware that crashes takes the tool down with it
+    if (wait(&iStatus) == iFirmware) {
+        iFirmwareStatus = iStatus;
+        kill(iTool, SIGTERM);
+        waitpid(iTool, &iStatus, 0);
+    } else {
+        kill(iFirmware, SIGTERM);
+        waitpid(iFirmware, &iFirmwareStatus, 0);
+    }
+    close(iSlave);
+    close(iMaster);
+
+    if (!WIFEXITED(iFirmwareStatus) || WEXITSTATUS(iFirmwareStatus)) {
+        return false;
+    }
+    return WIFEXITED(iStatus) && (!WEXITSTATUS(iStatus) || bStallOk);
+}
+
+int main(int argc, char *argv[]) {
+    static const uint32_t pui32Baud[] = { 115200, 1000000 };
+    bool bOk = true;
+    uint32_t ui32Idx;
+    int iOpt;
+
+    while ((iOpt = getopt(argc, argv, "n:")) != -1) {
+        if (iOpt == 'n') {
+            g_pcFrames = optarg;
+        } else {
+            fprintf(stderr, "usage: %s [-n frames]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    printf("uartlink, %s:\n", UARTLINK_DMA ? "uDMA" : "FIFO interrupts");
+    for (ui32Idx = 0; ui32Idx < 2; ui32Idx++) {
+        bOk &= run(pui32Baud[ui32Idx], 0, g_pcFrames, "1024", false);
+        bOk &= run(pui32Baud[ui32Idx], 0, "100", "1", false);
+    }
+    bOk &= run(1000000, STALL_MS, g_pcFrames, "1024", true);
+
+    return bOk ? 0 : 1;
+}
@@ -0,0 +1,131 @@
+/* bench_usbkbd.c
+ *
+ * The keyboard device's sendChar, USBKBD_putString, USBKBD_write and USB
+ * interrupt on the SYS/BIOS and usblib fakes, see bench.h. sendChar types
+ * one character with a press and a release report and blocks until the
+ * host has polled both, so its time includes the two USB interrupts that
+ * complete them, which are also timed on their own.
+ *
+ * USBKBD_putString and USBKBD_write each type a string per call. The
+ * blocking one is timed until the host has the string, less the USB
+ * interrupts that ran while the task slept; what is left is the task's
+ * work plus the fake scheduler's. The queued one is timed until it
+ * returns, and the host then polls, untimed, until the write callback
+ * runs. The simulated time each string took to reach the host and the
+ * task wakeups per string are printed after the report.
+ */
+
+#include "../hidTestKeyboardDevice/USBKBD.c"
+
+#include <string.h>
+
+#include "driverlib/sysctl.h"
+
+#include "bench.h"
+
+static const char g_pcText[] = "The quick brown fox jumps over the lazy dog 0123456789\n";
+
+// Strings typed by USBKBD_putString and USBKBD_write, one per call
+static const char g_pcString[] = "TI-RTOS controls USB.\n";
+
+static tBenchHandler *g_psUSB;
+static bool g_bWriteDone;
+
+// The Hwi function takes an argument, the vector does not
+static void USBHwi(void) {
+    USBKBD_hwiHandler(0);
+}
+
+static Void writeDone(unsigned int count) {
+    g_bWriteDone = true;
+}
+
+// Time one string typed by the task, less the USB interrupts meanwhile, and
+// return the simulated time it took in ticks
+static uint64_t typeString(tBenchHandler *psBench, bool bQueued) {
+    uint64_t ui64USBNs = g_psUSB->ui64TotalNs;
+    uint64_t ui64Ticks = g_ui64FakeTicks;
+    uint64_t ui64Call;
+
+    if (bQueued) {
+        g_bWriteDone = false;
+        ui64Call = BenchNow();
+        USBKBD_write((String)g_pcString, sizeof(g_pcString) - 1, writeDone);
+        BenchRecordExcept(psBench, ui64Call, g_psUSB->ui64TotalNs - ui64USBNs);
+        while (!g_bWriteDone) {
+            FakeEventRun(FakeEventNext());
+        }
+    } else {
+        ui64Call = BenchNow();
+        USBKBD_putString((String)g_pcString, sizeof(g_pcString) - 1, 100);
+        BenchRecordExcept(psBench, ui64Call, g_psUSB->ui64TotalNs - ui64USBNs);
+    }
+    return g_ui64FakeTicks - ui64Ticks;
+}
+
+int main(int argc, char *argv[]) {
+    tBenchHandler *psSendChar;
+    tBenchHandler *psString[2];
+    uint64_t pui64Ticks[2] = { 0, 0 };
+    uint32_t pui32Wakeups[2];
+    char pcTyped[64];
+    uint64_t ui64Start;
+    uint64_t ui64Call;
+    uint32_t ui32Call;
+    uint32_t ui32Typed = 0;
+    uint32_t ui32Reports;
+    uint32_t ui32Strings;
+    uint32_t ui32Idx;
+    int iCh;
+
+    BenchInit(argc, argv);
+    FakeReset();
+    SysCtlClockSet(SYSCTL_SYSDIV_2_5 | SYSCTL_USE_PLL | SYSCTL_OSC_MAIN | SYSCTL_XTAL_16MHZ);
+
+    USBKBD_init();
+    FakeUSBConnect();
+    USBKBD_waitForConnect(BIOS_WAIT_FOREVER);
+
+    g_psUSB = BenchWrap(INT_USB0, "USBKBD_hwiHandler", USBHwi);
+    psSendChar = BenchAdd("sendChar");
+    psString[0] = BenchAdd("USBKBD_putString");
+    psString[1] = BenchAdd("USBKBD_write");
+
+    ui64Start = BenchNow();
+    for (ui32Call = 0; ui32Call < g_ui32BenchCalls; ui32Call++) {
+        BenchPace(ui32Call, ui64Start);
+        iCh = g_pcText[ui32Call % (sizeof(g_pcText) - 1)];
+        ui64Call = BenchNow();
+        if (sendChar(iCh, 100) == iCh) {
+            ui32Typed++;
+        }
+        BenchRecord(psSendChar, ui64Call);
+    }
+    ui32Reports = FakeUSBReports();
+    FakeUSBTyped(pcTyped, sizeof(pcTyped));
+
+    // A string is some twenty characters, so a tenth as many calls
+    ui32Strings = (g_ui32BenchCalls + 9) / 10;
+    for (ui32Idx = 0; ui32Idx < 2; ui32Idx++) {
+        pui32Wakeups[ui32Idx] = FakeSemaphoreWakeups();
+        ui64Start = BenchNow();
+        for (ui32Call = 0; ui32Call < ui32Strings; ui32Call++) {
+            BenchPace(ui32Call, ui64Start);
+            pui64Ticks[ui32Idx] += typeString(psString[ui32Idx], ui32Idx == 1);
+        }
+        pui32Wakeups[ui32Idx] = FakeSemaphoreWakeups() - pui32Wakeups[ui32Idx];
+    }
+
+    BenchReport("bench_usbkbd");
+    printf("  %u characters typed in %u reports, %u ms simulated, host saw \"%.*s\"\n",
+           (unsigned)ui32Typed, (unsigned)ui32Reports,
+           (unsigned)(g_ui64FakeTicks / (FakeClockHz() / 1000)),
+           (int)strcspn(pcTyped, "\n"), pcTyped);
+    for (ui32Idx = 0; ui32Idx < 2; ui32Idx++) {
+        printf("  %-20s %.1f ms to the host, %.1f task wakeups per string\n",
+               psString[ui32Idx]->pcName,
+               (double)pui64Ticks[ui32Idx] / ui32Strings / (FakeClockHz() / 1000),
+               (double)pui32Wakeups[ui32Idx] / ui32Strings);
+    }
+    return 0;
+}
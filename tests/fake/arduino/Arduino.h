@@ -0,0 +1,87 @@
+/* Arduino.h
+ *
+ * Host fake of the parts of the Arduino core the sketches use: Serial and
+ * the clock. Serial is one HardwareSerial with the AVR core's 64 byte
+ * receive and transmit buffers, on a pty instead of a UART, see
+ * fakearduino.cpp.
+ *
+ * A sketch is built by force-including this header (-include Arduino.h)
+ * and compiling the .ino as C++.
+ */
+
+#ifndef ARDUINO_H_
+#define ARDUINO_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SERIAL_RX_BUFFER_SIZE   64
+#define SERIAL_TX_BUFFER_SIZE   64
+
+// Strings stay in RAM on the host
+class __FlashStringHelper;
+#define F(string)               (reinterpret_cast<const __FlashStringHelper *>(string))
+
+class HardwareSerial {
+public:
+    void begin(unsigned long baud);
+    int available(void);
+    int availableForWrite(void);
+    int read(void);
+    size_t readBytes(uint8_t *buffer, size_t length);
+    size_t readBytes(char *buffer, size_t length) {
+        return readBytes(reinterpret_cast<uint8_t *>(buffer), length);
+    }
+    void setTimeout(unsigned long timeout) { _timeout = timeout; }
+    void flush(void);
+
+    // Like the AVR core, writing to a full buffer waits for room
+    size_t write(uint8_t c);
+    size_t write(const uint8_t *buffer, size_t size);
+    size_t write(const char *str);
+
+    size_t print(const __FlashStringHelper *str);
+    size_t print(const char *str) { return write(str); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned long n);
+    size_t print(long n);
+    size_t print(unsigned int n) { return print((unsigned long)n); }
+    size_t print(int n) { return print((long)n); }
+    size_t println(void) { return write("\r\n"); }
+    template <typename T> size_t println(T value) {
+        size_t n = print(value);
+        return n + println();
+    }
+
+private:
+    unsigned long _timeout = 1000;
+};
+
+extern HardwareSerial Serial;
+
+extern unsigned long millis(void);
+extern unsigned long micros(void);
+extern void delay(unsigned long ms);
+
+// The sketch
+extern void setup(void);
+extern void loop(void);
+
+//*****************************************************************************
+// The host side
+//*****************************************************************************
+
+// Run setup() and then loop() with Serial on iFd, the master side of a pty,
+// until FakeArduinoStop(). Every ui32EveryMs, loop() is held up for
+// ui32StallMs, as a sketch busy with something else would be; 0 for none.
+extern void FakeArduinoRun(int iFd, uint32_t ui32StallMs, uint32_t ui32EveryMs);
+
+// Make FakeArduinoRun() return after the current loop(). Safe to call from
+// a signal handler.
+extern void FakeArduinoStop(void);
+
+// Bytes the line delivered while the receive buffer was full, which the
+// AVR core drops
+extern uint32_t FakeArduinoOverruns(void);
+
+#endif /* ARDUINO_H_ */
@@ -0,0 +1,24 @@
+/* interrupt.h
+ *
+ * Host fake of TivaWare's driverlib/interrupt.h, see tests/fake/fake.h.
+ */
+
+#ifndef INTERRUPT_H_
+#define INTERRUPT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+extern bool IntMasterEnable(void);
+extern bool IntMasterDisable(void);
+extern void IntRegister(uint32_t ui32Interrupt, void (*pfnHandler)(void));
+extern void IntUnregister(uint32_t ui32Interrupt);
+extern void IntEnable(uint32_t ui32Interrupt);
+extern void IntDisable(uint32_t ui32Interrupt);
+extern uint32_t IntIsEnabled(uint32_t ui32Interrupt);
+extern void IntPrioritySet(uint32_t ui32Interrupt, uint8_t ui8Priority);
+extern int32_t IntPriorityGet(uint32_t ui32Interrupt);
+extern void IntPendSet(uint32_t ui32Interrupt);
+extern void IntPendClear(uint32_t ui32Interrupt);
+
+#endif /* INTERRUPT_H_ */
@@ -0,0 +1,20 @@
+/* pin_map.h
+ *
+ * Host fake of TivaWare's driverlib/pin_map.h, see tests/fake/fake.h. Only
+ * the TM4C123GH6PM pins the projects use.
+ */
+
+#ifndef PIN_MAP_H_
+#define PIN_MAP_H_
+
+#define GPIO_PA0_U0RX           0x00000001
+#define GPIO_PA1_U0TX           0x00000401
+#define GPIO_PA2_SSI0CLK        0x00000802
+#define GPIO_PA3_SSI0FSS        0x00000C02
+#define GPIO_PA4_SSI0RX         0x00001002
+#define GPIO_PA5_SSI0TX         0x00001402
+#define GPIO_PB6_M0PWM0         0x00011804
+#define GPIO_PE4_CAN0RX         0x00041008
+#define GPIO_PE5_CAN0TX         0x00041408
+
+#endif /* PIN_MAP_H_ */
@@ -0,0 +1,30 @@
+/* pwm.h
+ *
+ * Host fake of TivaWare's driverlib/pwm.h, see tests/fake/fake.h.
+ */
+
+#ifndef PWM_H_
+#define PWM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PWM_GEN_0               0x00000040
+#define PWM_GEN_1               0x00000080
+#define PWM_OUT_0               0x00000040
+#define PWM_OUT_0_BIT           0x00000001
+#define PWM_GEN_MODE_DOWN       0x00000000
+#define PWM_GEN_MODE_UP_DOWN    0x00000002
+#define PWM_GEN_MODE_NO_SYNC    0x00000000
+#define PWM_OUTPUT_MODE_NO_SYNC 0x00000000
+
+extern void PWMGenConfigure(uint32_t ui32Base, uint32_t ui32Gen, uint32_t ui32Config);
+extern void PWMGenPeriodSet(uint32_t ui32Base, uint32_t ui32Gen, uint32_t ui32Period);
+extern void PWMGenEnable(uint32_t ui32Base, uint32_t ui32Gen);
+extern void PWMDeadBandDisable(uint32_t ui32Base, uint32_t ui32Gen);
+extern void PWMPulseWidthSet(uint32_t ui32Base, uint32_t ui32PWMOut, uint32_t ui32Width);
+extern uint32_t PWMPulseWidthGet(uint32_t ui32Base, uint32_t ui32PWMOut);
+extern void PWMOutputState(uint32_t ui32Base, uint32_t ui32PWMOutBits, bool bEnable);
+extern void PWMOutputUpdateMode(uint32_t ui32Base, uint32_t ui32PWMOutBits, uint32_t ui32Mode);
+
+#endif /* PWM_H_ */
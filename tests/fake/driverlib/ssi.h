@@ -0,0 +1,34 @@
+/* ssi.h
+ *
+ * Host fake of TivaWare's driverlib/ssi.h, see tests/fake/fake.h.
+ */
+
+#ifndef SSI_H_
+#define SSI_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SSI_FRF_MOTO_MODE_0     0x00000000
+#define SSI_MODE_MASTER         0x00000000
+#define SSI_CLOCK_SYSTEM        0x00000000
+#define SSI_DMA_RX              0x00000001
+#define SSI_DMA_TX              0x00000002
+
+extern void SSIConfigSetExpClk(uint32_t ui32Base, uint32_t ui32SSIClk, uint32_t ui32Protocol,
+                               uint32_t ui32Mode, uint32_t ui32BitRate,
+                               uint32_t ui32DataWidth);
+extern void SSIClockSourceSet(uint32_t ui32Base, uint32_t ui32Source);
+extern void SSIEnable(uint32_t ui32Base);
+extern void SSIDisable(uint32_t ui32Base);
+extern void SSIDataPut(uint32_t ui32Base, uint32_t ui32Data);
+extern int32_t SSIDataPutNonBlocking(uint32_t ui32Base, uint32_t ui32Data);
+extern void SSIDataGet(uint32_t ui32Base, uint32_t *pui32Data);
+extern int32_t SSIDataGetNonBlocking(uint32_t ui32Base, uint32_t *pui32Data);
+extern bool SSIBusy(uint32_t ui32Base);
+extern void SSIDMAEnable(uint32_t ui32Base, uint32_t ui32DMAFlags);
+extern void SSIIntRegister(uint32_t ui32Base, void (*pfnHandler)(void));
+extern uint32_t SSIIntStatus(uint32_t ui32Base, bool bMasked);
+extern void SSIIntClear(uint32_t ui32Base, uint32_t ui32IntFlags);
+
+#endif /* SSI_H_ */
@@ -0,0 +1,57 @@
+/* sysctl.h
+ *
+ * Host fake of TivaWare's driverlib/sysctl.h, see tests/fake/fake.h.
+ */
+
+#ifndef SYSCTL_H_
+#define SYSCTL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SYSCTL_PERIPH_ADC0      0xF0003800
+#define SYSCTL_PERIPH_ADC1      0xF0003801
+#define SYSCTL_PERIPH_CAN0      0xF0003400
+#define SYSCTL_PERIPH_CAN1      0xF0003401
+#define SYSCTL_PERIPH_GPIOA     0xF0000800
+#define SYSCTL_PERIPH_GPIOB     0xF0000801
+#define SYSCTL_PERIPH_GPIOC     0xF0000802
+#define SYSCTL_PERIPH_GPIOD     0xF0000803
+#define SYSCTL_PERIPH_GPIOE     0xF0000804
+#define SYSCTL_PERIPH_GPIOF     0xF0000805
+#define SYSCTL_PERIPH_PWM0      0xF0004000
+#define SYSCTL_PERIPH_SSI0      0xF0001C00
+#define SYSCTL_PERIPH_TIMER0    0xF0000400
+#define SYSCTL_PERIPH_TIMER1    0xF0000401
+#define SYSCTL_PERIPH_UART0     0xF0001800
+#define SYSCTL_PERIPH_UART1     0xF0001801
+#define SYSCTL_PERIPH_UDMA      0xF0000C00
+#define SYSCTL_PERIPH_USB0      0xF0002800
+#define SYSCTL_PERIPH_WTIMER5   0xF0005C05
+
+#define SYSCTL_SYSDIV_1         0x07800000
+#define SYSCTL_SYSDIV_2_5       0xC1000000
+#define SYSCTL_SYSDIV_4         0x01C00000
+#define SYSCTL_SYSDIV_5         0x02400000
+#define SYSCTL_USE_PLL          0x00000000
+#define SYSCTL_USE_OSC          0x00003800
+#define SYSCTL_OSC_MAIN         0x00000000
+#define SYSCTL_OSC_INT          0x00000010
+#define SYSCTL_XTAL_16MHZ       0x00000540
+
+#define SYSCTL_PWMDIV_1         0x00000000
+#define SYSCTL_PWMDIV_2         0x00100000
+#define SYSCTL_PWMDIV_4         0x00120000
+#define SYSCTL_PWMDIV_8         0x00140000
+#define SYSCTL_PWMDIV_16        0x00160000
+#define SYSCTL_PWMDIV_32        0x00180000
+#define SYSCTL_PWMDIV_64        0x001A0000
+
+extern void SysCtlClockSet(uint32_t ui32Config);
+extern uint32_t SysCtlClockGet(void);
+extern void SysCtlPeripheralEnable(uint32_t ui32Peripheral);
+extern bool SysCtlPeripheralReady(uint32_t ui32Peripheral);
+extern void SysCtlPWMClockSet(uint32_t ui32Config);
+extern void SysCtlDelay(uint32_t ui32Count);
+
+#endif /* SYSCTL_H_ */
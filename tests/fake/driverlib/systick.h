@@ -0,0 +1,17 @@
+/* systick.h
+ *
+ * Host fake of TivaWare's driverlib/systick.h, see tests/fake/fake.h.
+ */
+
+#ifndef SYSTICK_H_
+#define SYSTICK_H_
+
+#include <stdint.h>
+
+extern void SysTickEnable(void);
+extern void SysTickDisable(void);
+extern void SysTickIntRegister(void (*pfnHandler)(void));
+extern void SysTickIntEnable(void);
+extern void SysTickPeriodSet(uint32_t ui32Period);
+
+#endif /* SYSTICK_H_ */
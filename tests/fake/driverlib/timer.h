@@ -0,0 +1,39 @@
+/* timer.h
+ *
+ * Host fake of TivaWare's driverlib/timer.h, see tests/fake/fake.h.
+ */
+
+#ifndef TIMER_H_
+#define TIMER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define TIMER_A                 0x000000FF
+#define TIMER_B                 0x0000FF00
+#define TIMER_BOTH              0x0000FFFF
+
+#define TIMER_CFG_ONE_SHOT      0x00000021
+#define TIMER_CFG_PERIODIC      0x00000022
+#define TIMER_CFG_PERIODIC_UP   0x00000032
+#define TIMER_CFG_SPLIT_PAIR    0x04000000
+#define TIMER_CFG_A_PERIODIC    0x00000002
+
+#define TIMER_CLOCK_SYSTEM      0x00000000
+#define TIMER_CLOCK_PIOSC       0x00000001
+
+#define TIMER_TIMA_TIMEOUT      0x00000001
+
+extern void TimerClockSourceSet(uint32_t ui32Base, uint32_t ui32Source);
+extern void TimerConfigure(uint32_t ui32Base, uint32_t ui32Config);
+extern void TimerControlTrigger(uint32_t ui32Base, uint32_t ui32Timer, bool bEnable);
+extern void TimerPrescaleSet(uint32_t ui32Base, uint32_t ui32Timer, uint32_t ui32Value);
+extern void TimerLoadSet(uint32_t ui32Base, uint32_t ui32Timer, uint32_t ui32Value);
+extern void TimerLoadSet64(uint32_t ui32Base, uint64_t ui64Value);
+extern void TimerEnable(uint32_t ui32Base, uint32_t ui32Timer);
+extern void TimerDisable(uint32_t ui32Base, uint32_t ui32Timer);
+extern void TimerIntEnable(uint32_t ui32Base, uint32_t ui32IntFlags);
+extern void TimerIntClear(uint32_t ui32Base, uint32_t ui32IntFlags);
+extern void TimerIntRegister(uint32_t ui32Base, uint32_t ui32Timer, void (*pfnHandler)(void));
+
+#endif /* TIMER_H_ */
@@ -0,0 +1,66 @@
+/* udma.h
+ *
+ * Host fake of TivaWare's driverlib/udma.h, see tests/fake/fake.h.
+ */
+
+#ifndef UDMA_H_
+#define UDMA_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define UDMA_CHANNEL_UART0RX    8
+#define UDMA_CHANNEL_UART0TX    9
+#define UDMA_CHANNEL_SSI0RX     10
+#define UDMA_CHANNEL_SSI0TX     11
+#define UDMA_CHANNEL_ADC0       14
+
+#define UDMA_CH8_UART0RX        0x00000008
+#define UDMA_CH9_UART0TX        0x00000009
+
+#define UDMA_PRI_SELECT         0x00000000
+#define UDMA_ALT_SELECT         0x00000020
+
+#define UDMA_MODE_STOP          0x00000000
+#define UDMA_MODE_BASIC         0x00000001
+#define UDMA_MODE_AUTO          0x00000002
+#define UDMA_MODE_PINGPONG      0x00000003
+
+#define UDMA_ATTR_USEBURST      0x00000001
+#define UDMA_ATTR_ALTSELECT     0x00000002
+#define UDMA_ATTR_HIGH_PRIORITY 0x00000004
+#define UDMA_ATTR_REQMASK       0x00000008
+#define UDMA_ATTR_ALL           0x0000000F
+
+#define UDMA_DST_INC_8          0x00000000
+#define UDMA_DST_INC_16         0x50000000
+#define UDMA_DST_INC_32         0xA0000000
+#define UDMA_DST_INC_NONE       0xC0000000
+#define UDMA_SRC_INC_8          0x00000000
+#define UDMA_SRC_INC_16         0x05000000
+#define UDMA_SRC_INC_32         0x0A000000
+#define UDMA_SRC_INC_NONE       0x0C000000
+#define UDMA_SIZE_8             0x00000000
+#define UDMA_SIZE_16            0x11000000
+#define UDMA_SIZE_32            0x22000000
+#define UDMA_ARB_1              0x00000000
+#define UDMA_ARB_4              0x00008000
+#define UDMA_ARB_8              0x0000C000
+
+extern void uDMAEnable(void);
+extern void uDMAControlBaseSet(void *pControlTable);
+extern void uDMAChannelAssign(uint32_t ui32Mapping);
+extern void uDMAChannelAttributeEnable(uint32_t ui32ChannelNum, uint32_t ui32Attr);
+extern void uDMAChannelAttributeDisable(uint32_t ui32ChannelNum, uint32_t ui32Attr);
+extern uint32_t uDMAChannelAttributeGet(uint32_t ui32ChannelNum);
+extern void uDMAChannelControlSet(uint32_t ui32ChannelStructIndex, uint32_t ui32Control);
+extern void uDMAChannelTransferSet(uint32_t ui32ChannelStructIndex, uint32_t ui32Mode,
+                                   void *pvSrcAddr, void *pvDstAddr,
+                                   uint32_t ui32TransferSize);
+extern uint32_t uDMAChannelSizeGet(uint32_t ui32ChannelStructIndex);
+extern uint32_t uDMAChannelModeGet(uint32_t ui32ChannelStructIndex);
+extern void uDMAChannelEnable(uint32_t ui32ChannelNum);
+extern void uDMAChannelDisable(uint32_t ui32ChannelNum);
+extern bool uDMAChannelIsEnabled(uint32_t ui32ChannelNum);
+
+#endif /* UDMA_H_ */
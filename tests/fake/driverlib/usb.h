@@ -0,0 +1,43 @@
+/* usb.h
+ *
+ * Host fake of TivaWare's driverlib/usb.h, see tests/fake/fake.h. Only
+ * the device mode IN endpoint that the CDC fake puts its bulk data on is
+ * modelled, see fakeusbcdc.c.
+ */
+
+#ifndef USB_H_
+#define USB_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define USB_EP_0                0x00000000
+#define USB_EP_1                0x00000010
+#define USB_EP_2                0x00000020
+#define USB_EP_3                0x00000030
+
+#define USB_FIFO_SZ_8           0x00000000
+#define USB_FIFO_SZ_16          0x00000001
+#define USB_FIFO_SZ_32          0x00000002
+#define USB_FIFO_SZ_64          0x00000003
+#define USB_FIFO_SZ_64_DB       0x00000013
+#define USBFIFOSizeToBytes(x)   (8 << ((x) & 0xf))
+
+#define USB_EP_DEV_IN           0x00002000
+#define USB_EP_DEV_OUT          0x00000000
+
+#define USB_TRANS_IN            0x00000102
+
+#define USB_DEV_TX_TXPKTRDY     0x00000001
+
+extern void USBIntRegister(uint32_t ui32Base, void (*pfnHandler)(void));
+extern void USBFIFOConfigSet(uint32_t ui32Base, uint32_t ui32Endpoint, uint32_t ui32FIFOAddress,
+                             uint32_t ui32FIFOSize, uint32_t ui32Flags);
+extern void USBFIFOFlush(uint32_t ui32Base, uint32_t ui32Endpoint, uint32_t ui32Flags);
+extern uint32_t USBEndpointStatus(uint32_t ui32Base, uint32_t ui32Endpoint);
+extern int32_t USBEndpointDataPut(uint32_t ui32Base, uint32_t ui32Endpoint, uint8_t *pui8Data,
+                                  uint32_t ui32Size);
+extern int32_t USBEndpointDataSend(uint32_t ui32Base, uint32_t ui32Endpoint,
+                                   uint32_t ui32TransType);
+
+#endif /* USB_H_ */
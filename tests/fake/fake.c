@@ -0,0 +1,623 @@
+/* fake.c
+ *
+ * Simulated clock, register file and interrupt controller of the driverlib
+ * fake, with the peripherals that only hold state: SysCtl, GPIO, PWM,
+ * timers and SysTick. See fake.h.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+#include "inc/hw_timer.h"
+#include "inc/hw_types.h"
+#include "driverlib/gpio.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/pwm.h"
+#include "driverlib/sysctl.h"
+#include "driverlib/systick.h"
+#include "driverlib/timer.h"
+#include "utils/ustdlib.h"
+
+#include "fake.h"
+#include "fakepriv.h"
+
+// Registers HWREG() can reach, found by open addressing on the address
+#define FAKE_REGS               256
+
+// Handler runs of one interrupt in a row before the fake gives up on a
+// handler that never clears its source
+#define FAKE_INT_STORM          100000
+
+// Events that can be waiting at once
+#define FAKE_EVENTS             32
+
+uint64_t g_ui64FakeTicks;
+static uint32_t g_ui32FakeClockHz;
+
+static struct {
+    uint32_t ui32Addr;
+    uint32_t ui32Value;
+    bool bUsed;
+} g_psFakeRegs[FAKE_REGS];
+
+static void (*g_ppfnFakeVectors[NUM_INTERRUPTS])(void);
+static bool (*g_ppfnFakeLevel[NUM_INTERRUPTS])(void);
+static bool g_pbFakeIntEnabled[NUM_INTERRUPTS];
+static bool g_pbFakeIntPending[NUM_INTERRUPTS];
+static uint8_t g_pui8FakeIntPriority[NUM_INTERRUPTS];
+static uint32_t g_pui32FakeIntCount[NUM_INTERRUPTS];
+static bool g_bFakeMasterOn;
+static uint32_t g_ui32FakeActive;     // Vector running, 0 in thread mode
+
+// Scheduled events, soonest first
+static struct {
+    uint64_t ui64Tick;
+    void (*pfnEvent)(void);
+} g_psFakeEvents[FAKE_EVENTS];
+static uint32_t g_ui32FakeEvents;
+
+// GPIO ports A-F
+static const uint32_t g_pui32FakeGPIOBase[6] = {
+    GPIO_PORTA_BASE, GPIO_PORTB_BASE, GPIO_PORTC_BASE,
+    GPIO_PORTD_BASE, GPIO_PORTE_BASE, GPIO_PORTF_BASE
+};
+static uint8_t g_pui8FakeGPIOData[6];
+
+// PWM0 generator 0 output
+static uint32_t g_ui32FakePWMWidth;
+
+// Timer interrupt mask and raw status, TIMER0, TIMER1 and WTIMER5
+static uint32_t g_pui32FakeTimerIM[3];
+static uint32_t g_pui32FakeTimerRIS[3];
+
+//*****************************************************************************
+// Clock and registers
+//*****************************************************************************
+
+uint32_t FakeClockHz(void) {
+    return g_ui32FakeClockHz;
+}
+
+void FakeTicksAdvance(uint64_t ui64Ticks) {
+    g_ui64FakeTicks += ui64Ticks;
+}
+
+void FakeUsAdvance(uint32_t ui32Us) {
+    g_ui64FakeTicks += (uint64_t)ui32Us * (g_ui32FakeClockHz / 1000000);
+}
+
+uint32_t FakeCycles(void) {
+    return (uint32_t)g_ui64FakeTicks;
+}
+
+volatile uint32_t *FakeReg(uint32_t ui32Addr) {
+    uint32_t ui32Slot;
+    uint32_t ui32Try;
+
+    ui32Slot = (ui32Addr >> 2) % FAKE_REGS;
+    for (ui32Try = 0; ui32Try < FAKE_REGS; ui32Try++) {
+        if (!g_psFakeRegs[ui32Slot].bUsed) {
+            g_psFakeRegs[ui32Slot].bUsed = true;
+            g_psFakeRegs[ui32Slot].ui32Addr = ui32Addr;
+            g_psFakeRegs[ui32Slot].ui32Value = 0;
+        }
+        if (g_psFakeRegs[ui32Slot].ui32Addr == ui32Addr) {
+            break;
+        }
+        ui32Slot = (ui32Slot + 1) % FAKE_REGS;
+    }
+    if (ui32Try == FAKE_REGS) {
+        fprintf(stderr, "fake: register file full at 0x%08x\n", (unsigned)ui32Addr);
+        abort();
+    }
+
+    // WTIMER5 free runs at the system clock, counting up
+    if (ui32Addr == WTIMER5_BASE + TIMER_O_TAV) {
+        g_psFakeRegs[ui32Slot].ui32Value = (uint32_t)g_ui64FakeTicks;
+    }
+
+    return &g_psFakeRegs[ui32Slot].ui32Value;
+}
+
+void FakeReset(void) {
+    g_ui64FakeTicks = 0;
+    g_ui32FakeClockHz = 16000000;
+    memset(g_psFakeRegs, 0, sizeof(g_psFakeRegs));
+
+    memset(g_ppfnFakeVectors, 0, sizeof(g_ppfnFakeVectors));
+    memset(g_ppfnFakeLevel, 0, sizeof(g_ppfnFakeLevel));
+    memset(g_pbFakeIntEnabled, 0, sizeof(g_pbFakeIntEnabled));
+    memset(g_pbFakeIntPending, 0, sizeof(g_pbFakeIntPending));
+    memset(g_pui8FakeIntPriority, 0, sizeof(g_pui8FakeIntPriority));
+    memset(g_pui32FakeIntCount, 0, sizeof(g_pui32FakeIntCount));
+    g_bFakeMasterOn = true;
+    g_ui32FakeActive = 0;
+    g_ui32FakeEvents = 0;
+
+    memset(g_pui8FakeGPIOData, 0, sizeof(g_pui8FakeGPIOData));
+    g_ui32FakePWMWidth = 0;
+    memset(g_pui32FakeTimerIM, 0, sizeof(g_pui32FakeTimerIM));
+    memset(g_pui32FakeTimerRIS, 0, sizeof(g_pui32FakeTimerRIS));
+
+    FakeADCReset();
+    FakeCANReset();
+    FakeUARTReset();
+    FakeUDMAReset();
+    FakeRTOSReset();
+    FakeUSBReset();
+}
+
+void FakeEventAt(uint64_t ui64Tick, void (*pfnEvent)(void)) {
+    uint32_t ui32Idx;
+
+    if (g_ui32FakeEvents == FAKE_EVENTS) {
+        fprintf(stderr, "fake: too many events scheduled\n");
+        abort();
+    }
+
+    // Events due at the same tick run in the order they were scheduled
+    for (ui32Idx = g_ui32FakeEvents; ui32Idx > 0; ui32Idx--) {
+        if (g_psFakeEvents[ui32Idx - 1].ui64Tick <= ui64Tick) {
+            break;
+        }
+        g_psFakeEvents[ui32Idx] = g_psFakeEvents[ui32Idx - 1];
+    }
+    g_psFakeEvents[ui32Idx].ui64Tick = ui64Tick;
+    g_psFakeEvents[ui32Idx].pfnEvent = pfnEvent;
+    g_ui32FakeEvents++;
+}
+
+bool FakeEventRun(uint64_t ui64Until) {
+    void (*pfnEvent)(void);
+
+    if ((g_ui32FakeEvents == 0) || (g_psFakeEvents[0].ui64Tick > ui64Until)) {
+        if (ui64Until > g_ui64FakeTicks) {
+            g_ui64FakeTicks = ui64Until;
+        }
+        return false;
+    }
+
+    if (g_psFakeEvents[0].ui64Tick > g_ui64FakeTicks) {
+        g_ui64FakeTicks = g_psFakeEvents[0].ui64Tick;
+    }
+    pfnEvent = g_psFakeEvents[0].pfnEvent;
+    g_ui32FakeEvents--;
+    memmove(&g_psFakeEvents[0], &g_psFakeEvents[1], g_ui32FakeEvents * sizeof(g_psFakeEvents[0]));
+
+    pfnEvent();
+    return true;
+}
+
+uint64_t FakeEventNext(void) {
+    return g_ui32FakeEvents ? g_psFakeEvents[0].ui64Tick : UINT64_MAX;
+}
+
+//*****************************************************************************
+// Interrupt controller
+//*****************************************************************************
+
+uint32_t FakeIntNumber(uint32_t ui32Base) {
+    switch (ui32Base) {
+    case UART0_BASE:    return INT_UART0;
+    case UART1_BASE:    return INT_UART1;
+    case SSI0_BASE:     return INT_SSI0;
+    case ADC0_BASE:     return INT_ADC0SS0;
+    case TIMER0_BASE:   return INT_TIMER0A;
+    case TIMER1_BASE:   return INT_TIMER1A;
+    case CAN0_BASE:     return INT_CAN0;
+    case CAN1_BASE:     return INT_CAN1;
+    case WTIMER5_BASE:  return INT_WTIMER5A;
+    case USB0_BASE:     return INT_USB0;
+    default:
+        fprintf(stderr, "fake: no interrupt for base 0x%08x\n", (unsigned)ui32Base);
+        abort();
+    }
+}
+
+// Run pending handlers, lowest vector first, unless masked or already in
+// one. Handlers do not nest.
+static void FakeIntDispatch(void) {
+    uint32_t ui32Int;
+    uint32_t ui32Runs;
+
+    if (g_ui32FakeActive) {
+        return;
+    }
+
+    for (ui32Runs = 0; g_bFakeMasterOn; ui32Runs++) {
+        for (ui32Int = 0; ui32Int < NUM_INTERRUPTS; ui32Int++) {
+            if (g_pbFakeIntPending[ui32Int] && g_pbFakeIntEnabled[ui32Int] &&
+                g_ppfnFakeVectors[ui32Int]) {
+                break;
+            }
+        }
+        if (ui32Int == NUM_INTERRUPTS) {
+            return;
+        }
+        if (ui32Runs == FAKE_INT_STORM) {
+            fprintf(stderr, "fake: interrupt %u never cleared\n", (unsigned)ui32Int);
+            abort();
+        }
+
+        g_pbFakeIntPending[ui32Int] = false;
+        g_pui32FakeIntCount[ui32Int]++;
+        g_ui32FakeActive = ui32Int;
+        g_ppfnFakeVectors[ui32Int]();
+        g_ui32FakeActive = 0;
+
+        if (g_ppfnFakeLevel[ui32Int] && g_ppfnFakeLevel[ui32Int]()) {
+            g_pbFakeIntPending[ui32Int] = true;
+        }
+    }
+}
+
+void FakeIntPend(uint32_t ui32Int) {
+    g_pbFakeIntPending[ui32Int] = true;
+    FakeIntDispatch();
+}
+
+bool FakeIntPending(uint32_t ui32Int) {
+    return g_pbFakeIntPending[ui32Int];
+}
+
+void FakeIntService(void) {
+    FakeIntDispatch();
+}
+
+uint32_t FakeIntActive(void) {
+    return g_ui32FakeActive;
+}
+
+uint32_t FakeIntCount(uint32_t ui32Int) {
+    return g_pui32FakeIntCount[ui32Int];
+}
+
+void FakeIntLevelSet(uint32_t ui32Int, bool (*pfnLevel)(void)) {
+    g_ppfnFakeLevel[ui32Int] = pfnLevel;
+}
+
+bool IntMasterEnable(void) {
+    bool bWasOff = !g_bFakeMasterOn;
+
+    g_bFakeMasterOn = true;
+    FakeIntDispatch();
+    return bWasOff;
+}
+
+bool IntMasterDisable(void) {
+    bool bWasOff = !g_bFakeMasterOn;
+
+    g_bFakeMasterOn = false;
+    return bWasOff;
+}
+
+void IntRegister(uint32_t ui32Interrupt, void (*pfnHandler)(void)) {
+    g_ppfnFakeVectors[ui32Interrupt] = pfnHandler;
+}
+
+void IntUnregister(uint32_t ui32Interrupt) {
+    g_ppfnFakeVectors[ui32Interrupt] = 0;
+}
+
+void IntEnable(uint32_t ui32Interrupt) {
+    g_pbFakeIntEnabled[ui32Interrupt] = true;
+    FakeIntDispatch();
+}
+
+void IntDisable(uint32_t ui32Interrupt) {
+    g_pbFakeIntEnabled[ui32Interrupt] = false;
+}
+
+uint32_t IntIsEnabled(uint32_t ui32Interrupt) {
+    return g_pbFakeIntEnabled[ui32Interrupt] ? 1 : 0;
+}
+
+void IntPrioritySet(uint32_t ui32Interrupt, uint8_t ui8Priority) {
+    g_pui8FakeIntPriority[ui32Interrupt] = ui8Priority;
+}
+
+int32_t IntPriorityGet(uint32_t ui32Interrupt) {
+    return g_pui8FakeIntPriority[ui32Interrupt];
+}
+
+void IntPendSet(uint32_t ui32Interrupt) {
+    FakeIntPend(ui32Interrupt);
+}
+
+void IntPendClear(uint32_t ui32Interrupt) {
+    g_pbFakeIntPending[ui32Interrupt] = false;
+}
+
+//*****************************************************************************
+// SysCtl
+//*****************************************************************************
+
+void SysCtlClockSet(uint32_t ui32Config) {
+    // Only the dividers the projects use, off the 400 MHz PLL
+    switch (ui32Config & 0xFFC00000) {
+    case SYSCTL_SYSDIV_2_5:
+        g_ui32FakeClockHz = 80000000;
+        break;
+    case SYSCTL_SYSDIV_4:
+        g_ui32FakeClockHz = 50000000;
+        break;
+    case SYSCTL_SYSDIV_5:
+        g_ui32FakeClockHz = 40000000;
+        break;
+    default:
+        g_ui32FakeClockHz = 16000000;
+        break;
+    }
+}
+
+uint32_t SysCtlClockGet(void) {
+    return g_ui32FakeClockHz;
+}
+
+void SysCtlPeripheralEnable(uint32_t ui32Peripheral) {
+    (void)ui32Peripheral;
+}
+
+bool SysCtlPeripheralReady(uint32_t ui32Peripheral) {
+    (void)ui32Peripheral;
+    return true;
+}
+
+void SysCtlPWMClockSet(uint32_t ui32Config) {
+    (void)ui32Config;
+}
+
+void SysCtlDelay(uint32_t ui32Count) {
+    // Three cycles per loop
+    g_ui64FakeTicks += (uint64_t)ui32Count * 3;
+}
+
+//*****************************************************************************
+// GPIO
+//*****************************************************************************
+
+static uint8_t *FakeGPIOPort(uint32_t ui32Port) {
+    uint32_t ui32Idx;
+
+    for (ui32Idx = 0; ui32Idx < 6; ui32Idx++) {
+        if (g_pui32FakeGPIOBase[ui32Idx] == ui32Port) {
+            return &g_pui8FakeGPIOData[ui32Idx];
+        }
+    }
+    fprintf(stderr, "fake: no GPIO port at 0x%08x\n", (unsigned)ui32Port);
+    abort();
+}
+
+void FakeGPIOInput(uint32_t ui32Port, uint8_t ui8Pins, uint8_t ui8Val) {
+    uint8_t *pui8Data = FakeGPIOPort(ui32Port);
+
+    *pui8Data = (*pui8Data & ~ui8Pins) | (ui8Val & ui8Pins);
+}
+
+uint8_t FakeGPIOOutput(uint32_t ui32Port) {
+    return *FakeGPIOPort(ui32Port);
+}
+
+void GPIOPinConfigure(uint32_t ui32PinConfig) {
+    (void)ui32PinConfig;
+}
+
+void GPIOPadConfigSet(uint32_t ui32Port, uint8_t ui8Pins, uint32_t ui32Strength,
+                      uint32_t ui32PadType) {
+    (void)ui32Port;
+    (void)ui8Pins;
+    (void)ui32Strength;
+    (void)ui32PadType;
+}
+
+// Pin direction and function are not modelled
+#define FAKE_GPIO_TYPE(name)                                                \
+    void name(uint32_t ui32Port, uint8_t ui8Pins) {                         \
+        (void)FakeGPIOPort(ui32Port);                                       \
+        (void)ui8Pins;                                                      \
+    }
+
+FAKE_GPIO_TYPE(GPIOPinTypeADC)
+FAKE_GPIO_TYPE(GPIOPinTypeCAN)
+FAKE_GPIO_TYPE(GPIOPinTypeGPIOInput)
+FAKE_GPIO_TYPE(GPIOPinTypeGPIOOutput)
+FAKE_GPIO_TYPE(GPIOPinTypePWM)
+FAKE_GPIO_TYPE(GPIOPinTypeSSI)
+FAKE_GPIO_TYPE(GPIOPinTypeUART)
+FAKE_GPIO_TYPE(GPIOPinTypeUSBAnalog)
+
+int32_t GPIOPinRead(uint32_t ui32Port, uint8_t ui8Pins) {
+    return *FakeGPIOPort(ui32Port) & ui8Pins;
+}
+
+void GPIOPinWrite(uint32_t ui32Port, uint8_t ui8Pins, uint8_t ui8Val) {
+    FakeGPIOInput(ui32Port, ui8Pins, ui8Val);
+}
+
+//*****************************************************************************
+// PWM
+//*****************************************************************************
+
+void PWMGenConfigure(uint32_t ui32Base, uint32_t ui32Gen, uint32_t ui32Config) {
+    (void)ui32Base;
+    (void)ui32Gen;
+    (void)ui32Config;
+}
+
+void PWMGenPeriodSet(uint32_t ui32Base, uint32_t ui32Gen, uint32_t ui32Period) {
+    (void)ui32Base;
+    (void)ui32Gen;
+    (void)ui32Period;
+}
+
+void PWMGenEnable(uint32_t ui32Base, uint32_t ui32Gen) {
+    (void)ui32Base;
+    (void)ui32Gen;
+}
+
+void PWMDeadBandDisable(uint32_t ui32Base, uint32_t ui32Gen) {
+    (void)ui32Base;
+    (void)ui32Gen;
+}
+
+void PWMPulseWidthSet(uint32_t ui32Base, uint32_t ui32PWMOut, uint32_t ui32Width) {
+    (void)ui32Base;
+    (void)ui32PWMOut;
+    g_ui32FakePWMWidth = ui32Width;
+}
+
+uint32_t PWMPulseWidthGet(uint32_t ui32Base, uint32_t ui32PWMOut) {
+    (void)ui32Base;
+    (void)ui32PWMOut;
+    return g_ui32FakePWMWidth;
+}
+
+void PWMOutputState(uint32_t ui32Base, uint32_t ui32PWMOutBits, bool bEnable) {
+    (void)ui32Base;
+    (void)ui32PWMOutBits;
+    (void)bEnable;
+}
+
+void PWMOutputUpdateMode(uint32_t ui32Base, uint32_t ui32PWMOutBits, uint32_t ui32Mode) {
+    (void)ui32Base;
+    (void)ui32PWMOutBits;
+    (void)ui32Mode;
+}
+
+//*****************************************************************************
+// Timers. They do not count, FakeTimerTimeout() stands in for expiry.
+//*****************************************************************************
+
+static uint32_t FakeTimerIndex(uint32_t ui32Base) {
+    switch (ui32Base) {
+    case TIMER0_BASE:   return 0;
+    case TIMER1_BASE:   return 1;
+    case WTIMER5_BASE:  return 2;
+    default:
+        fprintf(stderr, "fake: no timer at 0x%08x\n", (unsigned)ui32Base);
+        abort();
+    }
+}
+
+static bool FakeTimer0Level(void) {
+    return (g_pui32FakeTimerIM[0] & g_pui32FakeTimerRIS[0]) != 0;
+}
+
+static bool FakeTimer1Level(void) {
+    return (g_pui32FakeTimerIM[1] & g_pui32FakeTimerRIS[1]) != 0;
+}
+
+void FakeTimerTimeout(uint32_t ui32Base) {
+    uint32_t ui32Idx = FakeTimerIndex(ui32Base);
+
+    g_pui32FakeTimerRIS[ui32Idx] |= TIMER_TIMA_TIMEOUT;
+    if (g_pui32FakeTimerIM[ui32Idx] & TIMER_TIMA_TIMEOUT) {
+        FakeIntPend(FakeIntNumber(ui32Base));
+    }
+}
+
+void TimerClockSourceSet(uint32_t ui32Base, uint32_t ui32Source) {
+    (void)FakeTimerIndex(ui32Base);
+    (void)ui32Source;
+}
+
+void TimerConfigure(uint32_t ui32Base, uint32_t ui32Config) {
+    (void)FakeTimerIndex(ui32Base);
+    (void)ui32Config;
+}
+
+void TimerControlTrigger(uint32_t ui32Base, uint32_t ui32Timer, bool bEnable) {
+    (void)FakeTimerIndex(ui32Base);
+    (void)ui32Timer;
+    (void)bEnable;
+}
+
+void TimerPrescaleSet(uint32_t ui32Base, uint32_t ui32Timer, uint32_t ui32Value) {
+    (void)FakeTimerIndex(ui32Base);
+    (void)ui32Timer;
+    (void)ui32Value;
+}
+
+void TimerLoadSet(uint32_t ui32Base, uint32_t ui32Timer, uint32_t ui32Value) {
+    (void)ui32Timer;
+    HWREG(ui32Base + TIMER_O_TAILR) = ui32Value;
+}
+
+void TimerLoadSet64(uint32_t ui32Base, uint64_t ui64Value) {
+    HWREG(ui32Base + TIMER_O_TAILR) = (uint32_t)ui64Value;
+}
+
+void TimerEnable(uint32_t ui32Base, uint32_t ui32Timer) {
+    (void)FakeTimerIndex(ui32Base);
+    (void)ui32Timer;
+}
+
+void TimerDisable(uint32_t ui32Base, uint32_t ui32Timer) {
+    (void)FakeTimerIndex(ui32Base);
+    (void)ui32Timer;
+}
+
+void TimerIntEnable(uint32_t ui32Base, uint32_t ui32IntFlags) {
+    g_pui32FakeTimerIM[FakeTimerIndex(ui32Base)] |= ui32IntFlags;
+}
+
+void TimerIntClear(uint32_t ui32Base, uint32_t ui32IntFlags) {
+    g_pui32FakeTimerRIS[FakeTimerIndex(ui32Base)] &= ~ui32IntFlags;
+}
+
+void TimerIntRegister(uint32_t ui32Base, uint32_t ui32Timer, void (*pfnHandler)(void)) {
+    uint32_t ui32Int = FakeIntNumber(ui32Base);
+
+    (void)ui32Timer;
+    FakeIntLevelSet(ui32Int, (FakeTimerIndex(ui32Base) == 0) ? FakeTimer0Level : FakeTimer1Level);
+    IntRegister(ui32Int, pfnHandler);
+    IntEnable(ui32Int);
+}
+
+//*****************************************************************************
+// SysTick
+//*****************************************************************************
+
+void SysTickEnable(void) {
+}
+
+void SysTickDisable(void) {
+}
+
+void SysTickIntRegister(void (*pfnHandler)(void)) {
+    IntRegister(FAULT_SYSTICK, pfnHandler);
+    g_pbFakeIntEnabled[FAULT_SYSTICK] = true;
+}
+
+void SysTickIntEnable(void) {
+    g_pbFakeIntEnabled[FAULT_SYSTICK] = true;
+}
+
+void SysTickPeriodSet(uint32_t ui32Period) {
+    (void)ui32Period;
+}
+
+//*****************************************************************************
+// utils/ustdlib
+//*****************************************************************************
+
+int uvsnprintf(char *pcBuf, uint32_t ui32Size, const char *pcString, va_list vaArgP) {
+    return vsnprintf(pcBuf, ui32Size, pcString, vaArgP);
+}
+
+int usnprintf(char *pcBuf, uint32_t ui32Size, const char *pcString, ...) {
+    va_list vaArgP;
+    int iRet;
+
+    va_start(vaArgP, pcString);
+    iRet = vsnprintf(pcBuf, ui32Size, pcString, vaArgP);
+    va_end(vaArgP);
+
+    return iRet;
+}
@@ -0,0 +1,265 @@
+/* fake.h
+ *
+ * Register-level fake of the TivaWare driverlib calls the firmware makes,
+ * so the projects build and run on the host. The headers under inc/ and
+ * driverlib/ next to this file stand in for TivaWare's and declare the same
+ * functions with the same constants. The fake*.c files behind them model
+ * the peripheral state the firmware depends on: the 32 CAN message objects
+ * with their acceptance filters, FIFO chaining, NEWDAT, MSGLST and TXRQST
+ * bits, the ADC sequencer FIFO, SSI with its uDMA receive channel, the UART
+ * FIFOs, GPIO data, and an interrupt controller that calls the registered
+ * handlers. The headers under xdc/, ti/ and usblib/ do the same for the
+ * parts of SYS/BIOS and usblib the USB devices use, with fakertos.c,
+ * fakeusb.c, fakeusbhid.c and fakeusbcdc.c behind them.
+ *
+ * The host build force-includes this header (-include fake.h), so the
+ * functions below, which a test or benchmark uses to play the other side of
+ * the hardware, are always declared.
+ *
+ * Time is simulated. g_ui64FakeTicks counts system clock cycles at the rate
+ * SysCtlClockSet() selected and only moves when FakeTicksAdvance() is
+ * called. WTIMER5's value register and the DWT cycle counter read it, so
+ * CANLatencyNow() and the interrupt trace see the simulated clock.
+ *
+ * Interrupts are taken the way the NVIC would at a single priority level:
+ * a pending interrupt runs as soon as it and the master enable are both
+ * enabled and no other handler is running. Peripherals with a level
+ * sensitive line pend it again when a handler returns without clearing the
+ * cause.
+ */
+
+#ifndef FAKE_H_
+#define FAKE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// The host has no DWT, the trace stamps the simulated clock instead
+#define ISRTRACE_NO_DWT
+#define ISRTRACE_CYCLES()       FakeCycles()
+
+//*****************************************************************************
+// Clock and registers
+//*****************************************************************************
+
+extern uint64_t g_ui64FakeTicks;
+
+// System clock in Hz, 16 MHz until SysCtlClockSet()
+extern uint32_t FakeClockHz(void);
+
+// Move the simulated clock on
+extern void FakeTicksAdvance(uint64_t ui64Ticks);
+extern void FakeUsAdvance(uint32_t ui32Us);
+
+// Low 32 bits of the clock, the DWT cycle counter
+extern uint32_t FakeCycles(void);
+
+// Storage behind HWREG(). Every address reads back what was last written
+// to it, except the few registers the fake models.
+extern volatile uint32_t *FakeReg(uint32_t ui32Addr);
+
+// Call pfnEvent from FakeEventRun() once the clock reaches ui64Tick. This
+// is how the models with their own timing, the USB host for one, get time
+// to pass while the firmware waits.
+extern void FakeEventAt(uint64_t ui64Tick, void (*pfnEvent)(void));
+
+// Run the next event if it is due by ui64Until, moving the clock on to it,
+// and return true. Otherwise move the clock to ui64Until and return false.
+extern bool FakeEventRun(uint64_t ui64Until);
+
+// Tick of the next event, UINT64_MAX if there is none
+extern uint64_t FakeEventNext(void);
+
+// Put every peripheral, the clock and the interrupt controller back to
+// their reset state
+extern void FakeReset(void);
+
+//*****************************************************************************
+// Interrupt controller
+//*****************************************************************************
+
+// Mark an interrupt pending and take it if it can be taken now
+extern void FakeIntPend(uint32_t ui32Int);
+
+// True if ui32Int is pending and has not run yet
+extern bool FakeIntPending(uint32_t ui32Int);
+
+// Take every pending interrupt that is enabled
+extern void FakeIntService(void);
+
+// Interrupt whose handler is running, 0 in thread mode
+extern uint32_t FakeIntActive(void);
+
+// Number of times each interrupt's handler has been called
+extern uint32_t FakeIntCount(uint32_t ui32Int);
+
+// For a level sensitive source, pfnLevel returns true while the peripheral
+// still asserts the line. Checked after each run of the handler.
+extern void FakeIntLevelSet(uint32_t ui32Int, bool (*pfnLevel)(void));
+
+//*****************************************************************************
+// Timers
+//*****************************************************************************
+
+// The timer has counted down, raise its timeout interrupt if enabled
+extern void FakeTimerTimeout(uint32_t ui32Base);
+
+//*****************************************************************************
+// GPIO
+//*****************************************************************************
+
+// Drive input pins from outside, or read back what the firmware wrote
+extern void FakeGPIOInput(uint32_t ui32Port, uint8_t ui8Pins, uint8_t ui8Val);
+extern uint8_t FakeGPIOOutput(uint32_t ui32Port);
+
+//*****************************************************************************
+// ADC, SSI and uDMA
+//*****************************************************************************
+
+// Value the next ADC conversions on ui32Base return
+extern void FakeADCInput(uint32_t ui32Base, uint32_t ui32Value);
+
+// Conversions the sequencer dropped because its FIFO was full
+extern uint32_t FakeADCOverflows(uint32_t ui32Base);
+
+// 12 bit value the device on SSI0 shifts back for each frame, the MCP3202
+extern void FakeSSIInput(uint32_t ui32Value);
+
+// Frames clocked out on SSI0 since reset
+extern uint32_t FakeSSIFrames(void);
+
+//*****************************************************************************
+// UART
+//*****************************************************************************
+
+// Take up to ui32Max bytes the firmware sent out of ui32Base, returning the
+// number taken. Taking them makes room in the transmit FIFO.
+extern uint32_t FakeUARTTxGet(uint32_t ui32Base, uint8_t *pui8Buf, uint32_t ui32Max);
+
+// Feed bytes to the receive FIFO, returning how many fitted
+extern uint32_t FakeUARTRxPut(uint32_t ui32Base, const uint8_t *pui8Buf, uint32_t ui32Len);
+
+//*****************************************************************************
+// CAN
+//*****************************************************************************
+
+typedef struct {
+    uint32_t ui32ID;            // 11 or 29 bit identifier
+    bool bExtended;
+    uint32_t ui32Len;
+    uint8_t pui8Data[8];
+} tFakeCANFrame;
+
+// A frame seen on the bus. The controller stores it in the first message
+// object whose filter accepts it, following FIFO chains, and returns that
+// object's number, or 0 if no object took it. Frames are ignored while the
+// controller is in init.
+extern uint32_t FakeCANReceive(uint32_t ui32Base, const tFakeCANFrame *psFrame);
+
+// Win arbitration with the lowest numbered object that has a transmit
+// request, send it and complete it. Returns the object number and the frame
+// sent, or 0 if nothing is waiting.
+extern uint32_t FakeCANTransmit(uint32_t ui32Base, tFakeCANFrame *psFrame);
+
+// Set the error counters and the last error code as the bus would, and
+// raise a status interrupt. The bus-off, passive and warning bits follow
+// from the counters. Going bus-off puts the controller in init like the
+// hardware does. Setting the counters back below 256 after CANEnable()
+// stands in for the 128 idle sequences that end bus-off.
+extern void FakeCANError(uint32_t ui32Base, uint32_t ui32TEC, uint32_t ui32REC,
+                         uint32_t ui32LEC);
+
+// True while the controller is held in init
+extern bool FakeCANInit(uint32_t ui32Base);
+
+//*****************************************************************************
+// SYS/BIOS
+//*****************************************************************************
+
+// Times a Semaphore_pend() had to wait and was then posted, each one a task
+// switch on the target
+extern uint32_t FakeSemaphoreWakeups(void);
+
+//*****************************************************************************
+// USB keyboard host
+//*****************************************************************************
+
+// Bus events, each delivered to the device's callback from INT_USB0
+extern void FakeUSBConnect(void);
+extern void FakeUSBDisconnect(void);
+extern void FakeUSBSuspend(void);
+
+// The host sets the keyboard LEDs with an output report
+extern void FakeUSBKeyboardLEDs(uint8_t ui8LEDs);
+
+// Interval at which the host polls the interrupt IN endpoint, 10 ms after
+// reset
+extern void FakeUSBPollSet(uint32_t ui32Ms);
+
+// Keyboard reports the host has received
+extern uint32_t FakeUSBReports(void);
+
+// USBDHIDKeyboardKeyStateChange() calls from thread mode (false) or from an
+// interrupt handler (true)
+extern uint32_t FakeUSBKeyCalls(bool bInterrupt);
+
+// The text the host saw typed, NULL terminated in a buffer of ui32Size
+// bytes. Returns its length.
+extern uint32_t FakeUSBTyped(char *pcBuf, uint32_t ui32Size);
+
+//*****************************************************************************
+// USB generic HID host
+//*****************************************************************************
+
+// Each device is the tUSBDHIDDevice the firmware passed to USBDHIDInit().
+// INT_USB0 must be routed to USB0DeviceIntHandler().
+
+// Interval in ms at which the host polls the device's interrupt IN
+// endpoint, from the endpoint descriptor, or 16 without one
+extern uint32_t FakeUSBHIDPollMs(const void *pvDevice);
+
+// Poll the device every ui32Ms instead, as if its descriptor asked for it
+extern void FakeUSBHIDPollSet(const void *pvDevice, uint32_t ui32Ms);
+
+// Reports the host has taken from the device, and those it dropped because
+// 64 were already waiting to be read
+extern uint32_t FakeUSBHIDReports(const void *pvDevice);
+extern uint32_t FakeUSBHIDOverflows(const void *pvDevice);
+
+// Copy the oldest unread report into a buffer of ui32Size bytes. Returns
+// its length, or 0 if none is waiting.
+extern uint32_t FakeUSBHIDRead(const void *pvDevice, uint8_t *pui8Buf, uint32_t ui32Size);
+
+// The host writes an OUT report. Returns false if the device has not read
+// the last one, or has no OUT endpoint.
+extern bool FakeUSBHIDWrite(const void *pvDevice, const uint8_t *pui8Data, uint32_t ui32Len);
+
+// Control requests, delivered to the device's callback from INT_USB0
+extern void FakeUSBHIDSetReport(const void *pvDevice, const uint8_t *pui8Data, uint32_t ui32Len);
+extern void FakeUSBHIDSetProtocol(const void *pvDevice, uint8_t ui8Protocol);
+extern uint32_t FakeUSBHIDGetReport(const void *pvDevice, uint8_t *pui8Buf, uint32_t ui32Size);
+
+//*****************************************************************************
+// USB CDC serial host
+//*****************************************************************************
+
+// The host opens the port, setting DTR and RTS, and from then on reads the
+// bulk IN endpoint with 19 tokens a frame, or closes it again
+extern void FakeUSBCDCOpen(bool bOpen);
+
+// Take up to ui32Size of the bytes the host has received, returning the
+// number taken. The host keeps 64 KB; what arrives beyond that is lost.
+extern uint32_t FakeUSBCDCRead(uint8_t *pui8Buf, uint32_t ui32Size);
+
+// Bytes the host has received in all, and the tokens it found no packet for
+extern uint64_t FakeUSBCDCBytes(void);
+extern uint64_t FakeUSBCDCNaks(void);
+
+// After ui32Pct percent of the packets the host takes, keep INT_USB0 from
+// running for ui32Us, as a longer handler of higher priority would
+extern void FakeUSBCDCHoldOff(uint32_t ui32Pct, uint32_t ui32Us);
+
+// Configure FIFOs asked for double buffered as single buffered instead
+extern void FakeUSBEndpointSingle(bool bSingle);
+
+#endif /* FAKE_H_ */
@@ -0,0 +1,354 @@
+/* fakeadc.c
+ *
+ * ADC0 and SSI0 of the driverlib fake, see fake.h.
+ *
+ * A sequencer converts every step up to the one marked ADC_CTL_END when it
+ * is triggered, all returning the FakeADCInput() value, and pushes the
+ * results into its FIFO. With ADC_CTL_IE on a step the raw interrupt bit is
+ * set, and the interrupt line stays up while it is set and unmasked. If the
+ * sequencer has uDMA enabled, channel 14 takes the results as they arrive.
+ *
+ * SSI0 clocks a frame out the moment it is written and the device on the
+ * other end answers with the FakeSSIInput() value. The answer goes to uDMA
+ * channel 10 when SSI receive DMA is on and the channel is armed, otherwise
+ * into the 8 entry receive FIFO. A finished uDMA transfer pends the SSI0
+ * interrupt, as on the TM4C123.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+#include "driverlib/adc.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/ssi.h"
+#include "driverlib/udma.h"
+
+#include "fake.h"
+#include "fakepriv.h"
+
+#define FAKE_ADC_SEQUENCERS     4
+#define FAKE_SSI_FIFO           8
+
+// FIFO depth of each sequencer
+static const uint32_t g_pui32FakeADCDepth[FAKE_ADC_SEQUENCERS] = { 8, 4, 4, 1 };
+
+static struct {
+    bool bEnabled;
+    bool bDMA;
+    uint32_t ui32Steps;         // Steps up to and including ADC_CTL_END
+    bool bIE;                   // Some step has ADC_CTL_IE
+    uint32_t pui32FIFO[8];
+    uint32_t ui32Head;
+    uint32_t ui32Count;
+} g_psFakeADCSeq[FAKE_ADC_SEQUENCERS];
+
+static uint32_t g_ui32FakeADCValue;
+static uint32_t g_ui32FakeADCIM;
+static uint32_t g_ui32FakeADCRIS;
+static uint32_t g_ui32FakeADCOverflows;
+
+static uint32_t g_ui32FakeSSIValue;
+static uint32_t g_ui32FakeSSIFrames;
+static uint32_t g_ui32FakeSSIDMA;
+static uint32_t g_pui32FakeSSIFIFO[FAKE_SSI_FIFO];
+static uint32_t g_ui32FakeSSIHead;
+static uint32_t g_ui32FakeSSICount;
+
+void FakeADCReset(void) {
+    memset(g_psFakeADCSeq, 0, sizeof(g_psFakeADCSeq));
+    g_ui32FakeADCValue = 0;
+    g_ui32FakeADCIM = 0;
+    g_ui32FakeADCRIS = 0;
+    g_ui32FakeADCOverflows = 0;
+
+    g_ui32FakeSSIValue = 0;
+    g_ui32FakeSSIFrames = 0;
+    g_ui32FakeSSIDMA = 0;
+    g_ui32FakeSSIHead = 0;
+    g_ui32FakeSSICount = 0;
+}
+
+//*****************************************************************************
+// ADC0
+//*****************************************************************************
+
+static void FakeADCCheck(uint32_t ui32Base, uint32_t ui32SequenceNum) {
+    if ((ui32Base != ADC0_BASE) || (ui32SequenceNum >= FAKE_ADC_SEQUENCERS)) {
+        fprintf(stderr, "fake: no ADC sequencer %u at 0x%08x\n", (unsigned)ui32SequenceNum,
+                (unsigned)ui32Base);
+        abort();
+    }
+}
+
+#define FAKE_ADC_LEVEL(n)                                                   \
+    static bool FakeADCLevel##n(void) {                                     \
+        return (g_ui32FakeADCIM & g_ui32FakeADCRIS & (1U << (n))) != 0;     \
+    }
+
+FAKE_ADC_LEVEL(0)
+FAKE_ADC_LEVEL(1)
+FAKE_ADC_LEVEL(2)
+FAKE_ADC_LEVEL(3)
+
+static bool (*const g_ppfnFakeADCLevel[FAKE_ADC_SEQUENCERS])(void) = {
+    FakeADCLevel0, FakeADCLevel1, FakeADCLevel2, FakeADCLevel3
+};
+
+void FakeADCInput(uint32_t ui32Base, uint32_t ui32Value) {
+    FakeADCCheck(ui32Base, 0);
+    g_ui32FakeADCValue = ui32Value & 0xFFF;
+}
+
+uint32_t FakeADCOverflows(uint32_t ui32Base) {
+    FakeADCCheck(ui32Base, 0);
+    return g_ui32FakeADCOverflows;
+}
+
+void ADCSequenceConfigure(uint32_t ui32Base, uint32_t ui32SequenceNum, uint32_t ui32Trigger,
+                          uint32_t ui32Priority) {
+    FakeADCCheck(ui32Base, ui32SequenceNum);
+    (void)ui32Trigger;
+    (void)ui32Priority;
+}
+
+void ADCSequenceStepConfigure(uint32_t ui32Base, uint32_t ui32SequenceNum, uint32_t ui32Step,
+                              uint32_t ui32Config) {
+    FakeADCCheck(ui32Base, ui32SequenceNum);
+    if (ui32Config & ADC_CTL_END) {
+        g_psFakeADCSeq[ui32SequenceNum].ui32Steps = ui32Step + 1;
+    }
+    if (ui32Config & ADC_CTL_IE) {
+        g_psFakeADCSeq[ui32SequenceNum].bIE = true;
+    }
+}
+
+void ADCSequenceEnable(uint32_t ui32Base, uint32_t ui32SequenceNum) {
+    FakeADCCheck(ui32Base, ui32SequenceNum);
+    g_psFakeADCSeq[ui32SequenceNum].bEnabled = true;
+}
+
+void ADCSequenceDisable(uint32_t ui32Base, uint32_t ui32SequenceNum) {
+    FakeADCCheck(ui32Base, ui32SequenceNum);
+    g_psFakeADCSeq[ui32SequenceNum].bEnabled = false;
+}
+
+void ADCSequenceDMAEnable(uint32_t ui32Base, uint32_t ui32SequenceNum) {
+    FakeADCCheck(ui32Base, ui32SequenceNum);
+    g_psFakeADCSeq[ui32SequenceNum].bDMA = true;
+}
+
+int32_t ADCSequenceDataGet(uint32_t ui32Base, uint32_t ui32SequenceNum, uint32_t *pui32Buffer) {
+    uint32_t ui32Count = 0;
+
+    FakeADCCheck(ui32Base, ui32SequenceNum);
+    while (g_psFakeADCSeq[ui32SequenceNum].ui32Count) {
+        *pui32Buffer++ = g_psFakeADCSeq[ui32SequenceNum].pui32FIFO[
+            g_psFakeADCSeq[ui32SequenceNum].ui32Head];
+        g_psFakeADCSeq[ui32SequenceNum].ui32Head =
+            (g_psFakeADCSeq[ui32SequenceNum].ui32Head + 1) % g_pui32FakeADCDepth[ui32SequenceNum];
+        g_psFakeADCSeq[ui32SequenceNum].ui32Count--;
+        ui32Count++;
+    }
+
+    return ui32Count;
+}
+
+void ADCProcessorTrigger(uint32_t ui32Base, uint32_t ui32SequenceNum) {
+    uint32_t ui32Step;
+    uint32_t ui32Slot;
+    bool bDone = false;
+
+    FakeADCCheck(ui32Base, ui32SequenceNum);
+    if (!g_psFakeADCSeq[ui32SequenceNum].bEnabled) {
+        return;
+    }
+
+    for (ui32Step = 0; ui32Step < g_psFakeADCSeq[ui32SequenceNum].ui32Steps; ui32Step++) {
+        if (g_psFakeADCSeq[ui32SequenceNum].bDMA &&
+            FakeUDMAToMemory(UDMA_CHANNEL_ADC0 + ui32SequenceNum, g_ui32FakeADCValue, &bDone)) {
+            continue;
+        }
+        if (g_psFakeADCSeq[ui32SequenceNum].ui32Count == g_pui32FakeADCDepth[ui32SequenceNum]) {
+            g_ui32FakeADCOverflows++;
+            continue;
+        }
+        ui32Slot = (g_psFakeADCSeq[ui32SequenceNum].ui32Head +
+                    g_psFakeADCSeq[ui32SequenceNum].ui32Count) % g_pui32FakeADCDepth[ui32SequenceNum];
+        g_psFakeADCSeq[ui32SequenceNum].pui32FIFO[ui32Slot] = g_ui32FakeADCValue;
+        g_psFakeADCSeq[ui32SequenceNum].ui32Count++;
+    }
+
+    // The uDMA done signal comes in on the sequencer's interrupt
+    if (g_psFakeADCSeq[ui32SequenceNum].bIE || bDone) {
+        g_ui32FakeADCRIS |= 1U << ui32SequenceNum;
+        if (g_ui32FakeADCIM & (1U << ui32SequenceNum)) {
+            FakeIntPend(INT_ADC0SS0 + ui32SequenceNum);
+        }
+    }
+}
+
+void ADCHardwareOversampleConfigure(uint32_t ui32Base, uint32_t ui32Factor) {
+    FakeADCCheck(ui32Base, 0);
+    (void)ui32Factor;
+}
+
+void ADCIntEnable(uint32_t ui32Base, uint32_t ui32SequenceNum) {
+    FakeADCCheck(ui32Base, ui32SequenceNum);
+    g_ui32FakeADCIM |= 1U << ui32SequenceNum;
+}
+
+void ADCIntDisable(uint32_t ui32Base, uint32_t ui32SequenceNum) {
+    FakeADCCheck(ui32Base, ui32SequenceNum);
+    g_ui32FakeADCIM &= ~(1U << ui32SequenceNum);
+}
+
+void ADCIntClear(uint32_t ui32Base, uint32_t ui32SequenceNum) {
+    FakeADCCheck(ui32Base, ui32SequenceNum);
+    g_ui32FakeADCRIS &= ~(1U << ui32SequenceNum);
+}
+
+uint32_t ADCIntStatus(uint32_t ui32Base, uint32_t ui32SequenceNum, bool bMasked) {
+    uint32_t ui32Bit = 1U << ui32SequenceNum;
+
+    FakeADCCheck(ui32Base, ui32SequenceNum);
+    if (bMasked) {
+        return g_ui32FakeADCIM & g_ui32FakeADCRIS & ui32Bit;
+    }
+    return g_ui32FakeADCRIS & ui32Bit;
+}
+
+void ADCIntRegister(uint32_t ui32Base, uint32_t ui32SequenceNum, void (*pfnHandler)(void)) {
+    FakeADCCheck(ui32Base, ui32SequenceNum);
+    FakeIntLevelSet(INT_ADC0SS0 + ui32SequenceNum, g_ppfnFakeADCLevel[ui32SequenceNum]);
+    IntRegister(INT_ADC0SS0 + ui32SequenceNum, pfnHandler);
+    IntEnable(INT_ADC0SS0 + ui32SequenceNum);
+}
+
+//*****************************************************************************
+// SSI0
+//*****************************************************************************
+
+static void FakeSSICheck(uint32_t ui32Base) {
+    if (ui32Base != SSI0_BASE) {
+        fprintf(stderr, "fake: no SSI at 0x%08x\n", (unsigned)ui32Base);
+        abort();
+    }
+}
+
+// Clock one frame, the answer goes to uDMA or the receive FIFO
+static void FakeSSIFrame(void) {
+    bool bDone;
+
+    g_ui32FakeSSIFrames++;
+
+    if ((g_ui32FakeSSIDMA & SSI_DMA_RX) &&
+        FakeUDMAToMemory(UDMA_CHANNEL_SSI0RX, g_ui32FakeSSIValue, &bDone)) {
+        if (bDone) {
+            FakeIntPend(INT_SSI0);
+        }
+        return;
+    }
+
+    // An overrun loses the new frame
+    if (g_ui32FakeSSICount < FAKE_SSI_FIFO) {
+        g_pui32FakeSSIFIFO[(g_ui32FakeSSIHead + g_ui32FakeSSICount) % FAKE_SSI_FIFO] =
+            g_ui32FakeSSIValue;
+        g_ui32FakeSSICount++;
+    }
+}
+
+void FakeSSIInput(uint32_t ui32Value) {
+    g_ui32FakeSSIValue = ui32Value & 0xFFF;
+}
+
+uint32_t FakeSSIFrames(void) {
+    return g_ui32FakeSSIFrames;
+}
+
+void SSIConfigSetExpClk(uint32_t ui32Base, uint32_t ui32SSIClk, uint32_t ui32Protocol,
+                        uint32_t ui32Mode, uint32_t ui32BitRate, uint32_t ui32DataWidth) {
+    FakeSSICheck(ui32Base);
+    (void)ui32SSIClk;
+    (void)ui32Protocol;
+    (void)ui32Mode;
+    (void)ui32BitRate;
+    (void)ui32DataWidth;
+}
+
+void SSIClockSourceSet(uint32_t ui32Base, uint32_t ui32Source) {
+    FakeSSICheck(ui32Base);
+    (void)ui32Source;
+}
+
+void SSIEnable(uint32_t ui32Base) {
+    FakeSSICheck(ui32Base);
+}
+
+void SSIDisable(uint32_t ui32Base) {
+    FakeSSICheck(ui32Base);
+}
+
+void SSIDataPut(uint32_t ui32Base, uint32_t ui32Data) {
+    FakeSSICheck(ui32Base);
+    (void)ui32Data;
+    FakeSSIFrame();
+}
+
+int32_t SSIDataPutNonBlocking(uint32_t ui32Base, uint32_t ui32Data) {
+    FakeSSICheck(ui32Base);
+    (void)ui32Data;
+    FakeSSIFrame();
+    return 1;
+}
+
+int32_t SSIDataGetNonBlocking(uint32_t ui32Base, uint32_t *pui32Data) {
+    FakeSSICheck(ui32Base);
+    if (g_ui32FakeSSICount == 0) {
+        return 0;
+    }
+    *pui32Data = g_pui32FakeSSIFIFO[g_ui32FakeSSIHead];
+    g_ui32FakeSSIHead = (g_ui32FakeSSIHead + 1) % FAKE_SSI_FIFO;
+    g_ui32FakeSSICount--;
+    return 1;
+}
+
+void SSIDataGet(uint32_t ui32Base, uint32_t *pui32Data) {
+    // Nothing else would ever fill the FIFO
+    if (!SSIDataGetNonBlocking(ui32Base, pui32Data)) {
+        fprintf(stderr, "fake: SSIDataGet() with an empty receive FIFO\n");
+        abort();
+    }
+}
+
+bool SSIBusy(uint32_t ui32Base) {
+    FakeSSICheck(ui32Base);
+    return false;
+}
+
+void SSIDMAEnable(uint32_t ui32Base, uint32_t ui32DMAFlags) {
+    FakeSSICheck(ui32Base);
+    g_ui32FakeSSIDMA |= ui32DMAFlags;
+}
+
+void SSIIntRegister(uint32_t ui32Base, void (*pfnHandler)(void)) {
+    FakeSSICheck(ui32Base);
+    IntRegister(INT_SSI0, pfnHandler);
+    IntEnable(INT_SSI0);
+}
+
+// Only the uDMA done signal raises the interrupt, it has no status bit
+uint32_t SSIIntStatus(uint32_t ui32Base, bool bMasked) {
+    FakeSSICheck(ui32Base);
+    (void)bMasked;
+    return 0;
+}
+
+void SSIIntClear(uint32_t ui32Base, uint32_t ui32IntFlags) {
+    FakeSSICheck(ui32Base);
+    (void)ui32IntFlags;
+}
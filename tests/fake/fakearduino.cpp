@@ -0,0 +1,268 @@
+/* fakearduino.cpp
+ *
+ * The Arduino core of Arduino.h, with Serial on a pty.
+ *
+ * The UART is modelled at the baud rate Serial.begin() asks for, 10 bits a
+ * byte. Bytes the host writes to the pty come off the line one byte time
+ * apart into the 64 byte receive buffer, and are lost when it is full, as
+ * the AVR core's receive interrupt drops them. Bytes written to Serial wait
+ * in the 64 byte transmit buffer and go to the pty one byte time apart.
+ * The line keeps running while loop() is busy: whenever Serial is next
+ * used, everything the line would have moved since is moved, in order,
+ * with what no longer fitted counted as overruns.
+ *
+ * Line time follows the host clock, except that it moves at most 200 us
+ * between two uses of Serial, or by the stall FakeArduinoRun() puts in.
+ * A sketch the host has not scheduled for a while has not stalled as far
+ * as the line is concerned, as an AVR's interrupts would not have been
+ * held up either.
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "Arduino.h"
+
+#define FAKE_LINE_GAP_NS        200000
+
+HardwareSerial Serial;
+
+static int g_iFakeFd = -1;
+static uint64_t g_ui64FakeByteNs = 1000000000 / 960;
+static uint64_t g_ui64FakeStartNs;
+static uint64_t g_ui64FakeLineNs;
+static uint64_t g_ui64FakeHostNs;
+static volatile sig_atomic_t g_bFakeStop;
+
+static uint8_t g_pui8FakeRx[SERIAL_RX_BUFFER_SIZE];
+static uint32_t g_ui32FakeRxHead;
+static uint32_t g_ui32FakeRxTail;
+static uint64_t g_ui64FakeRxNs;
+static uint32_t g_ui32FakeOverruns;
+
+static uint8_t g_pui8FakeTx[SERIAL_TX_BUFFER_SIZE];
+static uint32_t g_ui32FakeTxHead;
+static uint32_t g_ui32FakeTxTail;
+static uint64_t g_ui64FakeTxNs;
+
+static uint64_t FakeNowNs(void) {
+    struct timespec sTime;
+
+    clock_gettime(CLOCK_MONOTONIC, &sTime);
+    return (uint64_t)sTime.tv_sec * 1000000000u + (uint64_t)sTime.tv_nsec;
+}
+
+static uint64_t FakeLineNs(void) {
+    uint64_t ui64Host = FakeNowNs();
+    uint64_t ui64Delta = ui64Host - g_ui64FakeHostNs;
+
+    g_ui64FakeHostNs = ui64Host;
+    g_ui64FakeLineNs += (ui64Delta < FAKE_LINE_GAP_NS) ? ui64Delta : FAKE_LINE_GAP_NS;
+    return g_ui64FakeLineNs;
+}
+
+// Move what the line has carried each way since the last call
+static void FakeSerialService(void) {
+    uint8_t pui8Buf[256];
+    uint64_t ui64Now = FakeLineNs();
+    uint64_t ui64Bytes;
+    uint32_t ui32Count;
+    ssize_t iLen;
+    ssize_t iIdx;
+
+    if (g_iFakeFd < 0) {
+        return;
+    }
+
+    // Receive: the host's bytes arrive one byte time apart, until the
+    // line goes idle
+    ui64Bytes = (ui64Now - g_ui64FakeRxNs) / g_ui64FakeByteNs;
+    while (ui64Bytes) {
+        iLen = read(g_iFakeFd, pui8Buf,
+                    (ui64Bytes < sizeof(pui8Buf)) ? ui64Bytes : sizeof(pui8Buf));
+        if (iLen <= 0) {
+            g_ui64FakeRxNs = ui64Now;
+            break;
+        }
+        for (iIdx = 0; iIdx < iLen; iIdx++) {
+            if (g_ui32FakeRxHead - g_ui32FakeRxTail == SERIAL_RX_BUFFER_SIZE) {
+                g_ui32FakeOverruns++;
+            } else {
+                g_pui8FakeRx[g_ui32FakeRxHead++ % SERIAL_RX_BUFFER_SIZE] = pui8Buf[iIdx];
+            }
+        }
+        g_ui64FakeRxNs += iLen * g_ui64FakeByteNs;
+        ui64Bytes -= iLen;
+    }
+
+    // Transmit: one byte time per byte while the buffer has any
+    if (g_ui32FakeTxHead == g_ui32FakeTxTail) {
+        g_ui64FakeTxNs = ui64Now;
+        return;
+    }
+    ui64Bytes = (ui64Now - g_ui64FakeTxNs) / g_ui64FakeByteNs;
+    ui32Count = 0;
+    while ((ui32Count < ui64Bytes) && (g_ui32FakeTxTail + ui32Count != g_ui32FakeTxHead) &&
+           (ui32Count < sizeof(pui8Buf))) {
+        pui8Buf[ui32Count] = g_pui8FakeTx[(g_ui32FakeTxTail + ui32Count) % SERIAL_TX_BUFFER_SIZE];
+        ui32Count++;
+    }
+    if (ui32Count) {
+        // A host that has stopped reading holds the line up
+        iLen = write(g_iFakeFd, pui8Buf, ui32Count);
+        if (iLen > 0) {
+            g_ui32FakeTxTail += iLen;
+            g_ui64FakeTxNs += iLen * g_ui64FakeByteNs;
+        }
+    }
+    if (g_ui32FakeTxHead == g_ui32FakeTxTail) {
+        g_ui64FakeTxNs = ui64Now;
+    }
+}
+
+//*****************************************************************************
+// Serial
+//*****************************************************************************
+
+void HardwareSerial::begin(unsigned long baud) {
+    g_ui64FakeByteNs = 10 * 1000000000ull / baud;
+    g_ui64FakeRxNs = g_ui64FakeTxNs = FakeLineNs();
+}
+
+int HardwareSerial::available(void) {
+    FakeSerialService();
+    return g_ui32FakeRxHead - g_ui32FakeRxTail;
+}
+
+int HardwareSerial::availableForWrite(void) {
+    FakeSerialService();
+    return SERIAL_TX_BUFFER_SIZE - (g_ui32FakeTxHead - g_ui32FakeTxTail);
+}
+
+int HardwareSerial::read(void) {
+    FakeSerialService();
+    if (g_ui32FakeRxHead == g_ui32FakeRxTail) {
+        return -1;
+    }
+    return g_pui8FakeRx[g_ui32FakeRxTail++ % SERIAL_RX_BUFFER_SIZE];
+}
+
+size_t HardwareSerial::readBytes(uint8_t *buffer, size_t length) {
+    unsigned long ulStart = millis();
+    size_t count = 0;
+    int c;
+
+    while (count < length) {
+        c = read();
+        if (c >= 0) {
+            buffer[count++] = c;
+        } else if (millis() - ulStart >= _timeout) {
+            break;
+        }
+    }
+    return count;
+}
+
+void HardwareSerial::flush(void) {
+    while (g_ui32FakeTxHead != g_ui32FakeTxTail) {
+        FakeSerialService();
+    }
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    while (g_ui32FakeTxHead - g_ui32FakeTxTail == SERIAL_TX_BUFFER_SIZE) {
+        FakeSerialService();
+    }
+    g_pui8FakeTx[g_ui32FakeTxHead++ % SERIAL_TX_BUFFER_SIZE] = c;
+    return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+    size_t count;
+
+    for (count = 0; count < size; count++) {
+        write(buffer[count]);
+    }
+    return size;
+}
+
+size_t HardwareSerial::write(const char *str) {
+    return write(reinterpret_cast<const uint8_t *>(str), strlen(str));
+}
+
+size_t HardwareSerial::print(const __FlashStringHelper *str) {
+    return write(reinterpret_cast<const char *>(str));
+}
+
+size_t HardwareSerial::print(unsigned long n) {
+    char pcBuf[24];
+
+    snprintf(pcBuf, sizeof(pcBuf), "%lu", n);
+    return write(pcBuf);
+}
+
+size_t HardwareSerial::print(long n) {
+    char pcBuf[24];
+
+    snprintf(pcBuf, sizeof(pcBuf), "%ld", n);
+    return write(pcBuf);
+}
+
+//*****************************************************************************
+// Clock
+//*****************************************************************************
+
+unsigned long millis(void) {
+    return (FakeNowNs() - g_ui64FakeStartNs) / 1000000;
+}
+
+unsigned long micros(void) {
+    return (FakeNowNs() - g_ui64FakeStartNs) / 1000;
+}
+
+// The interrupts keep the line moving while the sketch waits
+void delay(unsigned long ms) {
+    unsigned long ulStart = millis();
+
+    while (millis() - ulStart < ms) {
+        FakeSerialService();
+    }
+}
+
+//*****************************************************************************
+// The host side
+//*****************************************************************************
+
+void FakeArduinoRun(int iFd, uint32_t ui32StallMs, uint32_t ui32EveryMs) {
+    struct timespec sStall = { 0, (long)ui32StallMs * 1000000 };
+    uint64_t ui64NextNs;
+
+    g_iFakeFd = iFd;
+    g_ui64FakeStartNs = g_ui64FakeHostNs = FakeNowNs();
+    setup();
+
+    ui64NextNs = FakeNowNs() + (uint64_t)ui32EveryMs * 1000000;
+    while (!g_bFakeStop) {
+        loop();
+        if (ui32StallMs && (FakeNowNs() >= ui64NextNs)) {
+            // The line moves on by the stall exactly, however long the host
+            // takes to wake up
+            FakeLineNs();
+            nanosleep(&sStall, 0);
+            g_ui64FakeLineNs += (uint64_t)ui32StallMs * 1000000;
+            g_ui64FakeHostNs = FakeNowNs();
+            ui64NextNs += (uint64_t)ui32EveryMs * 1000000;
+        }
+    }
+}
+
+void FakeArduinoStop(void) {
+    g_bFakeStop = 1;
+}
+
+uint32_t FakeArduinoOverruns(void) {
+    return g_ui32FakeOverruns;
+}
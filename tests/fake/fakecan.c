@@ -0,0 +1,484 @@
+/* fakecan.c
+ *
+ * CAN0 and CAN1 of the driverlib fake, see fake.h.
+ *
+ * Each controller has the 32 message objects of the TM4C123. Identifiers
+ * and masks are kept the way the controller holds them, in the 29 bit
+ * arbitration field with an 11 bit ID in bits 28-18, so a standard and an
+ * extended frame are compared against a filter the same way the hardware
+ * does it. Without MSG_OBJ_USE_EXT_FILTER the IDE bit is not part of the
+ * mask and an 11 bit filter also takes every 29 bit frame whose top 11 bits
+ * match, which then overwrites the object's ID with its own.
+ *
+ * A received frame is offered to the receive objects from object 1 up. An
+ * object that matches and holds no new data takes it. One that still holds
+ * new data passes it on down a FIFO chain, unless it is the end of the
+ * buffer (no MSG_OBJ_FIFO), which is overwritten and flags the lost frame.
+ *
+ * The interrupt line is up while the controller interrupt is enabled and
+ * either an object has its interrupt pending or there is a status
+ * interrupt. With CAN_INT_STATUS every good transmit or receive raises a
+ * status interrupt, as on the hardware, and reading the status register
+ * clears it.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "inc/hw_can.h"
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+#include "driverlib/can.h"
+#include "driverlib/interrupt.h"
+
+#include "fake.h"
+#include "fakepriv.h"
+
+#define FAKE_CAN_OBJECTS        32
+
+// Standard IDs sit in the top 11 bits of the arbitration field
+#define FAKE_CAN_STD_SHIFT      18
+#define FAKE_CAN_STD_MASK       0x1FFC0000
+#define FAKE_CAN_EXT_MASK       0x1FFFFFFF
+
+typedef struct {
+    bool bMsgVal;
+    bool bTx;                   // Direction, transmit
+    uint32_t ui32Arb;           // 29 bit arbitration field
+    bool bXtd;
+    uint32_t ui32Mask;          // 29 bit mask
+    bool bUMask;
+    bool bMXtd;                 // IDE takes part in filtering
+    bool bEOB;
+    bool bRxIE;
+    bool bTxIE;
+    bool bNewDat;
+    bool bMsgLst;
+    bool bTxRqst;
+    bool bIntPnd;
+    uint32_t ui32Len;
+    uint8_t pui8Data[8];
+} tFakeCANObj;
+
+typedef struct {
+    bool bInit;
+    uint32_t ui32IntFlags;      // CAN_INT_MASTER/ERROR/STATUS
+    uint32_t ui32Status;        // CAN_STATUS_* bits and LEC
+    bool bStatusInt;
+    uint32_t ui32TEC;
+    uint32_t ui32REC;
+    tFakeCANObj psObj[FAKE_CAN_OBJECTS + 1];    // 1 based
+} tFakeCAN;
+
+static tFakeCAN g_psFakeCAN[2];
+
+static uint32_t FakeCANIndex(uint32_t ui32Base) {
+    switch (ui32Base) {
+    case CAN0_BASE:     return 0;
+    case CAN1_BASE:     return 1;
+    default:
+        fprintf(stderr, "fake: no CAN controller at 0x%08x\n", (unsigned)ui32Base);
+        abort();
+    }
+}
+
+static tFakeCANObj *FakeCANObj(tFakeCAN *psCAN, uint32_t ui32ObjID) {
+    if ((ui32ObjID < 1) || (ui32ObjID > FAKE_CAN_OBJECTS)) {
+        fprintf(stderr, "fake: no CAN message object %u\n", (unsigned)ui32ObjID);
+        abort();
+    }
+    return &psCAN->psObj[ui32ObjID];
+}
+
+// Lowest object with its interrupt pending, 0 if none
+static uint32_t FakeCANIntPending(const tFakeCAN *psCAN) {
+    uint32_t ui32Obj;
+
+    for (ui32Obj = 1; ui32Obj <= FAKE_CAN_OBJECTS; ui32Obj++) {
+        if (psCAN->psObj[ui32Obj].bIntPnd) {
+            return ui32Obj;
+        }
+    }
+    return 0;
+}
+
+static bool FakeCANLine(const tFakeCAN *psCAN) {
+    return (psCAN->ui32IntFlags & CAN_INT_MASTER) &&
+           (psCAN->bStatusInt || FakeCANIntPending(psCAN));
+}
+
+static bool FakeCAN0Level(void) {
+    return FakeCANLine(&g_psFakeCAN[0]);
+}
+
+static bool FakeCAN1Level(void) {
+    return FakeCANLine(&g_psFakeCAN[1]);
+}
+
+static void FakeCANUpdate(uint32_t ui32Idx) {
+    if (FakeCANLine(&g_psFakeCAN[ui32Idx])) {
+        FakeIntPend(ui32Idx ? INT_CAN1 : INT_CAN0);
+    }
+}
+
+void FakeCANReset(void) {
+    memset(g_psFakeCAN, 0, sizeof(g_psFakeCAN));
+    g_psFakeCAN[0].bInit = g_psFakeCAN[1].bInit = true;
+
+    // The projects put CAN0IntHandler in the vector table, so the line is
+    // level sensitive whether or not CANIntRegister() is called
+    FakeIntLevelSet(INT_CAN0, FakeCAN0Level);
+    FakeIntLevelSet(INT_CAN1, FakeCAN1Level);
+}
+
+//*****************************************************************************
+// The bus side
+//*****************************************************************************
+
+// True if psObj's acceptance filter passes a frame
+static bool FakeCANAccepts(const tFakeCANObj *psObj, uint32_t ui32Arb, bool bXtd) {
+    uint32_t ui32Mask;
+
+    if (!psObj->bUMask) {
+        return (psObj->ui32Arb == ui32Arb) && (psObj->bXtd == bXtd);
+    }
+    if (psObj->bMXtd && (psObj->bXtd != bXtd)) {
+        return false;
+    }
+
+    // Only the 11 bits of a standard frame are compared
+    ui32Mask = psObj->ui32Mask & (bXtd ? FAKE_CAN_EXT_MASK : FAKE_CAN_STD_MASK);
+    return ((psObj->ui32Arb ^ ui32Arb) & ui32Mask) == 0;
+}
+
+// Raise a status interrupt if the controller has it enabled for this event
+static void FakeCANStatusEvent(tFakeCAN *psCAN, uint32_t ui32Flag) {
+    if (psCAN->ui32IntFlags & ui32Flag) {
+        psCAN->bStatusInt = true;
+    }
+}
+
+uint32_t FakeCANReceive(uint32_t ui32Base, const tFakeCANFrame *psFrame) {
+    uint32_t ui32Idx = FakeCANIndex(ui32Base);
+    tFakeCAN *psCAN = &g_psFakeCAN[ui32Idx];
+    tFakeCANObj *psObj;
+    uint32_t ui32Arb;
+    uint32_t ui32Obj;
+
+    if (psCAN->bInit) {
+        return 0;
+    }
+
+    ui32Arb = psFrame->bExtended ? (psFrame->ui32ID & FAKE_CAN_EXT_MASK) :
+                                   ((psFrame->ui32ID << FAKE_CAN_STD_SHIFT) & FAKE_CAN_STD_MASK);
+
+    for (ui32Obj = 1; ui32Obj <= FAKE_CAN_OBJECTS; ui32Obj++) {
+        psObj = &psCAN->psObj[ui32Obj];
+        if (!psObj->bMsgVal || psObj->bTx || !FakeCANAccepts(psObj, ui32Arb, psFrame->bExtended)) {
+            continue;
+        }
+        if (psObj->bNewDat) {
+            if (!psObj->bEOB) {
+                continue;
+            }
+            psObj->bMsgLst = true;
+        }
+
+        psObj->ui32Arb = ui32Arb;
+        psObj->bXtd = psFrame->bExtended;
+        psObj->ui32Len = (psFrame->ui32Len > 8) ? 8 : psFrame->ui32Len;
+        memcpy(psObj->pui8Data, psFrame->pui8Data, psObj->ui32Len);
+        psObj->bNewDat = true;
+        if (psObj->bRxIE) {
+            psObj->bIntPnd = true;
+        }
+
+        psCAN->ui32Status = (psCAN->ui32Status & ~CAN_STATUS_LEC_MSK) | CAN_STATUS_RXOK;
+        FakeCANStatusEvent(psCAN, CAN_INT_STATUS);
+        FakeCANUpdate(ui32Idx);
+        return ui32Obj;
+    }
+
+    return 0;
+}
+
+uint32_t FakeCANTransmit(uint32_t ui32Base, tFakeCANFrame *psFrame) {
+    uint32_t ui32Idx = FakeCANIndex(ui32Base);
+    tFakeCAN *psCAN = &g_psFakeCAN[ui32Idx];
+    tFakeCANObj *psObj;
+    uint32_t ui32Obj;
+
+    if (psCAN->bInit) {
+        return 0;
+    }
+
+    for (ui32Obj = 1; ui32Obj <= FAKE_CAN_OBJECTS; ui32Obj++) {
+        psObj = &psCAN->psObj[ui32Obj];
+        if (!psObj->bMsgVal || !psObj->bTx || !psObj->bTxRqst) {
+            continue;
+        }
+
+        psFrame->bExtended = psObj->bXtd;
+        psFrame->ui32ID = psObj->bXtd ? psObj->ui32Arb : (psObj->ui32Arb >> FAKE_CAN_STD_SHIFT);
+        psFrame->ui32Len = psObj->ui32Len;
+        memcpy(psFrame->pui8Data, psObj->pui8Data, sizeof(psFrame->pui8Data));
+
+        psObj->bTxRqst = false;
+        psObj->bNewDat = false;
+        if (psObj->bTxIE) {
+            psObj->bIntPnd = true;
+        }
+
+        psCAN->ui32Status = (psCAN->ui32Status & ~CAN_STATUS_LEC_MSK) | CAN_STATUS_TXOK;
+        FakeCANStatusEvent(psCAN, CAN_INT_STATUS);
+        FakeCANUpdate(ui32Idx);
+        return ui32Obj;
+    }
+
+    return 0;
+}
+
+void FakeCANError(uint32_t ui32Base, uint32_t ui32TEC, uint32_t ui32REC, uint32_t ui32LEC) {
+    uint32_t ui32Idx = FakeCANIndex(ui32Base);
+    tFakeCAN *psCAN = &g_psFakeCAN[ui32Idx];
+    uint32_t ui32State = 0;
+
+    psCAN->ui32TEC = ui32TEC;
+    psCAN->ui32REC = ui32REC;
+
+    if (ui32TEC > 255) {
+        ui32State = CAN_STATUS_BUS_OFF | CAN_STATUS_EPASS | CAN_STATUS_EWARN;
+        psCAN->bInit = true;
+    } else if ((ui32TEC > 127) || (ui32REC > 127)) {
+        ui32State = CAN_STATUS_EPASS | CAN_STATUS_EWARN;
+    } else if ((ui32TEC >= 96) || (ui32REC >= 96)) {
+        ui32State = CAN_STATUS_EWARN;
+    }
+
+    if (ui32State != (psCAN->ui32Status & (CAN_STATUS_BUS_OFF | CAN_STATUS_EPASS |
+                                           CAN_STATUS_EWARN))) {
+        FakeCANStatusEvent(psCAN, CAN_INT_ERROR);
+    }
+    if ((ui32LEC != CAN_STATUS_LEC_NONE) && (ui32LEC != CAN_STATUS_LEC_MASK)) {
+        FakeCANStatusEvent(psCAN, CAN_INT_STATUS);
+    }
+
+    psCAN->ui32Status = (psCAN->ui32Status & (CAN_STATUS_RXOK | CAN_STATUS_TXOK)) | ui32State |
+                        (ui32LEC & CAN_STATUS_LEC_MSK);
+    FakeCANUpdate(ui32Idx);
+}
+
+bool FakeCANInit(uint32_t ui32Base) {
+    return g_psFakeCAN[FakeCANIndex(ui32Base)].bInit;
+}
+
+//*****************************************************************************
+// driverlib
+//*****************************************************************************
+
+void CANInit(uint32_t ui32Base) {
+    tFakeCAN *psCAN = &g_psFakeCAN[FakeCANIndex(ui32Base)];
+
+    psCAN->bInit = true;
+    memset(psCAN->psObj, 0, sizeof(psCAN->psObj));
+}
+
+void CANEnable(uint32_t ui32Base) {
+    g_psFakeCAN[FakeCANIndex(ui32Base)].bInit = false;
+}
+
+void CANDisable(uint32_t ui32Base) {
+    g_psFakeCAN[FakeCANIndex(ui32Base)].bInit = true;
+}
+
+void CANBitTimingSet(uint32_t ui32Base, tCANBitClkParms *psClkParms) {
+    (void)FakeCANIndex(ui32Base);
+    (void)psClkParms;
+}
+
+void CANIntRegister(uint32_t ui32Base, void (*pfnHandler)(void)) {
+    uint32_t ui32Int = FakeIntNumber(ui32Base);
+
+    IntRegister(ui32Int, pfnHandler);
+    IntEnable(ui32Int);
+}
+
+void CANIntEnable(uint32_t ui32Base, uint32_t ui32IntFlags) {
+    uint32_t ui32Idx = FakeCANIndex(ui32Base);
+
+    g_psFakeCAN[ui32Idx].ui32IntFlags |= ui32IntFlags;
+    FakeCANUpdate(ui32Idx);
+}
+
+void CANIntDisable(uint32_t ui32Base, uint32_t ui32IntFlags) {
+    g_psFakeCAN[FakeCANIndex(ui32Base)].ui32IntFlags &= ~ui32IntFlags;
+}
+
+uint32_t CANIntStatus(uint32_t ui32Base, tCANIntStsReg eIntStsReg) {
+    tFakeCAN *psCAN = &g_psFakeCAN[FakeCANIndex(ui32Base)];
+    uint32_t ui32Obj;
+    uint32_t ui32Bits = 0;
+
+    if (eIntStsReg == CAN_INT_STS_CAUSE) {
+        return psCAN->bStatusInt ? CAN_INT_INTID_STATUS : FakeCANIntPending(psCAN);
+    }
+
+    for (ui32Obj = 1; ui32Obj <= FAKE_CAN_OBJECTS; ui32Obj++) {
+        if (psCAN->psObj[ui32Obj].bIntPnd) {
+            ui32Bits |= 1UL << (ui32Obj - 1);
+        }
+    }
+    return ui32Bits;
+}
+
+void CANIntClear(uint32_t ui32Base, uint32_t ui32IntClr) {
+    tFakeCAN *psCAN = &g_psFakeCAN[FakeCANIndex(ui32Base)];
+
+    // A status interrupt is cleared by reading the status register
+    if (ui32IntClr == CAN_INT_INTID_STATUS) {
+        (void)CANStatusGet(ui32Base, CAN_STS_CONTROL);
+    } else {
+        FakeCANObj(psCAN, ui32IntClr)->bIntPnd = false;
+    }
+}
+
+uint32_t CANStatusGet(uint32_t ui32Base, tCANStsReg eStatusReg) {
+    tFakeCAN *psCAN = &g_psFakeCAN[FakeCANIndex(ui32Base)];
+    uint32_t ui32Obj;
+    uint32_t ui32Bits = 0;
+    bool bSet;
+
+    if (eStatusReg == CAN_STS_CONTROL) {
+        // Reading clears the interrupt, driverlib then clears RXOK and TXOK
+        // and sets the LEC to 7, no event since the last read
+        ui32Bits = psCAN->ui32Status;
+        psCAN->bStatusInt = false;
+        psCAN->ui32Status = (psCAN->ui32Status & ~(CAN_STATUS_RXOK | CAN_STATUS_TXOK)) |
+                            CAN_STATUS_LEC_MASK;
+        return ui32Bits;
+    }
+
+    for (ui32Obj = 1; ui32Obj <= FAKE_CAN_OBJECTS; ui32Obj++) {
+        switch (eStatusReg) {
+        case CAN_STS_TXREQUEST:
+            bSet = psCAN->psObj[ui32Obj].bTxRqst;
+            break;
+        case CAN_STS_NEWDAT:
+            bSet = psCAN->psObj[ui32Obj].bNewDat;
+            break;
+        default:
+            bSet = psCAN->psObj[ui32Obj].bMsgVal;
+            break;
+        }
+        if (bSet) {
+            ui32Bits |= 1UL << (ui32Obj - 1);
+        }
+    }
+    return ui32Bits;
+}
+
+bool CANErrCntrGet(uint32_t ui32Base, uint32_t *pui32RxCount, uint32_t *pui32TxCount) {
+    tFakeCAN *psCAN = &g_psFakeCAN[FakeCANIndex(ui32Base)];
+
+    *pui32RxCount = psCAN->ui32REC;
+    *pui32TxCount = psCAN->ui32TEC;
+
+    // Receive error passive
+    return psCAN->ui32REC > 127;
+}
+
+void CANMessageSet(uint32_t ui32Base, uint32_t ui32ObjID, tCANMsgObject *psMsgObject,
+                   tMsgObjType eMsgType) {
+    uint32_t ui32Idx = FakeCANIndex(ui32Base);
+    tFakeCANObj *psObj = FakeCANObj(&g_psFakeCAN[ui32Idx], ui32ObjID);
+    uint32_t ui32Flags = psMsgObject->ui32Flags;
+
+    if ((eMsgType != MSG_OBJ_TYPE_TX) && (eMsgType != MSG_OBJ_TYPE_RX)) {
+        fprintf(stderr, "fake: remote frame objects are not modelled\n");
+        abort();
+    }
+
+    memset(psObj, 0, sizeof(*psObj));
+    psObj->bMsgVal = true;
+    psObj->bTx = (eMsgType == MSG_OBJ_TYPE_TX);
+    psObj->bXtd = (psMsgObject->ui32MsgID > 0x7FF) || (ui32Flags & MSG_OBJ_EXTENDED_ID);
+    if (psObj->bXtd) {
+        psObj->ui32Arb = psMsgObject->ui32MsgID & FAKE_CAN_EXT_MASK;
+        psObj->ui32Mask = psMsgObject->ui32MsgIDMask & FAKE_CAN_EXT_MASK;
+    } else {
+        psObj->ui32Arb = (psMsgObject->ui32MsgID << FAKE_CAN_STD_SHIFT) & FAKE_CAN_STD_MASK;
+        psObj->ui32Mask = (psMsgObject->ui32MsgIDMask << FAKE_CAN_STD_SHIFT) & FAKE_CAN_STD_MASK;
+    }
+    psObj->bUMask = (ui32Flags & MSG_OBJ_USE_ID_FILTER) != 0;
+    psObj->bMXtd = (ui32Flags & MSG_OBJ_USE_EXT_FILTER) == MSG_OBJ_USE_EXT_FILTER;
+    psObj->bEOB = psObj->bTx || !(ui32Flags & MSG_OBJ_FIFO);
+    psObj->bRxIE = (ui32Flags & MSG_OBJ_RX_INT_ENABLE) != 0;
+    psObj->bTxIE = (ui32Flags & MSG_OBJ_TX_INT_ENABLE) != 0;
+    psObj->ui32Len = (psMsgObject->ui32MsgLen > 8) ? 8 : psMsgObject->ui32MsgLen;
+
+    // Only a transmit object takes data, and asks to be sent straight away
+    if (psObj->bTx) {
+        memcpy(psObj->pui8Data, psMsgObject->pui8MsgData, psObj->ui32Len);
+        psObj->bNewDat = true;
+        psObj->bTxRqst = true;
+    }
+}
+
+void CANMessageGet(uint32_t ui32Base, uint32_t ui32ObjID, tCANMsgObject *psMsgObject,
+                   bool bClrPendingInt) {
+    uint32_t ui32Idx = FakeCANIndex(ui32Base);
+    tFakeCANObj *psObj = FakeCANObj(&g_psFakeCAN[ui32Idx], ui32ObjID);
+    uint32_t ui32Flags = 0;
+
+    if (psObj->bXtd) {
+        psMsgObject->ui32MsgID = psObj->ui32Arb;
+        psMsgObject->ui32MsgIDMask = psObj->ui32Mask;
+        ui32Flags |= MSG_OBJ_EXTENDED_ID;
+    } else {
+        psMsgObject->ui32MsgID = psObj->ui32Arb >> FAKE_CAN_STD_SHIFT;
+        psMsgObject->ui32MsgIDMask = psObj->ui32Mask >> FAKE_CAN_STD_SHIFT;
+    }
+    if (psObj->bUMask) {
+        ui32Flags |= psObj->bMXtd ? MSG_OBJ_USE_EXT_FILTER : MSG_OBJ_USE_ID_FILTER;
+    }
+    if (!psObj->bEOB) {
+        ui32Flags |= MSG_OBJ_FIFO;
+    }
+    if (psObj->bRxIE) {
+        ui32Flags |= MSG_OBJ_RX_INT_ENABLE;
+    }
+    if (psObj->bTxIE) {
+        ui32Flags |= MSG_OBJ_TX_INT_ENABLE;
+    }
+    psMsgObject->ui32MsgLen = psObj->ui32Len;
+
+    // Like driverlib, the data is only copied when there is new data, and
+    // reading it clears NEWDAT and a lost message flag
+    if (psObj->bNewDat) {
+        ui32Flags |= MSG_OBJ_NEW_DATA;
+        if (psMsgObject->pui8MsgData) {
+            memcpy(psMsgObject->pui8MsgData, psObj->pui8Data, psObj->ui32Len);
+        }
+        if (!psObj->bTx) {
+            psObj->bNewDat = false;
+        }
+    }
+    if (psObj->bMsgLst) {
+        ui32Flags |= MSG_OBJ_DATA_LOST;
+        psObj->bMsgLst = false;
+    }
+    if (bClrPendingInt) {
+        psObj->bIntPnd = false;
+    }
+
+    psMsgObject->ui32Flags = ui32Flags;
+}
+
+void CANMessageClear(uint32_t ui32Base, uint32_t ui32ObjID) {
+    tFakeCANObj *psObj = FakeCANObj(&g_psFakeCAN[FakeCANIndex(ui32Base)], ui32ObjID);
+
+    memset(psObj, 0, sizeof(*psObj));
+}
@@ -0,0 +1,51 @@
+/* fakepriv.h
+ *
+ * Shared between the fake*.c files only, see fake.h.
+ */
+
+#ifndef FAKEPRIV_H_
+#define FAKEPRIV_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Reset each peripheral model, called from FakeReset()
+extern void FakeADCReset(void);
+extern void FakeCANReset(void);
+extern void FakeUARTReset(void);
+extern void FakeUDMAReset(void);
+extern void FakeRTOSReset(void);
+extern void FakeUSBReset(void);
+
+// Bus events waiting for USB0DeviceIntHandler(), raised with FakeUSBRaise()
+#define FAKE_USB_EV_CONNECT     0x01
+#define FAKE_USB_EV_DISCONNECT  0x02
+#define FAKE_USB_EV_SUSPEND     0x04
+#define FAKE_USB_EV_RESUME      0x08
+#define FAKE_USB_EV_LEDS        0x10
+#define FAKE_USB_EV_TX_DONE     0x20    // The keyboard class's report
+
+extern void FakeUSBRaise(uint32_t ui32Event);
+extern uint64_t FakeUSBMsTicks(uint32_t ui32Ms);
+
+// The generic HID class in fakeusbhid.c, reset with the rest of the USB
+// fake and handed the bus events from USB0DeviceIntHandler()
+extern void FakeUSBHIDReset(void);
+extern void FakeUSBHIDInt(uint32_t ui32Events);
+
+// The CDC serial class in fakeusbcdc.c, the same way
+extern void FakeUSBCDCReset(void);
+extern void FakeUSBCDCInt(uint32_t ui32Events);
+
+// Interrupt number of a peripheral instance
+extern uint32_t FakeIntNumber(uint32_t ui32Base);
+
+// A peripheral raises a uDMA request on ui32Channel. The channel moves one
+// item, from ui32Value into memory or from memory into *pui32Value, if it
+// is enabled and has a transfer set up. Returns false if it did not, so the
+// item stays with the peripheral. *pbDone is set when this item finished
+// the transfer, which the peripheral signals on its own interrupt.
+extern bool FakeUDMAToMemory(uint32_t ui32Channel, uint32_t ui32Value, bool *pbDone);
+extern bool FakeUDMAFromMemory(uint32_t ui32Channel, uint32_t *pui32Value, bool *pbDone);
+
+#endif /* FAKEPRIV_H_ */
@@ -0,0 +1,217 @@
+/* fakertos.c
+ *
+ * The SYS/BIOS calls of the TI-RTOS projects, see fake.h.
+ *
+ * The test is the only task. Hwis are vectors in the fake interrupt
+ * controller. A task that pends on a semaphore nobody has posted lets
+ * simulated time run on, one scheduled event at a time, until an interrupt
+ * posts it or its timeout passes. The Clock tick is 1 ms, as in the
+ * projects' .cfg files.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <xdc/std.h>
+#include <xdc/runtime/Error.h>
+#include <xdc/runtime/System.h>
+#include <ti/sysbios/BIOS.h>
+#include <ti/sysbios/gates/GateMutex.h>
+#include <ti/sysbios/hal/Hwi.h>
+#include <ti/sysbios/knl/Semaphore.h>
+
+#include "inc/hw_ints.h"
+#include "driverlib/interrupt.h"
+
+#include "fake.h"
+#include "fakepriv.h"
+
+#define FAKE_SEMAPHORES         16
+#define FAKE_HWIS               8
+
+struct Semaphore_Object {
+    Semaphore_Mode mode;
+    uint32_t ui32Count;
+};
+
+struct Hwi_Object {
+    uint32_t ui32Int;
+    Hwi_FuncPtr pfnHwi;
+    UArg arg;
+};
+
+// A gate never blocks with one task, every handle can be the same object
+struct GateMutex_Object {
+    uint32_t ui32Depth;
+};
+
+static struct Semaphore_Object g_psFakeSem[FAKE_SEMAPHORES];
+static uint32_t g_ui32FakeSems;
+static struct Hwi_Object g_psFakeHwi[FAKE_HWIS];
+static uint32_t g_ui32FakeHwis;
+static struct GateMutex_Object g_sFakeGate;
+static uint32_t g_ui32FakeWakeups;
+
+void FakeRTOSReset(void) {
+    memset(g_psFakeSem, 0, sizeof(g_psFakeSem));
+    g_ui32FakeSems = 0;
+    memset(g_psFakeHwi, 0, sizeof(g_psFakeHwi));
+    g_ui32FakeHwis = 0;
+    g_sFakeGate.ui32Depth = 0;
+    g_ui32FakeWakeups = 0;
+}
+
+uint32_t FakeSemaphoreWakeups(void) {
+    return g_ui32FakeWakeups;
+}
+
+Void System_abort(const char *pcString) {
+    fprintf(stderr, "fake: System_abort: %s\n", pcString);
+    abort();
+}
+
+//*****************************************************************************
+// Hwi
+//*****************************************************************************
+
+// Vector of every Hwi, calls the function with its argument
+static void FakeHwiDispatch(void) {
+    uint32_t ui32Idx;
+
+    for (ui32Idx = 0; ui32Idx < g_ui32FakeHwis; ui32Idx++) {
+        if (g_psFakeHwi[ui32Idx].ui32Int == FakeIntActive()) {
+            g_psFakeHwi[ui32Idx].pfnHwi(g_psFakeHwi[ui32Idx].arg);
+            return;
+        }
+    }
+}
+
+Void Hwi_Params_init(Hwi_Params *psParams) {
+    psParams->arg = 0;
+}
+
+Hwi_Handle Hwi_create(Int iIntNum, Hwi_FuncPtr pfnHwi, const Hwi_Params *psParams,
+                      Error_Block *psEB) {
+    struct Hwi_Object *psHwi;
+
+    (void)psEB;
+    if (g_ui32FakeHwis == FAKE_HWIS) {
+        return NULL;
+    }
+
+    psHwi = &g_psFakeHwi[g_ui32FakeHwis++];
+    psHwi->ui32Int = (uint32_t)iIntNum;
+    psHwi->pfnHwi = pfnHwi;
+    psHwi->arg = psParams ? psParams->arg : 0;
+
+    IntRegister(psHwi->ui32Int, FakeHwiDispatch);
+    IntEnable(psHwi->ui32Int);
+    return psHwi;
+}
+
+UInt Hwi_disable(Void) {
+    return IntMasterDisable() ? 0 : 1;
+}
+
+Void Hwi_restore(UInt uiKey) {
+    if (uiKey) {
+        IntMasterEnable();
+    }
+}
+
+UInt Hwi_disableInterrupt(UInt uiIntNum) {
+    UInt uiKey = IntIsEnabled(uiIntNum);
+
+    IntDisable(uiIntNum);
+    return uiKey;
+}
+
+Void Hwi_restoreInterrupt(UInt uiIntNum, UInt uiKey) {
+    if (uiKey) {
+        IntEnable(uiIntNum);
+    }
+}
+
+//*****************************************************************************
+// GateMutex
+//*****************************************************************************
+
+GateMutex_Handle GateMutex_create(const void *pvParams, Error_Block *psEB) {
+    (void)pvParams;
+    (void)psEB;
+    return &g_sFakeGate;
+}
+
+IArg GateMutex_enter(GateMutex_Handle hGate) {
+    return (IArg)hGate->ui32Depth++;
+}
+
+Void GateMutex_leave(GateMutex_Handle hGate, IArg iKey) {
+    hGate->ui32Depth = (uint32_t)iKey;
+}
+
+//*****************************************************************************
+// Semaphore
+//*****************************************************************************
+
+Void Semaphore_Params_init(Semaphore_Params *psParams) {
+    psParams->mode = Semaphore_Mode_COUNTING;
+}
+
+Semaphore_Handle Semaphore_create(Int iCount, const Semaphore_Params *psParams,
+                                  Error_Block *psEB) {
+    struct Semaphore_Object *psSem;
+
+    (void)psEB;
+    if (g_ui32FakeSems == FAKE_SEMAPHORES) {
+        return NULL;
+    }
+
+    psSem = &g_psFakeSem[g_ui32FakeSems++];
+    psSem->mode = psParams ? psParams->mode : Semaphore_Mode_COUNTING;
+    psSem->ui32Count = (uint32_t)iCount;
+    return psSem;
+}
+
+Bool Semaphore_pend(Semaphore_Handle hSem, UInt uiTimeout) {
+    uint64_t ui64Deadline;
+
+    if (hSem->ui32Count == 0) {
+        if (FakeIntActive()) {
+            fprintf(stderr, "fake: Semaphore_pend blocks in an interrupt\n");
+            abort();
+        }
+        if (uiTimeout == BIOS_NO_WAIT) {
+            return false;
+        }
+
+        ui64Deadline = UINT64_MAX;
+        if (uiTimeout != BIOS_WAIT_FOREVER) {
+            ui64Deadline = g_ui64FakeTicks + (uint64_t)uiTimeout * (FakeClockHz() / 1000);
+        }
+
+        // The task sleeps, time runs on to whatever happens next
+        while (hSem->ui32Count == 0) {
+            if (FakeEventNext() == UINT64_MAX && ui64Deadline == UINT64_MAX) {
+                fprintf(stderr, "fake: Semaphore_pend waits forever\n");
+                abort();
+            }
+            if (!FakeEventRun(ui64Deadline)) {
+                return false;
+            }
+        }
+        g_ui32FakeWakeups++;
+    }
+
+    hSem->ui32Count--;
+    return true;
+}
+
+Void Semaphore_post(Semaphore_Handle hSem) {
+    if ((hSem->mode == Semaphore_Mode_COUNTING) || (hSem->ui32Count == 0)) {
+        hSem->ui32Count++;
+    }
+}
@@ -0,0 +1,269 @@
+/* fakeuart.c
+ *
+ * UART0 and UART1 of the driverlib fake, see fake.h.
+ *
+ * Bytes the firmware writes wait in the 16 byte transmit FIFO until the
+ * test takes them with FakeUARTTxGet(), so the test sets the line rate by
+ * how fast it takes them. Bytes fed with FakeUARTRxPut() land in the
+ * receive FIFO, or an overrun is flagged when it is full. With the FIFOs
+ * disabled both are one byte deep.
+ *
+ * The receive, receive timeout and transmit interrupts follow the FIFO
+ * levels: receive while the FIFO is at or above its trigger level, timeout
+ * while it holds anything, as if the line had gone idle straight away, and
+ * transmit while the transmit FIFO is at or below its level. Overrun is
+ * latched until cleared.
+ *
+ * With uDMA enabled, channel 8/9 (UART0) move bytes between memory and the
+ * FIFOs whenever a byte arrives or there is room, and a finished transfer
+ * raises the UART interrupt.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/uart.h"
+#include "driverlib/udma.h"
+
+#include "fake.h"
+#include "fakepriv.h"
+
+#define FAKE_UART_FIFO          16
+
+typedef struct {
+    bool bFIFO;
+    bool bEOT;                  // Transmit interrupt only once empty
+    uint32_t ui32TxLevel;       // Transmit interrupt at or below this many
+    uint32_t ui32RxLevel;       // Receive interrupt at or above this many
+    uint32_t ui32IM;
+    uint32_t ui32OE;            // Latched overrun
+    uint32_t ui32DMA;
+    uint8_t pui8Tx[FAKE_UART_FIFO];
+    uint32_t ui32TxHead;
+    uint32_t ui32TxCount;
+    uint8_t pui8Rx[FAKE_UART_FIFO];
+    uint32_t ui32RxHead;
+    uint32_t ui32RxCount;
+} tFakeUART;
+
+static tFakeUART g_psFakeUART[2];
+
+void FakeUARTReset(void) {
+    memset(g_psFakeUART, 0, sizeof(g_psFakeUART));
+
+    // Both FIFO levels reset to half full
+    g_psFakeUART[0].ui32TxLevel = g_psFakeUART[1].ui32TxLevel = 8;
+    g_psFakeUART[0].ui32RxLevel = g_psFakeUART[1].ui32RxLevel = 8;
+}
+
+static uint32_t FakeUARTIndex(uint32_t ui32Base) {
+    switch (ui32Base) {
+    case UART0_BASE:    return 0;
+    case UART1_BASE:    return 1;
+    default:
+        fprintf(stderr, "fake: no UART at 0x%08x\n", (unsigned)ui32Base);
+        abort();
+    }
+}
+
+static uint32_t FakeUARTDepth(const tFakeUART *psUART) {
+    return psUART->bFIFO ? FAKE_UART_FIFO : 1;
+}
+
+// Raw interrupt status as it stands
+static uint32_t FakeUARTRIS(const tFakeUART *psUART) {
+    uint32_t ui32RIS = psUART->ui32OE;
+
+    if (psUART->ui32RxCount && (psUART->ui32RxCount >= psUART->ui32RxLevel)) {
+        ui32RIS |= UART_INT_RX;
+    }
+    if (psUART->ui32RxCount) {
+        ui32RIS |= UART_INT_RT;
+    }
+    if (psUART->ui32TxCount <= (psUART->bEOT ? 0 : psUART->ui32TxLevel)) {
+        ui32RIS |= UART_INT_TX;
+    }
+    return ui32RIS;
+}
+
+static bool FakeUART0Level(void) {
+    return (g_psFakeUART[0].ui32IM & FakeUARTRIS(&g_psFakeUART[0])) != 0;
+}
+
+static bool FakeUART1Level(void) {
+    return (g_psFakeUART[1].ui32IM & FakeUARTRIS(&g_psFakeUART[1])) != 0;
+}
+
+// Let uDMA fill the transmit FIFO, then raise the line if anything is due
+static void FakeUARTUpdate(uint32_t ui32Idx) {
+    tFakeUART *psUART = &g_psFakeUART[ui32Idx];
+    uint32_t ui32Value;
+    bool bDone;
+    bool bPend = false;
+
+    if ((ui32Idx == 0) && (psUART->ui32DMA & UART_DMA_TX)) {
+        while ((psUART->ui32TxCount < FakeUARTDepth(psUART)) &&
+               FakeUDMAFromMemory(UDMA_CHANNEL_UART0TX, &ui32Value, &bDone)) {
+            psUART->pui8Tx[(psUART->ui32TxHead + psUART->ui32TxCount) % FAKE_UART_FIFO] =
+                (uint8_t)ui32Value;
+            psUART->ui32TxCount++;
+            bPend |= bDone;
+        }
+    }
+
+    if (bPend || (psUART->ui32IM & FakeUARTRIS(psUART))) {
+        FakeIntPend(ui32Idx ? INT_UART1 : INT_UART0);
+    }
+}
+
+uint32_t FakeUARTTxGet(uint32_t ui32Base, uint8_t *pui8Buf, uint32_t ui32Max) {
+    uint32_t ui32Idx = FakeUARTIndex(ui32Base);
+    tFakeUART *psUART = &g_psFakeUART[ui32Idx];
+    uint32_t ui32Count = 0;
+
+    FakeUARTUpdate(ui32Idx);
+
+    // Take one at a time so uDMA can refill the FIFO behind them
+    while (ui32Count < ui32Max && psUART->ui32TxCount) {
+        pui8Buf[ui32Count++] = psUART->pui8Tx[psUART->ui32TxHead];
+        psUART->ui32TxHead = (psUART->ui32TxHead + 1) % FAKE_UART_FIFO;
+        psUART->ui32TxCount--;
+        FakeUARTUpdate(ui32Idx);
+    }
+
+    return ui32Count;
+}
+
+uint32_t FakeUARTRxPut(uint32_t ui32Base, const uint8_t *pui8Buf, uint32_t ui32Len) {
+    uint32_t ui32Idx = FakeUARTIndex(ui32Base);
+    tFakeUART *psUART = &g_psFakeUART[ui32Idx];
+    uint32_t ui32Count;
+    bool bDone;
+
+    for (ui32Count = 0; ui32Count < ui32Len; ui32Count++) {
+        if ((ui32Idx == 0) && (psUART->ui32DMA & UART_DMA_RX) &&
+            FakeUDMAToMemory(UDMA_CHANNEL_UART0RX, pui8Buf[ui32Count], &bDone)) {
+            if (bDone) {
+                FakeIntPend(INT_UART0);
+            }
+            continue;
+        }
+        if (psUART->ui32RxCount == FakeUARTDepth(psUART)) {
+            psUART->ui32OE = UART_INT_OE;
+            FakeUARTUpdate(ui32Idx);
+            break;
+        }
+        psUART->pui8Rx[(psUART->ui32RxHead + psUART->ui32RxCount) % FAKE_UART_FIFO] =
+            pui8Buf[ui32Count];
+        psUART->ui32RxCount++;
+        FakeUARTUpdate(ui32Idx);
+    }
+
+    return ui32Count;
+}
+
+void UARTConfigSetExpClk(uint32_t ui32Base, uint32_t ui32UARTClk, uint32_t ui32Baud,
+                         uint32_t ui32Config) {
+    (void)FakeUARTIndex(ui32Base);
+    (void)ui32UARTClk;
+    (void)ui32Baud;
+    (void)ui32Config;
+}
+
+void UARTFIFOEnable(uint32_t ui32Base) {
+    g_psFakeUART[FakeUARTIndex(ui32Base)].bFIFO = true;
+}
+
+void UARTFIFOLevelSet(uint32_t ui32Base, uint32_t ui32TxLevel, uint32_t ui32RxLevel) {
+    tFakeUART *psUART = &g_psFakeUART[FakeUARTIndex(ui32Base)];
+
+    // 1/8, 2/8, 4/8, 6/8 or 7/8 of 16
+    static const uint32_t pui32Levels[] = { 2, 4, 8, 12, 14 };
+
+    psUART->ui32TxLevel = pui32Levels[ui32TxLevel & 7];
+    psUART->ui32RxLevel = pui32Levels[(ui32RxLevel >> 3) & 7];
+}
+
+bool UARTCharsAvail(uint32_t ui32Base) {
+    return g_psFakeUART[FakeUARTIndex(ui32Base)].ui32RxCount != 0;
+}
+
+bool UARTSpaceAvail(uint32_t ui32Base) {
+    tFakeUART *psUART = &g_psFakeUART[FakeUARTIndex(ui32Base)];
+
+    return psUART->ui32TxCount < FakeUARTDepth(psUART);
+}
+
+int32_t UARTCharGetNonBlocking(uint32_t ui32Base) {
+    uint32_t ui32Idx = FakeUARTIndex(ui32Base);
+    tFakeUART *psUART = &g_psFakeUART[ui32Idx];
+    uint8_t ui8Byte;
+
+    if (psUART->ui32RxCount == 0) {
+        return -1;
+    }
+    ui8Byte = psUART->pui8Rx[psUART->ui32RxHead];
+    psUART->ui32RxHead = (psUART->ui32RxHead + 1) % FAKE_UART_FIFO;
+    psUART->ui32RxCount--;
+    return ui8Byte;
+}
+
+bool UARTCharPutNonBlocking(uint32_t ui32Base, unsigned char ucData) {
+    tFakeUART *psUART = &g_psFakeUART[FakeUARTIndex(ui32Base)];
+
+    if (psUART->ui32TxCount == FakeUARTDepth(psUART)) {
+        return false;
+    }
+    psUART->pui8Tx[(psUART->ui32TxHead + psUART->ui32TxCount) % FAKE_UART_FIFO] = ucData;
+    psUART->ui32TxCount++;
+    return true;
+}
+
+void UARTIntRegister(uint32_t ui32Base, void (*pfnHandler)(void)) {
+    uint32_t ui32Idx = FakeUARTIndex(ui32Base);
+    uint32_t ui32Int = ui32Idx ? INT_UART1 : INT_UART0;
+
+    FakeIntLevelSet(ui32Int, ui32Idx ? FakeUART1Level : FakeUART0Level);
+    IntRegister(ui32Int, pfnHandler);
+    IntEnable(ui32Int);
+}
+
+void UARTIntEnable(uint32_t ui32Base, uint32_t ui32IntFlags) {
+    uint32_t ui32Idx = FakeUARTIndex(ui32Base);
+
+    g_psFakeUART[ui32Idx].ui32IM |= ui32IntFlags;
+    FakeUARTUpdate(ui32Idx);
+}
+
+void UARTIntDisable(uint32_t ui32Base, uint32_t ui32IntFlags) {
+    g_psFakeUART[FakeUARTIndex(ui32Base)].ui32IM &= ~ui32IntFlags;
+}
+
+uint32_t UARTIntStatus(uint32_t ui32Base, bool bMasked) {
+    tFakeUART *psUART = &g_psFakeUART[FakeUARTIndex(ui32Base)];
+
+    return FakeUARTRIS(psUART) & (bMasked ? psUART->ui32IM : 0xFFFFFFFF);
+}
+
+// Receive and transmit follow the FIFO levels, only the overrun latches
+void UARTIntClear(uint32_t ui32Base, uint32_t ui32IntFlags) {
+    g_psFakeUART[FakeUARTIndex(ui32Base)].ui32OE &= ~ui32IntFlags;
+}
+
+void UARTDMAEnable(uint32_t ui32Base, uint32_t ui32DMAFlags) {
+    uint32_t ui32Idx = FakeUARTIndex(ui32Base);
+
+    g_psFakeUART[ui32Idx].ui32DMA |= ui32DMAFlags;
+    FakeUARTUpdate(ui32Idx);
+}
+
+void UARTTxIntModeSet(uint32_t ui32Base, uint32_t ui32Mode) {
+    // End of transmission is the same as an empty FIFO here
+    g_psFakeUART[FakeUARTIndex(ui32Base)].bEOT = (ui32Mode == UART_TXINT_MODE_EOT);
+}
@@ -0,0 +1,210 @@
+/* fakeudma.c
+ *
+ * uDMA controller of the driverlib fake, see fake.h. Each channel has a
+ * primary and an alternate control structure. A transfer moves one item per
+ * request from the peripheral, in basic or ping-pong mode, and stops the
+ * structure when its count runs out. The control table the firmware hands
+ * to uDMAControlBaseSet() is not used.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "driverlib/udma.h"
+
+#include "fake.h"
+#include "fakepriv.h"
+
+#define FAKE_UDMA_CHANNELS      32
+
+typedef struct {
+    uint32_t ui32Control;
+    uint32_t ui32Mode;
+    uint8_t *pui8Src;
+    uint8_t *pui8Dst;
+    uint32_t ui32Size;          // Items in the transfer
+    uint32_t ui32Done;          // Items moved so far
+} tFakeUDMAStruct;
+
+static struct {
+    bool bEnabled;
+    uint32_t ui32Attr;
+    tFakeUDMAStruct psStruct[2];    // Primary, alternate
+} g_psFakeUDMA[FAKE_UDMA_CHANNELS];
+
+void FakeUDMAReset(void) {
+    memset(g_psFakeUDMA, 0, sizeof(g_psFakeUDMA));
+}
+
+// Channel and structure of a channel number ORed with UDMA_PRI/ALT_SELECT
+static tFakeUDMAStruct *FakeUDMAStruct(uint32_t ui32ChannelStructIndex) {
+    uint32_t ui32Channel = ui32ChannelStructIndex & 0x1F;
+
+    return &g_psFakeUDMA[ui32Channel].psStruct[(ui32ChannelStructIndex & UDMA_ALT_SELECT) ? 1 : 0];
+}
+
+// Bytes per item and address step for each increment field
+static uint32_t FakeUDMAItemSize(uint32_t ui32Control) {
+    return 1U << ((ui32Control >> 28) & 3);
+}
+
+static uint32_t FakeUDMAStep(uint32_t ui32Inc) {
+    return (ui32Inc == 3) ? 0 : (1U << ui32Inc);
+}
+
+// Structure the channel is working through, or 0 if it has nothing to do
+static tFakeUDMAStruct *FakeUDMAActive(uint32_t ui32Channel) {
+    tFakeUDMAStruct *psStruct;
+
+    if ((ui32Channel >= FAKE_UDMA_CHANNELS) || !g_psFakeUDMA[ui32Channel].bEnabled) {
+        return 0;
+    }
+    psStruct = &g_psFakeUDMA[ui32Channel].psStruct[
+        (g_psFakeUDMA[ui32Channel].ui32Attr & UDMA_ATTR_ALTSELECT) ? 1 : 0];
+    if (psStruct->ui32Mode == UDMA_MODE_STOP) {
+        return 0;
+    }
+    return psStruct;
+}
+
+// Account for one item moved, and stop or flip the structure at the end
+static void FakeUDMAAdvance(uint32_t ui32Channel, tFakeUDMAStruct *psStruct, bool *pbDone) {
+    uint32_t ui32Mode;
+
+    *pbDone = false;
+    if (++psStruct->ui32Done < psStruct->ui32Size) {
+        return;
+    }
+
+    *pbDone = true;
+    ui32Mode = psStruct->ui32Mode;
+    psStruct->ui32Mode = UDMA_MODE_STOP;
+    if (ui32Mode == UDMA_MODE_PINGPONG) {
+        g_psFakeUDMA[ui32Channel].ui32Attr ^= UDMA_ATTR_ALTSELECT;
+        if (FakeUDMAActive(ui32Channel)) {
+            return;
+        }
+    }
+    g_psFakeUDMA[ui32Channel].bEnabled = false;
+}
+
+bool FakeUDMAToMemory(uint32_t ui32Channel, uint32_t ui32Value, bool *pbDone) {
+    tFakeUDMAStruct *psStruct = FakeUDMAActive(ui32Channel);
+    uint32_t ui32ItemSize;
+    uint8_t *pui8Dst;
+
+    *pbDone = false;
+    if (!psStruct) {
+        return false;
+    }
+
+    ui32ItemSize = FakeUDMAItemSize(psStruct->ui32Control);
+    pui8Dst = psStruct->pui8Dst +
+              psStruct->ui32Done * FakeUDMAStep(psStruct->ui32Control >> 30);
+    if (ui32ItemSize == 1) {
+        *pui8Dst = (uint8_t)ui32Value;
+    } else if (ui32ItemSize == 2) {
+        *(uint16_t *)pui8Dst = (uint16_t)ui32Value;
+    } else {
+        *(uint32_t *)pui8Dst = ui32Value;
+    }
+
+    FakeUDMAAdvance(ui32Channel, psStruct, pbDone);
+    return true;
+}
+
+bool FakeUDMAFromMemory(uint32_t ui32Channel, uint32_t *pui32Value, bool *pbDone) {
+    tFakeUDMAStruct *psStruct = FakeUDMAActive(ui32Channel);
+    uint32_t ui32ItemSize;
+    const uint8_t *pui8Src;
+
+    *pbDone = false;
+    if (!psStruct) {
+        return false;
+    }
+
+    ui32ItemSize = FakeUDMAItemSize(psStruct->ui32Control);
+    pui8Src = psStruct->pui8Src +
+              psStruct->ui32Done * FakeUDMAStep((psStruct->ui32Control >> 26) & 3);
+    if (ui32ItemSize == 1) {
+        *pui32Value = *pui8Src;
+    } else if (ui32ItemSize == 2) {
+        *pui32Value = *(const uint16_t *)pui8Src;
+    } else {
+        *pui32Value = *(const uint32_t *)pui8Src;
+    }
+
+    FakeUDMAAdvance(ui32Channel, psStruct, pbDone);
+    return true;
+}
+
+void uDMAEnable(void) {
+}
+
+void uDMAControlBaseSet(void *pControlTable) {
+    (void)pControlTable;
+}
+
+void uDMAChannelAssign(uint32_t ui32Mapping) {
+    (void)ui32Mapping;
+}
+
+void uDMAChannelAttributeEnable(uint32_t ui32ChannelNum, uint32_t ui32Attr) {
+    g_psFakeUDMA[ui32ChannelNum & 0x1F].ui32Attr |= ui32Attr;
+}
+
+void uDMAChannelAttributeDisable(uint32_t ui32ChannelNum, uint32_t ui32Attr) {
+    g_psFakeUDMA[ui32ChannelNum & 0x1F].ui32Attr &= ~ui32Attr;
+}
+
+uint32_t uDMAChannelAttributeGet(uint32_t ui32ChannelNum) {
+    return g_psFakeUDMA[ui32ChannelNum & 0x1F].ui32Attr;
+}
+
+void uDMAChannelControlSet(uint32_t ui32ChannelStructIndex, uint32_t ui32Control) {
+    FakeUDMAStruct(ui32ChannelStructIndex)->ui32Control = ui32Control;
+}
+
+void uDMAChannelTransferSet(uint32_t ui32ChannelStructIndex, uint32_t ui32Mode,
+                            void *pvSrcAddr, void *pvDstAddr, uint32_t ui32TransferSize) {
+    tFakeUDMAStruct *psStruct = FakeUDMAStruct(ui32ChannelStructIndex);
+
+    if ((ui32TransferSize == 0) || (ui32TransferSize > 1024)) {
+        fprintf(stderr, "fake: uDMA transfer of %u items\n", (unsigned)ui32TransferSize);
+        abort();
+    }
+
+    psStruct->ui32Mode = ui32Mode;
+    psStruct->pui8Src = pvSrcAddr;
+    psStruct->pui8Dst = pvDstAddr;
+    psStruct->ui32Size = ui32TransferSize;
+    psStruct->ui32Done = 0;
+}
+
+uint32_t uDMAChannelSizeGet(uint32_t ui32ChannelStructIndex) {
+    tFakeUDMAStruct *psStruct = FakeUDMAStruct(ui32ChannelStructIndex);
+
+    if (psStruct->ui32Mode == UDMA_MODE_STOP) {
+        return 0;
+    }
+    return psStruct->ui32Size - psStruct->ui32Done;
+}
+
+uint32_t uDMAChannelModeGet(uint32_t ui32ChannelStructIndex) {
+    return FakeUDMAStruct(ui32ChannelStructIndex)->ui32Mode;
+}
+
+void uDMAChannelEnable(uint32_t ui32ChannelNum) {
+    g_psFakeUDMA[ui32ChannelNum & 0x1F].bEnabled = true;
+}
+
+void uDMAChannelDisable(uint32_t ui32ChannelNum) {
+    g_psFakeUDMA[ui32ChannelNum & 0x1F].bEnabled = false;
+}
+
+bool uDMAChannelIsEnabled(uint32_t ui32ChannelNum) {
+    return g_psFakeUDMA[ui32ChannelNum & 0x1F].bEnabled;
+}
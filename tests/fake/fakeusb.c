@@ -0,0 +1,366 @@
+/* fakeusb.c
+ *
+ * usblib's device stack and HID keyboard class, with the host on the other
+ * end of the bus, see fake.h.
+ *
+ * The keyboard class keeps one boot report. A key change while no report is
+ * in flight hands a copy of the report to the interrupt IN endpoint; a
+ * change while one is in flight only marks the report changed, and it goes
+ * out when the one in flight completes. The host polls the endpoint every
+ * FakeUSBPollSet() ms, 10 by default as the keyboard's bInterval asks, on
+ * the simulated clock. A poll that takes a report raises INT_USB0, and
+ * USB0DeviceIntHandler() sends any changed report before calling the
+ * application back with USB_EVENT_TX_COMPLETE, the order usblib uses.
+ *
+ * Bus events the test injects, connect, suspend, LED output reports and so
+ * on, are delivered from USB0DeviceIntHandler() as well, so every callback
+ * runs in interrupt context as on the hardware. A remote wakeup resumes the
+ * bus 20 ms after it was requested.
+ *
+ * A composite device gets connect before the classes in it and disconnect
+ * after them.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "inc/hw_ints.h"
+#include "driverlib/interrupt.h"
+#include "usblib/usblib.h"
+#include "usblib/usbhid.h"
+#include "usblib/device/usbdevice.h"
+#include "usblib/device/usbdcomp.h"
+#include "usblib/device/usbdhidkeyb.h"
+
+#include "fake.h"
+#include "fakepriv.h"
+
+// Reports the host keeps
+#define FAKE_USB_REPORTS        4096
+
+// Time from a remote wakeup request to the resume
+#define FAKE_USB_WAKEUP_MS      20
+
+typedef struct {
+    uint8_t ui8Modifiers;
+    uint8_t pui8Keys[KEYB_MAX_CHARS_PER_REPORT];
+} tFakeUSBReport;
+
+static tUSBDCompositeDevice *g_psFakeComposite;
+static tUSBDHIDKeyboardDevice *g_psFakeKeyboard;
+static bool g_bFakeUSBSuspended;
+static uint32_t g_ui32FakeUSBEvents;
+static uint8_t g_ui8FakeUSBLEDs;
+static uint32_t g_ui32FakeUSBPollMs;
+
+// Report on the IN endpoint waiting for the next poll
+static tFakeUSBReport g_sFakeUSBInFlight;
+static bool g_bFakeUSBPollDue;
+
+static tFakeUSBReport g_psFakeUSBLog[FAKE_USB_REPORTS];
+static uint32_t g_ui32FakeUSBLogged;
+static uint32_t g_pui32FakeUSBKeyCalls[2];
+
+void FakeUSBReset(void) {
+    g_psFakeComposite = 0;
+    g_psFakeKeyboard = 0;
+    g_bFakeUSBSuspended = false;
+    g_ui32FakeUSBEvents = 0;
+    g_ui8FakeUSBLEDs = 0;
+    g_ui32FakeUSBPollMs = 10;
+    g_bFakeUSBPollDue = false;
+    g_ui32FakeUSBLogged = 0;
+    g_pui32FakeUSBKeyCalls[0] = g_pui32FakeUSBKeyCalls[1] = 0;
+    FakeUSBHIDReset();
+    FakeUSBCDCReset();
+}
+
+void FakeUSBRaise(uint32_t ui32Event) {
+    g_ui32FakeUSBEvents |= ui32Event;
+    FakeIntPend(INT_USB0);
+}
+
+uint64_t FakeUSBMsTicks(uint32_t ui32Ms) {
+    return (uint64_t)ui32Ms * (FakeClockHz() / 1000);
+}
+
+//*****************************************************************************
+// The host
+//*****************************************************************************
+
+// The host polls the endpoint and takes the report
+static void FakeUSBPoll(void) {
+    g_bFakeUSBPollDue = false;
+    if (!g_psFakeKeyboard || !g_psFakeKeyboard->sPrivateData.bConfigured) {
+        return;
+    }
+
+    if (g_ui32FakeUSBLogged < FAKE_USB_REPORTS) {
+        g_psFakeUSBLog[g_ui32FakeUSBLogged] = g_sFakeUSBInFlight;
+    }
+    g_ui32FakeUSBLogged++;
+    FakeUSBRaise(FAKE_USB_EV_TX_DONE);
+}
+
+static void FakeUSBResume(void) {
+    g_bFakeUSBSuspended = false;
+    FakeUSBRaise(FAKE_USB_EV_RESUME);
+}
+
+// Load the endpoint with the report as it stands, the next poll takes it
+static void FakeUSBSend(tHIDKeyboardInstance *psInst) {
+    uint64_t ui64Period = FakeUSBMsTicks(g_ui32FakeUSBPollMs);
+
+    g_sFakeUSBInFlight.ui8Modifiers = psInst->ui8Modifiers;
+    memset(g_sFakeUSBInFlight.pui8Keys, 0, sizeof(g_sFakeUSBInFlight.pui8Keys));
+    memcpy(g_sFakeUSBInFlight.pui8Keys, psInst->pui8Keys, psInst->ui8KeyCount);
+    psInst->bTxBusy = true;
+    psInst->bChangeMade = false;
+
+    // Polls fall on whole intervals of the simulated clock
+    if (!g_bFakeUSBPollDue) {
+        g_bFakeUSBPollDue = true;
+        FakeEventAt((g_ui64FakeTicks / ui64Period + 1) * ui64Period, FakeUSBPoll);
+    }
+}
+
+void FakeUSBConnect(void) {
+    FakeUSBRaise(FAKE_USB_EV_CONNECT);
+}
+
+void FakeUSBDisconnect(void) {
+    FakeUSBRaise(FAKE_USB_EV_DISCONNECT);
+}
+
+void FakeUSBSuspend(void) {
+    g_bFakeUSBSuspended = true;
+    FakeUSBRaise(FAKE_USB_EV_SUSPEND);
+}
+
+void FakeUSBKeyboardLEDs(uint8_t ui8LEDs) {
+    g_ui8FakeUSBLEDs = ui8LEDs;
+    FakeUSBRaise(FAKE_USB_EV_LEDS);
+}
+
+void FakeUSBPollSet(uint32_t ui32Ms) {
+    g_ui32FakeUSBPollMs = ui32Ms;
+}
+
+uint32_t FakeUSBReports(void) {
+    return g_ui32FakeUSBLogged;
+}
+
+uint32_t FakeUSBKeyCalls(bool bInterrupt) {
+    return g_pui32FakeUSBKeyCalls[bInterrupt ? 1 : 0];
+}
+
+// Characters a US layout types for each usage code, unshifted and shifted
+static char FakeUSBKeyChar(uint8_t ui8Usage, bool bShift) {
+    static const char pcDigits[] = "1234567890";
+    static const char pcShiftDigits[] = "!@#$%^&*()";
+    static const char pcPunct[] = "-=[]\\?;'`,./";
+    static const char pcShiftPunct[] = "_+{}|?:\"~<>?";
+
+    if ((ui8Usage >= HID_KEYB_USAGE_A) && (ui8Usage <= HID_KEYB_USAGE_Z)) {
+        return (char)((bShift ? 'A' : 'a') + ui8Usage - HID_KEYB_USAGE_A);
+    }
+    if ((ui8Usage >= HID_KEYB_USAGE_1) && (ui8Usage <= HID_KEYB_USAGE_0)) {
+        return (bShift ? pcShiftDigits : pcDigits)[ui8Usage - HID_KEYB_USAGE_1];
+    }
+    if ((ui8Usage >= HID_KEYB_USAGE_MINUS) && (ui8Usage <= HID_KEYB_USAGE_FSLASH)) {
+        return (bShift ? pcShiftPunct : pcPunct)[ui8Usage - HID_KEYB_USAGE_MINUS];
+    }
+    if (ui8Usage == HID_KEYB_USAGE_ENTER) {
+        return '\n';
+    }
+    if (ui8Usage == HID_KEYB_USAGE_SPACE) {
+        return ' ';
+    }
+    return '?';
+}
+
+uint32_t FakeUSBTyped(char *pcBuf, uint32_t ui32Size) {
+    const tFakeUSBReport *psReport;
+    const tFakeUSBReport *psPrev;
+    static const tFakeUSBReport sNone;
+    uint32_t ui32Count = 0;
+    uint32_t ui32Idx;
+    uint32_t ui32Key;
+    uint32_t ui32Old;
+    uint32_t ui32Reports;
+
+    ui32Reports = (g_ui32FakeUSBLogged < FAKE_USB_REPORTS) ? g_ui32FakeUSBLogged :
+                                                            FAKE_USB_REPORTS;
+
+    // The host types each key the report presses that the last one did not
+    for (ui32Idx = 0; ui32Idx < ui32Reports; ui32Idx++) {
+        psReport = &g_psFakeUSBLog[ui32Idx];
+        psPrev = ui32Idx ? &g_psFakeUSBLog[ui32Idx - 1] : &sNone;
+        for (ui32Key = 0; ui32Key < KEYB_MAX_CHARS_PER_REPORT; ui32Key++) {
+            if (!psReport->pui8Keys[ui32Key]) {
+                continue;
+            }
+            for (ui32Old = 0; ui32Old < KEYB_MAX_CHARS_PER_REPORT; ui32Old++) {
+                if (psPrev->pui8Keys[ui32Old] == psReport->pui8Keys[ui32Key]) {
+                    break;
+                }
+            }
+            if ((ui32Old == KEYB_MAX_CHARS_PER_REPORT) && (ui32Count + 1 < ui32Size)) {
+                pcBuf[ui32Count++] = FakeUSBKeyChar(psReport->pui8Keys[ui32Key],
+                                                    (psReport->ui8Modifiers &
+                                                     HID_KEYB_LEFT_SHIFT) != 0);
+            }
+        }
+    }
+
+    if (ui32Size) {
+        pcBuf[ui32Count] = 0;
+    }
+    return ui32Count;
+}
+
+//*****************************************************************************
+// usblib
+//*****************************************************************************
+
+void USBStackModeSet(uint32_t ui32Index, tUSBMode iUSBMode, tUSBModeCallback pfnCallback) {
+    (void)ui32Index;
+    (void)iUSBMode;
+    (void)pfnCallback;
+}
+
+// The keyboard's share of the bus events
+static void FakeUSBKeyboardInt(uint32_t ui32Events) {
+    tUSBDHIDKeyboardDevice *psDev = g_psFakeKeyboard;
+    tHIDKeyboardInstance *psInst;
+
+    if (!psDev) {
+        return;
+    }
+    psInst = &psDev->sPrivateData;
+
+    if (ui32Events & FAKE_USB_EV_CONNECT) {
+        psInst->bConfigured = true;
+        psDev->pfnCallback(psDev->pvCBData, USB_EVENT_CONNECTED, 0, 0);
+    }
+    if ((ui32Events & FAKE_USB_EV_TX_DONE) && psInst->bConfigured) {
+        psInst->bTxBusy = false;
+        if (psInst->bChangeMade) {
+            FakeUSBSend(psInst);
+        }
+        psDev->pfnCallback(psDev->pvCBData, USB_EVENT_TX_COMPLETE, 0, 0);
+    }
+    if (ui32Events & FAKE_USB_EV_SUSPEND) {
+        psDev->pfnCallback(psDev->pvCBData, USB_EVENT_SUSPEND, 0, 0);
+    }
+    if (ui32Events & FAKE_USB_EV_RESUME) {
+        psDev->pfnCallback(psDev->pvCBData, USB_EVENT_RESUME, 0, 0);
+    }
+    if (ui32Events & FAKE_USB_EV_LEDS) {
+        psDev->pfnCallback(psDev->pvCBData, USBD_HID_KEYB_EVENT_SET_LEDS,
+                           g_ui8FakeUSBLEDs, 0);
+    }
+    if (ui32Events & FAKE_USB_EV_DISCONNECT) {
+        memset(psInst, 0, sizeof(*psInst));
+        psDev->pfnCallback(psDev->pvCBData, USB_EVENT_DISCONNECTED, 0, 0);
+    }
+}
+
+void USB0DeviceIntHandler(void) {
+    tUSBDCompositeDevice *psComp = g_psFakeComposite;
+    uint32_t ui32Events = g_ui32FakeUSBEvents;
+
+    g_ui32FakeUSBEvents = 0;
+    if (psComp && (ui32Events & FAKE_USB_EV_CONNECT)) {
+        psComp->pfnCallback(0, USB_EVENT_CONNECTED, 0, 0);
+    }
+    FakeUSBKeyboardInt(ui32Events);
+    FakeUSBHIDInt(ui32Events);
+    FakeUSBCDCInt(ui32Events);
+    if (psComp && (ui32Events & FAKE_USB_EV_DISCONNECT)) {
+        psComp->pfnCallback(0, USB_EVENT_DISCONNECTED, 0, 0);
+    }
+}
+
+void *USBDCompositeInit(uint32_t ui32Index, tUSBDCompositeDevice *psCompDevice,
+                        uint32_t ui32Size, uint8_t *pui8Data) {
+    (void)ui32Index;
+    (void)ui32Size;
+    (void)pui8Data;
+
+    g_psFakeComposite = psCompDevice;
+    return psCompDevice;
+}
+
+void *USBDHIDKeyboardInit(uint32_t ui32Index, tUSBDHIDKeyboardDevice *psHIDKbDevice) {
+    (void)ui32Index;
+
+    memset(&psHIDKbDevice->sPrivateData, 0, sizeof(psHIDKbDevice->sPrivateData));
+    g_psFakeKeyboard = psHIDKbDevice;
+    return psHIDKbDevice;
+}
+
+void *USBDHIDKeyboardCompositeInit(uint32_t ui32Index, tUSBDHIDKeyboardDevice *psHIDKbDevice,
+                                   tCompositeEntry *psCompEntry) {
+    psCompEntry->psDevInfo = 0;
+    psCompEntry->pvInstance = USBDHIDKeyboardInit(ui32Index, psHIDKbDevice);
+    return psCompEntry->pvInstance;
+}
+
+uint32_t USBDHIDKeyboardKeyStateChange(void *pvKeyboardDevice, uint8_t ui8Modifiers,
+                                       uint8_t ui8UsageCode, bool bPress) {
+    tHIDKeyboardInstance *psInst =
+        &((tUSBDHIDKeyboardDevice *)pvKeyboardDevice)->sPrivateData;
+    uint32_t ui32Idx;
+    uint32_t ui32Ret = KEYB_SUCCESS;
+
+    g_pui32FakeUSBKeyCalls[FakeIntActive() ? 1 : 0]++;
+
+    psInst->ui8Modifiers = ui8Modifiers;
+    for (ui32Idx = 0; ui32Idx < psInst->ui8KeyCount; ui32Idx++) {
+        if (psInst->pui8Keys[ui32Idx] == ui8UsageCode) {
+            break;
+        }
+    }
+
+    if (bPress) {
+        if (ui32Idx == psInst->ui8KeyCount) {
+            if (psInst->ui8KeyCount == KEYB_MAX_CHARS_PER_REPORT) {
+                ui32Ret = KEYB_ERR_TOO_MANY_KEYS;
+            } else {
+                psInst->pui8Keys[psInst->ui8KeyCount++] = ui8UsageCode;
+            }
+        }
+    } else if (ui32Idx == psInst->ui8KeyCount) {
+        ui32Ret = KEYB_ERR_NOT_FOUND;
+    } else {
+        psInst->ui8KeyCount--;
+        memmove(&psInst->pui8Keys[ui32Idx], &psInst->pui8Keys[ui32Idx + 1],
+                psInst->ui8KeyCount - ui32Idx);
+    }
+
+    if (!psInst->bConfigured) {
+        return KEYB_ERR_NOT_CONFIGURED;
+    }
+
+    // Send now if the endpoint is free, otherwise after the report in flight
+    if (psInst->bTxBusy) {
+        psInst->bChangeMade = true;
+    } else {
+        FakeUSBSend(psInst);
+    }
+    return ui32Ret;
+}
+
+bool USBDHIDKeyboardRemoteWakeupRequest(void *pvKeyboardDevice) {
+    (void)pvKeyboardDevice;
+
+    if (!g_bFakeUSBSuspended) {
+        return false;
+    }
+    FakeEventAt(g_ui64FakeTicks + FakeUSBMsTicks(FAKE_USB_WAKEUP_MS), FakeUSBResume);
+    return true;
+}
@@ -0,0 +1,329 @@
+/* fakeusbcdc.c
+ *
+ * usblib's CDC serial class and the device's bulk IN endpoint, with the
+ * host on the other end of the bus, see fake.h.
+ *
+ * The data goes out of EP1 IN, whose FIFO holds one 64 byte packet, or two
+ * once it is configured double buffered. USBEndpointStatus() shows
+ * TXPKTRDY while every half of it is loaded. The host reads the port with
+ * bulk IN tokens, 19 of them evenly spread over each 1 ms frame, the most
+ * full speed has room for, from the moment it opens the port. A token that
+ * finds a packet takes it and raises INT_USB0, from which the class calls
+ * the transmit callback with USB_EVENT_TX_COMPLETE; one that finds none is
+ * answered NAK and wasted.
+ *
+ * FakeUSBCDCHoldOff() keeps the USB interrupt waiting after a share of the
+ * packets, as a long handler of higher priority would, which is what the
+ * second half of a double buffered FIFO is there to ride out.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "inc/hw_ints.h"
+#include "driverlib/interrupt.h"
+#include "driverlib/usb.h"
+#include "usblib/usblib.h"
+#include "usblib/usbcdc.h"
+#include "usblib/device/usbdevice.h"
+#include "usblib/device/usbdcdc.h"
+
+#include "fake.h"
+#include "fakepriv.h"
+
+#define FAKE_USB_CDC_PACKET     64
+
+// Bulk IN tokens in a full speed frame
+#define FAKE_USB_CDC_TOKENS     19
+
+// Bytes the host buffers until the test reads them
+#define FAKE_USB_CDC_HOST       65536
+
+static tUSBDCDCDevice *g_psFakeCDC;
+static bool g_bFakeCDCOpen;
+static bool g_bFakeCDCLineReq;
+static bool g_bFakeCDCTokens;
+static uint64_t g_ui64FakeCDCToken;
+static uint64_t g_ui64FakeCDCFrame;
+
+// EP1 IN and its FIFO halves
+static uint8_t g_ppui8FakeEPHalf[2][FAKE_USB_CDC_PACKET];
+static uint32_t g_pui32FakeEPLen[2];
+static uint32_t g_ui32FakeEPHalves;
+static uint32_t g_ui32FakeEPLoaded;
+static uint32_t g_ui32FakeEPNext;
+static uint8_t g_pui8FakeEPStage[FAKE_USB_CDC_PACKET];
+static uint32_t g_ui32FakeEPStaged;
+static bool g_bFakeEPSingle;
+
+// Completion waiting for the interrupt, and the interrupt held off
+static bool g_bFakeCDCTxDone;
+static bool g_bFakeCDCLate;
+static uint64_t g_ui64FakeCDCHeld;
+static uint32_t g_ui32FakeCDCHoldPct;
+static uint32_t g_ui32FakeCDCHoldUs;
+static uint32_t g_ui32FakeCDCSeed;
+
+// What the host received
+static uint8_t g_pui8FakeCDCHost[FAKE_USB_CDC_HOST];
+static uint32_t g_ui32FakeCDCHead;
+static uint32_t g_ui32FakeCDCTail;
+static uint64_t g_ui64FakeCDCBytes;
+static uint64_t g_ui64FakeCDCNaks;
+
+void FakeUSBCDCReset(void) {
+    g_psFakeCDC = 0;
+    g_bFakeCDCOpen = false;
+    g_bFakeCDCLineReq = false;
+    g_bFakeCDCTokens = false;
+    g_ui32FakeEPHalves = 1;
+    g_ui32FakeEPLoaded = 0;
+    g_ui32FakeEPNext = 0;
+    g_ui32FakeEPStaged = 0;
+    g_bFakeEPSingle = false;
+    g_bFakeCDCTxDone = false;
+    g_bFakeCDCLate = false;
+    g_ui64FakeCDCHeld = 0;
+    g_ui32FakeCDCHoldPct = 0;
+    g_ui32FakeCDCHoldUs = 0;
+    g_ui32FakeCDCSeed = 1;
+    g_ui32FakeCDCHead = 0;
+    g_ui32FakeCDCTail = 0;
+    g_ui64FakeCDCBytes = 0;
+    g_ui64FakeCDCNaks = 0;
+}
+
+static void FakeUSBEPOnly(uint32_t ui32Endpoint) {
+    if (ui32Endpoint != USB_EP_1) {
+        fprintf(stderr, "fake: USB endpoint 0x%x is not modelled\n", (unsigned)ui32Endpoint);
+        abort();
+    }
+}
+
+//*****************************************************************************
+// The host
+//*****************************************************************************
+
+static void FakeUSBCDCLate(void) {
+    g_bFakeCDCLate = false;
+    FakeIntPend(INT_USB0);
+}
+
+// A packet has gone, raise the endpoint interrupt unless it is held off
+static void FakeUSBCDCComplete(void) {
+    g_bFakeCDCTxDone = true;
+    if (g_bFakeCDCLate) {
+        return;
+    }
+
+    g_ui32FakeCDCSeed = g_ui32FakeCDCSeed * 1103515245 + 12345;
+    if ((g_ui64FakeTicks >= g_ui64FakeCDCHeld) &&
+        ((g_ui32FakeCDCSeed >> 16) % 100 < g_ui32FakeCDCHoldPct)) {
+        g_ui64FakeCDCHeld = g_ui64FakeTicks +
+                            (uint64_t)g_ui32FakeCDCHoldUs * (FakeClockHz() / 1000000);
+    }
+    if (g_ui64FakeTicks < g_ui64FakeCDCHeld) {
+        g_bFakeCDCLate = true;
+        FakeEventAt(g_ui64FakeCDCHeld, FakeUSBCDCLate);
+        return;
+    }
+    FakeIntPend(INT_USB0);
+}
+
+static void FakeUSBCDCToken(void) {
+    uint32_t ui32Half;
+    uint32_t ui32Idx;
+
+    if (!g_psFakeCDC || !g_psFakeCDC->sPrivateData.bConfigured || !g_bFakeCDCOpen) {
+        g_bFakeCDCTokens = false;
+        return;
+    }
+
+    if (g_ui32FakeEPLoaded) {
+        ui32Half = g_ui32FakeEPNext;
+        for (ui32Idx = 0; ui32Idx < g_pui32FakeEPLen[ui32Half]; ui32Idx++) {
+            if (g_ui32FakeCDCHead - g_ui32FakeCDCTail < FAKE_USB_CDC_HOST) {
+                g_pui8FakeCDCHost[g_ui32FakeCDCHead++ % FAKE_USB_CDC_HOST] =
+                    g_ppui8FakeEPHalf[ui32Half][ui32Idx];
+            }
+        }
+        g_ui64FakeCDCBytes += g_pui32FakeEPLen[ui32Half];
+        g_ui32FakeEPNext = (ui32Half + 1) % g_ui32FakeEPHalves;
+        g_ui32FakeEPLoaded--;
+        FakeUSBCDCComplete();
+    } else {
+        g_ui64FakeCDCNaks++;
+    }
+
+    g_ui64FakeCDCToken++;
+    FakeEventAt(g_ui64FakeCDCFrame + g_ui64FakeCDCToken * FakeUSBMsTicks(1) / FAKE_USB_CDC_TOKENS,
+                FakeUSBCDCToken);
+}
+
+void FakeUSBCDCOpen(bool bOpen) {
+    g_bFakeCDCOpen = bOpen;
+    g_bFakeCDCLineReq = true;
+    FakeIntPend(INT_USB0);
+
+    if (bOpen && !g_bFakeCDCTokens) {
+        g_bFakeCDCTokens = true;
+        g_ui64FakeCDCToken = 0;
+        g_ui64FakeCDCFrame = g_ui64FakeTicks;
+        FakeEventAt(g_ui64FakeTicks, FakeUSBCDCToken);
+    }
+}
+
+uint32_t FakeUSBCDCRead(uint8_t *pui8Buf, uint32_t ui32Size) {
+    uint32_t ui32Count = 0;
+
+    while ((ui32Count < ui32Size) && (g_ui32FakeCDCTail != g_ui32FakeCDCHead)) {
+        pui8Buf[ui32Count++] = g_pui8FakeCDCHost[g_ui32FakeCDCTail++ % FAKE_USB_CDC_HOST];
+    }
+    return ui32Count;
+}
+
+uint64_t FakeUSBCDCBytes(void) {
+    return g_ui64FakeCDCBytes;
+}
+
+uint64_t FakeUSBCDCNaks(void) {
+    return g_ui64FakeCDCNaks;
+}
+
+void FakeUSBCDCHoldOff(uint32_t ui32Pct, uint32_t ui32Us) {
+    g_ui32FakeCDCHoldPct = ui32Pct;
+    g_ui32FakeCDCHoldUs = ui32Us;
+}
+
+void FakeUSBEndpointSingle(bool bSingle) {
+    g_bFakeEPSingle = bSingle;
+}
+
+//*****************************************************************************
+// driverlib
+//*****************************************************************************
+
+void USBIntRegister(uint32_t ui32Base, void (*pfnHandler)(void)) {
+    (void)ui32Base;
+
+    IntRegister(INT_USB0, pfnHandler);
+    IntEnable(INT_USB0);
+}
+
+void USBFIFOConfigSet(uint32_t ui32Base, uint32_t ui32Endpoint, uint32_t ui32FIFOAddress,
+                      uint32_t ui32FIFOSize, uint32_t ui32Flags) {
+    (void)ui32Base;
+    (void)ui32FIFOAddress;
+    (void)ui32Flags;
+    FakeUSBEPOnly(ui32Endpoint);
+
+    g_ui32FakeEPHalves = ((ui32FIFOSize & 0x10) && !g_bFakeEPSingle) ? 2 : 1;
+    g_ui32FakeEPLoaded = 0;
+    g_ui32FakeEPNext = 0;
+}
+
+void USBFIFOFlush(uint32_t ui32Base, uint32_t ui32Endpoint, uint32_t ui32Flags) {
+    (void)ui32Base;
+    (void)ui32Flags;
+    FakeUSBEPOnly(ui32Endpoint);
+
+    g_ui32FakeEPLoaded = 0;
+    g_ui32FakeEPNext = 0;
+}
+
+uint32_t USBEndpointStatus(uint32_t ui32Base, uint32_t ui32Endpoint) {
+    (void)ui32Base;
+    FakeUSBEPOnly(ui32Endpoint);
+
+    return (g_ui32FakeEPLoaded == g_ui32FakeEPHalves) ? USB_DEV_TX_TXPKTRDY : 0;
+}
+
+int32_t USBEndpointDataPut(uint32_t ui32Base, uint32_t ui32Endpoint, uint8_t *pui8Data,
+                           uint32_t ui32Size) {
+    (void)ui32Base;
+    FakeUSBEPOnly(ui32Endpoint);
+
+    if ((g_ui32FakeEPLoaded == g_ui32FakeEPHalves) ||
+        (g_ui32FakeEPStaged + ui32Size > FAKE_USB_CDC_PACKET)) {
+        return -1;
+    }
+    memcpy(&g_pui8FakeEPStage[g_ui32FakeEPStaged], pui8Data, ui32Size);
+    g_ui32FakeEPStaged += ui32Size;
+    return 0;
+}
+
+int32_t USBEndpointDataSend(uint32_t ui32Base, uint32_t ui32Endpoint, uint32_t ui32TransType) {
+    uint32_t ui32Half;
+
+    (void)ui32Base;
+    (void)ui32TransType;
+    FakeUSBEPOnly(ui32Endpoint);
+
+    if (g_ui32FakeEPLoaded == g_ui32FakeEPHalves) {
+        return -1;
+    }
+    ui32Half = (g_ui32FakeEPNext + g_ui32FakeEPLoaded) % g_ui32FakeEPHalves;
+    memcpy(g_ppui8FakeEPHalf[ui32Half], g_pui8FakeEPStage, g_ui32FakeEPStaged);
+    g_pui32FakeEPLen[ui32Half] = g_ui32FakeEPStaged;
+    g_ui32FakeEPStaged = 0;
+    g_ui32FakeEPLoaded++;
+    return 0;
+}
+
+//*****************************************************************************
+// usblib
+//*****************************************************************************
+
+void FakeUSBCDCInt(uint32_t ui32Events) {
+    tUSBDCDCDevice *psDev = g_psFakeCDC;
+
+    if (!psDev) {
+        return;
+    }
+
+    if (ui32Events & FAKE_USB_EV_CONNECT) {
+        // usbdcdc.c's FIFO for the data endpoint
+        g_ui32FakeEPHalves = 1;
+        g_ui32FakeEPLoaded = 0;
+        g_ui32FakeEPNext = 0;
+        psDev->sPrivateData.bConfigured = true;
+        psDev->pfnControlCallback(psDev->pvControlCBData, USB_EVENT_CONNECTED, 0, 0);
+    }
+    if (g_bFakeCDCLineReq) {
+        g_bFakeCDCLineReq = false;
+        psDev->pfnControlCallback(psDev->pvControlCBData, USBD_CDC_EVENT_SET_CONTROL_LINE_STATE,
+                                  g_bFakeCDCOpen ? (USB_CDC_DTE_PRESENT |
+                                                    USB_CDC_ACTIVATE_CARRIER) : 0,
+                                  0);
+    }
+    if (g_bFakeCDCTxDone && !g_bFakeCDCLate) {
+        g_bFakeCDCTxDone = false;
+        psDev->pfnTxCallback(psDev->pvTxCBData, USB_EVENT_TX_COMPLETE, 0, 0);
+    }
+    if (ui32Events & FAKE_USB_EV_DISCONNECT) {
+        psDev->sPrivateData.bConfigured = false;
+        g_bFakeCDCOpen = false;
+        g_bFakeCDCTxDone = false;
+        psDev->pfnControlCallback(psDev->pvControlCBData, USB_EVENT_DISCONNECTED, 0, 0);
+    }
+}
+
+void *USBDCDCInit(uint32_t ui32Index, tUSBDCDCDevice *psCDCDevice) {
+    (void)ui32Index;
+
+    psCDCDevice->sPrivateData.bConfigured = false;
+    g_psFakeCDC = psCDCDevice;
+    return psCDCDevice;
+}
+
+uint32_t USBDCDCPacketRead(void *pvCDCDevice, uint8_t *pi8Data, uint32_t ui32Length,
+                           bool bLast) {
+    (void)pvCDCDevice;
+    (void)pi8Data;
+    (void)ui32Length;
+    (void)bLast;
+    return 0;
+}
@@ -0,0 +1,407 @@
+/* fakeusbhid.c
+ *
+ * usblib's generic HID class and the HID mouse class, with the host on the
+ * other end of the bus, see fake.h.
+ *
+ * Each device's interrupt IN endpoint holds one report. The host polls it
+ * every bInterval ms of the endpoint descriptor it finds in the device's
+ * configuration sections, or every 16 ms, usblib's default, for a device
+ * that brings none. Polls fall on whole intervals of the simulated clock.
+ * A poll that takes a report puts it in the host's queue for that device,
+ * which holds 64 reports like hidraw's, and raises INT_USB0, from which
+ * the device's transmit callback gets USB_EVENT_TX_COMPLETE. Connect and
+ * disconnect reach the receive callback from the same interrupt, as do the
+ * control requests and the OUT reports the test makes as the host. An OUT
+ * report is offered with USB_EVENT_RX_AVAILABLE and the endpoint holds it,
+ * refusing the next, until the device takes it with USBDHIDPacketRead().
+ *
+ * The mouse class only follows connect and disconnect.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "inc/hw_ints.h"
+#include "usblib/usblib.h"
+#include "usblib/usbhid.h"
+#include "usblib/device/usbdevice.h"
+#include "usblib/device/usbdhid.h"
+#include "usblib/device/usbdhidmouse.h"
+
+#include "fake.h"
+#include "fakepriv.h"
+
+#define FAKE_USB_HID_DEVICES    4
+
+// Largest report, and the reports the host queues per device
+#define FAKE_USB_HID_REPORT     64
+#define FAKE_USB_HID_QUEUE      64
+
+// usblib's own HID configuration polls every 16 ms
+#define FAKE_USB_HID_POLL_MS    16
+
+// Control requests waiting for USB0DeviceIntHandler()
+#define FAKE_USB_HID_REQ_PROTOCOL 0x01
+#define FAKE_USB_HID_REQ_REPORT 0x02
+#define FAKE_USB_HID_REQ_SET_REPORT 0x04
+
+typedef struct {
+    tUSBDHIDDevice *psDevice;
+    uint32_t ui32PollMs;
+    bool bConfigured;
+
+    // The IN endpoint and the completion waiting for the interrupt
+    uint8_t pui8In[FAKE_USB_HID_REPORT];
+    uint32_t ui32InLen;
+    bool bLoaded;
+    uint64_t ui64PollAt;
+    bool bTxDone;
+
+    // The OUT endpoint, holding a report until the device reads it
+    uint8_t pui8Out[FAKE_USB_HID_REPORT];
+    uint32_t ui32OutLen;
+    bool bOutFull;
+    bool bOutOffered;
+
+    // Control requests, and the data of SET_REPORT or GET_REPORT
+    uint32_t ui32Requests;
+    uint8_t ui8Protocol;
+    uint8_t pui8Control[FAKE_USB_HID_REPORT];
+    uint32_t ui32ControlLen;
+
+    // Reports the host has received and not read yet
+    uint8_t ppui8Queue[FAKE_USB_HID_QUEUE][FAKE_USB_HID_REPORT];
+    uint32_t pui32QueueLen[FAKE_USB_HID_QUEUE];
+    uint32_t ui32Head;
+    uint32_t ui32Tail;
+    uint32_t ui32Reports;
+    uint32_t ui32Overflows;
+} tFakeUSBHID;
+
+static tFakeUSBHID g_psFakeUSBHID[FAKE_USB_HID_DEVICES];
+static uint32_t g_ui32FakeUSBHIDs;
+static tUSBDHIDMouseDevice *g_psFakeMouse;
+
+void FakeUSBHIDReset(void) {
+    memset(g_psFakeUSBHID, 0, sizeof(g_psFakeUSBHID));
+    g_ui32FakeUSBHIDs = 0;
+    g_psFakeMouse = 0;
+}
+
+static tFakeUSBHID *FakeUSBHIDFind(const void *pvDevice) {
+    uint32_t ui32Idx;
+
+    for (ui32Idx = 0; ui32Idx < g_ui32FakeUSBHIDs; ui32Idx++) {
+        if (g_psFakeUSBHID[ui32Idx].psDevice == pvDevice) {
+            return &g_psFakeUSBHID[ui32Idx];
+        }
+    }
+    fprintf(stderr, "fake: %p is not a HID device\n", pvDevice);
+    abort();
+}
+
+// bInterval of the first interrupt IN endpoint in the device's
+// configuration, as the host reads it at enumeration
+static uint32_t FakeUSBHIDInterval(const tUSBDHIDDevice *psDevice) {
+    const tConfigHeader *psConfig;
+    const uint8_t *pui8Desc;
+    uint32_t ui32Section;
+    uint32_t ui32Pos;
+
+    if (!psDevice->ppsConfigDescriptor) {
+        return FAKE_USB_HID_POLL_MS;
+    }
+
+    psConfig = psDevice->ppsConfigDescriptor[0];
+    for (ui32Section = 0; ui32Section < psConfig->ui8NumSections; ui32Section++) {
+        pui8Desc = psConfig->psSections[ui32Section]->pui8Data;
+        for (ui32Pos = 0; ui32Pos + 1 < psConfig->psSections[ui32Section]->ui16Size;
+             ui32Pos += pui8Desc[ui32Pos]) {
+            if (pui8Desc[ui32Pos] == 0) {
+                break;
+            }
+            if ((pui8Desc[ui32Pos + 1] == USB_DTYPE_ENDPOINT) &&
+                (pui8Desc[ui32Pos + 2] & USB_EP_DESC_IN) &&
+                (pui8Desc[ui32Pos + 3] == USB_EP_ATTR_INT)) {
+                return pui8Desc[ui32Pos + 6] ? pui8Desc[ui32Pos + 6] : 1;
+            }
+        }
+    }
+    return FAKE_USB_HID_POLL_MS;
+}
+
+//*****************************************************************************
+// The host
+//*****************************************************************************
+
+// Every endpoint whose poll is due hands over its report
+static void FakeUSBHIDPoll(void) {
+    tFakeUSBHID *psHID;
+    uint32_t ui32Idx;
+    bool bTaken = false;
+
+    for (ui32Idx = 0; ui32Idx < g_ui32FakeUSBHIDs; ui32Idx++) {
+        psHID = &g_psFakeUSBHID[ui32Idx];
+        if (!psHID->bLoaded || (psHID->ui64PollAt > g_ui64FakeTicks)) {
+            continue;
+        }
+
+        psHID->bLoaded = false;
+        psHID->ui32Reports++;
+        if (psHID->ui32Head - psHID->ui32Tail < FAKE_USB_HID_QUEUE) {
+            memcpy(psHID->ppui8Queue[psHID->ui32Head % FAKE_USB_HID_QUEUE], psHID->pui8In,
+                   psHID->ui32InLen);
+            psHID->pui32QueueLen[psHID->ui32Head % FAKE_USB_HID_QUEUE] = psHID->ui32InLen;
+            psHID->ui32Head++;
+        } else {
+            psHID->ui32Overflows++;
+        }
+        psHID->bTxDone = true;
+        bTaken = true;
+    }
+
+    if (bTaken) {
+        FakeIntPend(INT_USB0);
+    }
+}
+
+uint32_t FakeUSBHIDPollMs(const void *pvDevice) {
+    return FakeUSBHIDFind(pvDevice)->ui32PollMs;
+}
+
+void FakeUSBHIDPollSet(const void *pvDevice, uint32_t ui32Ms) {
+    FakeUSBHIDFind(pvDevice)->ui32PollMs = ui32Ms;
+}
+
+uint32_t FakeUSBHIDReports(const void *pvDevice) {
+    return FakeUSBHIDFind(pvDevice)->ui32Reports;
+}
+
+uint32_t FakeUSBHIDOverflows(const void *pvDevice) {
+    return FakeUSBHIDFind(pvDevice)->ui32Overflows;
+}
+
+uint32_t FakeUSBHIDRead(const void *pvDevice, uint8_t *pui8Buf, uint32_t ui32Size) {
+    tFakeUSBHID *psHID = FakeUSBHIDFind(pvDevice);
+    uint32_t ui32Len;
+
+    if (psHID->ui32Head == psHID->ui32Tail) {
+        return 0;
+    }
+    ui32Len = psHID->pui32QueueLen[psHID->ui32Tail % FAKE_USB_HID_QUEUE];
+    if (ui32Len > ui32Size) {
+        ui32Len = ui32Size;
+    }
+    memcpy(pui8Buf, psHID->ppui8Queue[psHID->ui32Tail % FAKE_USB_HID_QUEUE], ui32Len);
+    psHID->ui32Tail++;
+    return ui32Len;
+}
+
+bool FakeUSBHIDWrite(const void *pvDevice, const uint8_t *pui8Data, uint32_t ui32Len) {
+    tFakeUSBHID *psHID = FakeUSBHIDFind(pvDevice);
+
+    if (!psHID->bConfigured || !psHID->psDevice->bUseOutEndpoint || psHID->bOutFull ||
+        (ui32Len > FAKE_USB_HID_REPORT)) {
+        return false;
+    }
+    memcpy(psHID->pui8Out, pui8Data, ui32Len);
+    psHID->ui32OutLen = ui32Len;
+    psHID->bOutFull = true;
+    psHID->bOutOffered = false;
+    FakeIntPend(INT_USB0);
+    return true;
+}
+
+void FakeUSBHIDSetReport(const void *pvDevice, const uint8_t *pui8Data, uint32_t ui32Len) {
+    tFakeUSBHID *psHID = FakeUSBHIDFind(pvDevice);
+
+    if (ui32Len > FAKE_USB_HID_REPORT) {
+        ui32Len = FAKE_USB_HID_REPORT;
+    }
+    memcpy(psHID->pui8Control, pui8Data, ui32Len);
+    psHID->ui32ControlLen = ui32Len;
+    psHID->ui32Requests |= FAKE_USB_HID_REQ_SET_REPORT;
+    FakeIntPend(INT_USB0);
+}
+
+void FakeUSBHIDSetProtocol(const void *pvDevice, uint8_t ui8Protocol) {
+    tFakeUSBHID *psHID = FakeUSBHIDFind(pvDevice);
+
+    psHID->ui8Protocol = ui8Protocol;
+    psHID->ui32Requests |= FAKE_USB_HID_REQ_PROTOCOL;
+    FakeIntPend(INT_USB0);
+}
+
+uint32_t FakeUSBHIDGetReport(const void *pvDevice, uint8_t *pui8Buf, uint32_t ui32Size) {
+    tFakeUSBHID *psHID = FakeUSBHIDFind(pvDevice);
+
+    psHID->ui32ControlLen = 0;
+    psHID->ui32Requests |= FAKE_USB_HID_REQ_REPORT;
+    FakeIntPend(INT_USB0);
+
+    if (psHID->ui32ControlLen < ui32Size) {
+        ui32Size = psHID->ui32ControlLen;
+    }
+    memcpy(pui8Buf, psHID->pui8Control, ui32Size);
+    return ui32Size;
+}
+
+//*****************************************************************************
+// usblib
+//*****************************************************************************
+
+void FakeUSBHIDInt(uint32_t ui32Events) {
+    tUSBDHIDMouseDevice *psMouse = g_psFakeMouse;
+    tUSBDHIDDevice *psDev;
+    tFakeUSBHID *psHID;
+    uint8_t *pui8Report;
+    uint8_t *pui8Buffer;
+    uint32_t ui32Idx;
+
+    if (psMouse && (ui32Events & FAKE_USB_EV_CONNECT)) {
+        psMouse->sPrivateData.bConfigured = true;
+        psMouse->pfnCallback(psMouse->pvCBData, USB_EVENT_CONNECTED, 0, 0);
+    }
+    if (psMouse && (ui32Events & FAKE_USB_EV_DISCONNECT)) {
+        psMouse->sPrivateData.bConfigured = false;
+        psMouse->pfnCallback(psMouse->pvCBData, USB_EVENT_DISCONNECTED, 0, 0);
+    }
+
+    for (ui32Idx = 0; ui32Idx < g_ui32FakeUSBHIDs; ui32Idx++) {
+        psHID = &g_psFakeUSBHID[ui32Idx];
+        psDev = psHID->psDevice;
+
+        if (ui32Events & FAKE_USB_EV_CONNECT) {
+            psHID->bConfigured = true;
+            psDev->pfnRxCallback(psDev->pvRxCBData, USB_EVENT_CONNECTED, 0, 0);
+        }
+        if (psHID->bTxDone) {
+            psHID->bTxDone = false;
+            psDev->pfnTxCallback(psDev->pvTxCBData, USB_EVENT_TX_COMPLETE, psHID->ui32InLen, 0);
+        }
+        if (psHID->bOutFull && !psHID->bOutOffered) {
+            psHID->bOutOffered = true;
+            psDev->pfnRxCallback(psDev->pvRxCBData, USB_EVENT_RX_AVAILABLE, psHID->ui32OutLen,
+                                 0);
+        }
+        if (psHID->ui32Requests & FAKE_USB_HID_REQ_SET_REPORT) {
+            // The class asks for a buffer, fills it from the data stage and
+            // hands it back
+            pui8Buffer = (uint8_t *)(uintptr_t)psDev->pfnRxCallback(
+                psDev->pvRxCBData, USBD_HID_EVENT_GET_REPORT_BUFFER, psHID->ui32ControlLen, 0);
+            if (pui8Buffer) {
+                memcpy(pui8Buffer, psHID->pui8Control, psHID->ui32ControlLen);
+                psDev->pfnRxCallback(psDev->pvRxCBData, USBD_HID_EVENT_SET_REPORT,
+                                     psHID->ui32ControlLen, 0);
+            }
+        }
+        if (psHID->ui32Requests & FAKE_USB_HID_REQ_PROTOCOL) {
+            psDev->pfnRxCallback(psDev->pvRxCBData, USBD_HID_EVENT_SET_PROTOCOL,
+                                 psHID->ui8Protocol, 0);
+        }
+        if (psHID->ui32Requests & FAKE_USB_HID_REQ_REPORT) {
+            pui8Report = 0;
+            psHID->ui32ControlLen = psDev->pfnRxCallback(psDev->pvRxCBData,
+                                                         USBD_HID_EVENT_GET_REPORT, 0,
+                                                         &pui8Report);
+            if (psHID->ui32ControlLen > FAKE_USB_HID_REPORT) {
+                psHID->ui32ControlLen = FAKE_USB_HID_REPORT;
+            }
+            if (pui8Report) {
+                memcpy(psHID->pui8Control, pui8Report, psHID->ui32ControlLen);
+            }
+        }
+        psHID->ui32Requests = 0;
+        if (ui32Events & FAKE_USB_EV_DISCONNECT) {
+            psHID->bConfigured = false;
+            psHID->bLoaded = false;
+            psHID->bTxDone = false;
+            psHID->bOutFull = false;
+            psDev->pfnRxCallback(psDev->pvRxCBData, USB_EVENT_DISCONNECTED, 0, 0);
+        }
+    }
+}
+
+void *USBDHIDInit(uint32_t ui32Index, tUSBDHIDDevice *psHIDDevice) {
+    tFakeUSBHID *psHID;
+
+    (void)ui32Index;
+    if (g_ui32FakeUSBHIDs == FAKE_USB_HID_DEVICES) {
+        return 0;
+    }
+
+    psHID = &g_psFakeUSBHID[g_ui32FakeUSBHIDs++];
+    psHID->psDevice = psHIDDevice;
+    psHID->ui32PollMs = FakeUSBHIDInterval(psHIDDevice);
+    return psHIDDevice;
+}
+
+void *USBDHIDCompositeInit(uint32_t ui32Index, tUSBDHIDDevice *psHIDDevice,
+                           tCompositeEntry *psCompEntry) {
+    psCompEntry->psDevInfo = 0;
+    psCompEntry->pvInstance = USBDHIDInit(ui32Index, psHIDDevice);
+    return psCompEntry->pvInstance;
+}
+
+uint32_t USBDHIDReportWrite(void *pvHIDInstance, uint8_t *pi8Data, uint32_t ui32Length,
+                            bool bLast) {
+    tFakeUSBHID *psHID = FakeUSBHIDFind(pvHIDInstance);
+    uint64_t ui64Period = FakeUSBMsTicks(psHID->ui32PollMs);
+
+    (void)bLast;
+    if (!psHID->bConfigured || psHID->bLoaded || psHID->bTxDone ||
+        (ui32Length > FAKE_USB_HID_REPORT)) {
+        return 0;
+    }
+
+    memcpy(psHID->pui8In, pi8Data, ui32Length);
+    psHID->ui32InLen = ui32Length;
+    psHID->bLoaded = true;
+    psHID->ui64PollAt = (g_ui64FakeTicks / ui64Period + 1) * ui64Period;
+    FakeEventAt(psHID->ui64PollAt, FakeUSBHIDPoll);
+    return ui32Length;
+}
+
+uint32_t USBDHIDPacketRead(void *pvHIDInstance, uint8_t *pi8Data, uint32_t ui32Length,
+                           bool bLast) {
+    tFakeUSBHID *psHID = FakeUSBHIDFind(pvHIDInstance);
+
+    (void)bLast;
+    if (!psHID->bOutFull) {
+        return 0;
+    }
+    if (ui32Length > psHID->ui32OutLen) {
+        ui32Length = psHID->ui32OutLen;
+    }
+    memcpy(pi8Data, psHID->pui8Out, ui32Length);
+    psHID->bOutFull = false;
+    return ui32Length;
+}
+
+void *USBDHIDMouseInit(uint32_t ui32Index, tUSBDHIDMouseDevice *psMouseDevice) {
+    (void)ui32Index;
+
+    psMouseDevice->sPrivateData.bConfigured = false;
+    g_psFakeMouse = psMouseDevice;
+    return psMouseDevice;
+}
+
+void *USBDHIDMouseCompositeInit(uint32_t ui32Index, tUSBDHIDMouseDevice *psMouseDevice,
+                                tCompositeEntry *psCompEntry) {
+    psCompEntry->psDevInfo = 0;
+    psCompEntry->pvInstance = USBDHIDMouseInit(ui32Index, psMouseDevice);
+    return psCompEntry->pvInstance;
+}
+
+uint32_t USBDHIDMouseStateChange(void *pvMouseDevice, int8_t i8DeltaX, int8_t i8DeltaY,
+                                 uint8_t ui8Buttons) {
+    tUSBDHIDMouseDevice *psMouse = pvMouseDevice;
+
+    (void)i8DeltaX;
+    (void)i8DeltaY;
+    (void)ui8Buttons;
+    return psMouse->sPrivateData.bConfigured ? MOUSE_SUCCESS : MOUSE_ERR_NOT_CONFIGURED;
+}
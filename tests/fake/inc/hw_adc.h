@@ -0,0 +1,11 @@
+/* hw_adc.h
+ *
+ * Host fake of TivaWare's inc/hw_adc.h, see tests/fake/fake.h.
+ */
+
+#ifndef HW_ADC_H_
+#define HW_ADC_H_
+
+#define ADC_O_SSFIFO0           0x00000048
+
+#endif /* HW_ADC_H_ */
@@ -0,0 +1,22 @@
+/* hw_can.h
+ *
+ * Host fake of TivaWare's inc/hw_can.h, see tests/fake/fake.h.
+ */
+
+#ifndef HW_CAN_H_
+#define HW_CAN_H_
+
+#define CAN_O_CTL               0x00000000
+#define CAN_O_STS               0x00000004
+#define CAN_O_ERR               0x00000008
+#define CAN_O_INT               0x00000010
+
+#define CAN_CTL_INIT            0x00000001
+#define CAN_STS_BOFF            0x00000080
+#define CAN_STS_EWARN           0x00000040
+#define CAN_STS_EPASS           0x00000020
+
+// CAN_INT value for a status interrupt
+#define CAN_INT_INTID_STATUS    0x00008000
+
+#endif /* HW_CAN_H_ */
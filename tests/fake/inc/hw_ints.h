@@ -0,0 +1,31 @@
+/* hw_ints.h
+ *
+ * Host fake of TivaWare's inc/hw_ints.h, see tests/fake/fake.h. Vector
+ * numbers are the TM4C123 ones.
+ */
+
+#ifndef HW_INTS_H_
+#define HW_INTS_H_
+
+#define FAULT_SYSTICK           15
+#define INT_GPIOA               16
+#define INT_GPIOE               20
+#define INT_UART0               21
+#define INT_UART1               22
+#define INT_SSI0                23
+#define INT_ADC0SS0             30
+#define INT_ADC0SS1             31
+#define INT_ADC0SS2             32
+#define INT_ADC0SS3             33
+#define INT_TIMER0A             35
+#define INT_TIMER1A             37
+#define INT_CAN0                55
+#define INT_CAN1                56
+#define INT_USB0                60
+#define INT_UDMA                62
+#define INT_UDMAERR             63
+#define INT_WTIMER5A            120
+
+#define NUM_INTERRUPTS          155
+
+#endif /* HW_INTS_H_ */
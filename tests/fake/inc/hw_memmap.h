@@ -0,0 +1,32 @@
+/* hw_memmap.h
+ *
+ * Host fake of TivaWare's inc/hw_memmap.h, see tests/fake/fake.h. The
+ * addresses are the TM4C123GH6PM ones, as unsigned long so the firmware
+ * can still cast them to pointers on a 64 bit host.
+ */
+
+#ifndef HW_MEMMAP_H_
+#define HW_MEMMAP_H_
+
+#define GPIO_PORTA_BASE         0x40004000UL
+#define GPIO_PORTB_BASE         0x40005000UL
+#define GPIO_PORTC_BASE         0x40006000UL
+#define GPIO_PORTD_BASE         0x40007000UL
+#define SSI0_BASE               0x40008000UL
+#define UART0_BASE              0x4000C000UL
+#define UART1_BASE              0x4000D000UL
+#define GPIO_PORTE_BASE         0x40024000UL
+#define GPIO_PORTF_BASE         0x40025000UL
+#define PWM0_BASE               0x40028000UL
+#define TIMER0_BASE             0x40030000UL
+#define TIMER1_BASE             0x40031000UL
+#define ADC0_BASE               0x40038000UL
+#define ADC1_BASE               0x40039000UL
+#define CAN0_BASE               0x40040000UL
+#define CAN1_BASE               0x40041000UL
+#define WTIMER5_BASE            0x4004F000UL
+#define USB0_BASE               0x40050000UL
+#define SYSCTL_BASE             0x400FE000UL
+#define UDMA_BASE               0x400FF000UL
+
+#endif /* HW_MEMMAP_H_ */
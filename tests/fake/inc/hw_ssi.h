@@ -0,0 +1,11 @@
+/* hw_ssi.h
+ *
+ * Host fake of TivaWare's inc/hw_ssi.h, see tests/fake/fake.h.
+ */
+
+#ifndef HW_SSI_H_
+#define HW_SSI_H_
+
+#define SSI_O_DR                0x00000008
+
+#endif /* HW_SSI_H_ */
@@ -0,0 +1,13 @@
+/* hw_timer.h
+ *
+ * Host fake of TivaWare's inc/hw_timer.h, see tests/fake/fake.h. Reading
+ * TIMER_O_TAV of WTIMER5 returns the simulated clock.
+ */
+
+#ifndef HW_TIMER_H_
+#define HW_TIMER_H_
+
+#define TIMER_O_TAILR           0x00000028
+#define TIMER_O_TAV             0x00000050
+
+#endif /* HW_TIMER_H_ */
@@ -0,0 +1,17 @@
+/* hw_types.h
+ *
+ * Host fake of TivaWare's inc/hw_types.h, see tests/fake/fake.h. HWREG()
+ * reads and writes the fake register file instead of a peripheral address.
+ */
+
+#ifndef HW_TYPES_H_
+#define HW_TYPES_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+extern volatile uint32_t *FakeReg(uint32_t ui32Addr);
+
+#define HWREG(x)                (*FakeReg(x))
+
+#endif /* HW_TYPES_H_ */
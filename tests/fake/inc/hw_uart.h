@@ -0,0 +1,11 @@
+/* hw_uart.h
+ *
+ * Host fake of TivaWare's inc/hw_uart.h, see tests/fake/fake.h.
+ */
+
+#ifndef HW_UART_H_
+#define HW_UART_H_
+
+#define UART_O_DR               0x00000000
+
+#endif /* HW_UART_H_ */
@@ -0,0 +1,14 @@
+/* BIOS.h
+ *
+ * Host fake of SYS/BIOS' ti/sysbios/BIOS.h, see tests/fake/fake.h.
+ */
+
+#ifndef TI_SYSBIOS_BIOS_H_
+#define TI_SYSBIOS_BIOS_H_
+
+#include <xdc/std.h>
+
+#define BIOS_WAIT_FOREVER       (~(UInt)0)
+#define BIOS_NO_WAIT            0
+
+#endif /* TI_SYSBIOS_BIOS_H_ */
@@ -0,0 +1,19 @@
+/* GateMutex.h
+ *
+ * Host fake of SYS/BIOS' ti/sysbios/gates/GateMutex.h, see
+ * tests/fake/fake.h. There is only one task, so the gate never blocks.
+ */
+
+#ifndef TI_SYSBIOS_GATES_GATEMUTEX_H_
+#define TI_SYSBIOS_GATES_GATEMUTEX_H_
+
+#include <xdc/std.h>
+#include <xdc/runtime/Error.h>
+
+typedef struct GateMutex_Object *GateMutex_Handle;
+
+extern GateMutex_Handle GateMutex_create(const void *pvParams, Error_Block *psEB);
+extern IArg GateMutex_enter(GateMutex_Handle hGate);
+extern Void GateMutex_leave(GateMutex_Handle hGate, IArg iKey);
+
+#endif /* TI_SYSBIOS_GATES_GATEMUTEX_H_ */
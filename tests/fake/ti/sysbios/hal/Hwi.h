@@ -0,0 +1,28 @@
+/* Hwi.h
+ *
+ * Host fake of SYS/BIOS' ti/sysbios/hal/Hwi.h, see tests/fake/fake.h.
+ * Hwis are installed in the fake interrupt controller.
+ */
+
+#ifndef TI_SYSBIOS_HAL_HWI_H_
+#define TI_SYSBIOS_HAL_HWI_H_
+
+#include <xdc/std.h>
+#include <xdc/runtime/Error.h>
+
+typedef Void (*Hwi_FuncPtr)(UArg arg);
+typedef struct Hwi_Object *Hwi_Handle;
+
+typedef struct {
+    UArg arg;
+} Hwi_Params;
+
+extern Void Hwi_Params_init(Hwi_Params *psParams);
+extern Hwi_Handle Hwi_create(Int iIntNum, Hwi_FuncPtr pfnHwi, const Hwi_Params *psParams,
+                             Error_Block *psEB);
+extern UInt Hwi_disable(Void);
+extern Void Hwi_restore(UInt uiKey);
+extern UInt Hwi_disableInterrupt(UInt uiIntNum);
+extern Void Hwi_restoreInterrupt(UInt uiIntNum, UInt uiKey);
+
+#endif /* TI_SYSBIOS_HAL_HWI_H_ */
@@ -0,0 +1,33 @@
+/* Semaphore.h
+ *
+ * Host fake of SYS/BIOS' ti/sysbios/knl/Semaphore.h, see tests/fake/fake.h.
+ *
+ * There is one task, the test. When it pends on a semaphore that is not
+ * available, simulated time runs on event by event (FakeEventRun()) until
+ * an interrupt posts it or the timeout, in 1 ms clock ticks, has passed.
+ */
+
+#ifndef TI_SYSBIOS_KNL_SEMAPHORE_H_
+#define TI_SYSBIOS_KNL_SEMAPHORE_H_
+
+#include <xdc/std.h>
+#include <xdc/runtime/Error.h>
+
+typedef enum {
+    Semaphore_Mode_COUNTING,
+    Semaphore_Mode_BINARY
+} Semaphore_Mode;
+
+typedef struct {
+    Semaphore_Mode mode;
+} Semaphore_Params;
+
+typedef struct Semaphore_Object *Semaphore_Handle;
+
+extern Void Semaphore_Params_init(Semaphore_Params *psParams);
+extern Semaphore_Handle Semaphore_create(Int iCount, const Semaphore_Params *psParams,
+                                         Error_Block *psEB);
+extern Bool Semaphore_pend(Semaphore_Handle hSem, UInt uiTimeout);
+extern Void Semaphore_post(Semaphore_Handle hSem);
+
+#endif /* TI_SYSBIOS_KNL_SEMAPHORE_H_ */
@@ -0,0 +1,50 @@
+/* usbdcdc.h
+ *
+ * Host fake of TivaWare's usblib/device/usbdcdc.h, see tests/fake/fake.h.
+ * The CDC class puts its bulk IN endpoint on EP1 with a single buffered
+ * 64 byte FIFO when the host configures it, as usbdcdc.c does.
+ */
+
+#ifndef USBLIB_DEVICE_USBDCDC_H_
+#define USBLIB_DEVICE_USBDCDC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "usblib/usblib.h"
+#include "usblib/usbcdc.h"
+
+#define USBD_CDC_EVENT_BASE     0x8000
+#define USBD_CDC_EVENT_SEND_BREAK (USBD_CDC_EVENT_BASE + 0)
+#define USBD_CDC_EVENT_CLEAR_BREAK (USBD_CDC_EVENT_BASE + 1)
+#define USBD_CDC_EVENT_SET_CONTROL_LINE_STATE (USBD_CDC_EVENT_BASE + 2)
+#define USBD_CDC_EVENT_SET_LINE_CODING (USBD_CDC_EVENT_BASE + 3)
+#define USBD_CDC_EVENT_GET_LINE_CODING (USBD_CDC_EVENT_BASE + 4)
+
+typedef struct {
+    bool bConfigured;
+} tCDCSerInstance;
+
+typedef struct {
+    uint16_t ui16VID;
+    uint16_t ui16PID;
+    uint16_t ui16MaxPowermA;
+    uint8_t ui8PwrAttributes;
+    tUSBCallback pfnControlCallback;
+    void *pvControlCBData;
+    tUSBCallback pfnRxCallback;
+    void *pvRxCBData;
+    tUSBCallback pfnTxCallback;
+    void *pvTxCBData;
+    const uint8_t * const *ppui8StringDescriptors;
+    uint32_t ui32NumStringDescriptors;
+    tCDCSerInstance sPrivateData;
+} tUSBDCDCDevice;
+
+extern void *USBDCDCInit(uint32_t ui32Index, tUSBDCDCDevice *psCDCDevice);
+
+// Nothing is ever written to the OUT endpoint, so this returns 0
+extern uint32_t USBDCDCPacketRead(void *pvCDCDevice, uint8_t *pi8Data, uint32_t ui32Length,
+                                  bool bLast);
+
+#endif /* USBLIB_DEVICE_USBDCDC_H_ */
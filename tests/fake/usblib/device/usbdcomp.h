@@ -0,0 +1,42 @@
+/* usbdcomp.h
+ *
+ * Host fake of TivaWare's usblib/device/usbdcomp.h, see tests/fake/fake.h.
+ * The composite device only passes connect and disconnect to its own
+ * callback. The classes in it are the fake's ordinary ones, each handed the
+ * bus events by USB0DeviceIntHandler() as if it stood alone.
+ */
+
+#ifndef USBLIB_DEVICE_USBDCOMP_H_
+#define USBLIB_DEVICE_USBDCOMP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "usblib/usblib.h"
+
+typedef struct {
+    const tDeviceInfo *psDevInfo;
+    void *pvInstance;
+} tCompositeEntry;
+
+typedef struct {
+    uint32_t ui32Reserved;
+} tCompositeInstance;
+
+typedef struct {
+    uint16_t ui16VID;
+    uint16_t ui16PID;
+    uint16_t ui16MaxPowermA;
+    uint8_t ui8PwrAttributes;
+    tUSBCallback pfnCallback;
+    const uint8_t * const *ppui8StringDescriptors;
+    uint32_t ui32NumStringDescriptors;
+    uint32_t ui32NumDevices;
+    tCompositeEntry * const psDevices;
+    tCompositeInstance sPrivateData;
+} tUSBDCompositeDevice;
+
+extern void *USBDCompositeInit(uint32_t ui32Index, tUSBDCompositeDevice *psCompDevice,
+                               uint32_t ui32Size, uint8_t *pui8Data);
+
+#endif /* USBLIB_DEVICE_USBDCOMP_H_ */
@@ -0,0 +1,12 @@
+/* usbdevice.h
+ *
+ * Host fake of TivaWare's usblib/device/usbdevice.h, see tests/fake/fake.h.
+ */
+
+#ifndef USBLIB_DEVICE_USBDEVICE_H_
+#define USBLIB_DEVICE_USBDEVICE_H_
+
+// The USB0 interrupt handler usblib installs in device mode
+extern void USB0DeviceIntHandler(void);
+
+#endif /* USBLIB_DEVICE_USBDEVICE_H_ */
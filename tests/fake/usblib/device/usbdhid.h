@@ -0,0 +1,72 @@
+/* usbdhid.h
+ *
+ * Host fake of TivaWare's usblib/device/usbdhid.h, see tests/fake/fake.h.
+ * The generic HID class writes one report at a time to the interrupt IN
+ * endpoint, and the host polls it at the bInterval of the endpoint
+ * descriptor in the device's own configuration, or every 16 ms, usblib's
+ * default, if the device has none.
+ */
+
+#ifndef USBLIB_DEVICE_USBDHID_H_
+#define USBLIB_DEVICE_USBDHID_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "usblib/usblib.h"
+#include "usblib/usbhid.h"
+#include "usblib/device/usbdcomp.h"
+
+// Configuration descriptor space a HID class needs in a composite device
+#define COMPOSITE_DHID_SIZE     32
+
+#define USBD_HID_EVENT_BASE     0x8000
+#define USBD_HID_EVENT_IDLE_TIMEOUT (USBD_HID_EVENT_BASE + 0)
+#define USBD_HID_EVENT_GET_REPORT (USBD_HID_EVENT_BASE + 1)
+#define USBD_HID_EVENT_GET_REPORT_BUFFER (USBD_HID_EVENT_BASE + 2)
+#define USBD_HID_EVENT_SET_REPORT (USBD_HID_EVENT_BASE + 3)
+#define USBD_HID_EVENT_GET_PROTOCOL (USBD_HID_EVENT_BASE + 4)
+#define USBD_HID_EVENT_SET_PROTOCOL (USBD_HID_EVENT_BASE + 5)
+#define USBD_HID_EVENT_REPORT_SENT (USBD_HID_EVENT_BASE + 6)
+
+// The class keeps its state in the fake, see fakeusbhid.c
+typedef struct {
+    uint32_t ui32Reserved;
+} tHIDInstance;
+
+typedef struct {
+    uint16_t ui16VID;
+    uint16_t ui16PID;
+    uint16_t ui16MaxPowermA;
+    uint8_t ui8PwrAttributes;
+    uint8_t ui8Subclass;
+    uint8_t ui8Protocol;
+    uint8_t ui8NumInputReports;
+    tHIDReportIdle *psReportIdle;
+    tUSBCallback pfnRxCallback;
+    void *pvRxCBData;
+    tUSBCallback pfnTxCallback;
+    void *pvTxCBData;
+    bool bUseOutEndpoint;
+    const tHIDDescriptor *psHIDDescriptor;
+    const uint8_t * const *ppui8ClassDescriptors;
+    const uint8_t * const *ppui8StringDescriptors;
+    uint32_t ui32NumStringDescriptors;
+    const tConfigHeader * const *ppsConfigDescriptor;
+    tHIDInstance sPrivateData;
+} tUSBDHIDDevice;
+
+extern void *USBDHIDInit(uint32_t ui32Index, tUSBDHIDDevice *psHIDDevice);
+extern void *USBDHIDCompositeInit(uint32_t ui32Index, tUSBDHIDDevice *psHIDDevice,
+                                  tCompositeEntry *psCompEntry);
+
+// Returns ui32Length if the report was scheduled, 0 if one is still in
+// flight or the device is not configured
+extern uint32_t USBDHIDReportWrite(void *pvHIDInstance, uint8_t *pi8Data,
+                                   uint32_t ui32Length, bool bLast);
+
+// Take the OUT report USB_EVENT_RX_AVAILABLE announced
+extern uint32_t USBDHIDPacketRead(void *pvHIDInstance, uint8_t *pi8Data,
+                                  uint32_t ui32Length, bool bLast);
+
+#endif /* USBLIB_DEVICE_USBDHID_H_ */
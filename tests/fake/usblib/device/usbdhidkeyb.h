@@ -0,0 +1,59 @@
+/* usbdhidkeyb.h
+ *
+ * Host fake of TivaWare's usblib/device/usbdhidkeyb.h, see
+ * tests/fake/fake.h. The keyboard class keeps one boot report, sends it
+ * when a key changes and no report is in flight, and otherwise sends the
+ * accumulated changes once the report in flight completes.
+ */
+
+#ifndef USBLIB_DEVICE_USBDHIDKEYB_H_
+#define USBLIB_DEVICE_USBDHIDKEYB_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "usblib/usblib.h"
+#include "usblib/device/usbdhid.h"
+
+#define KEYB_MAX_CHARS_PER_REPORT 6
+
+#define USBD_HID_KEYB_EVENT_SET_LEDS (USBD_HID_EVENT_BASE + 0x10)
+
+#define KEYB_SUCCESS            0
+#define KEYB_ERR_TOO_MANY_KEYS  1
+#define KEYB_ERR_TX_ERROR       2
+#define KEYB_ERR_NOT_FOUND      3
+#define KEYB_ERR_NOT_CONFIGURED 4
+
+typedef struct {
+    bool bConfigured;
+    bool bTxBusy;               // A report is on the bus
+    bool bChangeMade;           // The report changed while one was in flight
+    uint8_t ui8Modifiers;
+    uint8_t ui8KeyCount;
+    uint8_t pui8Keys[KEYB_MAX_CHARS_PER_REPORT];
+} tHIDKeyboardInstance;
+
+typedef struct {
+    uint16_t ui16VID;
+    uint16_t ui16PID;
+    uint16_t ui16MaxPowermA;
+    uint8_t ui8PwrAttributes;
+    tUSBCallback pfnCallback;
+    void *pvCBData;
+    const uint8_t * const *ppui8StringDescriptors;
+    uint32_t ui32NumStringDescriptors;
+    tHIDKeyboardInstance sPrivateData;
+} tUSBDHIDKeyboardDevice;
+
+extern void *USBDHIDKeyboardInit(uint32_t ui32Index,
+                                 tUSBDHIDKeyboardDevice *psHIDKbDevice);
+extern void *USBDHIDKeyboardCompositeInit(uint32_t ui32Index,
+                                          tUSBDHIDKeyboardDevice *psHIDKbDevice,
+                                          tCompositeEntry *psCompEntry);
+extern uint32_t USBDHIDKeyboardKeyStateChange(void *pvKeyboardDevice,
+                                              uint8_t ui8Modifiers,
+                                              uint8_t ui8UsageCode, bool bPress);
+extern bool USBDHIDKeyboardRemoteWakeupRequest(void *pvKeyboardDevice);
+
+#endif /* USBLIB_DEVICE_USBDHIDKEYB_H_ */
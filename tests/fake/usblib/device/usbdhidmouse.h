@@ -0,0 +1,43 @@
+/* usbdhidmouse.h
+ *
+ * Host fake of TivaWare's usblib/device/usbdhidmouse.h, see
+ * tests/fake/fake.h. The mouse class only follows whether the host has it
+ * configured; its reports are taken and not passed to the host.
+ */
+
+#ifndef USBLIB_DEVICE_USBDHIDMOUSE_H_
+#define USBLIB_DEVICE_USBDHIDMOUSE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "usblib/usblib.h"
+#include "usblib/device/usbdcomp.h"
+
+#define MOUSE_SUCCESS           0
+#define MOUSE_ERR_TX_ERROR      2
+#define MOUSE_ERR_NOT_CONFIGURED 4
+
+typedef struct {
+    bool bConfigured;
+} tHIDMouseInstance;
+
+typedef struct {
+    uint16_t ui16VID;
+    uint16_t ui16PID;
+    uint16_t ui16MaxPowermA;
+    uint8_t ui8PwrAttributes;
+    tUSBCallback pfnCallback;
+    void *pvCBData;
+    const uint8_t * const *ppui8StringDescriptors;
+    uint32_t ui32NumStringDescriptors;
+    tHIDMouseInstance sPrivateData;
+} tUSBDHIDMouseDevice;
+
+extern void *USBDHIDMouseInit(uint32_t ui32Index, tUSBDHIDMouseDevice *psMouseDevice);
+extern void *USBDHIDMouseCompositeInit(uint32_t ui32Index, tUSBDHIDMouseDevice *psMouseDevice,
+                                       tCompositeEntry *psCompEntry);
+extern uint32_t USBDHIDMouseStateChange(void *pvMouseDevice, int8_t i8DeltaX, int8_t i8DeltaY,
+                                        uint8_t ui8Buttons);
+
+#endif /* USBLIB_DEVICE_USBDHIDMOUSE_H_ */
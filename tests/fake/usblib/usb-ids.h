@@ -0,0 +1,14 @@
+/* usb-ids.h
+ *
+ * Host fake of TivaWare's usblib/usb-ids.h, see tests/fake/fake.h.
+ */
+
+#ifndef USBLIB_USB_IDS_H_
+#define USBLIB_USB_IDS_H_
+
+#define USB_VID_TI_1CBE         0x1CBE
+#define USB_PID_MOUSE           0x0000
+#define USB_PID_KEYBOARD        0x0003
+#define USB_PID_SERIAL          0x0002
+
+#endif /* USBLIB_USB_IDS_H_ */
@@ -0,0 +1,25 @@
+/* usbcdc.h
+ *
+ * Host fake of TivaWare's usblib/usbcdc.h, see tests/fake/fake.h.
+ */
+
+#ifndef USBLIB_USBCDC_H_
+#define USBLIB_USBCDC_H_
+
+#include <stdint.h>
+
+// SET_CONTROL_LINE_STATE bits, DTR and RTS
+#define USB_CDC_DTE_PRESENT     0x01
+#define USB_CDC_ACTIVATE_CARRIER 0x02
+
+#define USB_CDC_STOP_BITS_1     0x00
+#define USB_CDC_PARITY_NONE     0x00
+
+typedef struct {
+    uint32_t ui32Rate;
+    uint8_t ui8Stop;
+    uint8_t ui8Parity;
+    uint8_t ui8Databits;
+} __attribute__((packed)) tLineCoding;
+
+#endif /* USBLIB_USBCDC_H_ */
@@ -0,0 +1,142 @@
+/* usbhid.h
+ *
+ * Host fake of TivaWare's usblib/usbhid.h, see tests/fake/fake.h.
+ */
+
+#ifndef USBLIB_USBHID_H_
+#define USBLIB_USBHID_H_
+
+#include <stdint.h>
+
+// Interface subclass and protocol, and the protocols SET_PROTOCOL selects
+#define USB_HID_SCLASS_NONE     0x00
+#define USB_HID_SCLASS_BOOT     0x01
+#define USB_HID_PROTOCOL_NONE   0
+#define USB_HID_PROTOCOL_KEYB   1
+#define USB_HID_PROTOCOL_MOUSE  2
+#define USB_HID_PROTOCOL_BOOT   0
+#define USB_HID_PROTOCOL_REPORT 1
+
+// Class descriptor types
+#define USB_HID_DTYPE_HID       0x21
+#define USB_HID_DTYPE_REPORT    0x22
+
+// Report descriptor items
+#define UsagePage(ui8Value)     0x05, ((ui8Value) & 0xff)
+#define Usage(ui8Value)         0x09, ((ui8Value) & 0xff)
+#define UsageMinimum(ui8Value)  0x19, ((ui8Value) & 0xff)
+#define UsageMaximum(ui8Value)  0x29, ((ui8Value) & 0xff)
+#define LogicalMinimum(i8Value) 0x15, ((i8Value) & 0xff)
+#define LogicalMaximum(i8Value) 0x25, ((i8Value) & 0xff)
+#define ReportSize(ui8Value)    0x75, ((ui8Value) & 0xff)
+#define ReportCount(ui8Value)   0x95, ((ui8Value) & 0xff)
+#define Input(ui8Value)         0x81, ((ui8Value) & 0xff)
+#define Output(ui8Value)        0x91, ((ui8Value) & 0xff)
+#define Collection(ui8Value)    0xa1, ((ui8Value) & 0xff)
+#define EndCollection           0xc0
+
+#define USB_HID_GENERIC_DESKTOP 0x01
+#define USB_HID_BUTTONS         0x09
+#define USB_HID_POINTER         0x01
+#define USB_HID_MOUSE           0x02
+#define USB_HID_X               0x30
+#define USB_HID_Y               0x31
+#define USB_HID_PHYSICAL        0x00
+#define USB_HID_APPLICATION     0x01
+
+#define USB_HID_INPUT_DATA      0x00
+#define USB_HID_INPUT_CONSTANT  0x01
+#define USB_HID_INPUT_VARIABLE  0x02
+#define USB_HID_INPUT_ABS       0x00
+#define USB_HID_INPUT_RELATIVE  0x04
+#define USB_HID_OUTPUT_DATA     0x00
+#define USB_HID_OUTPUT_VARIABLE 0x02
+#define USB_HID_OUTPUT_ABS      0x00
+
+// The HID class descriptor with one report descriptor after it
+typedef struct {
+    uint8_t bLength;
+    uint8_t bDescriptorType;
+    uint16_t bcdHID;
+    uint8_t bCountryCode;
+    uint8_t bNumDescriptors;
+    struct {
+        uint8_t bDescriptorType;
+        uint16_t wDescriptorLength;
+    } __attribute__((packed)) sClassDescriptor[1];
+} __attribute__((packed)) tHIDDescriptor;
+
+// Idle rate of an input report
+typedef struct {
+    uint8_t ui8Duration4mS;
+    uint8_t ui8ReportID;
+    uint16_t ui16TimeTillNextmS;
+    uint32_t ui32TimeSinceReportmS;
+} tHIDReportIdle;
+
+// Modifier bits of a boot keyboard report
+#define HID_KEYB_LEFT_CTRL      0x01
+#define HID_KEYB_LEFT_SHIFT     0x02
+#define HID_KEYB_LEFT_ALT       0x04
+#define HID_KEYB_LEFT_GUI       0x08
+
+// LED bits of the output report
+#define HID_KEYB_NUM_LOCK       0x01
+#define HID_KEYB_CAPS_LOCK      0x02
+#define HID_KEYB_SCROLL_LOCK    0x04
+
+// Usage codes, A to Z run on from 4 and 1 to 9 from 30
+#define HID_KEYB_USAGE_A        4
+#define HID_KEYB_USAGE_B        5
+#define HID_KEYB_USAGE_C        6
+#define HID_KEYB_USAGE_D        7
+#define HID_KEYB_USAGE_E        8
+#define HID_KEYB_USAGE_F        9
+#define HID_KEYB_USAGE_G        10
+#define HID_KEYB_USAGE_H        11
+#define HID_KEYB_USAGE_I        12
+#define HID_KEYB_USAGE_J        13
+#define HID_KEYB_USAGE_K        14
+#define HID_KEYB_USAGE_L        15
+#define HID_KEYB_USAGE_M        16
+#define HID_KEYB_USAGE_N        17
+#define HID_KEYB_USAGE_O        18
+#define HID_KEYB_USAGE_P        19
+#define HID_KEYB_USAGE_Q        20
+#define HID_KEYB_USAGE_R        21
+#define HID_KEYB_USAGE_S        22
+#define HID_KEYB_USAGE_T        23
+#define HID_KEYB_USAGE_U        24
+#define HID_KEYB_USAGE_V        25
+#define HID_KEYB_USAGE_W        26
+#define HID_KEYB_USAGE_X        27
+#define HID_KEYB_USAGE_Y        28
+#define HID_KEYB_USAGE_Z        29
+#define HID_KEYB_USAGE_1        30
+#define HID_KEYB_USAGE_2        31
+#define HID_KEYB_USAGE_3        32
+#define HID_KEYB_USAGE_4        33
+#define HID_KEYB_USAGE_5        34
+#define HID_KEYB_USAGE_6        35
+#define HID_KEYB_USAGE_7        36
+#define HID_KEYB_USAGE_8        37
+#define HID_KEYB_USAGE_9        38
+#define HID_KEYB_USAGE_0        39
+#define HID_KEYB_USAGE_ENTER    40
+#define HID_KEYB_USAGE_ESCAPE   41
+#define HID_KEYB_USAGE_BACKSPACE 42
+#define HID_KEYB_USAGE_TAB      43
+#define HID_KEYB_USAGE_SPACE    44
+#define HID_KEYB_USAGE_MINUS    45
+#define HID_KEYB_USAGE_EQUAL    46
+#define HID_KEYB_USAGE_LBRACKET 47
+#define HID_KEYB_USAGE_RBRACKET 48
+#define HID_KEYB_USAGE_BSLASH   49
+#define HID_KEYB_USAGE_SEMICOLON 51
+#define HID_KEYB_USAGE_FQUOTE   52
+#define HID_KEYB_USAGE_BQUOTE   53
+#define HID_KEYB_USAGE_COMMA    54
+#define HID_KEYB_USAGE_PERIOD   55
+#define HID_KEYB_USAGE_FSLASH   56
+
+#endif /* USBLIB_USBHID_H_ */
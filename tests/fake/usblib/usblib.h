@@ -0,0 +1,75 @@
+/* usblib.h
+ *
+ * Host fake of TivaWare's usblib/usblib.h, see tests/fake/fake.h.
+ */
+
+#ifndef USBLIB_USBLIB_H_
+#define USBLIB_USBLIB_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Descriptor types, and the fields of configuration, interface and endpoint
+// descriptors the devices fill in
+#define USB_DTYPE_CONFIGURATION 2
+#define USB_DTYPE_STRING        3
+#define USB_DTYPE_INTERFACE     4
+#define USB_DTYPE_ENDPOINT      5
+#define USB_LANG_EN_US          0x0409
+#define USBShort(ui16Value)     ((ui16Value) & 0xff), ((ui16Value) >> 8)
+
+#define USB_CONF_ATTR_BUS_PWR   0x80
+#define USB_CONF_ATTR_SELF_PWR  0xC0
+#define USB_CONF_ATTR_RWAKE     0x20
+
+#define USB_CLASS_HID           0x03
+
+#define USB_EP_DESC_OUT         0x00
+#define USB_EP_DESC_IN          0x80
+#define USB_EP_ATTR_INT         0x03
+#define USBEPToIndex(x)         ((x) >> 4)
+
+// One piece of a configuration descriptor, and the list of pieces that
+// make up a whole one
+typedef struct {
+    uint16_t ui16Size;
+    const uint8_t *pui8Data;
+} tConfigSection;
+
+typedef struct {
+    uint8_t ui8NumSections;
+    const tConfigSection * const *psSections;
+} tConfigHeader;
+
+// A class driver's table of handlers, which the fake does not look into
+typedef struct tDeviceInfo tDeviceInfo;
+
+#define USB_EVENT_BASE          0x0000
+#define USB_EVENT_CONNECTED     (USB_EVENT_BASE + 0)
+#define USB_EVENT_DISCONNECTED  (USB_EVENT_BASE + 1)
+#define USB_EVENT_RX_AVAILABLE  (USB_EVENT_BASE + 2)
+#define USB_EVENT_DATA_REMAINING (USB_EVENT_BASE + 3)
+#define USB_EVENT_REQUEST_BUFFER (USB_EVENT_BASE + 4)
+#define USB_EVENT_TX_COMPLETE   (USB_EVENT_BASE + 5)
+#define USB_EVENT_ERROR         (USB_EVENT_BASE + 6)
+#define USB_EVENT_SUSPEND       (USB_EVENT_BASE + 7)
+#define USB_EVENT_RESUME        (USB_EVENT_BASE + 8)
+
+typedef uint32_t (*tUSBCallback)(void *pvCBData, uint32_t ui32Event,
+                                 uint32_t ui32MsgParam, void *pvMsgData);
+
+typedef enum {
+    eUSBModeHost = 0,
+    eUSBModeDevice,
+    eUSBModeNone,
+    eUSBModeOTG,
+    eUSBModeForceHost,
+    eUSBModeForceDevice
+} tUSBMode;
+
+typedef void (*tUSBModeCallback)(uint32_t ui32Index, tUSBMode iMode);
+
+extern void USBStackModeSet(uint32_t ui32Index, tUSBMode iUSBMode,
+                            tUSBModeCallback pfnCallback);
+
+#endif /* USBLIB_USBLIB_H_ */
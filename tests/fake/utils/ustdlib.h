@@ -0,0 +1,15 @@
+/* ustdlib.h
+ *
+ * Host fake of TivaWare's utils/ustdlib.h, see tests/fake/fake.h.
+ */
+
+#ifndef USTDLIB_H_
+#define USTDLIB_H_
+
+#include <stdint.h>
+#include <stdarg.h>
+
+extern int uvsnprintf(char *pcBuf, uint32_t ui32Size, const char *pcString, va_list vaArgP);
+extern int usnprintf(char *pcBuf, uint32_t ui32Size, const char *pcString, ...);
+
+#endif /* USTDLIB_H_ */
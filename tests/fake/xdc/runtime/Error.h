@@ -0,0 +1,18 @@
+/* Error.h
+ *
+ * Host fake of XDCtools' xdc/runtime/Error.h, see tests/fake/fake.h.
+ * Nothing in the fake raises an error, creation either works or aborts.
+ */
+
+#ifndef XDC_RUNTIME_ERROR_H_
+#define XDC_RUNTIME_ERROR_H_
+
+#include <xdc/std.h>
+
+typedef struct {
+    Int iUnused;
+} Error_Block;
+
+#define Error_init(eb)          ((eb)->iUnused = 0)
+
+#endif /* XDC_RUNTIME_ERROR_H_ */
@@ -0,0 +1,13 @@
+/* System.h
+ *
+ * Host fake of XDCtools' xdc/runtime/System.h, see tests/fake/fake.h.
+ */
+
+#ifndef XDC_RUNTIME_SYSTEM_H_
+#define XDC_RUNTIME_SYSTEM_H_
+
+#include <xdc/std.h>
+
+extern Void System_abort(const char *pcString);
+
+#endif /* XDC_RUNTIME_SYSTEM_H_ */
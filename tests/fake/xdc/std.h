@@ -0,0 +1,24 @@
+/* std.h
+ *
+ * Host fake of XDCtools' xdc/std.h, see tests/fake/fake.h.
+ */
+
+#ifndef XDC_STD_H_
+#define XDC_STD_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef char *String;
+typedef void Void;
+typedef bool Bool;
+typedef int Int;
+typedef unsigned int UInt;
+typedef intptr_t IArg;
+typedef uintptr_t UArg;
+
+#define TRUE                    1
+#define FALSE                   0
+
+#endif /* XDC_STD_H_ */
@@ -0,0 +1,29 @@
+/* test.h
+ *
+ * Minimal checks for the host unit tests. CHECK() reports the file and
+ * line of a failed condition and carries on; TEST_DONE() prints a summary
+ * and returns the exit status from main().
+ */
+
+#ifndef TEST_H_
+#define TEST_H_
+
+#include <stdio.h>
+
+static int g_iTestChecks;
+static int g_iTestFailures;
+
+#define CHECK(cond)                                                         \
+    do {                                                                    \
+        g_iTestChecks++;                                                    \
+        if (!(cond)) {                                                      \
+            g_iTestFailures++;                                              \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        }                                                                   \
+    } while (0)
+
+#define TEST_DONE()                                                         \
+    (printf("%s: %d checks, %d failed\n", __FILE__, g_iTestChecks,          \
+            g_iTestFailures), g_iTestFailures != 0)
+
+#endif /* TEST_H_ */
@@ -0,0 +1,77 @@
+/* test_canbittiming.c
+ *
+ * CAN_BIT_TIMING() against a table of known good settings for the clocks
+ * the projects run at, see common/canbittiming.h.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "canbittiming.h"
+#include "test.h"
+
+// Same layout as driverlib's tCANBitClkParms
+typedef struct {
+    uint32_t ui32SyncPropPhase1Seg;
+    uint32_t ui32Phase2Seg;
+    uint32_t ui32SJW;
+    uint32_t ui32QuantumPrescaler;
+} tBitClk;
+
+typedef struct {
+    uint32_t ui32Clock;
+    uint32_t ui32BitRate;
+    tBitClk sExpected;
+    tBitClk sTiming;
+} tBitClkCase;
+
+#define CASE(clk, br, tseg1, tseg2, sjw, brp)                               \
+    { clk, br, { tseg1, tseg2, sjw, brp }, CAN_BIT_TIMING(clk, br, 875) }
+
+// Every entry must also build
+CAN_BIT_TIMING_CHECK(16000000, 125000, 875);
+CAN_BIT_TIMING_CHECK(50000000, 1000000, 875);
+CAN_BIT_TIMING_CHECK(80000000, 1000000, 875);
+
+static const tBitClkCase g_psCases[] = {
+    CASE(16000000, 125000, 14, 2, 2, 8),
+    CASE(16000000, 250000, 14, 2, 2, 4),
+    CASE(16000000, 500000, 14, 2, 2, 2),
+    CASE(16000000, 1000000, 14, 2, 2, 1),
+    CASE(50000000, 125000, 14, 2, 2, 25),
+    CASE(50000000, 250000, 9, 1, 1, 20),
+    CASE(50000000, 500000, 9, 1, 1, 10),
+    CASE(50000000, 1000000, 9, 1, 1, 5),
+    CASE(80000000, 125000, 14, 2, 2, 40),
+    CASE(80000000, 250000, 14, 2, 2, 20),
+    CASE(80000000, 500000, 14, 2, 2, 10),
+    CASE(80000000, 1000000, 14, 2, 2, 5),
+};
+
+int main(void) {
+    const tBitClkCase *psCase;
+    uint32_t ui32Quanta;
+    uint32_t ui32Index;
+    int32_t i32SamplePoint;
+
+    for (ui32Index = 0; ui32Index < sizeof(g_psCases) / sizeof(g_psCases[0]); ui32Index++) {
+        psCase = &g_psCases[ui32Index];
+        CHECK(psCase->sTiming.ui32SyncPropPhase1Seg == psCase->sExpected.ui32SyncPropPhase1Seg);
+        CHECK(psCase->sTiming.ui32Phase2Seg == psCase->sExpected.ui32Phase2Seg);
+        CHECK(psCase->sTiming.ui32SJW == psCase->sExpected.ui32SJW);
+        CHECK(psCase->sTiming.ui32QuantumPrescaler == psCase->sExpected.ui32QuantumPrescaler);
+
+        // The result gives the exact bit rate and a sample point in range
+        ui32Quanta = psCase->sTiming.ui32SyncPropPhase1Seg + psCase->sTiming.ui32Phase2Seg;
+        CHECK(psCase->sTiming.ui32QuantumPrescaler * ui32Quanta * psCase->ui32BitRate ==
+              psCase->ui32Clock);
+        i32SamplePoint = psCase->sTiming.ui32SyncPropPhase1Seg * 1000 / ui32Quanta;
+        CHECK(i32SamplePoint - 875 <= CAN_BIT_TIMING_SP_TOLERANCE);
+        CHECK(875 - i32SamplePoint <= CAN_BIT_TIMING_SP_TOLERANCE);
+    }
+
+    // No setting: 1 Mbit/s needs at least 3 quanta per bit
+    CHECK(CAN_BIT_TIMING_QUANTA(2000000, 1000000, 875) == 0);
+
+    return TEST_DONE();
+}
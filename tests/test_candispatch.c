@@ -0,0 +1,192 @@
+/* test_candispatch.c
+ *
+ * Registration and lookup in the dispatch table, see common/candispatch.h.
+ * Overlapping ID/mask registrations are checked against a model that scans
+ * them in order and keeps the last match, for every 11 bit ID.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "candispatch.h"
+#include "test.h"
+
+typedef struct {
+    uint32_t ui32ID;
+    uint32_t ui32Mask;
+    uint32_t ui32Handler;       // Index into g_pui32Calls, 0 for none
+} tReg;
+
+// Calls per handler argument, and the last frame a handler saw
+static uint32_t g_pui32Calls[CANDISPATCH_MAX_HANDLERS + 2];
+static const tCANFrame *g_psLastFrame;
+static uint32_t g_ui32OtherCalls;
+
+static void handler(const tCANFrame *psFrame, void *pvArg) {
+    (*(uint32_t *)pvArg)++;
+    g_psLastFrame = psFrame;
+}
+
+static void otherHandler(const tCANFrame *psFrame, void *pvArg) {
+    (void)psFrame;
+    (void)pvArg;
+    g_ui32OtherCalls++;
+}
+
+// Handler the model expects for ui32ID, the last registration to match
+static uint32_t model(const tReg *psRegs, uint32_t ui32Num, uint32_t ui32ID) {
+    uint32_t ui32Handler = 0;
+    uint32_t ui32Idx;
+
+    for (ui32Idx = 0; ui32Idx < ui32Num; ui32Idx++) {
+        if ((ui32ID & psRegs[ui32Idx].ui32Mask) ==
+            (psRegs[ui32Idx].ui32ID & psRegs[ui32Idx].ui32Mask)) {
+            ui32Handler = psRegs[ui32Idx].ui32Handler;
+        }
+    }
+    return ui32Handler;
+}
+
+// Dispatch every ID and check it reaches the handler the model says
+static void checkAll(const tReg *psRegs, uint32_t ui32Num) {
+    tCANFrame sFrame = { 0, 0, { 0 }, 0 };
+    uint32_t ui32Expect;
+    uint32_t ui32Before;
+
+    for (sFrame.ui32ID = 0; sFrame.ui32ID <= 0x7FF; sFrame.ui32ID++) {
+        ui32Expect = model(psRegs, ui32Num, sFrame.ui32ID);
+        ui32Before = g_pui32Calls[ui32Expect];
+        CHECK(CANDispatch(&sFrame) == (ui32Expect != 0));
+        if (ui32Expect != 0) {
+            CHECK(g_pui32Calls[ui32Expect] == ui32Before + 1);
+        }
+    }
+}
+
+static void registerAll(const tReg *psRegs, uint32_t ui32Num) {
+    uint32_t ui32Idx;
+
+    CANDispatchInit();
+    for (ui32Idx = 0; ui32Idx < ui32Num; ui32Idx++) {
+        CHECK(CANDispatchRegister(psRegs[ui32Idx].ui32ID, psRegs[ui32Idx].ui32Mask, handler,
+                                  &g_pui32Calls[psRegs[ui32Idx].ui32Handler]));
+    }
+}
+
+static void testOverlap(void) {
+    // CANRX's layout: everything to the LED handler, then the ISO-TP ID
+    const tReg psCANRX[] = { { 0, 0, 1 }, { 0x7E0, 0x7FF, 2 } };
+
+    // The other way round the catch-all takes the ISO-TP ID back
+    const tReg psReversed[] = { { 0x7E0, 0x7FF, 2 }, { 0, 0, 1 } };
+
+    // Ranges inside ranges, one ID listed twice with different handlers,
+    // and ID bits outside the mask, which are ignored
+    const tReg psNested[] = {
+        { 0x100, 0x700, 1 },
+        { 0x120, 0x7F0, 2 },
+        { 0x123, 0x7FF, 3 },
+        { 0x1FF, 0x7F0, 4 },
+        { 0x123, 0x7FF, 5 },
+        { 0x7FF, 0x001, 6 },
+    };
+    tCANFrame sFrame = { 0x7E0, 8, { 0x02, 0x10, 0x01 }, 1234 };
+    uint32_t ui32Idx;
+
+    registerAll(psCANRX, 2);
+    checkAll(psCANRX, 2);
+
+    // The handler gets the frame as passed
+    g_psLastFrame = 0;
+    CHECK(CANDispatch(&sFrame));
+    CHECK(g_psLastFrame == &sFrame);
+
+    // Only the 11 ID bits index the table
+    sFrame.ui32ID = 0x7E0 | 0x800;
+    ui32Idx = g_pui32Calls[2];
+    CHECK(CANDispatch(&sFrame));
+    CHECK(g_pui32Calls[2] == ui32Idx + 1);
+
+    registerAll(psReversed, 2);
+    checkAll(psReversed, 2);
+    CHECK(model(psReversed, 2, 0x7E0) == 1);
+
+    registerAll(psNested, 6);
+    checkAll(psNested, 6);
+    CHECK(model(psNested, 6, 0x123) == 6);
+    CHECK(model(psNested, 6, 0x122) == 2);
+    CHECK(model(psNested, 6, 0x12F) == 6);
+    CHECK(model(psNested, 6, 0x1F2) == 4);
+    CHECK(model(psNested, 6, 0x200) == 0);
+
+    // Init forgets them all
+    CANDispatchInit();
+    checkAll(psNested, 0);
+}
+
+static void testRandom(void) {
+    tReg psRegs[64];
+    uint32_t ui32Seed = 1;
+    uint32_t ui32Round;
+    uint32_t ui32Idx;
+
+    for (ui32Round = 0; ui32Round < 20; ui32Round++) {
+        for (ui32Idx = 0; ui32Idx < 64; ui32Idx++) {
+            ui32Seed = ui32Seed * 1103515245 + 12345;
+            psRegs[ui32Idx].ui32ID = (ui32Seed >> 8) & 0x7FF;
+
+            // Mostly single IDs, some ranges of a few bits, rarely wider
+            ui32Seed = ui32Seed * 1103515245 + 12345;
+            psRegs[ui32Idx].ui32Mask = (0x7FF << ((ui32Seed >> 16) % 8)) & 0x7FF;
+            if (((ui32Seed >> 20) & 3) == 0) {
+                psRegs[ui32Idx].ui32Mask = 0x7FF;
+            }
+
+            psRegs[ui32Idx].ui32Handler = 1 + (ui32Seed >> 24) % CANDISPATCH_MAX_HANDLERS;
+        }
+        registerAll(psRegs, 64);
+        checkAll(psRegs, 64);
+    }
+}
+
+static void testHandlers(void) {
+    tCANFrame sFrame = { 0, 0, { 0 }, 0 };
+    uint32_t ui32Idx;
+
+    // One registration per distinct handler and argument fills the table
+    CANDispatchInit();
+    for (ui32Idx = 1; ui32Idx <= CANDISPATCH_MAX_HANDLERS; ui32Idx++) {
+        CHECK(CANDispatchRegister(ui32Idx, 0x7FF, handler, &g_pui32Calls[ui32Idx]));
+    }
+
+    // Repeats of a pair share its slot, a new argument or a new function
+    // does not fit
+    CHECK(CANDispatchRegister(0x400, 0x700, handler, &g_pui32Calls[1]));
+    CHECK(!CANDispatchRegister(0x300, 0x7FF, handler,
+                               &g_pui32Calls[CANDISPATCH_MAX_HANDLERS + 1]));
+    CHECK(!CANDispatchRegister(0x300, 0x7FF, otherHandler, &g_pui32Calls[1]));
+
+    // A refused registration leaves the table as it was
+    sFrame.ui32ID = 0x300;
+    CHECK(!CANDispatch(&sFrame));
+    CHECK(g_ui32OtherCalls == 0);
+    sFrame.ui32ID = 0x4AB;
+    ui32Idx = g_pui32Calls[1];
+    CHECK(CANDispatch(&sFrame));
+    CHECK(g_pui32Calls[1] == ui32Idx + 1);
+
+    // After Init the slots are free again
+    CANDispatchInit();
+    CHECK(CANDispatchRegister(0x300, 0x7FF, otherHandler, 0));
+    sFrame.ui32ID = 0x300;
+    CHECK(CANDispatch(&sFrame));
+    CHECK(g_ui32OtherCalls == 1);
+}
+
+int main(void) {
+    testOverlap();
+    testRandom();
+    testHandlers();
+
+    return TEST_DONE();
+}
@@ -0,0 +1,199 @@
+/* test_canerr.c
+ *
+ * Error state tracking and bus-off recovery on the fake CAN controller, see
+ * common/canerr.h. FakeCANError() sets the error counters and last error
+ * code the way the bus would, the status interrupt is handled by calling
+ * CANErrStatusIntHandler() as CAN0IntHandler() does, and CANErrUpdate() and
+ * CANErrTxPermit() run against a scripted clock that wraps during the first
+ * backoff. Covers the backoff doubling from 10 ms up to 1 s while bus-offs
+ * keep following recoveries, its reset once a recovery has held for the
+ * stable window, the recovery time kept in g_sCANErrStats, and the transmit
+ * throttle in the warning and passive states.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "inc/hw_memmap.h"
+#include "driverlib/can.h"
+
+#include "canerr.h"
+#include "test.h"
+
+// 80 MHz, as CANLatencyNow() counts on the board
+#define TICKS_PER_MS            80000
+
+// Time from clearing INIT to the end of 128 idle sequences, in ms
+#define RECOVERY_MS             3
+
+static uint32_t g_ui32Now;
+
+static void advance(uint32_t ui32Ms) {
+    g_ui32Now += ui32Ms * TICKS_PER_MS;
+}
+
+// The bus changes the counters and the interrupt handler sees it
+static void busError(uint32_t ui32TEC, uint32_t ui32REC, uint32_t ui32LEC) {
+    FakeCANError(CAN0_BASE, ui32TEC, ui32REC, ui32LEC);
+    CANErrStatusIntHandler();
+    CANErrUpdate(g_ui32Now);
+}
+
+// Go bus-off now, then sit out the backoff and recover. Returns the backoff
+// used, in ms.
+static uint32_t busOff(void) {
+    uint32_t ui32BusOffs = g_sCANErrStats.ui32BusOffs;
+    uint32_t ui32Recoveries = g_sCANErrStats.ui32Recoveries;
+    uint32_t ui32Backoff;
+    uint32_t ui32Ms;
+
+    busError(256, 0, CAN_STATUS_LEC_BIT0);
+    CHECK(g_sCANErrStats.eState == CANERR_BUSOFF);
+    CHECK(g_sCANErrStats.ui32BusOffs == ui32BusOffs + 1);
+    CHECK(FakeCANInit(CAN0_BASE));
+    ui32Backoff = g_sCANErrStats.ui32BackoffMs;
+
+    // The controller stays stopped until the backoff has run out
+    for (ui32Ms = 1; ui32Ms < ui32Backoff; ui32Ms++) {
+        advance(1);
+        CANErrUpdate(g_ui32Now);
+        CHECK(g_sCANErrStats.eState == CANERR_BUSOFF);
+        CHECK(FakeCANInit(CAN0_BASE));
+        CHECK(!CANErrTxPermit(g_ui32Now));
+    }
+    advance(1);
+    CANErrUpdate(g_ui32Now);
+    CHECK(g_sCANErrStats.eState == CANERR_RECOVERING);
+    CHECK(!FakeCANInit(CAN0_BASE));
+    CHECK(!CANErrTxPermit(g_ui32Now));
+
+    // BOFF stays set until the idle sequences have gone by
+    advance(RECOVERY_MS - 1);
+    CANErrUpdate(g_ui32Now);
+    CHECK(g_sCANErrStats.eState == CANERR_RECOVERING);
+    CHECK(g_sCANErrStats.ui32Recoveries == ui32Recoveries);
+
+    advance(1);
+    busError(0, 0, CAN_STATUS_LEC_NONE);
+    CHECK(g_sCANErrStats.eState == CANERR_ACTIVE);
+    CHECK(g_sCANErrStats.ui32Recoveries == ui32Recoveries + 1);
+    CHECK(g_sCANErrStats.ui32LastRecovery == (ui32Backoff + RECOVERY_MS) * TICKS_PER_MS);
+    CHECK(CANErrTxPermit(g_ui32Now));
+
+    return ui32Backoff;
+}
+
+static void testThrottle(void) {
+    uint32_t ui32Throttled;
+    uint32_t ui32Ms;
+
+    // No limit while error active
+    for (ui32Ms = 0; ui32Ms < 20; ui32Ms++) {
+        CHECK(CANErrTxPermit(g_ui32Now));
+        CHECK(CANErrTxPermit(g_ui32Now));
+    }
+    CHECK(g_sCANErrStats.ui32TxThrottled == 0);
+
+    // One frame per 10 ms in the warning state
+    busError(96, 0, CAN_STATUS_LEC_STUFF);
+    CHECK(g_sCANErrStats.eState == CANERR_WARNING);
+    CHECK(g_sCANErrStats.ui32TEC == 96);
+    CHECK(CANErrTxPermit(g_ui32Now));
+    for (ui32Ms = 0; ui32Ms < 10; ui32Ms++) {
+        CHECK(!CANErrTxPermit(g_ui32Now));
+        advance(1);
+    }
+    CHECK(CANErrTxPermit(g_ui32Now));
+    CHECK(!CANErrTxPermit(g_ui32Now));
+    CHECK(g_sCANErrStats.ui32TxThrottled == 11);
+
+    // One per 100 ms when error passive, from either counter
+    advance(10);
+    busError(40, 128, CAN_STATUS_LEC_FORM);
+    CHECK(g_sCANErrStats.eState == CANERR_PASSIVE);
+    ui32Throttled = g_sCANErrStats.ui32TxThrottled;
+    CHECK(CANErrTxPermit(g_ui32Now));
+    for (ui32Ms = 0; ui32Ms < 100; ui32Ms++) {
+        CHECK(!CANErrTxPermit(g_ui32Now));
+        advance(1);
+    }
+    CHECK(CANErrTxPermit(g_ui32Now));
+    CHECK(g_sCANErrStats.ui32TxThrottled == ui32Throttled + 100);
+
+    // Back to error active lifts the limit at once, and a later warning
+    // does not inherit the old interval
+    advance(1);
+    busError(10, 0, CAN_STATUS_LEC_NONE);
+    CHECK(g_sCANErrStats.eState == CANERR_ACTIVE);
+    CHECK(CANErrTxPermit(g_ui32Now));
+    busError(0, 96, CAN_STATUS_LEC_ACK);
+    CHECK(g_sCANErrStats.eState == CANERR_WARNING);
+    CHECK(CANErrTxPermit(g_ui32Now));
+    CHECK(!CANErrTxPermit(g_ui32Now));
+    busError(0, 0, CAN_STATUS_LEC_NONE);
+    CHECK(g_sCANErrStats.eState == CANERR_ACTIVE);
+
+    // Error codes counted by kind, no error and no event are not
+    CHECK(g_sCANErrStats.pui32LEC[CAN_STATUS_LEC_STUFF] == 1);
+    CHECK(g_sCANErrStats.pui32LEC[CAN_STATUS_LEC_FORM] == 1);
+    CHECK(g_sCANErrStats.pui32LEC[CAN_STATUS_LEC_ACK] == 1);
+    CHECK(g_sCANErrStats.pui32LEC[CAN_STATUS_LEC_NONE] == 0);
+    CANErrStatusIntHandler();
+    CHECK(g_sCANErrStats.pui32LEC[CAN_STATUS_LEC_MASK] == 0);
+}
+
+static void testBackoff(void) {
+    static const uint32_t pui32Expect[] = { 10, 20, 40, 80, 160, 320, 640, 1000, 1000 };
+    uint32_t ui32Throttled;
+    uint32_t ui32Backoff;
+    uint32_t ui32Idx;
+
+    // The first bus-off since reset waits the minimum, each one within 5 s
+    // of the last recovery twice as long, up to 1 s
+    for (ui32Idx = 0; ui32Idx < sizeof(pui32Expect) / sizeof(pui32Expect[0]); ui32Idx++) {
+        ui32Backoff = busOff();
+        CHECK(ui32Backoff == pui32Expect[ui32Idx]);
+        printf("  bus-off %u: restart after %4u ms, error active again after %4u ms\n",
+               (unsigned)g_sCANErrStats.ui32BusOffs, (unsigned)ui32Backoff,
+               (unsigned)(g_sCANErrStats.ui32LastRecovery / TICKS_PER_MS));
+        advance(1000);
+    }
+
+    // A recovery that holds for the stable window starts over from 10 ms
+    advance(CANERR_STABLE_MS - 1000);
+    CHECK(busOff() == 10);
+
+    // One that falls 1 ms short of it does not
+    advance(CANERR_STABLE_MS - 1);
+    CHECK(busOff() == 20);
+
+    // Frames refused while off the bus are counted
+    busError(256, 0, CAN_STATUS_LEC_BIT1);
+    ui32Throttled = g_sCANErrStats.ui32TxThrottled;
+    CHECK(!CANErrTxPermit(g_ui32Now));
+    CHECK(!CANErrTxPermit(g_ui32Now));
+    CHECK(g_sCANErrStats.ui32TxThrottled == ui32Throttled + 2);
+
+    CHECK(g_sCANErrStats.ui32BusOffs == 12);
+    CHECK(g_sCANErrStats.ui32Recoveries == 11);
+    CHECK(g_sCANErrStats.pui32LEC[CAN_STATUS_LEC_BIT0] == 11);
+    CHECK(g_sCANErrStats.pui32LEC[CAN_STATUS_LEC_BIT1] == 1);
+}
+
+int main(void) {
+    FakeReset();
+    CANInit(CAN0_BASE);
+    CANEnable(CAN0_BASE);
+    CANErrInit(CAN0_BASE, TICKS_PER_MS);
+    CHECK(g_sCANErrStats.eState == CANERR_ACTIVE);
+    CHECK(g_sCANErrStats.ui32BackoffMs == CANERR_BACKOFF_MIN_MS);
+
+    testThrottle();
+
+    // The first backoff runs across the clock wrapping
+    g_ui32Now = (uint32_t)-(5 * TICKS_PER_MS);
+    testBackoff();
+
+    return TEST_DONE();
+}
@@ -0,0 +1,193 @@
+/* test_canfilter.c
+ *
+ * Acceptance filters worked out for realistic ID sets, see
+ * common/canfilter.h. For every set and object budget the filters must fit
+ * the budget, accept every wanted ID, be exact when there are no more IDs
+ * than filters, and let through the number of unwanted IDs
+ * CANFilterFalsePositives() reports. The filters are then programmed into
+ * the fake CAN controller and every 11 bit ID is put on the bus, along with
+ * 29 bit frames that must not get in. The unwanted counts are printed
+ * against a single merged filter, which is what one message object would
+ * take.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "inc/hw_memmap.h"
+#include "driverlib/can.h"
+
+#include "canfilter.h"
+#include "test.h"
+
+typedef struct {
+    const char *pcName;
+    const uint32_t *pui32IDs;
+    uint32_t ui32Count;
+} tIDSet;
+
+// What CANRX listens to: LED frames and the ISO-TP block
+static const uint32_t g_pui32CANRX[] = { 0x002, 0x7E0 };
+
+// OBD-II tester: the functional request, and the ECU requests and replies
+static const uint32_t g_pui32OBD[] = {
+    0x7DF,
+    0x7E0, 0x7E1, 0x7E2, 0x7E3, 0x7E4, 0x7E5, 0x7E6, 0x7E7,
+    0x7E8, 0x7E9, 0x7EA, 0x7EB, 0x7EC, 0x7ED, 0x7EE, 0x7EF
+};
+
+// A body controller's broadcast IDs, spread over the range, one listed twice
+static const uint32_t g_pui32Body[] = {
+    0x0C0, 0x0C8, 0x130, 0x140, 0x1A0, 0x1F0, 0x200, 0x201, 0x260, 0x280,
+    0x2A0, 0x316, 0x329, 0x340, 0x350, 0x3E0, 0x43F, 0x440, 0x4F0, 0x545,
+    0x200
+};
+
+// As many IDs as CANFilterCompute() takes, with no pattern to them
+static uint32_t g_pui32Random[CANFILTER_MAX_IDS];
+
+static const uint32_t g_pui32Budgets[] = { 16, 8, 4, 2, 1 };
+
+static bool wanted(const tIDSet *psSet, uint32_t ui32ID) {
+    uint32_t ui32Idx;
+
+    for (ui32Idx = 0; ui32Idx < psSet->ui32Count; ui32Idx++) {
+        if (psSet->pui32IDs[ui32Idx] == ui32ID) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint32_t distinct(const tIDSet *psSet) {
+    uint32_t ui32Count = 0;
+    uint32_t ui32ID;
+
+    for (ui32ID = 0; ui32ID <= 0x7FF; ui32ID++) {
+        if (wanted(psSet, ui32ID)) {
+            ui32Count++;
+        }
+    }
+    return ui32Count;
+}
+
+static bool accepts(const tCANFilter *psFilters, uint32_t ui32Num, uint32_t ui32ID) {
+    uint32_t ui32Idx;
+
+    for (ui32Idx = 0; ui32Idx < ui32Num; ui32Idx++) {
+        if ((ui32ID & psFilters[ui32Idx].ui32Mask) == psFilters[ui32Idx].ui32ID) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Put every 11 bit ID, and a 29 bit frame for each wanted one, on the fake
+// bus with the filters programmed one per object. Returns the unwanted 11
+// bit IDs the controller took and counts the 29 bit frames it took.
+static uint32_t onBus(const tIDSet *psSet, const tCANFilter *psFilters, uint32_t ui32Num,
+                      uint32_t *pui32Extended) {
+    tFakeCANFrame sFrame = { 0, false, 8, { 0 } };
+    uint32_t ui32Unwanted = 0;
+    uint32_t ui32ID;
+    uint32_t ui32Idx;
+    bool bTaken;
+
+    FakeReset();
+    CANInit(CAN0_BASE);
+    CANFilterProgram(CAN0_BASE, 1, psFilters, ui32Num, 1, 0);
+    CANEnable(CAN0_BASE);
+
+    for (ui32ID = 0; ui32ID <= 0x7FF; ui32ID++) {
+        sFrame.ui32ID = ui32ID;
+        bTaken = FakeCANReceive(CAN0_BASE, &sFrame) != 0;
+        CHECK(bTaken == accepts(psFilters, ui32Num, ui32ID));
+        if (wanted(psSet, ui32ID)) {
+            CHECK(bTaken);
+        } else if (bTaken) {
+            ui32Unwanted++;
+        }
+    }
+
+    // The same 11 bits at the top of a 29 bit ID, and as a small 29 bit ID
+    sFrame.bExtended = true;
+    *pui32Extended = 0;
+    for (ui32Idx = 0; ui32Idx < psSet->ui32Count; ui32Idx++) {
+        sFrame.ui32ID = (psSet->pui32IDs[ui32Idx] << 18) | 0x2A5A5;
+        *pui32Extended += FakeCANReceive(CAN0_BASE, &sFrame) != 0;
+        sFrame.ui32ID = psSet->pui32IDs[ui32Idx];
+        *pui32Extended += FakeCANReceive(CAN0_BASE, &sFrame) != 0;
+    }
+
+    return ui32Unwanted;
+}
+
+static void testSet(const tIDSet *psSet) {
+    tCANFilter psFilters[16];
+    tCANFilter sSingle;
+    uint32_t ui32Distinct = distinct(psSet);
+    uint32_t ui32Budget;
+    uint32_t ui32Num;
+    uint32_t ui32Unwanted;
+    uint32_t ui32Single;
+    uint32_t ui32OnBus;
+    uint32_t ui32Extended;
+    uint32_t ui32Idx;
+
+    CHECK(CANFilterCompute(psSet->pui32IDs, psSet->ui32Count, &sSingle, 1) == 1);
+    ui32Single = CANFilterFalsePositives(&sSingle, 1, psSet->pui32IDs, psSet->ui32Count);
+
+    for (ui32Idx = 0; ui32Idx < sizeof(g_pui32Budgets) / sizeof(g_pui32Budgets[0]); ui32Idx++) {
+        ui32Budget = g_pui32Budgets[ui32Idx];
+        ui32Num = CANFilterCompute(psSet->pui32IDs, psSet->ui32Count, psFilters, ui32Budget);
+        CHECK((ui32Num >= 1) && (ui32Num <= ui32Budget));
+        CHECK(ui32Num <= ui32Distinct);
+
+        ui32Unwanted = CANFilterFalsePositives(psFilters, ui32Num, psSet->pui32IDs,
+                                               psSet->ui32Count);
+        if (ui32Distinct <= ui32Budget) {
+            // One exact filter per ID
+            CHECK(ui32Num == ui32Distinct);
+            CHECK(ui32Unwanted == 0);
+        }
+        CHECK(ui32Unwanted <= ui32Single);
+
+        ui32OnBus = onBus(psSet, psFilters, ui32Num, &ui32Extended);
+        CHECK(ui32OnBus == ui32Unwanted);
+        CHECK(ui32Extended == 0);
+
+        printf("  %-8s %2u IDs, %2u objects: %2u filters, %4u unwanted IDs "
+               "(%4u with one filter), %u 29 bit frames taken\n",
+               psSet->pcName, (unsigned)ui32Distinct, (unsigned)ui32Budget,
+               (unsigned)ui32Num, (unsigned)ui32Unwanted, (unsigned)ui32Single,
+               (unsigned)ui32Extended);
+    }
+}
+
+int main(void) {
+    const tIDSet psSets[] = {
+        { "CANRX", g_pui32CANRX, sizeof(g_pui32CANRX) / sizeof(g_pui32CANRX[0]) },
+        { "OBD-II", g_pui32OBD, sizeof(g_pui32OBD) / sizeof(g_pui32OBD[0]) },
+        { "body", g_pui32Body, sizeof(g_pui32Body) / sizeof(g_pui32Body[0]) },
+        { "random", g_pui32Random, CANFILTER_MAX_IDS },
+    };
+    uint32_t ui32Seed = 12345;
+    uint32_t ui32Idx;
+
+    for (ui32Idx = 0; ui32Idx < CANFILTER_MAX_IDS; ui32Idx++) {
+        ui32Seed = ui32Seed * 1103515245 + 12345;
+        g_pui32Random[ui32Idx] = (ui32Seed >> 16) & 0x7FF;
+    }
+
+    // No IDs, too many IDs or no room gives no filters
+    CHECK(CANFilterCompute(g_pui32OBD, 0, 0, 4) == 0);
+    CHECK(CANFilterCompute(g_pui32Random, CANFILTER_MAX_IDS + 1, 0, 4) == 0);
+    CHECK(CANFilterCompute(g_pui32OBD, 1, 0, 0) == 0);
+
+    for (ui32Idx = 0; ui32Idx < sizeof(psSets) / sizeof(psSets[0]); ui32Idx++) {
+        testSet(&psSets[ui32Idx]);
+    }
+
+    return TEST_DONE();
+}
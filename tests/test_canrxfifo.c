@@ -0,0 +1,307 @@
+/* test_canrxfifo.c
+ *
+ * CANRX's receive FIFO on the fake CAN controller, see CANRX/canrxfifo.h.
+ * One interrupt drains every object holding new data into the ring, in
+ * arrival order; a full hardware FIFO and a full ring are counted against
+ * the frame's ID in the 16 entry open addressed drop table, and IDs that
+ * find it full go to g_ui32CANRXFifoDropsOther.
+ *
+ * Then a burst simulation: one second of back to back 8 byte frames at
+ * 500 kbit/s, 100% bus load, with the CAN interrupt held off for part of
+ * every 10 ms, or the main loop busy for part of every 50 ms. The frames
+ * lost are printed for the single receive object CANRX used before the
+ * FIFO, whose handler read object 1 and used the frame there and then, and
+ * for the FIFO. Handlers take no time here, so only the masked and busy
+ * windows lose frames.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "inc/hw_ints.h"
+#include "inc/hw_memmap.h"
+#include "driverlib/can.h"
+#include "driverlib/interrupt.h"
+
+#include "canrxfifo.h"
+#include "canlatency.h"
+#include "test.h"
+
+// An 8 byte frame with an 11 bit ID, stuff bits and interframe space is
+// about 125 bits, 250 us at 500 kbit/s
+#define FRAME_US                250
+#define BURST_FRAMES            4000
+
+#define MASK_PERIOD_US          10000
+#define BUSY_PERIOD_US          50000
+
+typedef struct {
+    const char *pcName;
+    uint32_t ui32MaskedUs;      // CAN interrupt held off per MASK_PERIOD_US
+    uint32_t ui32BusyUs;        // Main loop not draining per BUSY_PERIOD_US
+} tBurst;
+
+static const tBurst g_psBursts[] = {
+    { "interrupt masked 1 ms in 10", 1000, 0 },
+    { "interrupt masked 3 ms in 10", 3000, 0 },
+    { "interrupt masked 5 ms in 10", 5000, 0 },
+    { "main loop busy 5 ms in 50", 0, 5000 },
+    { "main loop busy 12 ms in 50", 0, 12000 },
+};
+
+// Frames the firmware got, and the sequence number of the last one per ID
+static uint32_t g_ui32Received;
+static uint32_t g_pui32LastSeq[0x800];
+static bool g_pbSeen[0x800];
+
+// Frames of one ID may be lost but never reordered or repeated. Each filter
+// has a FIFO of its own, so frames that passed different filters can come
+// out in a different order than they arrived.
+static void received(uint32_t ui32ID, const uint8_t *pui8Data) {
+    uint32_t ui32Seq = pui8Data[0] | (pui8Data[1] << 8) | (pui8Data[2] << 16) |
+                       ((uint32_t)pui8Data[3] << 24);
+
+    CHECK(!g_pbSeen[ui32ID] || (ui32Seq > g_pui32LastSeq[ui32ID]));
+    g_pui32LastSeq[ui32ID] = ui32Seq;
+    g_pbSeen[ui32ID] = true;
+    g_ui32Received++;
+}
+
+static void FifoIntHandler(void) {
+    uint32_t ui32Cause = CANIntStatus(CAN0_BASE, CAN_INT_STS_CAUSE);
+
+    if (!CANRXFifoIntHandler(ui32Cause)) {
+        CANIntClear(CAN0_BASE, ui32Cause);
+    }
+}
+
+// CANRX's handler before the FIFO, one object taking every ID
+static void SingleIntHandler(void) {
+    tCANMsgObject sMsg;
+    uint8_t pui8Data[8];
+    uint32_t ui32Cause = CANIntStatus(CAN0_BASE, CAN_INT_STS_CAUSE);
+
+    if (ui32Cause == 1) {
+        sMsg.pui8MsgData = pui8Data;
+        CANMessageGet(CAN0_BASE, 1, &sMsg, true);
+        received(sMsg.ui32MsgID, pui8Data);
+    } else {
+        CANIntClear(CAN0_BASE, ui32Cause);
+    }
+}
+
+static void setup(void (*pfnHandler)(void)) {
+    FakeReset();
+    CANLatencyInit(80000000);
+    CANInit(CAN0_BASE);
+    CANEnable(CAN0_BASE);
+    CANIntEnable(CAN0_BASE, CAN_INT_MASTER);
+    IntRegister(INT_CAN0, pfnHandler);
+    IntEnable(INT_CAN0);
+    IntMasterEnable();
+    memset(g_pbSeen, 0, sizeof(g_pbSeen));
+    g_ui32Received = 0;
+}
+
+static void send(uint32_t ui32ID, uint32_t ui32Seq) {
+    tFakeCANFrame sFrame = { ui32ID, false, 8, { 0 } };
+
+    sFrame.pui8Data[0] = ui32Seq;
+    sFrame.pui8Data[1] = ui32Seq >> 8;
+    sFrame.pui8Data[2] = ui32Seq >> 16;
+    sFrame.pui8Data[3] = ui32Seq >> 24;
+    sFrame.pui8Data[4] = ui32ID;
+    FakeCANReceive(CAN0_BASE, &sFrame);
+}
+
+static void drain(void) {
+    tCANFrame sFrame;
+
+    while (CANRXFifoGet(&sFrame)) {
+        CHECK(sFrame.ui32Len == 8);
+        CHECK(sFrame.pui8Data[4] == (sFrame.ui32ID & 0xFF));
+        received(sFrame.ui32ID, sFrame.pui8Data);
+    }
+}
+
+static void testDrain(void) {
+    const tCANFilter psFilters[] = { { 0x100, 0x700 }, { 0x200, 0x700 } };
+    uint32_t ui32Ints;
+    uint32_t ui32Seq;
+
+    setup(FifoIntHandler);
+    CHECK(!CANRXFifoInit(psFilters, 0));
+    CHECK(!CANRXFifoInit(psFilters, CANRXFIFO_MAX_FILTERS + 1));
+    CHECK(CANRXFifoInit(psFilters, 2));
+
+    // Eight objects per filter. Sixteen frames held while the interrupt is
+    // masked all come out of one handler run.
+    IntDisable(INT_CAN0);
+    for (ui32Seq = 0; ui32Seq < 16; ui32Seq++) {
+        send((ui32Seq & 1) ? 0x1A1 : 0x2A2, ui32Seq);
+    }
+    ui32Ints = FakeIntCount(INT_CAN0);
+    IntEnable(INT_CAN0);
+    CHECK(FakeIntCount(INT_CAN0) == ui32Ints + 1);
+    drain();
+    CHECK(g_ui32Received == 16);
+    CHECK(g_pui32LastSeq[0x1A1] == 15);
+    CHECK(g_pui32LastSeq[0x2A2] == 14);
+    CHECK(CANRXFifoDropsGet(0x1A1) == 0);
+    CHECK(CANRXFifoDropsGet(0x2A2) == 0);
+
+    // Ten into one filter's eight: the last object is overwritten twice,
+    // the controller flags it once and that is charged to the ID
+    IntDisable(INT_CAN0);
+    for (ui32Seq = 16; ui32Seq < 26; ui32Seq++) {
+        send(0x1A1, ui32Seq);
+    }
+    IntEnable(INT_CAN0);
+    drain();
+    CHECK(g_ui32Received == 16 + 8);
+    CHECK(g_pui32LastSeq[0x1A1] == 25);
+    CHECK(CANRXFifoDropsGet(0x1A1) == 1);
+
+    // With the main loop not draining, the ring takes 32 and the rest are
+    // counted one by one
+    for (ui32Seq = 26; ui32Seq < 26 + CANRXFIFO_RING_SIZE + 8; ui32Seq++) {
+        send(0x2A2, ui32Seq);
+    }
+    drain();
+    CHECK(g_ui32Received == 24 + CANRXFIFO_RING_SIZE);
+    CHECK(CANRXFifoDropsGet(0x2A2) == 8);
+    CHECK(g_ui32CANRXFifoDropsOther == 0);
+}
+
+static void testDropTable(void) {
+    const tCANFilter sAll = { 0, 0 };
+    uint32_t pui32IDs[CANRXFIFO_DROP_IDS];
+    uint32_t ui32Seq = 0;
+    uint32_t ui32Idx;
+    uint32_t ui32Drop;
+
+    setup(FifoIntHandler);
+    CHECK(CANRXFifoInit(&sAll, 1));
+    for (ui32Seq = 0; ui32Seq < CANRXFIFO_RING_SIZE; ui32Seq++) {
+        send(0x7FF, ui32Seq);
+    }
+
+    // The table already holds 0x1A1 and 0x2A2. Fill the rest with IDs that
+    // all hash to slot 0, so every one has to probe past the others, and
+    // with ID 0, stored as 1 since 0 marks a free slot. The ring stays full
+    // so every frame is a drop, the nth ID gets n + 1 of them.
+    pui32IDs[0] = 0;
+    for (ui32Idx = 1; ui32Idx < CANRXFIFO_DROP_IDS - 2; ui32Idx++) {
+        pui32IDs[ui32Idx] = ui32Idx << 4;
+    }
+    for (ui32Idx = 0; ui32Idx < CANRXFIFO_DROP_IDS - 2; ui32Idx++) {
+        for (ui32Drop = 0; ui32Drop <= ui32Idx; ui32Drop++) {
+            send(pui32IDs[ui32Idx], ui32Seq++);
+        }
+    }
+    for (ui32Idx = 0; ui32Idx < CANRXFIFO_DROP_IDS - 2; ui32Idx++) {
+        CHECK(CANRXFifoDropsGet(pui32IDs[ui32Idx]) == ui32Idx + 1);
+    }
+    CHECK(CANRXFifoDropsGet(0x1A1) == 1);
+    CHECK(CANRXFifoDropsGet(0x2A2) == 8);
+    CHECK(g_ui32CANRXFifoDropsOther == 0);
+
+    // Full: a new ID goes to the overflow count and reads back as 0, the
+    // IDs already in the table keep counting
+    send(0x7FF, ui32Seq++);
+    send(0x7FF, ui32Seq++);
+    send(0x0F0, ui32Seq++);
+    send(pui32IDs[CANRXFIFO_DROP_IDS - 3], ui32Seq++);
+    CHECK(g_ui32CANRXFifoDropsOther == 3);
+    CHECK(CANRXFifoDropsGet(0x7FF) == 0);
+    CHECK(CANRXFifoDropsGet(0x0F0) == 0);
+    CHECK(CANRXFifoDropsGet(pui32IDs[CANRXFIFO_DROP_IDS - 3]) == CANRXFIFO_DROP_IDS - 1);
+
+    drain();
+    CHECK(g_ui32Received == CANRXFIFO_RING_SIZE);
+}
+
+// Returns the frames lost, and for the FIFO sets *pui32Counted to the drops
+// it counted. The drop table is full by now, so they all go to
+// g_ui32CANRXFifoDropsOther.
+static uint32_t burst(const tBurst *psBurst, bool bFifo, uint32_t *pui32Counted) {
+    const tCANFilter sAll = { 0, 0 };
+    tCANMsgObject sMsg;
+    uint32_t ui32Other;
+    uint32_t ui32Seq;
+    uint32_t ui32Us;
+
+    if (bFifo) {
+        setup(FifoIntHandler);
+        CHECK(CANRXFifoInit(&sAll, 1));
+    } else {
+        setup(SingleIntHandler);
+        sMsg.ui32MsgID = 0;
+        sMsg.ui32MsgIDMask = 0;
+        sMsg.ui32Flags = MSG_OBJ_RX_INT_ENABLE | MSG_OBJ_USE_ID_FILTER;
+        sMsg.ui32MsgLen = 8;
+        sMsg.pui8MsgData = 0;
+        CANMessageSet(CAN0_BASE, 1, &sMsg, MSG_OBJ_TYPE_RX);
+    }
+    ui32Other = g_ui32CANRXFifoDropsOther;
+
+    for (ui32Seq = 0; ui32Seq < BURST_FRAMES; ui32Seq++) {
+        ui32Us = ui32Seq * FRAME_US;
+
+        if ((ui32Us % MASK_PERIOD_US) < psBurst->ui32MaskedUs) {
+            IntDisable(INT_CAN0);
+        } else {
+            IntEnable(INT_CAN0);
+        }
+        if (bFifo && ((ui32Us % BUSY_PERIOD_US) >= psBurst->ui32BusyUs)) {
+            drain();
+        }
+
+        send(0x100 + (ui32Seq & 7), ui32Seq);
+    }
+    IntEnable(INT_CAN0);
+    if (bFifo) {
+        drain();
+    }
+
+    *pui32Counted = g_ui32CANRXFifoDropsOther - ui32Other;
+    return BURST_FRAMES - g_ui32Received;
+}
+
+static void testBurst(void) {
+    const tBurst *psBurst;
+    uint32_t ui32Before;
+    uint32_t ui32After;
+    uint32_t ui32Counted;
+    uint32_t ui32Idx;
+
+    for (ui32Idx = 0; ui32Idx < sizeof(g_psBursts) / sizeof(g_psBursts[0]); ui32Idx++) {
+        psBurst = &g_psBursts[ui32Idx];
+        ui32Before = burst(psBurst, false, &ui32Counted);
+        ui32After = burst(psBurst, true, &ui32Counted);
+
+        // Everything the ring turns away is counted, the hardware flags
+        // only that the last object was overwritten, not how often
+        CHECK(ui32Counted <= ui32After);
+        CHECK((ui32Counted == 0) == (ui32After == 0));
+        if (psBurst->ui32BusyUs != 0) {
+            CHECK(ui32Counted == ui32After);
+        } else {
+            CHECK(ui32After < ui32Before);
+        }
+
+        printf("  %-28s lost %4u of %u frames with one object, %4u with the FIFO "
+               "(%u counted)\n", psBurst->pcName, (unsigned)ui32Before,
+               (unsigned)BURST_FRAMES, (unsigned)ui32After, (unsigned)ui32Counted);
+    }
+}
+
+int main(void) {
+    testDrain();
+    testDropTable();
+    testBurst();
+
+    return TEST_DONE();
+}
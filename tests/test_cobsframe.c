@@ -0,0 +1,107 @@
+/* test_cobsframe.c
+ *
+ * CRC-16 check value and COBS frame round trips, see common/cobsframe.h.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "crc16.h"
+#include "cobsframe.h"
+#include "test.h"
+
+#define FRAMES                  500
+#define PAYLOAD_MAX             700
+
+static uint8_t g_ppui8Payload[FRAMES][PAYLOAD_MAX];
+static uint32_t g_pui32Len[FRAMES];
+static uint8_t g_pui8Stream[FRAMES * COBSFRAME_ENCODED_MAX(PAYLOAD_MAX)];
+static uint8_t g_pui8Decoded[PAYLOAD_MAX + 2];
+
+// Fill the payloads with zeros, runs of more than 254 non-zero bytes and
+// random data, and encode them all back to back
+static uint32_t buildStream(void) {
+    uint32_t ui32Frame;
+    uint32_t ui32Index;
+    uint32_t ui32Used = 0;
+    uint32_t ui32Encoded;
+
+    srand(1);
+    for (ui32Frame = 0; ui32Frame < FRAMES; ui32Frame++) {
+        g_pui32Len[ui32Frame] = (ui32Frame < 4) ? ui32Frame : (uint32_t)rand() % PAYLOAD_MAX;
+        for (ui32Index = 0; ui32Index < g_pui32Len[ui32Frame]; ui32Index++) {
+            g_ppui8Payload[ui32Frame][ui32Index] = (rand() % 4) ? rand() : 0;
+        }
+        if (ui32Frame % 7 == 0) {
+            memset(g_ppui8Payload[ui32Frame], 0x55, g_pui32Len[ui32Frame]);
+        }
+
+        ui32Encoded = COBSFrameEncode(g_ppui8Payload[ui32Frame], g_pui32Len[ui32Frame],
+                                      &g_pui8Stream[ui32Used]);
+        CHECK(ui32Encoded <= COBSFRAME_ENCODED_MAX(g_pui32Len[ui32Frame]));
+        CHECK(memchr(&g_pui8Stream[ui32Used], 0, ui32Encoded - 1) == 0);
+        CHECK(g_pui8Stream[ui32Used + ui32Encoded - 1] == 0);
+        ui32Used += ui32Encoded;
+    }
+    return ui32Used;
+}
+
+int main(void) {
+    tCOBSDecoder sDecoder;
+    uint32_t ui32Len;
+    uint32_t ui32Pos;
+    uint32_t ui32Chunk;
+    uint32_t ui32Frame;
+    bool bFrame;
+
+    CHECK(CRC16Update(CRC16_INIT, (const uint8_t *)"123456789", 9) == 0x29B1);
+    CHECK(CRC16Update(CRC16Update(CRC16_INIT, (const uint8_t *)"1234", 4),
+                      (const uint8_t *)"56789", 5) == 0x29B1);
+
+    // Clean stream fed in uneven pieces: every frame comes back intact
+    ui32Len = buildStream();
+    COBSFrameDecoderInit(&sDecoder, g_pui8Decoded, sizeof(g_pui8Decoded));
+    ui32Frame = 0;
+    for (ui32Pos = 0; ui32Pos < ui32Len; ) {
+        ui32Chunk = 1 + (uint32_t)rand() % 100;
+        if (ui32Chunk > ui32Len - ui32Pos) {
+            ui32Chunk = ui32Len - ui32Pos;
+        }
+        ui32Pos += COBSFrameDecode(&sDecoder, &g_pui8Stream[ui32Pos], ui32Chunk, &bFrame);
+        if (bFrame) {
+            CHECK(ui32Frame < FRAMES);
+            CHECK(sDecoder.ui32Len == g_pui32Len[ui32Frame]);
+            CHECK(memcmp(g_pui8Decoded, g_ppui8Payload[ui32Frame], sDecoder.ui32Len) == 0);
+            ui32Frame++;
+        }
+    }
+    CHECK(ui32Frame == FRAMES);
+    CHECK(sDecoder.ui32CRCErrors == 0 && sDecoder.ui32Errors == 0);
+
+    // One flipped bit in frame 10 loses that frame only
+    ui32Len = COBSFrameEncode(g_ppui8Payload[10], g_pui32Len[10], g_pui8Stream);
+    g_pui8Stream[ui32Len / 2] ^= 0x10;
+    ui32Len += COBSFrameEncode(g_ppui8Payload[11], g_pui32Len[11], &g_pui8Stream[ui32Len]);
+    COBSFrameDecoderInit(&sDecoder, g_pui8Decoded, sizeof(g_pui8Decoded));
+    ui32Frame = 0;
+    for (ui32Pos = 0; ui32Pos < ui32Len; ) {
+        ui32Pos += COBSFrameDecode(&sDecoder, &g_pui8Stream[ui32Pos], ui32Len - ui32Pos, &bFrame);
+        if (bFrame) {
+            CHECK(sDecoder.ui32Len == g_pui32Len[11]);
+            CHECK(memcmp(g_pui8Decoded, g_ppui8Payload[11], sDecoder.ui32Len) == 0);
+            ui32Frame++;
+        }
+    }
+    CHECK(ui32Frame == 1);
+    CHECK(sDecoder.ui32CRCErrors + sDecoder.ui32Errors >= 1);
+
+    // A frame too long for the buffer is dropped, not truncated
+    COBSFrameDecoderInit(&sDecoder, g_pui8Decoded, 10);
+    ui32Len = COBSFrameEncode(g_ppui8Payload[20], 9, g_pui8Stream);
+    COBSFrameDecode(&sDecoder, g_pui8Stream, ui32Len, &bFrame);
+    CHECK(!bFrame && sDecoder.ui32Errors == 1);
+
+    return TEST_DONE();
+}
@@ -0,0 +1,73 @@
+/* test_fixedpoint.c
+ *
+ * Q15 helpers, and the PWM mapping in TivaWare_Test against the double
+ * precision code it replaced, see TivaWare_Test/fixedpoint.h.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "fixedpoint.h"
+#include "test.h"
+
+// Same scale as g_sPWMScale in TivaWare_Test/main.c
+static const tQ15Scale g_sPWMScale = { 2048, Q15(2.5), 5120 };
+
+// The original getADC mapping, kept as the reference
+static uint32_t referencePWM(uint32_t ui32Sample, bool *pbNegative) {
+    uint32_t g_i32Value = ui32Sample;
+    uint32_t g_ui32PWMValue;
+
+    g_i32Value -= 2048;
+    if ((int) g_i32Value < 0) {
+        *pbNegative = true;
+        g_ui32PWMValue = (int) g_i32Value*(-2.5);
+    } else {
+        *pbNegative = false;
+        g_ui32PWMValue = g_i32Value*2.5;
+    }
+    return g_ui32PWMValue;
+}
+
+int main(void) {
+    static const tQ15Scale sHalf = { 0, Q15(-0.5), 100 };
+    uint32_t ui32Sample;
+    uint32_t ui32Fixed;
+    uint32_t ui32Reference;
+    bool bFixedNegative;
+    bool bReferenceNegative;
+    uint32_t ui32Mismatches = 0;
+
+    // Every 12 bit reading maps exactly as before
+    for (ui32Sample = 0; ui32Sample < 4096; ui32Sample++) {
+        ui32Reference = referencePWM(ui32Sample, &bReferenceNegative);
+        ui32Fixed = Q15ScaleMagnitude(&g_sPWMScale, (int32_t)ui32Sample, &bFixedNegative);
+        if ((ui32Fixed != ui32Reference) ||
+            ((ui32Reference != 0) && (bFixedNegative != bReferenceNegative))) {
+            ui32Mismatches++;
+        }
+    }
+    CHECK(ui32Mismatches == 0);
+
+    // Constants round to nearest
+    CHECK(Q15(1.0) == 32768);
+    CHECK(Q15(2.5) == 81920);
+    CHECK(Q15(-0.5) == -16384);
+    CHECK(Q15(0.00002) == 1);
+
+    // Multiply truncates toward zero on both sides and saturates
+    CHECK(Q15SatMul(3, Q15(2.5)) == 7);
+    CHECK(Q15SatMul(-3, Q15(2.5)) == -7);
+    CHECK(Q15SatMul(1000, Q15(-0.5)) == -500);
+    CHECK(Q15SatMul(INT32_MAX, Q15(2.5)) == INT32_MAX);
+    CHECK(Q15SatMul(INT32_MIN, Q15(2.5)) == INT32_MIN);
+    CHECK(Q15SatMul(INT32_MIN, Q15(1.0)) == INT32_MIN);
+
+    // Output limit, sign from the result, and no overflow at INT32_MIN
+    CHECK(Q15ScaleMagnitude(&g_sPWMScale, 1000000, &bFixedNegative) == 5120 && !bFixedNegative);
+    CHECK(Q15ScaleMagnitude(&sHalf, 80, &bFixedNegative) == 40 && bFixedNegative);
+    CHECK(Q15ScaleMagnitude(&sHalf, -80, &bFixedNegative) == 40 && !bFixedNegative);
+    CHECK(Q15ScaleMagnitude(&sHalf, INT32_MAX, &bFixedNegative) == 100 && bFixedNegative);
+
+    return TEST_DONE();
+}
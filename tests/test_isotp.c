@@ -0,0 +1,159 @@
+/* test_isotp.c
+ *
+ * ISO-TP segmentation and reassembly between two links over a simulated
+ * bus that carries one frame at a time, see common/isotp.h.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "isotp.h"
+#include "test.h"
+
+#define SENDER_ID               0x7E0
+#define RECEIVER_ID             0x7E8
+
+// Ticks per ms, one tick is a microsecond
+#define TICKS_PER_MS            1000
+
+// Time a frame spends on the wire at 1 Mbit/s
+#define FRAME_TICKS             130
+
+static tISOTPLink g_sSender;
+static tISOTPLink g_sReceiver;
+
+// The frame on the wire, if any
+static tCANFrame g_sWire;
+static bool g_bWireBusy;
+
+// Frames the sender put on the bus by PCI type, and the receiver's flow
+// control frames
+static uint32_t g_pui32Sent[4];
+static uint32_t g_ui32FlowControls;
+static uint8_t g_pui8FirstFrame[8];
+
+static uint8_t g_pui8Tx[5000];
+static uint8_t g_pui8Rx[5000];
+
+static bool wireSend(uint32_t ui32ID, const uint8_t *pui8Data, uint32_t ui32Len) {
+    if (g_bWireBusy) {
+        return false;
+    }
+    g_sWire.ui32ID = ui32ID;
+    g_sWire.ui32Len = ui32Len;
+    memcpy(g_sWire.pui8Data, pui8Data, ui32Len);
+    g_bWireBusy = true;
+
+    if (ui32ID == SENDER_ID) {
+        g_pui32Sent[pui8Data[0] >> 4]++;
+        if ((pui8Data[0] >> 4) == 1) {
+            memcpy(g_pui8FirstFrame, pui8Data, 8);
+        }
+    } else {
+        g_ui32FlowControls++;
+    }
+    return true;
+}
+
+// Send ui32Len bytes and run the bus until the receiver has them. Returns
+// the receive status.
+static tISOTPStatus transfer(uint32_t ui32Len, uint8_t ui8BlockSize, uint8_t ui8STmin,
+                             uint32_t ui32RxSize, uint32_t *pui32Ticks) {
+    uint32_t ui32Now = 0;
+    uint32_t ui32Busy = 0;
+    uint32_t ui32Index;
+    uint32_t ui32RxLen;
+    tISOTPStatus eStatus = ISOTP_BUSY;
+
+    g_bWireBusy = false;
+    memset(g_pui32Sent, 0, sizeof(g_pui32Sent));
+    g_ui32FlowControls = 0;
+    memset(g_pui8Rx, 0, sizeof(g_pui8Rx));
+    for (ui32Index = 0; ui32Index < ui32Len; ui32Index++) {
+        g_pui8Tx[ui32Index] = ui32Index * 7 + 3;
+    }
+
+    ISOTPInit(&g_sSender, SENDER_ID, RECEIVER_ID, wireSend, TICKS_PER_MS);
+    ISOTPInit(&g_sReceiver, RECEIVER_ID, SENDER_ID, wireSend, TICKS_PER_MS);
+    ISOTPConfigure(&g_sReceiver, ui8BlockSize, ui8STmin);
+    ISOTPRxBufferSet(&g_sReceiver, g_pui8Rx, ui32RxSize);
+    CHECK(ISOTPSend(&g_sSender, g_pui8Tx, ui32Len, ui32Now));
+
+    while ((eStatus == ISOTP_BUSY || eStatus == ISOTP_IDLE) && ui32Now < 10000000) {
+        ui32Now++;
+        if (g_bWireBusy && ++ui32Busy >= FRAME_TICKS) {
+            ui32Busy = 0;
+            g_bWireBusy = false;
+            if (g_sWire.ui32ID == SENDER_ID) {
+                ISOTPFrameReceived(&g_sReceiver, &g_sWire, ui32Now);
+            } else {
+                ISOTPFrameReceived(&g_sSender, &g_sWire, ui32Now);
+            }
+        }
+        ISOTPPoll(&g_sSender, ui32Now);
+        ISOTPPoll(&g_sReceiver, ui32Now);
+
+        eStatus = ISOTPRxStatus(&g_sReceiver, &ui32RxLen);
+        if (ISOTPTxStatus(&g_sSender) == ISOTP_ERROR) {
+            eStatus = ISOTP_ERROR;
+        }
+    }
+
+    if (eStatus == ISOTP_DONE) {
+        CHECK(ui32RxLen == ui32Len);
+        CHECK(memcmp(g_pui8Tx, g_pui8Rx, ui32Len) == 0);
+    }
+    if (pui32Ticks) {
+        *pui32Ticks = ui32Now;
+    }
+    return eStatus;
+}
+
+// Consecutive frames needed after a first frame carrying ui32First bytes
+static uint32_t consecutiveFrames(uint32_t ui32Len, uint32_t ui32First) {
+    return (ui32Len - ui32First + 6) / 7;
+}
+
+int main(void) {
+    uint32_t ui32Fast;
+    uint32_t ui32Slow;
+
+    // Single frames
+    CHECK(transfer(1, 0, 0, sizeof(g_pui8Rx), 0) == ISOTP_DONE);
+    CHECK(g_pui32Sent[0] == 1 && g_pui32Sent[1] == 0 && g_pui32Sent[2] == 0);
+    CHECK(transfer(7, 0, 0, sizeof(g_pui8Rx), 0) == ISOTP_DONE);
+    CHECK(g_pui32Sent[0] == 1 && g_pui32Sent[1] == 0);
+
+    // Shortest and longest classic first frame
+    CHECK(transfer(8, 0, 0, sizeof(g_pui8Rx), 0) == ISOTP_DONE);
+    CHECK(g_pui32Sent[1] == 1 && g_pui32Sent[2] == 1);
+    CHECK(g_pui8FirstFrame[0] == 0x10 && g_pui8FirstFrame[1] == 8);
+
+    CHECK(transfer(4095, 0, 0, sizeof(g_pui8Rx), 0) == ISOTP_DONE);
+    CHECK(g_pui32Sent[1] == 1 && g_pui32Sent[2] == consecutiveFrames(4095, 6));
+    CHECK(g_ui32FlowControls == 1);
+    CHECK(g_pui8FirstFrame[0] == 0x1F && g_pui8FirstFrame[1] == 0xFF);
+
+    // Longer messages use the 32 bit length escape
+    CHECK(transfer(5000, 0, 0, sizeof(g_pui8Rx), 0) == ISOTP_DONE);
+    CHECK(g_pui32Sent[2] == consecutiveFrames(5000, 2));
+    CHECK(g_pui8FirstFrame[0] == 0x10 && g_pui8FirstFrame[1] == 0);
+    CHECK(g_pui8FirstFrame[4] == (5000 >> 8) && g_pui8FirstFrame[5] == (5000 & 0xFF));
+
+    // Block size 4 asks for a flow control after every 4 frames
+    CHECK(transfer(300, 4, 0, sizeof(g_pui8Rx), 0) == ISOTP_DONE);
+    CHECK(g_pui32Sent[2] == consecutiveFrames(300, 6));
+    CHECK(g_ui32FlowControls == 1 + (consecutiveFrames(300, 6) - 1) / 4);
+
+    // STmin of 2 ms slows the transfer down accordingly
+    CHECK(transfer(100, 0, 0, sizeof(g_pui8Rx), &ui32Fast) == ISOTP_DONE);
+    CHECK(transfer(100, 0, 2, sizeof(g_pui8Rx), &ui32Slow) == ISOTP_DONE);
+    CHECK(ui32Slow >= ui32Fast + (consecutiveFrames(100, 6) - 1) * (2000 - FRAME_TICKS));
+
+    // A message bigger than the receive buffer is refused with an overflow
+    CHECK(transfer(200, 0, 0, 100, 0) == ISOTP_ERROR);
+    CHECK(g_pui32Sent[2] == 0);
+
+    return TEST_DONE();
+}
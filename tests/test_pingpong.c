@@ -0,0 +1,134 @@
+/* test_pingpong.c
+ *
+ * The filled and consumed counts behind the ADC capture buffers, see
+ * TivaWare_Test/pingpong.h. A model of the two uDMA halves records which
+ * fill each buffer holds and whether the hardware is writing it, and the
+ * reader checks that it only ever gets a buffer that is complete, not
+ * being written, and newer than the last one it had, and that every fill
+ * is either read or counted as an overrun.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "pingpong.h"
+#include "test.h"
+
+static tPingPong g_sPingPong;
+
+// Fill number held by each buffer, and the one being written, if any
+static uint32_t g_pui32Holds[2];
+static uint32_t g_ui32Writing;
+static bool g_bWriting;
+
+// The ISR after the hardware completed a buffer: re-arm it, the other one
+// is written next
+static void complete(void) {
+    uint32_t ui32Index = PingPongNextFill(&g_sPingPong);
+
+    g_pui32Holds[ui32Index] = g_sPingPong.ui32Filled;
+    PingPongFilled(&g_sPingPong);
+    g_ui32Writing = ui32Index ^ 1;
+    g_bWriting = true;
+}
+
+static void testBasic(void) {
+    uint32_t ui32Index;
+
+    PingPongInit(&g_sPingPong);
+    CHECK(!PingPongGet(&g_sPingPong, &ui32Index));
+    PingPongRelease(&g_sPingPong);
+    CHECK(g_sPingPong.ui32Consumed == 0);
+
+    // Read in step with the hardware, the buffers alternate
+    complete();
+    CHECK(PingPongGet(&g_sPingPong, &ui32Index));
+    CHECK(ui32Index == 0);
+    PingPongRelease(&g_sPingPong);
+    CHECK(!PingPongGet(&g_sPingPong, &ui32Index));
+    complete();
+    CHECK(PingPongGet(&g_sPingPong, &ui32Index));
+    CHECK(ui32Index == 1);
+    PingPongRelease(&g_sPingPong);
+    CHECK(g_sPingPong.ui32Overruns == 0);
+
+    // Two completed before the reader looked: the first is being written
+    // again, the reader gets the second
+    complete();
+    complete();
+    CHECK(PingPongGet(&g_sPingPong, &ui32Index));
+    CHECK(ui32Index == 1);
+    CHECK(g_sPingPong.ui32Overruns == 1);
+    PingPongRelease(&g_sPingPong);
+    CHECK(!PingPongGet(&g_sPingPong, &ui32Index));
+
+    // Five behind skips four
+    complete();
+    complete();
+    complete();
+    complete();
+    complete();
+    CHECK(PingPongGet(&g_sPingPong, &ui32Index));
+    CHECK(ui32Index == 0);
+    CHECK(g_sPingPong.ui32Overruns == 5);
+
+    // A buffer held while the hardware moves on is released, and the one
+    // completed meanwhile comes next
+    complete();
+    PingPongRelease(&g_sPingPong);
+    CHECK(PingPongGet(&g_sPingPong, &ui32Index));
+    CHECK(ui32Index == 1);
+    PingPongRelease(&g_sPingPong);
+    CHECK(g_sPingPong.ui32Consumed == g_sPingPong.ui32Filled);
+    CHECK(g_sPingPong.ui32Overruns == 5);
+}
+
+// Random interleaving of the ISR and the reader, starting with the counts
+// just short of wrapping
+static void testRandom(uint32_t ui32Start) {
+    uint32_t ui32Seed = 99;
+    uint32_t ui32Reads = 0;
+    uint32_t ui32Last = 0;
+    uint32_t ui32Index;
+    uint32_t ui32Step;
+    uint32_t ui32Fills;
+
+    PingPongInit(&g_sPingPong);
+    g_sPingPong.ui32Filled = ui32Start;
+    g_sPingPong.ui32Consumed = ui32Start;
+    g_bWriting = false;
+
+    for (ui32Step = 0; ui32Step < 100000; ui32Step++) {
+        ui32Seed = ui32Seed * 1103515245 + 12345;
+
+        // Up to three buffers complete between looks
+        for (ui32Fills = (ui32Seed >> 16) & 3; ui32Fills != 0; ui32Fills--) {
+            complete();
+        }
+
+        if (!PingPongGet(&g_sPingPong, &ui32Index)) {
+            CHECK(g_sPingPong.ui32Consumed == g_sPingPong.ui32Filled);
+            continue;
+        }
+
+        // The newest complete fill, in a buffer nobody is writing
+        CHECK(g_pui32Holds[ui32Index] == g_sPingPong.ui32Filled - 1);
+        CHECK(!g_bWriting || (g_ui32Writing != ui32Index));
+        CHECK((ui32Reads == 0) || (g_pui32Holds[ui32Index] - ui32Last - 1 < 0x80000000u));
+        ui32Last = g_pui32Holds[ui32Index];
+        ui32Reads++;
+        PingPongRelease(&g_sPingPong);
+    }
+
+    // Every fill was read or counted
+    CHECK(g_sPingPong.ui32Consumed == g_sPingPong.ui32Filled);
+    CHECK(ui32Reads + g_sPingPong.ui32Overruns == g_sPingPong.ui32Filled - ui32Start);
+}
+
+int main(void) {
+    testBasic();
+    testRandom(0);
+    testRandom(0xFFFFFF00);
+
+    return TEST_DONE();
+}
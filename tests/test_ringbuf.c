@@ -0,0 +1,87 @@
+/* test_ringbuf.c
+ *
+ * Ring buffer capacity, ordering and index wrap, see common/ringbuf.h.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "ringbuf.h"
+#include "test.h"
+
+static uint32_t g_pui32Buf[8];
+
+// Push and pop a few thousand elements starting from the given index, so
+// both the slot index and the 32 bit head/tail counters wrap
+static void testWrap(uint32_t ui32Start) {
+    tRingBuf sRing;
+    uint32_t ui32In = 0;
+    uint32_t ui32Out = 0;
+    uint32_t ui32Value;
+    uint32_t ui32Round;
+
+    CHECK(RingBufInit(&sRing, g_pui32Buf, sizeof(uint32_t), 8));
+    sRing.ui32Head = ui32Start;
+    sRing.ui32Tail = ui32Start;
+
+    for (ui32Round = 0; ui32Round < 1000; ui32Round++) {
+        // Fill by a varying amount, then drain most of it
+        while (RingBufCount(&sRing) < 1 + ui32Round % 8) {
+            CHECK(RingBufPush(&sRing, &ui32In));
+            ui32In++;
+        }
+        while (RingBufCount(&sRing) > ui32Round % 3) {
+            CHECK(RingBufPop(&sRing, &ui32Value));
+            CHECK(ui32Value == ui32Out);
+            ui32Out++;
+        }
+    }
+    while (RingBufPop(&sRing, &ui32Value)) {
+        CHECK(ui32Value == ui32Out);
+        ui32Out++;
+    }
+    CHECK(ui32In == ui32Out);
+}
+
+int main(void) {
+    tRingBuf sRing;
+    uint32_t ui32Value;
+    uint32_t ui32Index;
+    uint32_t *pui32Slot;
+
+    // Only powers of two
+    CHECK(!RingBufInit(&sRing, g_pui32Buf, sizeof(uint32_t), 0));
+    CHECK(!RingBufInit(&sRing, g_pui32Buf, sizeof(uint32_t), 6));
+    CHECK(RingBufInit(&sRing, g_pui32Buf, sizeof(uint32_t), 8));
+
+    // Empty, then exactly eight elements fit
+    CHECK(!RingBufPop(&sRing, &ui32Value));
+    CHECK(RingBufReadPtr(&sRing) == 0);
+    for (ui32Index = 0; ui32Index < 8; ui32Index++) {
+        CHECK(RingBufPush(&sRing, &ui32Index));
+    }
+    CHECK(!RingBufPush(&sRing, &ui32Index));
+    CHECK(RingBufWritePtr(&sRing) == 0);
+    CHECK(RingBufCount(&sRing) == 8);
+
+    // Zero copy side sees the same elements in the same order
+    for (ui32Index = 0; ui32Index < 8; ui32Index++) {
+        pui32Slot = RingBufReadPtr(&sRing);
+        CHECK(pui32Slot != 0 && *pui32Slot == ui32Index);
+        RingBufRelease(&sRing);
+    }
+    CHECK(RingBufCount(&sRing) == 0);
+
+    // A written slot is invisible until committed
+    pui32Slot = RingBufWritePtr(&sRing);
+    CHECK(pui32Slot != 0);
+    *pui32Slot = 42;
+    CHECK(!RingBufPop(&sRing, &ui32Value));
+    RingBufCommit(&sRing);
+    CHECK(RingBufPop(&sRing, &ui32Value) && ui32Value == 42);
+
+    testWrap(0);
+    testWrap(0xFFFFFFF0);
+
+    return TEST_DONE();
+}
@@ -0,0 +1,142 @@
+/* test_ringbuf_spsc.c
+ *
+ * The ring with a real producer and consumer on two threads, see
+ * common/ringbuf.h. Every element carries its sequence number and a
+ * checksum of it across the whole element, so the consumer catches lost,
+ * repeated, reordered and torn elements. Each side alternates between the
+ * copying and the zero copy calls. A small ring keeps both sides hitting
+ * the full and empty cases.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include "ringbuf.h"
+#include "test.h"
+
+#define ELEMENTS                2000000
+#define RING_SIZE               16
+
+typedef struct {
+    uint32_t ui32Seq;
+    uint32_t pui32Fill[6];
+    uint32_t ui32Check;
+} tElem;
+
+static tElem g_psBuf[RING_SIZE];
+static tRingBuf g_sRing;
+
+// Errors seen by the consumer, checked once both threads are done
+static uint32_t g_ui32OutOfOrder;
+static uint32_t g_ui32Torn;
+
+static void elemFill(tElem *psElem, uint32_t ui32Seq) {
+    uint32_t ui32Idx;
+
+    psElem->ui32Seq = ui32Seq;
+    for (ui32Idx = 0; ui32Idx < 6; ui32Idx++) {
+        psElem->pui32Fill[ui32Idx] = ui32Seq * 2654435761u + ui32Idx;
+    }
+    psElem->ui32Check = ~ui32Seq;
+}
+
+static bool elemGood(const tElem *psElem) {
+    uint32_t ui32Idx;
+
+    for (ui32Idx = 0; ui32Idx < 6; ui32Idx++) {
+        if (psElem->pui32Fill[ui32Idx] != psElem->ui32Seq * 2654435761u + ui32Idx) {
+            return false;
+        }
+    }
+    return psElem->ui32Check == ~psElem->ui32Seq;
+}
+
+static void *producer(void *pvArg) {
+    tElem sElem;
+    tElem *psSlot;
+    uint32_t ui32Seq;
+
+    (void)pvArg;
+    for (ui32Seq = 0; ui32Seq < ELEMENTS; ui32Seq++) {
+        if (ui32Seq & 1) {
+            while ((psSlot = RingBufWritePtr(&g_sRing)) == 0) {
+                sched_yield();
+            }
+            elemFill(psSlot, ui32Seq);
+            RingBufCommit(&g_sRing);
+        } else {
+            elemFill(&sElem, ui32Seq);
+            while (!RingBufPush(&g_sRing, &sElem)) {
+                sched_yield();
+            }
+        }
+    }
+    return 0;
+}
+
+static void *consumer(void *pvArg) {
+    tElem sElem;
+    const tElem *psSlot;
+    uint32_t ui32Seq;
+
+    (void)pvArg;
+    for (ui32Seq = 0; ui32Seq < ELEMENTS; ui32Seq++) {
+        if (ui32Seq & 2) {
+            while ((psSlot = RingBufReadPtr(&g_sRing)) == 0) {
+                sched_yield();
+            }
+            sElem = *psSlot;
+            RingBufRelease(&g_sRing);
+        } else {
+            while (!RingBufPop(&g_sRing, &sElem)) {
+                sched_yield();
+            }
+        }
+
+        if (sElem.ui32Seq != ui32Seq) {
+            g_ui32OutOfOrder++;
+        }
+        if (!elemGood(&sElem)) {
+            g_ui32Torn++;
+        }
+    }
+    return 0;
+}
+
+static double now(void) {
+    struct timespec sTime;
+
+    clock_gettime(CLOCK_MONOTONIC, &sTime);
+    return (double)sTime.tv_sec + (double)sTime.tv_nsec / 1e9;
+}
+
+int main(void) {
+    pthread_t sProducer;
+    pthread_t sConsumer;
+    double dStart;
+    double dSeconds;
+
+    CHECK(RingBufInit(&g_sRing, g_psBuf, sizeof(tElem), RING_SIZE));
+
+    dStart = now();
+    CHECK(pthread_create(&sConsumer, 0, consumer, 0) == 0);
+    CHECK(pthread_create(&sProducer, 0, producer, 0) == 0);
+    CHECK(pthread_join(sProducer, 0) == 0);
+    CHECK(pthread_join(sConsumer, 0) == 0);
+    dSeconds = now() - dStart;
+
+    CHECK(g_ui32OutOfOrder == 0);
+    CHECK(g_ui32Torn == 0);
+    CHECK(RingBufCount(&g_sRing) == 0);
+    CHECK(g_sRing.ui32Head == ELEMENTS);
+
+    printf("%s: %u elements of %u bytes through %u slots, %.0f elements/s\n",
+           __FILE__, (unsigned)ELEMENTS, (unsigned)sizeof(tElem), (unsigned)RING_SIZE,
+           ELEMENTS / dSeconds);
+
+    return TEST_DONE();
+}
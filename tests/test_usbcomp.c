@@ -0,0 +1,236 @@
+/* test_usbcomp.c
+ *
+ * The telemetry interface of the composite keyboard, mouse and telemetry
+ * device, see HID_Test/USBCOMP.h, against the usblib generic HID fake.
+ *
+ * A sender like telemFxn in HID_Test/empty_min.c keeps the queue full of
+ * test reports, backing off 1 ms whenever it is refused, while the host
+ * reads for 10 s and checks the sequence numbers and the running word
+ * counter. The bytes/s the host received are printed at the 1 ms interval
+ * the interface's endpoint descriptor asks for and at usblib's default of
+ * 16 ms. A host that stops reading for 100 ms loses the reports hidraw has
+ * no room for, and the sequence gap must show exactly those.
+ *
+ * OUT reports and SET_REPORT must reach the command callback, GET_REPORT
+ * must return the last report sent, and nothing is queued while the device
+ * is disconnected.
+ */
+
+#include "../HID_Test/USBCOMP.c"
+
+#include <string.h>
+
+#include "driverlib/sysctl.h"
+
+#include "test.h"
+
+#define RUN_MS                  10000
+
+#define MS(x)                   ((uint64_t)(x) * (FakeClockHz() / 1000))
+
+#define WORDS                   (USBCOMP_TELEM_MAX_DATA / sizeof(uint32_t))
+
+// What the host has read
+static uint32_t g_ui32Reports;
+static uint32_t g_ui32Lost;
+static uint32_t g_ui32BadWords;
+static uint16_t g_ui16NextSeq;
+static uint32_t g_ui32NextWord;
+
+// Sender
+static uint32_t g_ui32Counter;
+static uint32_t g_ui32Refused;
+
+// Command callback
+static uint8_t g_pui8Command[USBCOMP_TELEM_SIZE];
+static uint32_t g_ui32CommandLen;
+static uint32_t g_ui32Commands;
+
+static Void command(const uint8_t *data, unsigned int length) {
+    CHECK(FakeIntActive() == INT_USB0);
+    memcpy(g_pui8Command, data, length);
+    g_ui32CommandLen = length;
+    g_ui32Commands++;
+}
+
+static void connect(void) {
+    FakeReset();
+    SysCtlClockSet(SYSCTL_SYSDIV_2_5 | SYSCTL_USE_PLL | SYSCTL_OSC_MAIN | SYSCTL_XTAL_16MHZ);
+    telemHead = telemTail = 0;
+    telemSequence = 0;
+    memset(&stats, 0, sizeof(stats));
+    USBCOMP_init(command);
+    FakeUSBConnect();
+    CHECK(USBCOMP_waitForConnect(BIOS_WAIT_FOREVER));
+
+    g_ui32Reports = 0;
+    g_ui32Lost = 0;
+    g_ui32BadWords = 0;
+    g_ui16NextSeq = 0;
+    g_ui32NextWord = 0;
+    g_ui32Counter = 0;
+    g_ui32Refused = 0;
+    g_ui32Commands = 0;
+}
+
+// Decode every report the host has received, as tools/hidtelem.py does
+static void hostRead(void) {
+    const USBCOMP_TelemHeader *psHeader;
+    uint8_t pui8Report[USBCOMP_TELEM_SIZE];
+    uint32_t ui32Word;
+    uint16_t ui16Gap;
+
+    while (FakeUSBHIDRead(&telemDevice, pui8Report, sizeof(pui8Report)) ==
+           USBCOMP_TELEM_SIZE) {
+        psHeader = (const USBCOMP_TelemHeader *)pui8Report;
+        CHECK(psHeader->type == USBCOMP_TELEM_TEST);
+        CHECK(psHeader->length == WORDS * sizeof(uint32_t));
+
+        ui16Gap = psHeader->sequence - g_ui16NextSeq;
+        g_ui32Lost += ui16Gap;
+        g_ui16NextSeq = psHeader->sequence + 1;
+
+        // The words only skip those of the reports lost
+        memcpy(&ui32Word, &pui8Report[USBCOMP_TELEM_HDR_SIZE], sizeof(ui32Word));
+        if (ui32Word != g_ui32NextWord + ui16Gap * WORDS) {
+            g_ui32BadWords++;
+        }
+        g_ui32NextWord = ui32Word + WORDS;
+        g_ui32Reports++;
+    }
+}
+
+// telemFxn's loop: send until refused, then sleep 1 ms
+static void send(void) {
+    uint32_t pui32Words[WORDS];
+    uint32_t ui32Idx;
+
+    for (;;) {
+        for (ui32Idx = 0; ui32Idx < WORDS; ui32Idx++) {
+            pui32Words[ui32Idx] = g_ui32Counter + ui32Idx;
+        }
+        if (!USBCOMP_telemSend(USBCOMP_TELEM_TEST, pui32Words, sizeof(pui32Words))) {
+            g_ui32Refused++;
+            return;
+        }
+        g_ui32Counter += WORDS;
+    }
+}
+
+// Run the sender and the bus for ui32Ms, the host reading unless bDeaf
+static void stream(uint32_t ui32Ms, bool bDeaf) {
+    uint64_t ui64End = g_ui64FakeTicks + MS(ui32Ms);
+    uint64_t ui64Wake;
+
+    while (g_ui64FakeTicks < ui64End) {
+        send();
+        ui64Wake = g_ui64FakeTicks + MS(1);
+        while (FakeEventRun(ui64Wake)) {
+        }
+        if (!bDeaf) {
+            hostRead();
+        }
+    }
+}
+
+static void testThroughput(void) {
+    static const uint32_t pui32PollMs[] = { 1, 16 };
+    uint32_t ui32Idx;
+    double dRate;
+
+    for (ui32Idx = 0; ui32Idx < 2; ui32Idx++) {
+        connect();
+        CHECK(FakeUSBHIDPollMs(&telemDevice) == 1);
+        FakeUSBHIDPollSet(&telemDevice, pui32PollMs[ui32Idx]);
+
+        stream(RUN_MS, false);
+
+        // One report per poll, none lost or out of order
+        CHECK(g_ui32Reports == RUN_MS / pui32PollMs[ui32Idx]);
+        CHECK(g_ui32Lost == 0);
+        CHECK(g_ui32BadWords == 0);
+        CHECK(stats.sent == g_ui32Reports);
+        CHECK(stats.dropped == g_ui32Refused);
+
+        dRate = (double)g_ui32Reports * USBCOMP_TELEM_SIZE * 1000.0 / RUN_MS;
+        printf("  polled every %2u ms: %5.0f bytes/s, %5.0f of it data, sender refused %u times\n",
+               (unsigned)pui32PollMs[ui32Idx], dRate,
+               dRate * USBCOMP_TELEM_MAX_DATA / USBCOMP_TELEM_SIZE, (unsigned)g_ui32Refused);
+    }
+}
+
+static void testHostStall(void) {
+    uint32_t ui32Overflows;
+
+    connect();
+    stream(1000, false);
+    stream(100, true);
+    hostRead();
+    stream(1000, false);
+    ui32Overflows = FakeUSBHIDOverflows(&telemDevice);
+
+    // The host could keep 64 of the 100 reports it did not read
+    CHECK(ui32Overflows == 100 - 64);
+    CHECK(g_ui32Lost == ui32Overflows);
+    CHECK(g_ui32BadWords == 0);
+    CHECK(g_ui32Reports + g_ui32Lost == stats.sent);
+    printf("  host stalled 100 ms: %u reports lost, %u counted from the sequence gap\n",
+           (unsigned)ui32Overflows, (unsigned)g_ui32Lost);
+}
+
+static void testCommands(void) {
+    static const uint8_t pui8Start[2] = { USBCOMP_CMD_STREAM, 1 };
+    static const uint8_t pui8Reset[1] = { USBCOMP_CMD_RESET_STATS };
+    uint8_t pui8Report[USBCOMP_TELEM_SIZE];
+    uint32_t ui32Word = 1234;
+
+    connect();
+
+    // An OUT report, and the next one once the first was read
+    CHECK(FakeUSBHIDWrite(&telemDevice, pui8Start, sizeof(pui8Start)));
+    CHECK(g_ui32Commands == 1);
+    CHECK(g_ui32CommandLen == sizeof(pui8Start));
+    CHECK(memcmp(g_pui8Command, pui8Start, sizeof(pui8Start)) == 0);
+    CHECK(FakeUSBHIDWrite(&telemDevice, pui8Reset, sizeof(pui8Reset)));
+    CHECK(g_ui32Commands == 2);
+    CHECK(g_pui8Command[0] == USBCOMP_CMD_RESET_STATS);
+
+    // SET_REPORT on the control endpoint
+    FakeUSBHIDSetReport(&telemDevice, pui8Start, sizeof(pui8Start));
+    CHECK(g_ui32Commands == 3);
+    CHECK(memcmp(g_pui8Command, pui8Start, sizeof(pui8Start)) == 0);
+    CHECK(stats.commands == 3);
+
+    // GET_REPORT returns the last report the host took
+    CHECK(USBCOMP_telemSend(USBCOMP_TELEM_STATS, &ui32Word, sizeof(ui32Word)));
+    while (FakeEventRun(FakeEventNext())) {
+    }
+    CHECK(stats.sent == 1);
+    CHECK(FakeUSBHIDGetReport(&telemDevice, pui8Report, sizeof(pui8Report)) ==
+          USBCOMP_TELEM_SIZE);
+    CHECK(pui8Report[0] == USBCOMP_TELEM_STATS);
+    CHECK(pui8Report[1] == sizeof(ui32Word));
+    CHECK(memcmp(&pui8Report[USBCOMP_TELEM_HDR_SIZE], &ui32Word, sizeof(ui32Word)) == 0);
+
+    // The keyboard and mouse share the bus
+    CHECK(USBCOMP_keyStateChange(0, HID_KEYB_USAGE_A, true));
+    CHECK(USBCOMP_mouseMove(1, -1, 0));
+
+    // Nothing is queued while disconnected, and what was queued is dropped
+    CHECK(USBCOMP_telemSend(USBCOMP_TELEM_STATS, &ui32Word, sizeof(ui32Word)));
+    CHECK(USBCOMP_telemSend(USBCOMP_TELEM_STATS, &ui32Word, sizeof(ui32Word)));
+    FakeUSBDisconnect();
+    CHECK(!connected);
+    CHECK(telemHead == telemTail);
+    CHECK(!USBCOMP_telemSend(USBCOMP_TELEM_STATS, &ui32Word, sizeof(ui32Word)));
+    CHECK(stats.dropped == 1);
+    CHECK(!USBCOMP_mouseMove(1, -1, 0));
+}
+
+int main(void) {
+    testThroughput();
+    testHostStall();
+    testCommands();
+
+    return TEST_DONE();
+}
@@ -0,0 +1,197 @@
+/* test_usbkbd.c
+ *
+ * Fast typing in the keyboard device's USBKBD_putString and the queued
+ * USBKBD_write, see hidTestKeyboardDevice/USBKBD.h, against the usblib
+ * fake. Each string is typed once with USBKBD_putString and once a
+ * character at a time with USBKBD_putChar, which is what USBKBD_putString
+ * did before and still does with USBKBD_FAST_TYPING 0. The host must see
+ * the same text both ways, and fast typing must need fewer reports. The
+ * report counts are printed.
+ *
+ * USBKBD_write is typed from the USB interrupt, so it must get the same
+ * text to the host without the task ever being woken. The wakeups, the
+ * usblib calls made from the task and the reports are printed for both.
+ */
+
+#include "../hidTestKeyboardDevice/USBKBD.c"
+
+#include <string.h>
+
+#include "driverlib/sysctl.h"
+
+#include "test.h"
+
+static const char *g_ppcStrings[] = {
+    "TI-RTOS controls USB.\n",
+    "hello world",
+    "The quick brown fox jumps over the lazy dog.\n",
+    "ABCDEFghijkl123456",
+    "aaaa bbbb AAAA",
+    "!@#$%^&*()_+{}|:\"<>?~",
+};
+
+#define STRINGS                 (sizeof(g_ppcStrings) / sizeof(g_ppcStrings[0]))
+
+// A connected keyboard on a freshly reset bus
+static void connect(void) {
+    FakeReset();
+    SysCtlClockSet(SYSCTL_SYSDIV_2_5 | SYSCTL_USE_PLL | SYSCTL_OSC_MAIN | SYSCTL_XTAL_16MHZ);
+    USBKBD_init();
+    FakeUSBConnect();
+    CHECK(USBKBD_waitForConnect(BIOS_WAIT_FOREVER));
+}
+
+// Type pcString and return the reports it took. The host must have seen
+// exactly pcString.
+static uint32_t type(const char *pcString, bool bFast) {
+    char pcTyped[128];
+    uint32_t ui32Len = strlen(pcString);
+    uint32_t ui32Idx;
+
+    connect();
+    if (bFast) {
+        CHECK(USBKBD_putString((String)pcString, ui32Len, 100) == (int)ui32Len);
+    } else {
+        for (ui32Idx = 0; ui32Idx < ui32Len; ui32Idx++) {
+            CHECK(USBKBD_putChar(pcString[ui32Idx], 100) == pcString[ui32Idx]);
+        }
+    }
+
+    // Every key is up again at the end
+    CHECK(keyboardDevice.sPrivateData.ui8KeyCount == 0);
+
+    FakeUSBTyped(pcTyped, sizeof(pcTyped));
+    CHECK(strcmp(pcTyped, pcString) == 0);
+    return FakeUSBReports();
+}
+
+static void testStrings(void) {
+    uint32_t ui32Fast;
+    uint32_t ui32Slow;
+    uint32_t ui32Idx;
+
+    for (ui32Idx = 0; ui32Idx < STRINGS; ui32Idx++) {
+        ui32Slow = type(g_ppcStrings[ui32Idx], false);
+        ui32Fast = type(g_ppcStrings[ui32Idx], true);
+
+        // A press and a release per character, then at most one report per
+        // character plus the final release
+        CHECK(ui32Slow == 2 * strlen(g_ppcStrings[ui32Idx]));
+        CHECK(ui32Fast < ui32Slow);
+        printf("  %-46.*s %3u reports a character at a time, %3u fast\n",
+               (int)strcspn(g_ppcStrings[ui32Idx], "\n"), g_ppcStrings[ui32Idx],
+               (unsigned)ui32Slow, (unsigned)ui32Fast);
+    }
+}
+
+// Up to six distinct keys with one modifier share a report, a repeat or a
+// modifier change costs a release. usblib sends the first key change on an
+// idle endpoint at once, so a batch staged then goes out as its first key
+// and the rest of it.
+static void testPacking(void) {
+    CHECK(type("a", true) == 2);
+    CHECK(type("abcdef", true) == 3);
+    CHECK(type("abcdefg", true) == 4);
+    CHECK(type("aa", true) == 4);
+    CHECK(type("aA", true) == 4);
+    CHECK(type("", true) == 0);
+}
+
+static uint32_t g_ui32WriteDone;
+static uint32_t g_ui32WriteCount;
+
+static Void writeDone(unsigned int count) {
+    g_ui32WriteDone++;
+    g_ui32WriteCount = count;
+}
+
+// Let the host poll until the write callback has run
+static void waitWrite(void) {
+    while (!g_ui32WriteDone && (FakeEventNext() != UINT64_MAX)) {
+        FakeEventRun(FakeEventNext());
+    }
+}
+
+static void testWrite(void) {
+    char pcTyped[128];
+    uint32_t ui32SlowWakeups;
+    uint32_t ui32Wakeups;
+    uint32_t ui32Len;
+    uint32_t ui32Idx;
+
+    for (ui32Idx = 0; ui32Idx < STRINGS; ui32Idx++) {
+        ui32Len = strlen(g_ppcStrings[ui32Idx]);
+
+        // The blocking calls sleep until each report has gone
+        type(g_ppcStrings[ui32Idx], false);
+        ui32SlowWakeups = FakeSemaphoreWakeups();
+        connect();
+        CHECK(USBKBD_putString((String)g_ppcStrings[ui32Idx], ui32Len, 100) == (int)ui32Len);
+        ui32Wakeups = FakeSemaphoreWakeups();
+
+        // The queued one returns at once and is typed from the interrupt
+        connect();
+        g_ui32WriteDone = 0;
+        CHECK(USBKBD_write((String)g_ppcStrings[ui32Idx], ui32Len, writeDone) == ui32Len);
+        CHECK(!g_ui32WriteDone);
+        waitWrite();
+        CHECK(g_ui32WriteDone == 1);
+        CHECK(g_ui32WriteCount == ui32Len);
+        CHECK(FakeSemaphoreWakeups() == 0);
+        CHECK(FakeUSBKeyCalls(true) > FakeUSBKeyCalls(false));
+        FakeUSBTyped(pcTyped, sizeof(pcTyped));
+        CHECK(strcmp(pcTyped, g_ppcStrings[ui32Idx]) == 0);
+
+        printf("  %-46.*s woken %2u times by putChar, %2u by putString, %u by write, "
+               "which made %u usblib calls from the task and %2u reports\n",
+               (int)strcspn(g_ppcStrings[ui32Idx], "\n"), g_ppcStrings[ui32Idx],
+               (unsigned)ui32SlowWakeups, (unsigned)ui32Wakeups,
+               (unsigned)FakeSemaphoreWakeups(), (unsigned)FakeUSBKeyCalls(false),
+               (unsigned)FakeUSBReports());
+    }
+
+    // A blocking call after queued writes waits for them, the host sees
+    // everything in order, and flush returns at once when nothing is queued
+    connect();
+    g_ui32WriteDone = 0;
+    CHECK(USBKBD_write("queued ", 100, NULL) == 7);
+    CHECK(USBKBD_write("twice, ", 100, writeDone) == 7);
+    CHECK(USBKBD_putString("then blocking", 100, 100) == 13);
+    CHECK(USBKBD_write(" and queued", 100, writeDone) == 11);
+    CHECK(USBKBD_flush(1000));
+    CHECK(USBKBD_flush(0));
+    CHECK(g_ui32WriteDone == 2);
+    FakeUSBTyped(pcTyped, sizeof(pcTyped));
+    CHECK(strcmp(pcTyped, "queued twice, then blocking and queued") == 0);
+
+    // The queue is bounded. The first batch of keys has left it by the
+    // time the write returns, so a few more fit.
+    connect();
+    memset(pcTyped, 'x', sizeof(pcTyped));
+    ui32Len = 0;
+    for (ui32Idx = 0; ui32Idx < 4; ui32Idx++) {
+        ui32Len += USBKBD_write(pcTyped, sizeof(pcTyped), NULL);
+    }
+    CHECK(ui32Len >= USBKBD_TXQUEUE_SIZE);
+    CHECK(ui32Len <= USBKBD_TXQUEUE_SIZE + 6);
+    CHECK(USBKBD_write(pcTyped, sizeof(pcTyped), NULL) == 0);
+    CHECK(USBKBD_flush(BIOS_WAIT_FOREVER));
+    CHECK(USBKBD_write(pcTyped, sizeof(pcTyped), NULL) == sizeof(pcTyped));
+
+    // A disconnect drops the rest and reports how much was taken
+    g_ui32WriteDone = 0;
+    CHECK(USBKBD_write(pcTyped, 10, writeDone) == 10);
+    FakeUSBDisconnect();
+    CHECK(g_ui32WriteDone == 1);
+    CHECK(g_ui32WriteCount < sizeof(pcTyped) + 10);
+    CHECK(!USBKBD_flush(0));
+    CHECK(USBKBD_write("late", 4, writeDone) == 0);
+}
+
+int main(void) {
+    testStrings();
+    testPacking();
+    testWrite();
+
+    return TEST_DONE();
+}
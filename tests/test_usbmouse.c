@@ -0,0 +1,236 @@
+/* test_usbmouse.c
+ *
+ * The 1 ms mouse, see hidTestMouseDevice/usbhidmouse.h, against the usblib
+ * generic HID fake. Motion at 1, 8 and 64 moves per ms, with a left click
+ * every 100 ms, runs for 8 s and then the mouse is left idle for 2 s. The
+ * host must end up with the same X, Y and wheel totals and the same
+ * clicks, however much had to be merged or carried over.
+ *
+ * The backlog is the motion in the mouse's accumulators, not yet written
+ * to the endpoint, and its age the time since they were last empty; what
+ * is written reaches the host at the next poll. The worst age is printed
+ * for each rate: it stays within a poll at 1 move per ms and a few polls at
+ * 8, and at 64, more than the +/-127 a report can carry, it grows until the
+ * motion stops.
+ */
+
+#include "../hidTestMouseDevice/usbhidmouse.c"
+
+#include <string.h>
+
+#include "driverlib/sysctl.h"
+
+#include "test.h"
+
+#define MOTION_MS               8000
+#define IDLE_MS                 2000
+#define CLICK_MS                100
+
+#define MS(x)                   ((uint64_t)(x) * (FakeClockHz() / 1000))
+
+// Totals passed to USBMouseMove() and decoded by the host
+static int32_t g_pi32Moved[3];
+static int32_t g_pi32Seen[3];
+static uint32_t g_ui32Clicks;
+static uint32_t g_ui32SeenClicks;
+static uint8_t g_ui8SeenButtons;
+
+static uint32_t g_ui32Seed;
+
+// When the accumulators were last empty, and the longest they were not
+static uint64_t g_ui64Empty;
+static uint64_t g_ui64Worst;
+
+static int32_t jitter(int32_t i32Max) {
+    g_ui32Seed = g_ui32Seed * 1103515245 + 12345;
+    return (int32_t)((g_ui32Seed >> 8) % (uint32_t)(2 * i32Max + 1)) - i32Max;
+}
+
+static void connect(void) {
+    FakeReset();
+    SysCtlClockSet(SYSCTL_SYSDIV_2_5 | SYSCTL_USE_PLL | SYSCTL_OSC_MAIN | SYSCTL_XTAL_16MHZ);
+    IntRegister(INT_USB0, USB0DeviceIntHandler);
+    IntEnable(INT_USB0);
+    memset(&g_sUSBMouseStats, 0, sizeof(g_sUSBMouseStats));
+    USBMouseInit();
+    FakeUSBConnect();
+    CHECK(USBMouseConnected());
+
+    memset(g_pi32Moved, 0, sizeof(g_pi32Moved));
+    memset(g_pi32Seen, 0, sizeof(g_pi32Seen));
+    g_ui32Clicks = 0;
+    g_ui32SeenClicks = 0;
+    g_ui8SeenButtons = 0;
+    g_ui64Empty = 0;
+    g_ui64Worst = 0;
+}
+
+// Decode every report the host has taken
+static void hostRead(void) {
+    uint8_t pui8Report[8];
+    uint32_t ui32Len;
+
+    while ((ui32Len = FakeUSBHIDRead(&g_sMouseDevice, pui8Report, sizeof(pui8Report))) != 0) {
+        CHECK((ui32Len == 3) || (ui32Len == 4));
+        if ((pui8Report[0] & MOUSE_BUTTON_LEFT) && !(g_ui8SeenButtons & MOUSE_BUTTON_LEFT)) {
+            g_ui32SeenClicks++;
+        }
+        g_ui8SeenButtons = pui8Report[0];
+        g_pi32Seen[0] += (int8_t)pui8Report[1];
+        g_pi32Seen[1] += (int8_t)pui8Report[2];
+        if (ui32Len == 4) {
+            g_pi32Seen[2] += (int8_t)pui8Report[3];
+        }
+    }
+}
+
+static bool hostHasAll(void) {
+    return (g_pi32Seen[0] == g_pi32Moved[0]) && (g_pi32Seen[1] == g_pi32Moved[1]) &&
+           (g_pi32Seen[2] == g_pi32Moved[2]);
+}
+
+static void backlog(void) {
+    if ((g_i32AccX == 0) && (g_i32AccY == 0) && (g_i32AccWheel == 0)) {
+        g_ui64Empty = g_ui64FakeTicks;
+    } else if (g_ui64FakeTicks - g_ui64Empty > g_ui64Worst) {
+        g_ui64Worst = g_ui64FakeTicks - g_ui64Empty;
+    }
+}
+
+// Let the host poll until ui64Until
+static void runUntil(uint64_t ui64Until) {
+    while (FakeEventRun(ui64Until)) {
+        backlog();
+        hostRead();
+    }
+    hostRead();
+}
+
+// Returns the worst backlog age in ms
+static double motion(uint32_t ui32PerMs, int32_t i32Max) {
+    uint64_t ui64Ms = MS(1);
+    uint64_t ui64Step = ui64Ms / ui32PerMs;
+    uint32_t ui32Steps = MOTION_MS * ui32PerMs;
+    uint32_t ui32Step;
+    uint8_t ui8Buttons = 0;
+    int32_t pi32Delta[3];
+
+    g_ui32Seed = ui32PerMs;
+    for (ui32Step = 0; ui32Step < ui32Steps; ui32Step++) {
+        // Half a step off the poll boundaries
+        runUntil(ui32Step * ui64Step + ui64Step / 2);
+        backlog();
+
+        // Press for half of every CLICK_MS
+        if ((ui32Step % (CLICK_MS * ui32PerMs)) == 0) {
+            ui8Buttons = MOUSE_BUTTON_LEFT;
+            g_ui32Clicks++;
+        } else if ((ui32Step % (CLICK_MS * ui32PerMs)) == CLICK_MS * ui32PerMs / 2) {
+            ui8Buttons = 0;
+        }
+
+        pi32Delta[0] = jitter(i32Max);
+        pi32Delta[1] = jitter(i32Max);
+        pi32Delta[2] = jitter(i32Max / 8);
+
+        // A click not sent yet turns the call away until the next poll
+        while (!USBMouseMove(pi32Delta[0], pi32Delta[1], pi32Delta[2], ui8Buttons)) {
+            runUntil(FakeEventNext());
+        }
+        g_pi32Moved[0] += pi32Delta[0];
+        g_pi32Moved[1] += pi32Delta[1];
+        g_pi32Moved[2] += pi32Delta[2];
+        backlog();
+    }
+
+    // Idle, with the button released
+    while (!USBMouseMove(0, 0, 0, 0)) {
+        runUntil(FakeEventNext());
+    }
+    runUntil(g_ui64FakeTicks + IDLE_MS * ui64Ms);
+    return (double)g_ui64Worst / (double)ui64Ms;
+}
+
+static void testRates(void) {
+    static const uint32_t pui32PerMs[] = { 1, 8, 64 };
+    static const int32_t pi32Max[] = { 5, 40, 127 };
+    double dWorst;
+    uint32_t ui32Idx;
+
+    for (ui32Idx = 0; ui32Idx < 3; ui32Idx++) {
+        connect();
+        CHECK(FakeUSBHIDPollMs(&g_sMouseDevice) == 1);
+
+        dWorst = motion(pui32PerMs[ui32Idx], pi32Max[ui32Idx]);
+
+        // Everything arrived, nothing overflowed the host and the
+        // endpoint went quiet
+        CHECK(hostHasAll());
+        CHECK(g_ui32SeenClicks == g_ui32Clicks);
+        CHECK(g_ui8SeenButtons == 0);
+        CHECK(FakeUSBHIDOverflows(&g_sMouseDevice) == 0);
+        CHECK(FakeEventNext() == UINT64_MAX);
+        CHECK(g_sUSBMouseStats.ui32Reports == FakeUSBHIDReports(&g_sMouseDevice));
+        CHECK(g_sUSBMouseStats.ui32Moves == MOTION_MS * pui32PerMs[ui32Idx] + 1);
+
+        if (pui32PerMs[ui32Idx] == 1) {
+            CHECK(dWorst <= 1.0);
+        } else if (pui32PerMs[ui32Idx] == 8) {
+            CHECK(dWorst <= 8.0);
+        } else {
+            CHECK(dWorst > 100.0);
+        }
+        printf("  %2u moves/ms of +/-%-3d %5u reports, %3u clicks (%u calls retried), "
+               "backlog at most %.1f ms\n",
+               (unsigned)pui32PerMs[ui32Idx], (int)pi32Max[ui32Idx],
+               (unsigned)g_sUSBMouseStats.ui32Reports, (unsigned)g_ui32SeenClicks,
+               (unsigned)g_sUSBMouseStats.ui32ButtonRetries, dWorst);
+    }
+}
+
+// Boot protocol drops the wheel and sends 3 bytes, GET_REPORT returns the
+// last report, and a disconnect drops what is left
+static void testProtocol(void) {
+    uint8_t pui8Report[8];
+
+    connect();
+    FakeUSBHIDSetProtocol(&g_sMouseDevice, USB_HID_PROTOCOL_BOOT);
+    CHECK(USBMouseMove(10, -20, 5, MOUSE_BUTTON_RIGHT));
+    runUntil(MS(2));
+    CHECK(FakeUSBHIDReports(&g_sMouseDevice) == 1);
+    CHECK(g_pi32Seen[0] == 10);
+    CHECK(g_pi32Seen[1] == -20);
+    CHECK(g_pi32Seen[2] == 0);
+    CHECK(g_ui8SeenButtons == MOUSE_BUTTON_RIGHT);
+
+    CHECK(FakeUSBHIDGetReport(&g_sMouseDevice, pui8Report, sizeof(pui8Report)) == 3);
+    CHECK(pui8Report[0] == MOUSE_BUTTON_RIGHT);
+    CHECK((int8_t)pui8Report[1] == 10);
+    CHECK((int8_t)pui8Report[2] == -20);
+
+    // Back to the report protocol, more than one report's worth
+    FakeUSBHIDSetProtocol(&g_sMouseDevice, USB_HID_PROTOCOL_REPORT);
+    CHECK(USBMouseMove(300, 0, -3, 0));
+    runUntil(MS(10));
+    CHECK(FakeUSBHIDReports(&g_sMouseDevice) == 4);
+    CHECK(g_pi32Seen[0] == 310);
+    CHECK(g_pi32Seen[2] == -3);
+    CHECK(FakeUSBHIDGetReport(&g_sMouseDevice, pui8Report, sizeof(pui8Report)) == 4);
+
+    // Motion sent while disconnected goes nowhere, and a new connection
+    // starts from nothing
+    CHECK(USBMouseMove(1000, 0, 0, 0));
+    FakeUSBDisconnect();
+    CHECK(!USBMouseConnected());
+    CHECK(USBMouseMove(5, 5, 0, 0));
+    runUntil(MS(500));
+    CHECK(FakeUSBHIDReports(&g_sMouseDevice) <= 5);
+    CHECK(FakeEventNext() == UINT64_MAX);
+}
+
+int main(void) {
+    testRates();
+    testProtocol();
+
+    return TEST_DONE();
+}
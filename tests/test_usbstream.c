@@ -0,0 +1,234 @@
+/* test_usbstream.c
+ *
+ * The CDC sample stream, see TivaWare_Test/usbstream.h, against the usblib
+ * CDC fake, whose host reads the bulk IN endpoint with 19 tokens a frame.
+ *
+ * A producer offers a 64 sample block every 100 us, more than full speed
+ * bulk can carry, for 2 s. The host decodes every block: the sync word and
+ * sample count, the samples themselves, and the per source sequence gaps,
+ * which must add up to the blocks dropped. The MB/s it received are printed
+ * with the double buffered FIFO the stream asks for and with it single
+ * buffered, while 0, 5 and 20% of the USB interrupts are held off 150 us.
+ * Double buffering must never be slower, and with interrupts held off it
+ * must be faster.
+ *
+ * At 400 kS/s, a 256 sample block every 640 us, the stream keeps up either
+ * way and nothing is dropped.
+ */
+
+#include "../TivaWare_Test/usbstream.c"
+
+#include <string.h>
+
+#include "driverlib/sysctl.h"
+
+#include "test.h"
+
+#define RUN_MS                  2000
+#define HOLD_US                 150
+
+#define US(x)                   ((uint64_t)(x) * (FakeClockHz() / 1000000))
+
+#define HEADER_SIZE             sizeof(tUSBStreamHeader)
+
+// What the host has read and not decoded yet, at most one block and a read
+static uint8_t g_pui8Host[HEADER_SIZE + 512 + 4096];
+static uint32_t g_ui32HostLen;
+
+static uint32_t g_ui32Blocks;
+static uint32_t g_ui32Missed;
+static uint32_t g_ui32BadBlocks;
+static uint16_t g_ui16NextSeq;
+static uint64_t g_ui64Samples;
+
+static void connect(bool bSingle, uint32_t ui32HoldPct) {
+    FakeReset();
+    SysCtlClockSet(SYSCTL_SYSDIV_2_5 | SYSCTL_USE_PLL | SYSCTL_OSC_MAIN | SYSCTL_XTAL_16MHZ);
+    FakeUSBEndpointSingle(bSingle);
+    FakeUSBCDCHoldOff(ui32HoldPct, HOLD_US);
+    g_ui32USBStreamDrops = 0;
+    g_ui32USBStreamPackets = 0;
+    g_ui32USBStreamFill = 0;
+    g_bUSBStreamConnected = false;
+    g_bUSBStreamOpen = false;
+    memset(g_pui16USBStreamSeq, 0, sizeof(g_pui16USBStreamSeq));
+    USBStreamInit();
+
+    FakeUSBConnect();
+    CHECK(!USBStreamActive());
+    FakeUSBCDCOpen(true);
+    CHECK(USBStreamActive());
+
+    g_ui32HostLen = 0;
+    g_ui32Blocks = 0;
+    g_ui32Missed = 0;
+    g_ui32BadBlocks = 0;
+    g_ui16NextSeq = 0;
+    g_ui64Samples = 0;
+}
+
+// Decode the complete blocks the host has, as tools/cdcstream.py does
+static void hostRead(void) {
+    tUSBStreamHeader sHeader;
+    uint16_t ui16Sample;
+    uint32_t ui32Size;
+    uint32_t ui32Idx;
+    uint32_t ui32Pos = 0;
+
+    g_ui32HostLen += FakeUSBCDCRead(&g_pui8Host[g_ui32HostLen],
+                                    sizeof(g_pui8Host) - g_ui32HostLen);
+
+    while (g_ui32HostLen - ui32Pos >= HEADER_SIZE) {
+        memcpy(&sHeader, &g_pui8Host[ui32Pos], HEADER_SIZE);
+        ui32Size = HEADER_SIZE + sHeader.ui16Count * sizeof(uint16_t);
+        if (g_ui32HostLen - ui32Pos < ui32Size) {
+            break;
+        }
+
+        if ((sHeader.ui16Sync != USB_STREAM_SYNC) ||
+            (sHeader.ui8Source != USB_STREAM_SRC_ADC0)) {
+            g_ui32BadBlocks++;
+        }
+        for (ui32Idx = 0; ui32Idx < sHeader.ui16Count; ui32Idx++) {
+            memcpy(&ui16Sample, &g_pui8Host[ui32Pos + HEADER_SIZE + ui32Idx * 2], 2);
+            if (ui16Sample != (uint16_t)(sHeader.ui16Seq + ui32Idx)) {
+                g_ui32BadBlocks++;
+                break;
+            }
+        }
+        g_ui32Missed += (uint16_t)(sHeader.ui16Seq - g_ui16NextSeq);
+        g_ui16NextSeq = sHeader.ui16Seq + 1;
+        g_ui64Samples += sHeader.ui16Count;
+        g_ui32Blocks++;
+        ui32Pos += ui32Size;
+    }
+
+    memmove(g_pui8Host, &g_pui8Host[ui32Pos], g_ui32HostLen - ui32Pos);
+    g_ui32HostLen -= ui32Pos;
+}
+
+static bool offer(uint32_t ui32Count) {
+    uint16_t pui16Samples[256];
+    uint32_t ui32Idx;
+
+    for (ui32Idx = 0; ui32Idx < ui32Count; ui32Idx++) {
+        pui16Samples[ui32Idx] = g_pui16USBStreamSeq[USB_STREAM_SRC_ADC0] + ui32Idx;
+    }
+    return USBStreamBlock(USB_STREAM_SRC_ADC0, pui16Samples, ui32Count);
+}
+
+static void runFor(uint32_t ui32Us) {
+    uint64_t ui64Until = g_ui64FakeTicks + US(ui32Us);
+
+    while (FakeEventRun(ui64Until)) {
+    }
+    hostRead();
+}
+
+// Offer a block of ui32Count samples every ui32PeriodUs for RUN_MS,
+// returning the MB/s the host received. Then let the queue drain and send
+// short blocks until the last of them goes out as a short packet, so the
+// host has every block and sees the gap left by every one dropped.
+static double stream(uint32_t ui32Count, uint32_t ui32PeriodUs) {
+    uint64_t ui64End = g_ui64FakeTicks + US(RUN_MS * 1000);
+    uint64_t ui64Start = g_ui64FakeTicks;
+    uint64_t ui64Bytes = FakeUSBCDCBytes();
+    double dRate;
+
+    while (g_ui64FakeTicks < ui64End) {
+        offer(ui32Count);
+        runFor(ui32PeriodUs);
+    }
+    dRate = (double)(FakeUSBCDCBytes() - ui64Bytes) * FakeClockHz() /
+            (double)(g_ui64FakeTicks - ui64Start) / 1e6;
+
+    runFor(10000);
+    do {
+        CHECK(offer(4));
+        runFor(1000);
+    } while (g_ui32HostLen && (g_ui64FakeTicks < ui64End + US(20000)));
+    CHECK(g_ui32HostLen == 0);
+    return dRate;
+}
+
+static void checkBlocks(void) {
+    CHECK(g_ui32BadBlocks == 0);
+    CHECK(g_ui32Missed == g_ui32USBStreamDrops);
+}
+
+static void testSaturated(void) {
+    static const uint32_t pui32HoldPct[] = { 0, 5, 20 };
+    double pdRate[2];
+    uint32_t pui32Drops[2];
+    uint32_t ui32Idx;
+    uint32_t ui32Single;
+
+    for (ui32Idx = 0; ui32Idx < 3; ui32Idx++) {
+        for (ui32Single = 0; ui32Single < 2; ui32Single++) {
+            connect(ui32Single, pui32HoldPct[ui32Idx]);
+            pdRate[ui32Single] = stream(64, 100);
+            pui32Drops[ui32Single] = g_ui32USBStreamDrops;
+            checkBlocks();
+
+            // The producer offers more than the bus carries
+            CHECK(g_ui32USBStreamDrops > 0);
+            CHECK(pdRate[ui32Single] < 19 * 64 * 1001 / 1e6);
+        }
+
+        CHECK(pdRate[0] >= pdRate[1]);
+        if (pui32HoldPct[ui32Idx]) {
+            CHECK(pdRate[0] > pdRate[1]);
+        }
+        printf("  %2u%% of interrupts held %u us: %.2f MB/s double buffered, "
+               "%.2f single (%u / %u blocks dropped)\n",
+               (unsigned)pui32HoldPct[ui32Idx], HOLD_US, pdRate[0], pdRate[1],
+               (unsigned)pui32Drops[0], (unsigned)pui32Drops[1]);
+    }
+}
+
+static void test400k(void) {
+    double pdRate[2];
+    uint32_t ui32Single;
+
+    for (ui32Single = 0; ui32Single < 2; ui32Single++) {
+        connect(ui32Single, 20);
+        pdRate[ui32Single] = stream(256, 640);
+        checkBlocks();
+        CHECK(g_ui32USBStreamDrops == 0);
+        CHECK(g_ui32Missed == 0);
+        CHECK(g_ui64Samples >= 400 * (RUN_MS - 1));
+    }
+    printf("  400 kS/s with 20%% held: %.2f MB/s double buffered, %.2f single, "
+           "nothing dropped\n", pdRate[0], pdRate[1]);
+}
+
+// Nothing is sent before the port is opened or after it is closed, and a
+// block offered then is refused without counting as a drop
+static void testOpenClose(void) {
+    connect(false, 0);
+    FakeUSBCDCOpen(false);
+    CHECK(!USBStreamActive());
+    CHECK(!offer(64));
+    runFor(10000);
+    CHECK(FakeUSBCDCBytes() == 0);
+    CHECK(g_ui32USBStreamDrops == 0);
+
+    // Reopened, the first block is a short packet sent at once
+    FakeUSBCDCOpen(true);
+    CHECK(offer(4));
+    CHECK(g_ui32USBStreamPackets == 1);
+    runFor(1000);
+    CHECK(FakeUSBCDCBytes() == HEADER_SIZE + 4 * sizeof(uint16_t));
+    CHECK(g_ui32Blocks == 1);
+
+    FakeUSBDisconnect();
+    CHECK(!USBStreamActive());
+}
+
+int main(void) {
+    testSaturated();
+    test400k();
+    testOpenClose();
+
+    return TEST_DONE();
+}
@@ -0,0 +1,266 @@
+#!/usr/bin/env python3
+"""Print binary log messages from common/binlog.c using the ELF file.
+
+    binlog.py decode app.out log.bin              saved stream or memory dump
+    binlog.py decode app.out /dev/ttyACM0 -b 115200   live from the board
+    binlog.py list app.out                        format strings and indexes
+
+The target writes only a format index and 32 bit arguments; the format
+strings live in the .binlog section of the .out file, which is never
+loaded. log.bin is the stream from BinLogRead(), e.g. the UART0 output of
+hidTestKeyboardDevice saved with `cat /dev/ttyACM0 > log.bin`, or a raw
+memory dump of g_sBinLog from the debugger. A stream can start anywhere,
+decoding picks up at the first whole record; the "BLOG" header the target
+sends at boot only marks a restart.
+
+Use the .out file from the same build as the target, the indexes change
+whenever a log call is added or moved. Records the target had to drop, and
+bytes skipped to find the next record after line noise, are reported in
+the output.
+"""
+
+import argparse
+import os
+import re
+import stat
+import struct
+import sys
+import termios
+import tty
+
+MAGIC = 0x474F4C42
+SYNC = 0xB0
+INDEX_DROPPED = 0xFFFF
+
+CONVERSION = re.compile(r"%([-+ #0]*)(\d+|\*)?(?:\.(\d+|\*))?(hh|h|ll|l|j|z|t|L)?([diouxXcsp%])")
+
+
+class Elf:
+    """Sections of an ELF file, enough to find strings by address."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            data = f.read()
+        if data[:4] != b"\x7fELF":
+            raise ValueError("%s is not an ELF file" % path)
+        wide = data[4] == 2
+        end = "<" if data[5] == 1 else ">"
+        if wide:
+            shoff, = struct.unpack_from(end + "Q", data, 0x28)
+            shentsize, shnum, shstrndx = struct.unpack_from(end + "HHH", data, 0x3A)
+            fmt = end + "IIQQQQIIQQ"
+        else:
+            shoff, = struct.unpack_from(end + "I", data, 0x20)
+            shentsize, shnum, shstrndx = struct.unpack_from(end + "HHH", data, 0x2E)
+            fmt = end + "IIIIIIIIII"
+
+        headers = [struct.unpack_from(fmt, data, shoff + i * shentsize) for i in range(shnum)]
+        names = headers[shstrndx]
+        self.sections = {}
+        for h in headers:
+            name_off, kind, _, addr, off, size = h[:6]
+            name = data[names[4] + name_off:data.index(b"\0", names[4] + name_off)]
+            # SHT_NOBITS sections (.bss) have no contents to read
+            body = data[off:off + size] if kind != 8 else b""
+            self.sections[name.decode("ascii", "replace")] = (addr, body)
+
+    def string(self, addr):
+        """Return the C string at addr, or None if no section holds it."""
+        for start, body in self.sections.values():
+            if start and start <= addr < start + len(body):
+                off = addr - start
+                return body[off:body.find(b"\0", off)].decode("latin-1")
+        return None
+
+    def formats(self):
+        """Return {index: format} from the .binlog section."""
+        if ".binlog" not in self.sections:
+            raise ValueError("no .binlog section, nothing was logged or wrong file")
+        start, body = self.sections[".binlog"]
+        table = {}
+        off = 0
+        while off < len(body):
+            end = body.find(b"\0", off)
+            if end < 0:
+                end = len(body)
+            if end > off:
+                table[(start + off) & 0xFFFF] = body[off:end].decode("latin-1")
+            off = end + 1
+        return table
+
+
+def signed(value):
+    return value - (1 << 32) if value & 0x80000000 else value
+
+
+def render(fmt, args, elf):
+    """printf fmt on the host, taking every argument as a 32 bit word."""
+    args = list(args)
+
+    def take():
+        return args.pop(0) if args else None
+
+    def convert(m):
+        flags, width, precision, _, kind = m.groups()
+        if kind == "%":
+            return "%"
+        if width == "*":
+            width = str(signed(take() or 0))
+        if precision == "*":
+            precision = str(take() or 0)
+        spec = "%" + flags + (width or "") + ("." + precision if precision else "")
+        value = take()
+        if value is None:
+            return "<missing>"
+        if kind in "di":
+            return (spec + "d") % signed(value)
+        if kind == "u":
+            return (spec + "d") % value
+        if kind in "oxX":
+            return (spec + kind) % value
+        if kind == "c":
+            return (spec + "c") % chr(value & 0xFF)
+        if kind == "p":
+            return (spec + "s") % ("0x%08x" % value)
+        text = elf.string(value)
+        return (spec + "s") % (text if text is not None else "<0x%08x>" % value)
+
+    return CONVERSION.sub(convert, fmt)
+
+
+class Decoder:
+    """Turn the BinLogRead() byte stream, fed in any pieces, into messages."""
+
+    def __init__(self, elf):
+        self.elf = elf
+        self.formats = elf.formats()
+        self.buf = b""
+        self.started = False
+        self.skipped = 0
+
+    def feed(self, data):
+        buf = self.buf + data
+        pos = 0
+        out = []
+        while len(buf) - pos >= 4:
+            word, = struct.unpack_from("<I", buf, pos)
+            if word == MAGIC:
+                if len(buf) - pos < 16:
+                    break
+                if self.started:
+                    out.append("# target restarted\n")
+                self.started = True
+                self.skipped = 0
+                pos += 16
+                continue
+            index = word & 0xFFFF
+            count = (word >> 16) & 0xFF
+            fmt = self.formats.get(index)
+            if word >> 24 != SYNC or count > 4 or (fmt is None and index != INDEX_DROPPED):
+                # Not a record start, slide along a byte at a time
+                pos += 1
+                self.skipped += 1
+                continue
+            if len(buf) - pos < 4 * (1 + count):
+                break
+            args = struct.unpack_from("<%dI" % count, buf, pos + 4)
+            pos += 4 * (1 + count)
+
+            # Bytes before the first record are only a stream cut mid-record
+            if self.skipped and self.started:
+                out.append("# %d bytes skipped\n" % self.skipped)
+            self.skipped = 0
+            self.started = True
+            if index == INDEX_DROPPED:
+                out.append("# %d records dropped\n" % args[0])
+            else:
+                out.append(render(fmt, args, self.elf))
+        self.buf = buf[pos:]
+        return out
+
+
+def read_dump(data, decoder):
+    """Return messages from the unread records in a memory dump of g_sBinLog."""
+    start = data.find(b"BLOG")
+    _, size, head, tail, dropped = struct.unpack_from("<5I", data, start)
+    words = struct.unpack_from("<%dI" % size, data, start + 20)
+    stream = b"BLOG" + bytes(12)
+    while tail != head:
+        word = words[tail % size]
+        if word == 0:
+            break
+        count = 1 + ((word >> 16) & 0xFF)
+        stream += struct.pack("<%dI" % count, *(words[(tail + i) % size] for i in range(count)))
+        tail += count
+    out = decoder.feed(stream)
+    if dropped:
+        out.append("# %d records dropped since start\n" % dropped)
+    return out
+
+
+def open_port(path, baud):
+    fd = os.open(path, os.O_RDONLY | os.O_NOCTTY)
+    tty.setraw(fd)
+    speed = getattr(termios, "B%d" % baud, None)
+    if speed is not None:
+        attrs = termios.tcgetattr(fd)
+        attrs[4] = attrs[5] = speed
+        termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    termios.tcflush(fd, termios.TCIFLUSH)
+    return fd
+
+
+def cmd_decode(args):
+    decoder = Decoder(Elf(args.elf))
+
+    if stat.S_ISCHR(os.stat(args.log).st_mode):
+        fd = open_port(args.log, args.baud)
+        try:
+            while True:
+                for line in decoder.feed(os.read(fd, 4096)):
+                    sys.stdout.write(line)
+                sys.stdout.flush()
+        except KeyboardInterrupt:
+            return
+        finally:
+            os.close(fd)
+
+    with open(args.log, "rb") as f:
+        data = f.read()
+    start = data.find(b"BLOG")
+    if start >= 0 and start + 20 <= len(data) and struct.unpack_from("<I", data, start + 4)[0]:
+        lines = read_dump(data, decoder)
+    else:
+        lines = decoder.feed(data)
+    for line in lines:
+        sys.stdout.write(line)
+
+
+def cmd_list(args):
+    formats = Elf(args.elf).formats()
+    for index in sorted(formats):
+        print("%5d  %r" % (index, formats[index]))
+    print("%d format strings" % len(formats), file=sys.stderr)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="cmd", required=True)
+
+    p = sub.add_parser("decode", help="print the messages in a stream, dump or serial port")
+    p.add_argument("elf", help=".out file of the running build")
+    p.add_argument("log")
+    p.add_argument("-b", "--baud", type=int, default=115200)
+    p.set_defaults(func=cmd_decode)
+
+    p = sub.add_parser("list", help="print the format strings in an ELF file")
+    p.add_argument("elf")
+    p.set_defaults(func=cmd_list)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
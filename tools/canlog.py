@@ -0,0 +1,221 @@
+#!/usr/bin/env python3
+"""Read CAN capture logs from common/canlog.c and replay them onto a bus.
+
+    canlog.py dump capture.bin               print in candump -L format
+    canlog.py replay capture.bin can0        send at the original timing
+    canlog.py replay trace.log can0 -s 10    candump -L input, 10x speed
+    canlog.py replay trace.log can0 -s 0     as fast as the interface takes
+
+capture.bin is the raw byte stream from the firmware, saved from the
+serial port with e.g. `cat /dev/ttyACM0 > capture.bin`. The capture can
+start at any time: the firmware repeats its header record, which carries
+the tick rate, every 64 records. --tick-hz decodes a capture too short to
+hold one. Text the firmware logs, such as the CANRX latency histogram, is
+printed by dump as comment lines and left out of replay.
+
+Replay uses a Linux SocketCAN interface, so traffic recorded on one bus can
+be played into CANRX through a USB-CAN adapter to test its handlers under
+real load.
+"""
+
+import argparse
+import re
+import socket
+import struct
+import sys
+import time
+
+RECORD = struct.Struct("<IHBB8s")
+ID_HEADER = 0xFFFF
+ID_TEXT = 0xFFFE
+FLAG_TX = 0x01
+FLAG_OVERRUN = 0x02
+
+CANDUMP_LINE = re.compile(r"\((\d+\.\d+)\)\s+(\S+)\s+([0-9A-Fa-f]+)#([0-9A-Fa-f]*)")
+
+
+def is_header(data, off):
+    """True if a header record starts at off."""
+    _, ident, _, _, payload = RECORD.unpack_from(data, off)
+    return ident == ID_HEADER and payload[:4] == b"CANL"
+
+
+def is_frame(record):
+    """True if an unpacked record could be a logged frame."""
+    _, ident, flags, length, payload = record
+    return (ident <= 0x7FF and length <= 8 and not flags & ~(FLAG_TX | FLAG_OVERRUN)
+            and not payload[length:].strip(b"\0"))
+
+
+def is_text(record):
+    """True if an unpacked record could be a piece of a text message."""
+    _, ident, flags, length, payload = record
+    return (ident == ID_TEXT and 1 <= length <= 8 and not flags
+            and not payload[length:].strip(b"\0"))
+
+
+def guess_alignment(data):
+    """Record offset in a capture without a header, from the first records."""
+    def score(start):
+        offs = range(start, min(len(data), start + 64 * RECORD.size) - RECORD.size + 1,
+                     RECORD.size)
+        return sum(is_frame(r) or is_text(r)
+                   for r in (RECORD.unpack_from(data, off) for off in offs))
+    return max(range(RECORD.size), key=score)
+
+
+def read_binary(data, tick_hz=None):
+    """Yield (seconds, id, data, flags) from a firmware byte stream.
+
+    Pieces of text messages come out with id ID_TEXT. The firmware repeats the header record every so often, so the stream can
+    start anywhere. Records are aligned on the headers; after a lost byte
+    the records up to the next header are skipped and the first one after
+    it is flagged FLAG_OVERRUN."""
+    headers = [m.start() - 8 for m in re.finditer(b"CANL", data)
+               if m.start() >= 8 and is_header(data, m.start() - 8)]
+    fixed_hz = tick_hz is not None
+    if not fixed_hz:
+        if not headers:
+            raise ValueError("no CANL header record found, give --tick-hz")
+        tick_hz = struct.unpack_from("<I", data, headers[0] + 12)[0]
+
+    # Records before the first header line up with it
+    off = headers[0] % RECORD.size if headers else guess_alignment(data)
+    next_header = 0
+    lost = False
+
+    # Timestamps are 32 bit tick counts, unwrap them. Records are not all
+    # logged in time order, so only a large step back is a wrap.
+    last = None
+    base = 0
+    while off + RECORD.size <= len(data):
+        while next_header < len(headers) and headers[next_header] < off:
+            next_header += 1
+        if next_header < len(headers) and headers[next_header] < off + RECORD.size:
+            if headers[next_header] != off:
+                # Out of step with the header, something was lost
+                lost = True
+                off = headers[next_header]
+            if not fixed_hz:
+                tick_hz = struct.unpack_from("<I", data, off + 12)[0]
+            off += RECORD.size
+            continue
+
+        record = RECORD.unpack_from(data, off)
+        if not is_frame(record) and not is_text(record):
+            # Lost alignment, skip to the next header
+            lost = True
+            if next_header == len(headers):
+                break
+            off = headers[next_header]
+            continue
+        off += RECORD.size
+
+        ticks, ident, flags, length, payload = record
+        if lost:
+            flags |= FLAG_OVERRUN
+            lost = False
+        if last is not None and ticks - last > 1 << 31:
+            # Logged late, from before the last wrap
+            yield (base - (1 << 32) + ticks) / tick_hz, ident, payload[:length], flags
+            continue
+        if last is not None and last - ticks > 1 << 31:
+            base += 1 << 32
+        last = ticks
+        yield (base + ticks) / tick_hz, ident, payload[:length], flags
+
+
+def read_candump(lines):
+    """Yield (seconds, id, data, flags) from candump -L lines."""
+    for line in lines:
+        m = CANDUMP_LINE.match(line.strip())
+        if m:
+            yield float(m.group(1)), int(m.group(3), 16), bytes.fromhex(m.group(4)), 0
+
+
+def read_any(path, tick_hz=None):
+    with open(path, "rb") as f:
+        data = f.read()
+    lines = data[:4096].decode("ascii", "replace").splitlines()
+    if any(CANDUMP_LINE.match(line.strip()) for line in lines[:5]):
+        return list(read_candump(data.decode("ascii", "replace").splitlines()))
+    return list(read_binary(data, tick_hz))
+
+
+def cmd_dump(args):
+    text = b""
+    for t, ident, payload, flags in read_any(args.log, args.tick_hz):
+        if flags & FLAG_OVERRUN:
+            text = b""
+            print("# log records lost here")
+        if ident == ID_TEXT:
+            text += payload
+            while b"\n" in text:
+                line, text = text.split(b"\n", 1)
+                print("# " + line.decode("ascii", "replace"))
+            continue
+        print("(%.6f) %s %03X#%s%s" % (t, args.iface, ident, payload.hex().upper(),
+                                       "  # tx" if flags & FLAG_TX else ""))
+
+
+def cmd_replay(args):
+    frames = [f for f in read_any(args.log, args.tick_hz)
+              if f[1] != ID_TEXT and (args.tx or not f[3] & FLAG_TX)]
+    if not frames:
+        return
+
+    sock = socket.socket(socket.AF_CAN, socket.SOCK_RAW, socket.CAN_RAW)
+    sock.bind((args.iface,))
+
+    first = frames[0][0]
+    start = time.monotonic()
+    for t, ident, payload, _ in frames:
+        if args.speed > 0:
+            delay = start + (t - first) / args.speed - time.monotonic()
+            if delay > 0:
+                time.sleep(delay)
+        frame = struct.pack("=IB3x8s", ident, len(payload), payload.ljust(8, b"\0"))
+        while True:
+            try:
+                sock.send(frame)
+                break
+            except OSError:
+                # Transmit queue full, give the interface a moment
+                time.sleep(0.0001)
+
+    elapsed = time.monotonic() - start
+    print("%d frames in %.3f s (%.0f frames/s)" % (len(frames), elapsed,
+                                                   len(frames) / elapsed if elapsed else 0),
+          file=sys.stderr)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="cmd", required=True)
+
+    def common(p):
+        p.add_argument("log")
+        p.add_argument("--tick-hz", type=int,
+                       help="timestamp rate, instead of the one in the header records")
+
+    p = sub.add_parser("dump", help="print a log in candump -L format")
+    common(p)
+    p.add_argument("--iface", default="can0", help="interface name to print")
+    p.set_defaults(func=cmd_dump)
+
+    p = sub.add_parser("replay", help="send a log onto a SocketCAN interface")
+    common(p)
+    p.add_argument("iface")
+    p.add_argument("-s", "--speed", type=float, default=1.0,
+                   help="time scale, 2 is twice as fast, 0 is no delay")
+    p.add_argument("--tx", action="store_true",
+                   help="also send frames the logging node sent itself")
+    p.set_defaults(func=cmd_replay)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
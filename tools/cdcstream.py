@@ -0,0 +1,239 @@
+#!/usr/bin/env python3
+"""Capture and decode the USB sample stream from TivaWare_Test/usbstream.c.
+
+    cdcstream.py capture /dev/ttyACM0 run.bin -m 64     64 MB into run.bin
+    cdcstream.py capture /dev/ttyACM0 run.bin -t 10     10 s, file trimmed
+    cdcstream.py decode run.bin                          block and gap summary
+    cdcstream.py decode run.bin --csv run.csv            samples as CSV
+    cdcstream.py bench -m 64                             pty loopback test
+
+The firmware streams while the port is open, which raises DTR. Capture
+sizes the output file up front and maps it, so received data goes from the
+tty straight into the page cache without another copy in Python; the file
+is cut to the bytes actually received at the end.
+
+Each block is an 8 byte header (sync 0xA55A, source, reserved, sample
+count, per-source sequence number) followed by little-endian 16 bit
+samples. A gap in a sequence is a block the firmware dropped because the
+host did not keep up.
+
+bench runs the same capture code against a simulated endpoint on a
+pseudo-terminal: a thread writes blocks of counting samples in 64 byte
+packets, as the bulk endpoint delivers them, and the capture is decoded
+and checked afterwards.
+"""
+
+import argparse
+import mmap
+import os
+import struct
+import sys
+import tempfile
+import threading
+import time
+import tty
+
+HEADER = struct.Struct("<HBBHH")
+SYNC = 0xA55A
+SYNC_BYTES = struct.pack("<H", SYNC)
+SOURCES = {0: "adc0", 1: "mcp3202"}
+PACKET = 64
+CHUNK = 1 << 16
+
+
+def open_port(path):
+    fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+    tty.setraw(fd)
+    return fd
+
+
+def capture(fd, path, size, seconds=None):
+    """Read from fd into a mapped file of up to size bytes, return (bytes, s)."""
+    with open(path, "w+b") as f:
+        f.truncate(size)
+        mm = mmap.mmap(f.fileno(), size)
+        view = memoryview(mm)
+        off = 0
+        start = time.monotonic()
+        deadline = start + seconds if seconds else None
+        try:
+            while off < size:
+                if deadline and time.monotonic() >= deadline:
+                    break
+                try:
+                    n = os.readv(fd, [view[off:off + CHUNK]])
+                except OSError:
+                    # EIO once the device or pty master goes away
+                    break
+                if n == 0:
+                    break
+                off += n
+        finally:
+            elapsed = time.monotonic() - start
+            view.release()
+            mm.close()
+        f.truncate(off)
+    return off, elapsed
+
+
+def blocks(data):
+    """Yield (source, seq, samples) for every block, skipping damaged data."""
+    off = data.find(SYNC_BYTES)
+    while 0 <= off and off + HEADER.size <= len(data):
+        sync, source, _, count, seq = HEADER.unpack_from(data, off)
+        end = off + HEADER.size + count * 2
+        if sync != SYNC or source not in SOURCES or end > len(data):
+            off = data.find(SYNC_BYTES, off + 1)
+            continue
+        yield source, seq, memoryview(data)[off + HEADER.size:end].cast("H")
+        off = end
+
+
+class Stats:
+    def __init__(self):
+        self.blocks = {}
+        self.samples = {}
+        self.gaps = {}
+        self.last = {}
+
+    def add(self, source, seq, samples):
+        if source in self.last:
+            missed = (seq - self.last[source] - 1) & 0xFFFF
+            self.gaps[source] = self.gaps.get(source, 0) + missed
+        self.last[source] = seq
+        self.blocks[source] = self.blocks.get(source, 0) + 1
+        self.samples[source] = self.samples.get(source, 0) + len(samples)
+
+    def lost(self):
+        return sum(self.gaps.values())
+
+    def summary(self, elapsed=None):
+        for source in sorted(self.blocks):
+            line = "%-8s %8d blocks %10d samples %6d blocks missed" % (
+                SOURCES[source], self.blocks[source], self.samples[source],
+                self.gaps.get(source, 0))
+            if elapsed:
+                line += "  %.0f samples/s" % (self.samples[source] / elapsed)
+            print(line)
+
+
+def cmd_capture(args):
+    fd = open_port(args.port)
+    try:
+        size, elapsed = capture(fd, args.out, args.megabytes << 20, args.time)
+    finally:
+        os.close(fd)
+    print("%d bytes in %.3f s (%.3f MB/s)" % (size, elapsed, size / elapsed / 1e6 if elapsed else 0),
+          file=sys.stderr)
+
+
+def cmd_decode(args):
+    with open(args.capture, "rb") as f:
+        data = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+    stats = Stats()
+    out = open(args.csv, "w") if args.csv else None
+    if out:
+        out.write("source,seq,index,value\n")
+    for source, seq, samples in blocks(data):
+        stats.add(source, seq, samples)
+        if out:
+            name = SOURCES[source]
+            for i, value in enumerate(samples):
+                out.write("%s,%d,%d,%d\n" % (name, seq, i, value))
+        samples.release()
+    if out:
+        out.close()
+    stats.summary()
+
+
+def simulated_endpoint(fd, size, count, rate):
+    """Write counting-sample blocks to fd in 64 byte packets."""
+    seq = 0
+    value = 0
+    sent = 0
+    pending = b""
+    start = time.monotonic()
+    try:
+        while sent < size:
+            if len(pending) < PACKET:
+                samples = [(value + i) & 0xFFFF for i in range(count)]
+                pending += HEADER.pack(SYNC, 0, 0, count, seq) + struct.pack("<%dH" % count, *samples)
+                seq = (seq + 1) & 0xFFFF
+                value += count
+            os.write(fd, pending[:PACKET])
+            pending = pending[PACKET:]
+            sent += PACKET
+            if rate:
+                ahead = sent / rate - (time.monotonic() - start)
+                if ahead > 0.001:
+                    time.sleep(ahead)
+    finally:
+        # Let the reader drain before the slave side sees the hangup
+        time.sleep(0.2)
+        os.close(fd)
+
+
+def cmd_bench(args):
+    size = args.megabytes << 20
+    master, slave = os.openpty()
+    tty.setraw(master)
+    tty.setraw(slave)
+    writer = threading.Thread(target=simulated_endpoint,
+                              args=(master, size, args.block, args.rate))
+    with tempfile.TemporaryDirectory() as tmp:
+        path = os.path.join(tmp, "bench.bin")
+        writer.start()
+        received, elapsed = capture(slave, path, size)
+        writer.join()
+        os.close(slave)
+
+        with open(path, "rb") as f:
+            data = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        stats = Stats()
+        bad = 0
+        expect = 0
+        for source, seq, samples in blocks(data):
+            stats.add(source, seq, samples)
+            if samples[0] != expect & 0xFFFF or samples[-1] != (expect + len(samples) - 1) & 0xFFFF:
+                bad += 1
+            expect += len(samples)
+            samples.release()
+        data.close()
+
+    print("%d bytes in %.3f s (%.3f MB/s)" % (received, elapsed, received / elapsed / 1e6))
+    stats.summary(elapsed)
+    print("%d blocks with wrong samples" % bad)
+    if received != size or bad or stats.lost():
+        sys.exit(1)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="cmd", required=True)
+
+    p = sub.add_parser("capture", help="record the stream into a file")
+    p.add_argument("port")
+    p.add_argument("out")
+    p.add_argument("-m", "--megabytes", type=int, default=64, help="file size limit")
+    p.add_argument("-t", "--time", type=float, help="stop after this many seconds")
+    p.set_defaults(func=cmd_capture)
+
+    p = sub.add_parser("decode", help="summarize a capture and check for dropped blocks")
+    p.add_argument("capture")
+    p.add_argument("--csv", help="also write every sample to this file")
+    p.set_defaults(func=cmd_decode)
+
+    p = sub.add_parser("bench", help="measure capture against a simulated endpoint")
+    p.add_argument("-m", "--megabytes", type=int, default=16, help="amount to transfer")
+    p.add_argument("-b", "--block", type=int, default=256, help="samples per block")
+    p.add_argument("-r", "--rate", type=float, default=0,
+                   help="endpoint rate in bytes/s, 0 for as fast as the pty takes")
+    p.set_defaults(func=cmd_bench)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
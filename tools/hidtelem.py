@@ -0,0 +1,232 @@
+#!/usr/bin/env python3
+"""Read telemetry from the HID_Test composite device through hidraw.
+
+    hidtelem.py read                    print reports as they arrive
+    hidtelem.py stream -t 10            turn streaming on, measure for 10 s
+    hidtelem.py bench -t 10             same measurement, simulated endpoint
+
+The device is found by the vendor usage page in its report descriptor, or
+given with --dev /dev/hidrawN. The user needs read/write access to the
+node, e.g. through a udev rule for VID 1CBE. Each 64 byte report starts
+with a type byte, a length byte and a little-endian 16 bit sequence
+number (USBCOMP_TelemHeader in HID_Test/USBCOMP.h).
+
+bench runs the same reader against a simulated endpoint that hands out
+one report per poll interval. By default it runs in simulated time,
+which shows how much faster than the bus the reader can decode. Use
+--realtime to pace it like the bus, and --drop to check that lost
+reports are counted; the losses are the same from run to run for a given
+--seed. tests/test_usbcomp.c measures the firmware side, USBCOMP.c
+against a simulated host.
+"""
+
+import argparse
+import glob
+import os
+import random
+import struct
+import sys
+import time
+
+REPORT_SIZE = 64
+HEADER = struct.Struct("<BBH")
+DATA_SIZE = REPORT_SIZE - HEADER.size
+VENDOR_PAGE = b"\x06\x00\xff"
+
+TELEM_TEST = 0x01
+TELEM_ADC = 0x02
+TELEM_STATS = 0x03
+TYPE_NAMES = {TELEM_TEST: "test", TELEM_ADC: "adc", TELEM_STATS: "stats"}
+
+CMD_STREAM = 0x01
+CMD_RESET_STATS = 0x02
+
+STATS_FIELDS = ("sent", "dropped", "commands")
+
+
+def find_device():
+    """Return the /dev/hidrawN node of the telemetry interface."""
+    for node in sorted(glob.glob("/sys/class/hidraw/hidraw*")):
+        try:
+            with open(os.path.join(node, "device", "uevent")) as f:
+                uevent = f.read().upper()
+            with open(os.path.join(node, "device", "report_descriptor"), "rb") as f:
+                desc = f.read()
+        except OSError:
+            continue
+        if ":00001CBE:" in uevent and desc.startswith(VENDOR_PAGE):
+            return "/dev/" + os.path.basename(node)
+    raise SystemExit("no telemetry interface found, try --dev")
+
+
+def decode(report):
+    """Return (type, sequence, data) from one report."""
+    kind, length, seq = HEADER.unpack_from(report)
+    return kind, seq, report[HEADER.size:HEADER.size + min(length, DATA_SIZE)]
+
+
+def describe(kind, data):
+    if kind == TELEM_TEST:
+        words = struct.unpack("<%dI" % (len(data) // 4), data[:len(data) // 4 * 4])
+        return "words %d..%d" % (words[0], words[-1]) if words else "empty"
+    if kind == TELEM_ADC:
+        return " ".join(str(v) for v in struct.unpack("<%dH" % (len(data) // 2),
+                                                      data[:len(data) // 2 * 2]))
+    if kind == TELEM_STATS:
+        values = struct.unpack("<%dI" % (len(data) // 4), data[:len(data) // 4 * 4])
+        return " ".join("%s=%d" % (n, v) for n, v in zip(STATS_FIELDS, values))
+    return data.hex()
+
+
+class Meter:
+    """Counts reports and bytes, and lost reports from sequence gaps."""
+
+    def __init__(self):
+        self.reports = 0
+        self.lost = 0
+        self.bad_words = 0
+        self.last_seq = None
+        self.next_word = None
+        self.device_stats = None
+
+    def add(self, report):
+        kind, seq, data = decode(report)
+        self.reports += 1
+        if self.last_seq is not None:
+            self.lost += (seq - self.last_seq - 1) & 0xFFFF
+        self.last_seq = seq
+
+        if kind == TELEM_TEST and len(data) >= 4:
+            first = struct.unpack_from("<I", data)[0]
+            # A gap in the words is fine when reports were lost
+            if self.next_word is not None and first != self.next_word and not self.lost:
+                self.bad_words += 1
+            self.next_word = first + len(data) // 4
+        elif kind == TELEM_STATS:
+            self.device_stats = describe(kind, data)
+
+    def summary(self, elapsed):
+        rate = self.reports * REPORT_SIZE / elapsed if elapsed else 0
+        line = ("%d reports in %.2f s, %.0f bytes/s (%.1f%% of 64000), %d lost"
+                % (self.reports, elapsed, rate, rate / 640, self.lost))
+        if self.bad_words:
+            line += ", %d counter errors" % self.bad_words
+        if self.device_stats:
+            line += "\ndevice: " + self.device_stats
+        return line
+
+
+def send_command(fd, *payload):
+    # hidraw wants the report ID first, 0 when the descriptor has none
+    os.write(fd, bytes([0]) + bytes(payload).ljust(REPORT_SIZE, b"\0"))
+
+
+def cmd_read(args):
+    fd = os.open(args.dev or find_device(), os.O_RDWR)
+    try:
+        while True:
+            kind, seq, data = decode(os.read(fd, REPORT_SIZE))
+            print("%5d %-5s %s" % (seq, TYPE_NAMES.get(kind, "%02x" % kind),
+                                   describe(kind, data)))
+    except KeyboardInterrupt:
+        pass
+    finally:
+        os.close(fd)
+
+
+def cmd_stream(args):
+    fd = os.open(args.dev or find_device(), os.O_RDWR)
+    meter = Meter()
+    send_command(fd, CMD_STREAM, 1)
+    try:
+        start = time.monotonic()
+        end = start + args.time
+        while time.monotonic() < end:
+            meter.add(os.read(fd, REPORT_SIZE))
+        elapsed = time.monotonic() - start
+    finally:
+        send_command(fd, CMD_STREAM, 0)
+        os.close(fd)
+    print(meter.summary(elapsed))
+
+
+class SimEndpoint:
+    """Interrupt IN endpoint fed the way telemFxn in empty_min.c feeds it.
+
+    The firmware always has a report ready, and the host takes one per poll.
+    """
+
+    def __init__(self, poll_ms, drop, realtime):
+        self.poll = poll_ms / 1000.0
+        self.drop = drop
+        self.realtime = realtime
+        self.seq = 0
+        self.word = 0
+        self.clock = 0.0
+        self.start = time.monotonic()
+
+    def read(self):
+        while True:
+            self.clock += self.poll
+            if self.realtime:
+                delay = self.start + self.clock - time.monotonic()
+                if delay > 0:
+                    time.sleep(delay)
+            words = range(self.word, self.word + DATA_SIZE // 4)
+            report = HEADER.pack(TELEM_TEST, DATA_SIZE, self.seq & 0xFFFF) + \
+                struct.pack("<%dI" % len(words), *words)
+            self.seq += 1
+            self.word += len(words)
+            if random.random() >= self.drop:
+                return report
+
+
+def cmd_bench(args):
+    random.seed(args.seed)
+    ep = SimEndpoint(args.poll_ms, args.drop, args.realtime)
+    meter = Meter()
+    cpu = time.process_time()
+    wall = time.monotonic()
+    while ep.clock < args.time:
+        meter.add(ep.read())
+    cpu = time.process_time() - cpu
+    wall = time.monotonic() - wall
+
+    print(meter.summary(ep.clock))
+    print("reader: %.2f s CPU, %.0f reports/s decoded, %.0fx the bus rate"
+          % (cpu, meter.reports / cpu if cpu else 0,
+             (meter.reports / cpu) / (1000.0 / args.poll_ms) if cpu else 0))
+    if not args.realtime:
+        print("(simulated time, %.2f s wall)" % wall)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="cmd", required=True)
+
+    p = sub.add_parser("read", help="print reports as they arrive")
+    p.add_argument("--dev", help="hidraw node, found automatically if omitted")
+    p.set_defaults(func=cmd_read)
+
+    p = sub.add_parser("stream", help="measure the streaming rate from the device")
+    p.add_argument("--dev", help="hidraw node, found automatically if omitted")
+    p.add_argument("-t", "--time", type=float, default=10.0, help="seconds to measure")
+    p.set_defaults(func=cmd_stream)
+
+    p = sub.add_parser("bench", help="measure the reader against a simulated endpoint")
+    p.add_argument("-t", "--time", type=float, default=10.0, help="simulated seconds")
+    p.add_argument("--poll-ms", type=float, default=1.0, help="endpoint polling interval")
+    p.add_argument("--drop", type=float, default=0.0,
+                   help="fraction of reports the simulated link loses")
+    p.add_argument("--seed", type=int, default=1,
+                   help="seed for the losses, so a run can be repeated")
+    p.add_argument("--realtime", action="store_true", help="pace reads like the bus")
+    p.set_defaults(func=cmd_bench)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,302 @@
+#!/usr/bin/env python3
+"""Decode interrupt traces from common/isrtrace.c.
+
+    isrtrace.py stats trace.bin              per-ISR duration, jitter, nesting
+    isrtrace.py chrome trace.bin -o t.json   Chrome trace for chrome://tracing
+    isrtrace.py dump trace.bin               one line per record
+    isrtrace.py stats trace.bin --names 16=spiDone,17=pwmUpdate
+
+trace.bin is either a memory dump of g_sISRTrace (in CCS, Memory Browser,
+Save Memory, raw binary, sizeof(g_sISRTrace) bytes from &g_sISRTrace) or
+the byte stream from ISRTraceDrain(), e.g. TivaWare_Test built with
+UART_LINK 2 and saved with `cat /dev/ttyACM0 > trace.bin`. Both carry the
+same "ISRT" header with the clock rate. The stream repeats it every 256
+records, so a capture can start at any time and a lost byte only costs
+the records up to the next header. --clock decodes a stream too short to
+hold a header.
+
+Durations are inclusive (entry to exit) and exclusive (less the time spent
+in handlers that preempted it). Jitter is taken over the gaps between
+entries of the same ISR. Trace records lost to the ring lapping, or to a
+cut in the stream, are counted, and the nesting is restarted at the gap.
+"""
+
+import argparse
+import json
+import math
+import re
+import struct
+import sys
+
+HEADER = struct.Struct("<4sIII")
+RECORD = struct.Struct("<IBBH")
+
+ENTRY = 0
+EXIT = 1
+MARK = 2
+
+# Kept in step with ISRTRACE_ID_* in common/isrtrace.h
+NAMES = {
+    1: "timerISR",
+    2: "getADC",
+    3: "CAN0 ISR",
+    4: "USB0 Hwi",
+}
+
+
+def stream_alignment(data):
+    """Record offset in a stream without a header, from the record numbers."""
+    def score(start):
+        nums = [RECORD.unpack_from(data, off)[3]
+                for off in range(start, min(len(data), start + 256 * RECORD.size)
+                                 - RECORD.size + 1, RECORD.size)]
+        return sum(b == (a + 1) & 0xFFFF for a, b in zip(nums, nums[1:]))
+    return max(range(RECORD.size), key=score)
+
+
+def read_stream(data):
+    """Return (clock Hz or None, raw records) from ISRTraceDrain() output.
+
+    None in the records marks a restart of the target."""
+    headers = [m.start() for m in re.finditer(b"ISRT", data)
+               if m.start() + HEADER.size <= len(data)
+               and HEADER.unpack_from(data, m.start())[2] == 0]
+    clock_hz = None
+    off = headers[0] % RECORD.size if headers else stream_alignment(data)
+    next_header = 0
+    raw = []
+    while off + RECORD.size <= len(data):
+        while next_header < len(headers) and headers[next_header] < off:
+            next_header += 1
+        if next_header < len(headers) and headers[next_header] < off + RECORD.size:
+            # A header, or one found out of step after a lost byte
+            off = headers[next_header]
+            _, header_hz, _, repeat = HEADER.unpack_from(data, off)
+            clock_hz = clock_hz or header_hz
+            if not repeat and raw:
+                # Target restarted, numbering starts again
+                raw.append(None)
+            off += HEADER.size
+            continue
+
+        record = RECORD.unpack_from(data, off)
+        if record[2] > MARK:
+            # Out of step, pick up again at the next header
+            if next_header == len(headers):
+                break
+            off = headers[next_header]
+            continue
+        raw.append(record)
+        off += RECORD.size
+    return clock_hz, raw
+
+
+def read_trace(data):
+    """Return (clock Hz, [(cycles, id, type, gap before)]) from a dump or stream.
+
+    The clock is None for a stream without a header."""
+    start = data.find(b"ISRT")
+    size = 0
+    if 0 <= start and start + HEADER.size <= len(data):
+        _, clock_hz, size, head = HEADER.unpack_from(data, start)
+
+    if size:
+        # Memory dump, put the ring back in write order
+        body = start + HEADER.size
+        if body + size * RECORD.size > len(data):
+            raise ValueError("dump is shorter than the %d record ring" % size)
+        count = min(head, size)
+        ring = [RECORD.unpack_from(data, body + i * RECORD.size) for i in range(size)]
+        raw = [ring[(head - count + i) % size] for i in range(count)]
+    else:
+        clock_hz, raw = read_stream(data)
+
+    # Unwrap the 32 bit cycle count and check the record numbers
+    records = []
+    base = 0
+    last = None
+    seq = None
+    for r in raw:
+        if r is None:
+            last = None
+            seq = None
+            continue
+        cycles, ident, kind, num = r
+        gap = 0 if seq is None else (num - seq - 1) & 0xFFFF
+        seq = num
+        if last is None and records:
+            # After a restart carry on from the previous record
+            base = records[-1][0] + 1 - cycles
+        elif last is not None and cycles < last:
+            base += 1 << 32
+        last = cycles
+        records.append((base + cycles, ident, kind, gap))
+    return clock_hz, records
+
+
+def walk(records):
+    """Yield (kind, id, start, end, exclusive cycles, depth) spans and marks."""
+    stack = []
+    for cycles, ident, kind, gap in records:
+        if gap:
+            # Entries or exits went missing, the open handlers are unknown
+            stack = []
+            yield "gap", gap, cycles, cycles, 0, 0
+        if kind == ENTRY:
+            if stack:
+                stack[-1][3] += 1
+            stack.append([ident, cycles, 0, 0])
+            yield "enter", ident, cycles, cycles, 0, len(stack)
+        elif kind == EXIT:
+            for depth in range(len(stack) - 1, -1, -1):
+                if stack[depth][0] == ident:
+                    break
+            else:
+                continue
+            del stack[depth + 1:]
+            ident, begin, inner, preempted = stack.pop()
+            total = cycles - begin
+            if stack:
+                stack[-1][2] += total
+            yield "span", ident, begin, cycles, total - inner, preempted
+        elif kind == MARK:
+            yield "mark", ident, cycles, cycles, 0, len(stack)
+
+
+def summary(values):
+    mean = sum(values) / len(values)
+    dev = math.sqrt(sum((v - mean) ** 2 for v in values) / len(values))
+    return min(values), mean, max(values), dev
+
+
+def cmd_stats(args, clock_hz, records, names):
+    us = 1e6 / clock_hz
+    isrs = {}
+    lost = 0
+    deepest = 0
+    for kind, ident, begin, end, excl, extra in walk(records):
+        if kind == "gap":
+            # Do not take a period across the missing records
+            lost += ident
+            for s in isrs.values():
+                s["last"] = None
+            continue
+        s = isrs.setdefault(ident, {"last": None, "periods": [], "incl": [], "excl": [],
+                                    "preempted": 0, "depth": 0, "marks": 0})
+        if kind == "enter":
+            if s["last"] is not None:
+                s["periods"].append(begin - s["last"])
+            s["last"] = begin
+            s["depth"] = max(s["depth"], extra)
+            deepest = max(deepest, extra)
+        elif kind == "span":
+            s["incl"].append(end - begin)
+            s["excl"].append(excl)
+            s["preempted"] += 1 if extra else 0
+        else:
+            s["marks"] += 1
+
+    span = (records[-1][0] - records[0][0]) * us if records else 0
+    print("%d records over %.1f us at %d Hz, %d lost, nesting depth %d"
+          % (len(records), span, clock_hz, lost, deepest))
+    print()
+    print("%-12s %7s %28s %28s %24s %5s %9s" % (
+        "ISR", "count", "inclusive us min/mean/max", "exclusive us min/mean/max",
+        "period us mean jitter", "depth", "preempted"))
+    for ident in sorted(isrs):
+        s = isrs[ident]
+        name = names.get(ident, "id%d" % ident)
+        if not s["incl"]:
+            print("%-12s %7d %s" % (name, s["marks"], "marks"))
+            continue
+        incl = summary([v * us for v in s["incl"]])
+        excl = summary([v * us for v in s["excl"]])
+        if s["periods"]:
+            p = summary([v * us for v in s["periods"]])
+            period = "%11.2f %6.2f/%-5.2f" % (p[1], p[3], p[2] - p[0])
+        else:
+            period = "%24s" % "-"
+        print("%-12s %7d %9.2f %8.2f %9.2f %9.2f %8.2f %9.2f %s %5d %9d" % (
+            name, len(s["incl"]), incl[0], incl[1], incl[2], excl[0], excl[1], excl[2],
+            period, s["depth"], s["preempted"]))
+    print()
+    print("jitter is standard deviation/peak to peak of the entry period")
+
+
+def cmd_chrome(args, clock_hz, records, names):
+    us = 1e6 / clock_hz
+    t0 = records[0][0] if records else 0
+    events = [{"name": "thread_name", "ph": "M", "pid": 0, "tid": 0,
+               "args": {"name": "interrupts"}}]
+    for cycles, ident, kind, gap in records:
+        ts = (cycles - t0) * us
+        if gap:
+            events.append({"name": "%d records lost" % gap, "ph": "i", "s": "g",
+                           "pid": 0, "tid": 0, "ts": ts})
+        name = names.get(ident, "id%d" % ident)
+        if kind == MARK:
+            events.append({"name": name, "ph": "i", "s": "t", "pid": 0, "tid": 0, "ts": ts})
+        else:
+            events.append({"name": name, "ph": "B" if kind == ENTRY else "E",
+                           "pid": 0, "tid": 0, "ts": ts})
+    out = open(args.output, "w") if args.output else sys.stdout
+    json.dump({"traceEvents": events, "displayTimeUnit": "ns"}, out)
+    if args.output:
+        out.close()
+        print("%d events written to %s" % (len(events), args.output), file=sys.stderr)
+
+
+def cmd_dump(args, clock_hz, records, names):
+    us = 1e6 / clock_hz
+    t0 = records[0][0] if records else 0
+    for cycles, ident, kind, gap in records:
+        if gap:
+            print("# %d records lost here" % gap)
+        print("%12.3f %12d %-5s %s" % ((cycles - t0) * us, cycles - t0,
+                                       ("enter", "exit", "mark")[kind] if kind <= MARK
+                                       else "?%d" % kind,
+                                       names.get(ident, "id%d" % ident)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="cmd", required=True)
+
+    def common(p):
+        p.add_argument("trace")
+        p.add_argument("--names", default="",
+                       help="extra event names, e.g. 16=spiDone,17=pwmUpdate")
+        p.add_argument("--clock", "--clock-hz", type=int, default=0,
+                       help="processor clock in Hz, overrides the trace header")
+
+    p = sub.add_parser("stats", help="per-ISR duration, jitter and nesting")
+    common(p)
+    p.set_defaults(func=cmd_stats)
+
+    p = sub.add_parser("chrome", help="export Chrome trace event JSON")
+    common(p)
+    p.add_argument("-o", "--output", help="output file, default stdout")
+    p.set_defaults(func=cmd_chrome)
+
+    p = sub.add_parser("dump", help="print every record")
+    common(p)
+    p.set_defaults(func=cmd_dump)
+
+    args = parser.parse_args()
+
+    names = dict(NAMES)
+    for item in filter(None, args.names.split(",")):
+        ident, _, name = item.partition("=")
+        names[int(ident, 0)] = name
+
+    with open(args.trace, "rb") as f:
+        clock_hz, records = read_trace(f.read())
+    clock_hz = args.clock or clock_hz
+    if not clock_hz:
+        sys.exit("no clock rate in the trace, give --clock")
+    args.func(args, clock_hz, records, names)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,232 @@
+#!/usr/bin/env python3
+"""Turn PC histograms from common/pcprof.c into a flat profile.
+
+    pcprof.py flat app.out prof.bin               percent of samples per function
+    pcprof.py flat app.out uart.bin --interval    last dump minus the first
+    pcprof.py buckets app.out prof.bin -n 20      hottest address ranges
+
+prof.bin is a memory dump of g_sPCProf (in CCS, Memory Browser, Save
+Memory, raw binary, sizeof(g_sPCProf) bytes from &g_sPCProf) or the UART
+output of TivaWare_Test built with PC_PROFILE and UART_LINK 3, saved with
+`cat /dev/ttyACM0 > uart.bin`. The UART sends a fresh dump about once a
+second; the last complete one is used, or with --interval the difference
+between the first and the last, which leaves out start-up.
+
+A histogram bucket that straddles two functions is split between them in
+proportion to the bytes of each it covers. Samples in the SRAM histogram
+are matched to functions by their run address, which is the address the
+ELF symbol table gives for code copied to SRAM, such as the RAMFUNC
+handlers in .TI.ramfunc. Use the .out file from the same build as the
+target.
+"""
+
+import argparse
+import bisect
+import struct
+import sys
+
+HEADER = struct.Struct("<4s9I")
+
+# ELF symbol types
+STT_FUNC = 2
+EM_ARM = 40
+
+
+def read_dumps(data):
+    """Return every complete dump in data as (header dict, counts)."""
+    dumps = []
+    start = data.find(b"PCPF")
+    while start >= 0 and start + HEADER.size <= len(data):
+        (_, rate, base, shift, buckets, samples, outside, halved,
+         ram_base, ram_buckets) = HEADER.unpack_from(data, start)
+        end = start + HEADER.size + 2 * (buckets + ram_buckets)
+        if buckets + ram_buckets > 1 << 20 or end > len(data):
+            break
+        counts = list(struct.unpack_from("<%dH" % (buckets + ram_buckets), data,
+                                         start + HEADER.size))
+        dumps.append(({"rate": rate, "base": base, "shift": shift, "buckets": buckets,
+                       "samples": samples, "outside": outside, "halved": halved,
+                       "ram_base": ram_base}, counts))
+        start = data.find(b"PCPF", end)
+    if not dumps:
+        raise ValueError("no complete PCPF dump found")
+    return dumps
+
+
+def read_symbols(path):
+    """Return sorted [(start, end, name)] for the functions in an ELF file."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if data[:4] != b"\x7fELF":
+        raise ValueError("%s is not an ELF file" % path)
+    wide = data[4] == 2
+    end = "<" if data[5] == 1 else ">"
+    machine, = struct.unpack_from(end + "H", data, 18)
+    if wide:
+        shoff, = struct.unpack_from(end + "Q", data, 0x28)
+        shentsize, shnum = struct.unpack_from(end + "HH", data, 0x3A)
+        shfmt, symfmt = end + "IIQQQQIIQQ", end + "IBBHQQ"
+    else:
+        shoff, = struct.unpack_from(end + "I", data, 0x20)
+        shentsize, shnum = struct.unpack_from(end + "HH", data, 0x2E)
+        shfmt, symfmt = end + "IIIIIIIIII", end + "IIIBBH"
+
+    headers = [struct.unpack_from(shfmt, data, shoff + i * shentsize) for i in range(shnum)]
+    symbols = []
+    for h in headers:
+        if h[1] != 2:   # SHT_SYMTAB
+            continue
+        strtab = headers[h[6]][4]
+        for off in range(h[4], h[4] + h[5], struct.calcsize(symfmt)):
+            fields = struct.unpack_from(symfmt, data, off)
+            if wide:
+                name_off, info, _, shndx, value, size = fields
+            else:
+                name_off, value, size, info, _, shndx = fields
+            if info & 0xF != STT_FUNC or shndx == 0:
+                continue
+            if machine == EM_ARM:
+                value &= ~1     # Thumb bit
+            name = data[strtab + name_off:data.index(b"\0", strtab + name_off)]
+            symbols.append([value, value + size, name.decode("ascii", "replace")])
+    if not symbols:
+        raise ValueError("no function symbols in %s" % path)
+
+    # Drop duplicates and give sizeless symbols the room up to the next one
+    symbols.sort()
+    unique = []
+    for s in symbols:
+        if unique and unique[-1][0] == s[0]:
+            continue
+        unique.append(s)
+    for s, following in zip(unique, unique[1:] + [None]):
+        if s[1] == s[0] and following:
+            s[1] = following[0]
+    return [tuple(s) for s in unique]
+
+
+def bucket_address(header, i):
+    """Return the first address counted in bucket i, flash or SRAM."""
+    if i < header["buckets"]:
+        return header["base"] + (i << header["shift"])
+    return header["ram_base"] + ((i - header["buckets"]) << header["shift"])
+
+
+def attribute(header, counts, symbols):
+    """Return ({function: samples}, {(bucket start, size): samples})."""
+    starts = [s[0] for s in symbols]
+    size = 1 << header["shift"]
+    functions = {}
+    buckets = {}
+    for i, count in enumerate(counts):
+        if not count:
+            continue
+        lo = bucket_address(header, i)
+        hi = lo + size
+        buckets[lo, size] = count
+        covered = 0
+        j = max(bisect.bisect_right(starts, lo) - 1, 0)
+        while j < len(symbols) and symbols[j][0] < hi:
+            overlap = min(hi, symbols[j][1]) - max(lo, symbols[j][0])
+            if overlap > 0:
+                functions[symbols[j][2]] = functions.get(symbols[j][2], 0) + count * overlap / size
+                covered += overlap
+            j += 1
+        if covered < size:
+            functions["[no symbol]"] = functions.get("[no symbol]", 0) + count * (size - covered) / size
+    if header["outside"]:
+        functions["[outside histogram]"] = header["outside"]
+    return functions, buckets
+
+
+def select(args):
+    with open(args.profile, "rb") as f:
+        dumps = read_dumps(f.read())
+    header, counts = dumps[-1]
+    if args.interval:
+        if len(dumps) < 2:
+            sys.exit("--interval needs two dumps, only one found")
+        first, first_counts = dumps[0]
+        if first["halved"] != header["halved"]:
+            sys.exit("counts were halved between the first and last dump, "
+                     "use a shorter capture or the last dump alone")
+        counts = [b - a for a, b in zip(first_counts, counts)]
+        header = dict(header, samples=header["samples"] - first["samples"],
+                      outside=header["outside"] - first["outside"])
+    return header, counts, len(dumps)
+
+
+def describe(header, counts, dumps):
+    total = sum(counts) + header["outside"]
+    note = ", counts halved %d times" % header["halved"] if header["halved"] else ""
+    print("%d samples at %d Hz (%.1f s), %d dumps read%s"
+          % (header["samples"], header["rate"], header["samples"] / max(header["rate"], 1),
+             dumps, note), file=sys.stderr)
+    return total
+
+
+def cmd_flat(args):
+    header, counts, dumps = select(args)
+    total = describe(header, counts, dumps)
+    if not total:
+        return
+    functions, _ = attribute(header, counts, read_symbols(args.elf))
+
+    print("%7s %7s %9s  %s" % ("%", "cum %", "samples", "function"))
+    cumulative = 0
+    for name, samples in sorted(functions.items(), key=lambda f: -f[1]):
+        cumulative += samples
+        if samples * 100 / total < args.min:
+            continue
+        print("%7.2f %7.2f %9.1f  %s" % (samples * 100 / total, cumulative * 100 / total,
+                                          samples, name))
+
+
+def cmd_buckets(args):
+    header, counts, dumps = select(args)
+    total = describe(header, counts, dumps)
+    if not total:
+        return
+    symbols = read_symbols(args.elf)
+    starts = [s[0] for s in symbols]
+    _, buckets = attribute(header, counts, symbols)
+
+    print("%7s %9s  %-21s  %s" % ("%", "samples", "address", "function"))
+    for (lo, size), samples in sorted(buckets.items(), key=lambda b: -b[1])[:args.n]:
+        j = bisect.bisect_right(starts, lo + size - 1) - 1
+        names = []
+        while j >= 0 and symbols[j][1] > lo:
+            names.insert(0, "%s+0x%x" % (symbols[j][2], max(lo - symbols[j][0], 0)))
+            j -= 1
+        print("%7.2f %9d  0x%08x-0x%08x  %s" % (samples * 100 / total, samples, lo,
+                                               lo + size - 1, " ".join(names) or "-"))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="cmd", required=True)
+
+    def common(p):
+        p.add_argument("elf", help=".out file of the profiled build")
+        p.add_argument("profile")
+        p.add_argument("--interval", action="store_true",
+                       help="profile the time between the first and last dump")
+
+    p = sub.add_parser("flat", help="samples per function")
+    common(p)
+    p.add_argument("--min", type=float, default=0.0,
+                   help="leave out functions below this percentage")
+    p.set_defaults(func=cmd_flat)
+
+    p = sub.add_parser("buckets", help="hottest histogram buckets")
+    common(p)
+    p.add_argument("-n", type=int, default=20, help="buckets to show")
+    p.set_defaults(func=cmd_buckets)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
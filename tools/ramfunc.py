@@ -0,0 +1,238 @@
+#!/usr/bin/env python3
+"""Check and measure the functions TivaWare_Test runs from SRAM.
+
+    ramfunc.py report TivaWare_Test.out          what went to SRAM, and its size
+    ramfunc.py report TivaWare_Test.out --strict  fail if SRAM code calls flash
+    ramfunc.py compare flash.bin sram.bin        ISR cycles, flash vs SRAM build
+
+report reads the .TI.ramfunc section of the linked ELF file (see
+TivaWare_Test/ramfunc.h and tm4c123gh6pm.cmd). It lists each function with
+its run address in SRAM and its size, then the total against the SRAM size
+and where the load image sits in flash. It also decodes the Thumb-2 BL and
+B.W instructions in those functions and lists calls that still land in
+flash, directly or through a linker trampoline. Those are the call-tree
+entries to add to the .cmd file. The CCS project's RAMFunc_Report build
+configuration runs it as a post-build step, the others need no python3.
+
+compare takes two interrupt traces from tools/isrtrace.py (memory dumps or
+UART_LINK 2 streams). One comes from a build linked with
+--define=RAMFUNC_FLASH and one from the normal build. It prints exclusive
+cycles per handler for both.
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+SRAM_BASE = 0x20000000
+SRAM_SIZE = 0x8000
+
+STT_FUNC = 2
+EM_ARM = 40
+SHT_SYMTAB = 2
+
+
+class Elf:
+    """ELF32 little endian sections, program headers and function symbols."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = data = f.read()
+        if data[:4] != b"\x7fELF" or data[4] != 1 or data[5] != 1:
+            raise ValueError("%s is not a 32 bit little endian ELF file" % path)
+        self.machine, = struct.unpack_from("<H", data, 18)
+        phoff, shoff = struct.unpack_from("<II", data, 0x1C)
+        phentsize, phnum, shentsize, shnum, shstrndx = struct.unpack_from("<HHHHH", data, 0x2A)
+
+        self.segments = [struct.unpack_from("<8I", data, phoff + i * phentsize)
+                         for i in range(phnum)]
+        headers = [struct.unpack_from("<10I", data, shoff + i * shentsize) for i in range(shnum)]
+        names = headers[shstrndx][4]
+        self.sections = {}
+        for h in headers:
+            name = data[names + h[0]:data.index(b"\0", names + h[0])].decode("ascii", "replace")
+            self.sections[name] = h
+
+        self.functions = []
+        for h in headers:
+            if h[1] != SHT_SYMTAB:
+                continue
+            strtab = headers[h[6]][4]
+            for off in range(h[4], h[4] + h[5], 16):
+                name_off, value, size, info, _, shndx = struct.unpack_from("<IIIBBH", data, off)
+                if info & 0xF != STT_FUNC or shndx == 0:
+                    continue
+                name = data[strtab + name_off:data.index(b"\0", strtab + name_off)]
+                self.functions.append((value & ~1, size, name.decode("ascii", "replace")))
+        self.functions = sorted(set(self.functions))
+
+    def load_address(self, addr):
+        """Return the load (physical) address for a run address."""
+        for _, offset, vaddr, paddr, filesz, memsz, _, _ in self.segments:
+            if vaddr <= addr < vaddr + max(memsz, 1):
+                return paddr + addr - vaddr
+        return addr
+
+    def read(self, addr, size):
+        """Return up to size bytes from a run address, or b''."""
+        for h in self.sections.values():
+            if h[3] <= addr < h[3] + h[5] and h[1] != 8:
+                size = min(size, h[3] + h[5] - addr)
+                return self.data[h[4] + addr - h[3]:h[4] + addr - h[3] + size]
+        return b""
+
+    def name_at(self, addr):
+        for start, size, name in self.functions:
+            if start <= addr < start + max(size, 2):
+                return name, addr - start
+        return None, 0
+
+
+def branch_target(first, second, addr):
+    """Decode a 32 bit Thumb BL or B.W at addr, or return None."""
+    if first & 0xF800 != 0xF000:
+        return None
+    link = second & 0xD000
+    if link not in (0xD000, 0x9000):
+        return None
+    s = (first >> 10) & 1
+    j1 = (second >> 13) & 1
+    j2 = (second >> 11) & 1
+    i1 = 1 - (j1 ^ s)
+    i2 = 1 - (j2 ^ s)
+    offset = (s << 24) | (i1 << 23) | (i2 << 22) | ((first & 0x3FF) << 12) | ((second & 0x7FF) << 1)
+    if s:
+        offset -= 1 << 25
+    return (addr + 4 + offset) & 0xFFFFFFFF
+
+
+def trampoline_target(code, addr):
+    """Follow a linker far-call trampoline, or return None."""
+    if len(code) >= 8:
+        # LDR.W PC, [PC, #imm] then the literal
+        first, second = struct.unpack_from("<HH", code)
+        if first == 0xF8DF and second & 0xF000 == 0xF000:
+            lit = (addr + 4) & ~3
+            off = lit + (second & 0xFFF) - addr
+            if off + 4 <= len(code):
+                return struct.unpack_from("<I", code, off)[0] & ~1
+    if len(code) >= 10:
+        # MOVW/MOVT into a register, then BX
+        words = struct.unpack_from("<4H", code)
+        if words[0] & 0xFBF0 == 0xF240 and words[2] & 0xFBF0 == 0xF2C0:
+            def imm16(hi, lo):
+                return ((hi & 0xF) << 12) | (((hi >> 10) & 1) << 11) | \
+                       (((lo >> 12) & 7) << 8) | (lo & 0xFF)
+            return (imm16(words[0], words[1]) | imm16(words[2], words[3]) << 16) & ~1
+    return None
+
+
+def flash_calls(elf, start, size, lo, hi):
+    """Yield (offset, target, name) for branches in [start, start+size) leaving [lo, hi)."""
+    code = elf.read(start, size)
+    i = 0
+    while i + 4 <= len(code):
+        first, second = struct.unpack_from("<HH", code, i)
+        target = branch_target(first, second, start + i)
+        if target is None:
+            # 32 bit instructions start with 0b11101, 0b11110 or 0b11111
+            i += 4 if first >> 11 in (0x1D, 0x1E, 0x1F) else 2
+            continue
+        name, _ = elf.name_at(target)
+        if lo <= target < hi and name is None:
+            # Not a function, so a trampoline the linker put next to us
+            final = trampoline_target(elf.read(target, 16), target)
+            if final is not None and not lo <= final < hi:
+                yield i, final, "%s (via trampoline)" % (elf.name_at(final)[0] or "?")
+        elif not lo <= target < hi:
+            yield i, target, name or "?"
+        i += 4
+
+
+def cmd_report(args):
+    elf = Elf(args.elf)
+    section = elf.sections.get(".TI.ramfunc")
+    if section is None:
+        sys.exit("%s has no .TI.ramfunc section" % args.elf)
+    run, size = section[3], section[5]
+    load = elf.load_address(run)
+    in_sram = SRAM_BASE <= run < SRAM_BASE + SRAM_SIZE
+
+    functions = [f for f in elf.functions if run <= f[0] < run + size]
+    print("%s: .TI.ramfunc %d bytes, %d functions, runs at 0x%08x%s"
+          % (os.path.basename(args.elf), size, len(functions), run,
+             "" if in_sram else " (FLASH, linked with RAMFUNC_FLASH)"))
+    if in_sram:
+        print("    SRAM used %d of %d bytes (%.1f%%), image loaded from flash at 0x%08x"
+              % (size, SRAM_SIZE, size * 100.0 / SRAM_SIZE, load))
+    for start, length, name in sorted(functions, key=lambda f: -f[1]):
+        print("    0x%08x %5d  %s" % (start, length, name))
+
+    if elf.machine != EM_ARM:
+        return
+    problems = 0
+    for start, length, name in functions:
+        for offset, target, callee in flash_calls(elf, start, length, run, run + size):
+            if problems == 0:
+                print("calls from .TI.ramfunc that leave it:")
+            problems += 1
+            print("    %s+0x%x -> 0x%08x %s" % (name, offset, target, callee))
+    if problems and args.strict:
+        sys.exit(1)
+
+
+def cmd_compare(args):
+    sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+    import isrtrace
+
+    results = []
+    for path in (args.flash, args.sram):
+        with open(path, "rb") as f:
+            clock_hz, records = isrtrace.read_trace(f.read())
+        spans = {}
+        for kind, ident, begin, end, excl, _ in isrtrace.walk(records):
+            if kind == "span":
+                spans.setdefault(ident, []).append(excl)
+        results.append(spans)
+
+    flash, sram = results
+    print("%-12s %7s %7s %10s %10s %10s %10s %8s" % (
+        "ISR", "n flash", "n sram", "flash mean", "sram mean", "flash max", "sram max", "saved"))
+    for ident in sorted(set(flash) | set(sram)):
+        name = isrtrace.NAMES.get(ident, "id%d" % ident)
+        a = flash.get(ident, [])
+        b = sram.get(ident, [])
+        if not a or not b:
+            print("%-12s %7d %7d  only in one trace" % (name, len(a), len(b)))
+            continue
+        mean_a = sum(a) / len(a)
+        mean_b = sum(b) / len(b)
+        print("%-12s %7d %7d %10.1f %10.1f %10d %10d %7.1f%%" % (
+            name, len(a), len(b), mean_a, mean_b, max(a), max(b),
+            (mean_a - mean_b) * 100 / mean_a if mean_a else 0))
+    print("cycles are exclusive of nested handlers")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="cmd", required=True)
+
+    p = sub.add_parser("report", help="list the SRAM functions and calls back to flash")
+    p.add_argument("elf")
+    p.add_argument("--strict", action="store_true",
+                   help="exit with an error if any call leaves .TI.ramfunc")
+    p.set_defaults(func=cmd_report)
+
+    p = sub.add_parser("compare", help="ISR cycles from a flash build and an SRAM build")
+    p.add_argument("flash", help="trace from the build linked with RAMFUNC_FLASH")
+    p.add_argument("sram", help="trace from the normal build")
+    p.set_defaults(func=cmd_compare)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,162 @@
+#!/usr/bin/env python3
+"""Measure echo throughput and latency of Arduino_Serial_UART_Echo.
+
+    serialecho.py bench /dev/ttyACM0                   1000 frames at 115200
+    serialecho.py bench /dev/ttyUSB0 -n 5000 -s 200    longer, larger frames
+    serialecho.py bench /dev/ttyACM0 -w 64 --stats     64 bytes in flight,
+                                                       then ask for counters
+
+Frames are '#' seq len payload crc16, the format the sketch checks when
+built with ECHO_CHECK. The echo is compared byte for byte against what was
+sent. Up to --window bytes are kept in flight; the default of 1 KB keeps
+the line busy both ways, a window of one frame measures round trip
+latency without queueing. Latency is from writing a frame to reading the
+last byte of its echo.
+
+--stats sends a zero length frame at the end and prints the counter line
+the sketch answers with. It needs ECHO_CHECK, without it the tool times
+out waiting for the line.
+"""
+
+import argparse
+import os
+import random
+import select
+import struct
+import sys
+import termios
+import time
+import tty
+
+SYNC = b"#"
+
+
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE, as crc16Update in the sketch."""
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+        crc &= 0xFFFF
+    return crc
+
+
+def frame(seq, payload):
+    body = bytes((seq & 0xFF, len(payload))) + payload
+    return SYNC + body + struct.pack("<H", crc16(body))
+
+
+def open_port(path, baud):
+    fd = os.open(path, os.O_RDWR | os.O_NOCTTY | os.O_NONBLOCK)
+    tty.setraw(fd)
+    speed = getattr(termios, "B%d" % baud, None)
+    if speed is not None:
+        attrs = termios.tcgetattr(fd)
+        attrs[4] = attrs[5] = speed
+        termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    termios.tcflush(fd, termios.TCIOFLUSH)
+    return fd
+
+
+def percentile(values, pct):
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * pct / 100))]
+
+
+def cmd_bench(args):
+    fd = open_port(args.port, args.baud)
+    # An Arduino resets when the port opens, give the bootloader time
+    time.sleep(args.settle)
+    termios.tcflush(fd, termios.TCIFLUSH)
+
+    rng = random.Random(1)
+    frames = [frame(seq, bytes(rng.getrandbits(8) for _ in range(args.size)))
+              for seq in range(args.count)]
+    stream = b"".join(frames)
+    # Offset just past each frame in the stream
+    ends = []
+    off = 0
+    for f in frames:
+        off += len(f)
+        ends.append(off)
+
+    sent = 0
+    queued = 0          # Frames handed to the write side
+    received = bytearray()
+    sent_at = []
+    latency = []
+    start = time.monotonic()
+    deadline = start + args.timeout
+    while len(received) < len(stream) and time.monotonic() < deadline:
+        # Queue whole frames while they fit in the window, at least one
+        # when nothing is in flight, so each frame has one send time
+        now = time.monotonic()
+        target = ends[queued - 1] if queued else 0
+        while queued < len(frames) and (ends[queued] - len(received) <= args.window or
+                                        target == len(received)):
+            sent_at.append(now)
+            target = ends[queued]
+            queued += 1
+
+        r, w, _ = select.select([fd], [fd] if sent < target else [], [], 0.1)
+        if w:
+            sent += os.write(fd, stream[sent:target])
+        if r:
+            received += os.read(fd, 65536)
+            now = time.monotonic()
+            while len(latency) < queued and ends[len(latency)] <= len(received):
+                latency.append(now - sent_at[len(latency)])
+    elapsed = time.monotonic() - start
+
+    errors = sum(a != b for a, b in zip(received, stream)) + abs(len(stream) - len(received))
+    line_rate = args.baud / 10
+    print("%d/%d bytes echoed in %.3f s, %.0f B/s each way (%.0f%% of %d baud)" % (
+        len(received), len(stream), elapsed, len(received) / elapsed,
+        100 * len(received) / elapsed / line_rate, args.baud))
+    if latency:
+        print("latency ms: min %.2f  median %.2f  p99 %.2f  max %.2f" % (
+            1e3 * min(latency), 1e3 * percentile(latency, 50),
+            1e3 * percentile(latency, 99), 1e3 * max(latency)))
+    print("%d bytes differ" % errors)
+
+    if args.stats:
+        request = frame(args.count, b"")
+        os.write(fd, request)
+        line = bytearray()
+        deadline = time.monotonic() + 2
+        while not (len(line) > len(request) and line.endswith(b"\n")):
+            if time.monotonic() > deadline:
+                break
+            if select.select([fd], [], [], 0.1)[0]:
+                line += os.read(fd, 256)
+        # Skip the echo of the request itself
+        text = line[len(request):].decode("ascii", "replace").strip()
+        print(text or "no stats line, is the sketch built with ECHO_CHECK?")
+
+    os.close(fd)
+    if errors:
+        sys.exit(1)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="cmd", required=True)
+
+    p = sub.add_parser("bench", help="echo framed data and check it")
+    p.add_argument("port")
+    p.add_argument("-b", "--baud", type=int, default=115200)
+    p.add_argument("-n", "--count", type=int, default=1000, help="frames to send")
+    p.add_argument("-s", "--size", type=int, default=60, help="payload bytes per frame, up to 255")
+    p.add_argument("-w", "--window", type=int, default=1024, help="bytes in flight")
+    p.add_argument("--settle", type=float, default=2.0, help="seconds to wait after opening")
+    p.add_argument("--timeout", type=float, default=60.0)
+    p.add_argument("--stats", action="store_true", help="print the sketch counters at the end")
+    p.set_defaults(func=cmd_bench)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,324 @@
+#!/usr/bin/env python3
+"""Talk to common/uartlink.c: COBS framed messages with a CRC-16.
+
+    uartframe.py bench /dev/ttyACM0 -b 1000000       echo test against a board
+    uartframe.py bench --sim                         simulated peer, 115200 and 1M
+    uartframe.py bench --sim -b 115200 --corrupt 1e-4
+    uartframe.py peer -b 115200                      simulated peer on a pty
+
+Frames are COBS(payload, crcLo, crcHi) followed by 0x00, with
+CRC-16/CCITT-FALSE over the payload. bench sends numbered frames, expects
+each one echoed (TivaWare_Test with UART_LINK set does this) and reports
+payload and line throughput, round trip latency and lost or damaged
+frames. Up to --window bytes are kept in flight; -w 1 measures latency
+without queueing.
+
+peer stands in for the board: it opens a pseudo-terminal, prints its
+path, and echoes frames at the speed a UART at the given baud rate
+would, 10 bits per byte. --corrupt flips random bits on the way back to
+check that the receiver resynchronises. bench --sim runs a peer in the
+same process for each baud rate given.
+"""
+
+import argparse
+import os
+import random
+import select
+import struct
+import sys
+import termios
+import threading
+import time
+import tty
+
+
+def make_table():
+    table = []
+    for i in range(256):
+        crc = i << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+        table.append(crc & 0xFFFF)
+    return table
+
+
+CRC_TABLE = make_table()
+
+
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE, as common/crc16.c."""
+    for byte in data:
+        crc = ((crc << 8) & 0xFFFF) ^ CRC_TABLE[(crc >> 8) ^ byte]
+    return crc
+
+
+def cobs_encode(data):
+    """COBS encode data, the same way as COBSFrameEncode()."""
+    out = bytearray([0])
+    code = 0
+    for byte in data:
+        if byte:
+            out.append(byte)
+        # A zero or a full block of 254 ends the block
+        if not byte or len(out) - code == 0xFF:
+            out[code] = len(out) - code
+            code = len(out)
+            out.append(0)
+    out[code] = len(out) - code
+    return bytes(out)
+
+
+def encode(payload):
+    """Return the framed bytes for payload, delimiter included."""
+    return cobs_encode(payload + struct.pack("<H", crc16(payload))) + b"\x00"
+
+
+class Decoder:
+    """Split a byte stream into checked frames, counting bad ones."""
+
+    def __init__(self, limit=4096):
+        self.buf = bytearray()
+        self.limit = limit
+        self.frames = 0
+        self.crc_errors = 0
+        self.errors = 0
+
+    def feed(self, data):
+        """Yield the payload of every good frame completed by data."""
+        self.buf += data
+        while True:
+            end = self.buf.find(0)
+            if end < 0:
+                if len(self.buf) > self.limit:
+                    self.errors += 1
+                    del self.buf[:]
+                return
+            raw = bytes(self.buf[:end])
+            del self.buf[:end + 1]
+            if not raw:
+                continue
+            payload = self.decode(raw)
+            if payload is not None:
+                yield payload
+
+    def decode(self, raw):
+        out = bytearray()
+        i = 0
+        while i < len(raw):
+            code = raw[i]
+            if i + code > len(raw):
+                self.errors += 1
+                return None
+            out += raw[i + 1:i + code]
+            i += code
+            if code != 0xFF and i < len(raw):
+                out.append(0)
+        if len(out) < 2:
+            self.errors += 1
+            return None
+        payload = bytes(out[:-2])
+        if struct.unpack("<H", out[-2:])[0] != crc16(payload):
+            self.crc_errors += 1
+            return None
+        self.frames += 1
+        return payload
+
+
+def open_port(path, baud):
+    fd = os.open(path, os.O_RDWR | os.O_NOCTTY | os.O_NONBLOCK)
+    tty.setraw(fd)
+    speed = getattr(termios, "B%d" % baud, None)
+    if speed is not None:
+        attrs = termios.tcgetattr(fd)
+        attrs[4] = attrs[5] = speed
+        termios.tcsetattr(fd, termios.TCSANOW, attrs)
+    termios.tcflush(fd, termios.TCIOFLUSH)
+    return fd
+
+
+class Peer(threading.Thread):
+    """Echo frames on a pty at the pace of a UART at baud."""
+
+    def __init__(self, baud, corrupt=0.0):
+        super().__init__(daemon=True)
+        self.master, slave = os.openpty()
+        tty.setraw(self.master)
+        tty.setraw(slave)
+        self.path = os.ttyname(slave)
+        self.slave = slave
+        self.byte_time = 10.0 / baud
+        self.corrupt = corrupt
+        self.running = True
+
+    def run(self):
+        decoder = Decoder()
+        rng = random.Random(2)
+        out = bytearray()
+        rx_time = tx_time = time.monotonic()
+        while self.running:
+            now = time.monotonic()
+            # Take bytes no faster than they would arrive on the wire
+            can_read = int((now - rx_time) / self.byte_time)
+            if can_read > 0:
+                r = select.select([self.master], [], [], 0)[0]
+                if r:
+                    data = os.read(self.master, can_read)
+                    rx_time += len(data) * self.byte_time
+                    for payload in decoder.feed(data):
+                        out += encode(payload)
+                else:
+                    rx_time = now
+            # And send them back at the same rate
+            if out:
+                can_send = int((now - tx_time) / self.byte_time)
+                if can_send > 0:
+                    chunk = bytearray(out[:can_send])
+                    if self.corrupt:
+                        for i in range(len(chunk)):
+                            if rng.random() < self.corrupt:
+                                chunk[i] ^= 1 << rng.randrange(8)
+                    n = os.write(self.master, chunk)
+                    del out[:n]
+                    tx_time += n * self.byte_time
+            else:
+                tx_time = now
+            time.sleep(min(self.byte_time * 16, 0.0005))
+
+    def stop(self):
+        self.running = False
+        self.join()
+        os.close(self.master)
+        os.close(self.slave)
+
+
+def percentile(values, pct):
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * pct / 100))]
+
+
+def bench(port, baud, count, size, window, timeout):
+    fd = open_port(port, baud)
+    rng = random.Random(1)
+    frames = [encode(struct.pack("<I", seq) + bytes(rng.getrandbits(8) for _ in range(size)))
+              for seq in range(count)]
+    stream = b"".join(frames)
+    ends = []
+    off = 0
+    for f in frames:
+        off += len(f)
+        ends.append(off)
+
+    decoder = Decoder()
+    sent = 0
+    queued = 0
+    in_flight = 0       # Bytes sent whose echo has not come back
+    sent_at = []
+    latency = {}
+    received = 0
+    start = time.monotonic()
+    deadline = start + timeout
+    while len(latency) < count and time.monotonic() < deadline:
+        now = time.monotonic()
+        # Queue whole frames while they fit in the window, at least one when
+        # nothing is outstanding. Frames lost on the way back free their
+        # window share once a later frame comes back.
+        target = ends[queued - 1] if queued else 0
+        while queued < count and (ends[queued] - received <= window or target == received):
+            sent_at.append(now)
+            target = ends[queued]
+            queued += 1
+
+        r, w, _ = select.select([fd], [fd] if sent < target else [], [], 0.2)
+        if w:
+            sent += os.write(fd, stream[sent:target])
+        if r:
+            data = os.read(fd, 65536)
+            now = time.monotonic()
+            for payload in decoder.feed(data):
+                seq = struct.unpack_from("<I", payload)[0]
+                if seq < count and seq not in latency:
+                    latency[seq] = now - sent_at[seq]
+                    received = max(received, ends[seq])
+        if not r and not w and sent == target and queued == count:
+            # Everything sent and nothing more coming back
+            if time.monotonic() - now > 0.2:
+                break
+    elapsed = time.monotonic() - start
+    os.close(fd)
+
+    payload_bytes = len(latency) * (size + 4)
+    wire_bytes = sum(len(frames[s]) for s in latency)
+    line_rate = baud / 10.0
+    print("%d baud: %d/%d frames of %d bytes echoed in %.3f s" % (
+        baud, len(latency), count, size + 4, elapsed))
+    print("  payload %.0f B/s, line %.0f B/s each way (%.0f%% of line rate)" % (
+        payload_bytes / elapsed, wire_bytes / elapsed, 100 * wire_bytes / elapsed / line_rate))
+    if latency:
+        values = list(latency.values())
+        print("  latency ms: min %.2f  median %.2f  p99 %.2f  max %.2f" % (
+            1e3 * min(values), 1e3 * percentile(values, 50),
+            1e3 * percentile(values, 99), 1e3 * max(values)))
+    print("  %d lost, %d CRC errors, %d framing errors" % (
+        count - len(latency), decoder.crc_errors, decoder.errors))
+    return count - len(latency)
+
+
+def cmd_bench(args):
+    lost = 0
+    if args.sim:
+        for baud in args.baud or [115200, 1000000]:
+            peer = Peer(baud, args.corrupt)
+            peer.start()
+            lost += bench(peer.path, baud, args.count, args.size, args.window, args.timeout)
+            peer.stop()
+    else:
+        if not args.port:
+            sys.exit("a port is needed without --sim")
+        time.sleep(args.settle)
+        for baud in args.baud or [115200]:
+            lost += bench(args.port, baud, args.count, args.size, args.window, args.timeout)
+    if lost and not args.corrupt:
+        sys.exit(1)
+
+
+def cmd_peer(args):
+    peer = Peer(args.baud, args.corrupt)
+    print(peer.path, flush=True)
+    peer.start()
+    try:
+        while True:
+            time.sleep(1)
+    except KeyboardInterrupt:
+        peer.stop()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="cmd", required=True)
+
+    p = sub.add_parser("bench", help="echo numbered frames and measure them")
+    p.add_argument("port", nargs="?")
+    p.add_argument("-b", "--baud", type=int, action="append",
+                   help="baud rate, may be repeated")
+    p.add_argument("-n", "--count", type=int, default=500, help="frames to send")
+    p.add_argument("-s", "--size", type=int, default=60, help="payload bytes after the sequence number")
+    p.add_argument("-w", "--window", type=int, default=1024, help="bytes in flight")
+    p.add_argument("--sim", action="store_true", help="echo through a simulated peer")
+    p.add_argument("--corrupt", type=float, default=0.0,
+                   help="bit error probability per byte in the simulated peer")
+    p.add_argument("--settle", type=float, default=0.5, help="seconds to wait after opening")
+    p.add_argument("--timeout", type=float, default=60.0)
+    p.set_defaults(func=cmd_bench)
+
+    p = sub.add_parser("peer", help="run a simulated peer on a pty")
+    p.add_argument("-b", "--baud", type=int, default=115200)
+    p.add_argument("--corrupt", type=float, default=0.0)
+    p.set_defaults(func=cmd_peer)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == "__main__":
+    main()